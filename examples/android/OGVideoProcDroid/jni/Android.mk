@@ -21,15 +21,33 @@ LOCAL_SRC_FILES := \
         og_jni_wrapper.cpp \
         og_pipeline.cpp \
         $(OG_SRC_PATH)/common/core.cpp \
+        $(OG_SRC_PATH)/common/profiler.cpp \
+        $(OG_SRC_PATH)/common/backendtuner.cpp \
         $(OG_SRC_PATH)/common/tools.cpp \
+        $(OG_SRC_PATH)/common/trace_recorder.cpp \
+        $(OG_SRC_PATH)/common/cpu/cpukernels.cpp \
+        $(OG_SRC_PATH)/common/cpu/cpukernels_x86.cpp \
+        $(OG_SRC_PATH)/common/cpu/cputhreadpool.cpp \
+        $(OG_SRC_PATH)/common/cpu/cputileexecutor.cpp \
         $(OG_SRC_PATH)/common/gl/fbo.cpp \
+        $(OG_SRC_PATH)/common/gl/fence.cpp \
+        $(OG_SRC_PATH)/common/gl/glstate.cpp \
         $(OG_SRC_PATH)/common/gl/memtransfer.cpp \
         $(OG_SRC_PATH)/common/gl/memtransfer_factory.cpp \
+        $(OG_SRC_PATH)/common/gl/memtransfer_pbo.cpp \
+        $(OG_SRC_PATH)/common/gl/programcache.cpp \
+        $(OG_SRC_PATH)/common/gl/quadbuffers.cpp \
         $(OG_SRC_PATH)/common/gl/shader.cpp \
+        $(OG_SRC_PATH)/common/gl/shaderregistry.cpp \
+        $(OG_SRC_PATH)/common/gl/texpool.cpp \
+        $(OG_SRC_PATH)/common/proc/blend.cpp \
+        $(OG_SRC_PATH)/common/proc/diff.cpp \
         $(OG_SRC_PATH)/common/proc/disp.cpp \
         $(OG_SRC_PATH)/common/proc/grayscale.cpp \
+        $(OG_SRC_PATH)/common/proc/pack.cpp \
         $(OG_SRC_PATH)/common/proc/thresh.cpp \
         $(OG_SRC_PATH)/common/proc/base/filterprocbase.cpp \
+        $(OG_SRC_PATH)/common/proc/base/multiinputprocbase.cpp \
         $(OG_SRC_PATH)/common/proc/base/multipassproc.cpp \
         $(OG_SRC_PATH)/common/proc/base/procbase.cpp \
         $(OG_SRC_PATH)/common/proc/multipass/adapt_thresh_pass.cpp \
@@ -0,0 +1,844 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Headless Linux benchmark harness: builds a pipeline from the available processors,
+ * feeds synthetic frames or frames from a PPM/PNG image at one or more resolutions,
+ * runs warm-up and timed iterations and reports the per-stage CPU/GPU times (see
+ * Profiler) and the end-to-end latency and throughput as CSV or JSON.
+ * Status messages go to stderr, so that the report can be redirected to a file and
+ * compared between commits.
+ *
+ * Usage: og_bench [options]
+ *   --pipeline <procs>     comma separated processors: gray, thresh, adaptthresh, gauss
+ *                          (default: gray,gauss,adaptthresh)
+ *   --size <WxH>[,<WxH>]   frame size(s) (default: 640x480,1280x720,1920x1080;
+ *                          with --input the image size)
+ *   --input <file>         PPM (P6) or PNG image, scaled to each frame size
+ *   --warmup <n>           number of warm-up iterations (default: 10)
+ *   --iterations <n>       number of timed iterations (default: 100)
+ *   --ring-depth <n>       frame ring depth, frames in flight (default: 1)
+ *   --async-readback       use asynchronous readback
+ *   --tex-pool             share the intermediate output textures (see Core::setUseTexPool())
+ *   --fuse                 fuse chains of point operations (see Core::setUseShaderFusion())
+ *   --no-state-cache       issue all OpenGL state calls (see Core::setUseGLStateCache())
+ *   --no-vbo               use client-side vertex arrays (see Core::setUseVertexBuffers())
+ *   --packed-gray          process grayscale images with 4 pixels per texel (see Core::setUsePackedGray())
+ *   --input-format <fmt>   input data format: rgba, nv12, nv21 or i420 (see Core::prepare(); the
+ *                          frames are converted before the benchmark; default: rgba)
+ *   --output-format <fmt>  output data format: rgba, gray8 or mask1 (see Core::setOutputFormat();
+ *                          default: rgba)
+ *   --roi <x,y,w,h>        compute and read back only this region of the output frames
+ *                          (see Core::setROI(); default: whole frame)
+ *   --validation <level>   OpenGL error checking: off, frame or call (see Core::setValidationLevel();
+ *                          default: call in DEBUG builds, otherwise frame)
+ *   --backend <gpu|cpu|auto>  run the pipeline with OpenGL or on the CPU, or select the faster
+ *                          one for each frame size (see Core::setBackend(); default: gpu)
+ *   --backend-tuning-dir <dir>  store the backend selection of --backend auto in <dir> and use
+ *                          the stored one in later runs (see Core::setBackendTuningDir())
+ *   --cpu-isa <isa>        instruction set of the CPU kernels: scalar, sse2, avx2 or neon
+ *                          (see CPUKernels::setInstructionSet(); default: best supported)
+ *   --cpu-threads <n>[,<n>]  number(s) of threads of the CPU backend, each one is benchmarked and
+ *                          the scaling is reported (see Core::setCPUNumThreads(); default: 0,
+ *                          one thread per CPU core)
+ *   --no-cpu-tiling        run the CPU backend without row bands (see Core::setUseCPUTiling())
+ *   --format <csv|json>    report format (default: csv)
+ *   --output <file>        write the report to <file> instead of stdout
+ */
+
+#include "ogles_gpgpu/ogles_gpgpu.h"
+#include "ogles_gpgpu/common/cpu/cpukernels.h"
+#include "../common/og_example_tools.h"
+
+#ifdef OG_BENCH_HAVE_PNG
+#include <png.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define NUM_SYNTHETIC_FRAMES    4
+
+// names of the validation levels for --validation
+static const char *validationNames[] = { "off", "frame", "call" };
+
+// names of the processing backends for --backend
+static const char *backendNames[] = { "gpu", "cpu", "auto" };
+
+// names of the output formats for --output-format
+static const char *outputFormatNames[] = { "rgba", "gray8", "mask1" };
+
+// names and pixel data formats of the input formats for --input-format
+static const char *inputFormatNames[] = { "rgba", "nv12", "nv21", "i420" };
+static const GLenum inputFormats[] = { GL_RGBA, ogles_gpgpu::INPUT_FORMAT_NV12, ogles_gpgpu::INPUT_FORMAT_NV21, ogles_gpgpu::INPUT_FORMAT_I420 };
+
+/**
+ * Benchmark configuration.
+ */
+struct BenchConf {
+    vector<string> pipeline;
+    vector<pair<int, int> > sizes;
+    const char *inputPath;
+    int warmup;
+    int iterations;
+    int ringDepth;
+    bool asyncReadback;
+    bool texPool;
+    bool fuse;
+    bool stateCache;
+    bool vertexBuffers;
+    bool packedGray;
+    int inputFormat;    // index into inputFormats
+    ogles_gpgpu::OutputFormat outputFormat;
+    ogles_gpgpu::ROI roi;       // w = 0 for the whole frame
+    ogles_gpgpu::ValidationLevel validation;
+    ogles_gpgpu::ProcessingBackend backend;
+    const char *backendTuningDir;
+    ogles_gpgpu::CPUInstructionSet cpuISA;
+    vector<int> cpuThreads;
+    bool cpuTiling;
+    bool json;
+    const char *outputPath;
+};
+
+/**
+ * Result of a benchmark run with one frame size.
+ */
+struct BenchResult {
+    int w, h;
+    int outW, outH;
+    ogles_gpgpu::ProcessingBackend backend;                                 // backend that executed the pipeline
+    ogles_gpgpu::BackendTuningResult tuning;                                // measurements of the backend selection
+    int threads, bands;                                                     // threads and row bands of the CPU backend
+    double latencyMin, latencyMean, latencyP50, latencyP95, latencyMax;     // end-to-end latency per frame in ms
+    double fps;                                                             // throughput in frames per second
+    vector<ogles_gpgpu::ProfilerStageStats> stages;
+    bool gpuTimerSupport;                                                   // GPU times available?
+    int poolTextures, poolOutputs;                                          // texture pool usage
+    double poolMB, unpooledMB;                                              // texture pool memory and memory without pool
+    int fusedProcs;                                                         // number of processors fused into another one
+    int packedGrayProcs;                                                    // number of processors with packed grayscale output
+    int uploadBytes;                                                        // bytes of input data per frame
+    bool inputLumaOnly;                                                     // only the Y plane of YUV input is uploaded?
+    int readbackBytes;                                                      // bytes of output data per frame
+    int glCallsIssued, glCallsElided;                                       // OpenGL state calls of the last frame
+};
+
+/**
+ * Read a binary PPM (P6) image from <path> into RGBA buffer <rgba>.
+ */
+static bool readPPM(const char *path, vector<unsigned char> &rgba, int &w, int &h) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    
+    int maxVal;
+    if (fscanf(f, "P6 %d %d %d", &w, &h, &maxVal) != 3 || maxVal != 255 || fgetc(f) == EOF) {
+        fclose(f);
+        return false;
+    }
+    
+    vector<unsigned char> rgb(w * h * 3);
+    bool ok = fread(&rgb[0], 1, rgb.size(), f) == rgb.size();
+    fclose(f);
+    
+    rgba.resize(w * h * 4);
+    for (int i = 0; i < w * h; i++) {
+        rgba[i * 4    ] = rgb[i * 3    ];
+        rgba[i * 4 + 1] = rgb[i * 3 + 1];
+        rgba[i * 4 + 2] = rgb[i * 3 + 2];
+        rgba[i * 4 + 3] = 255;
+    }
+    
+    return ok;
+}
+
+/**
+ * Read a PNG image from <path> into RGBA buffer <rgba>.
+ */
+static bool readPNG(const char *path, vector<unsigned char> &rgba, int &w, int &h) {
+#ifdef OG_BENCH_HAVE_PNG
+    png_image img;
+    memset(&img, 0, sizeof(img));
+    img.version = PNG_IMAGE_VERSION;
+    
+    if (!png_image_begin_read_from_file(&img, path)) return false;
+    
+    img.format = PNG_FORMAT_RGBA;
+    w = (int)img.width;
+    h = (int)img.height;
+    rgba.resize(PNG_IMAGE_SIZE(img));
+    
+    if (!png_image_finish_read(&img, NULL, &rgba[0], 0, NULL)) {
+        png_image_free(&img);
+        return false;
+    }
+    
+    return true;
+#else
+    fprintf(stderr, "compiled without PNG support\n");
+    return false;
+#endif
+}
+
+/**
+ * Read a PPM or PNG image (depending on the file extension of <path>).
+ */
+static bool readImage(const char *path, vector<unsigned char> &rgba, int &w, int &h) {
+    size_t len = strlen(path);
+    
+    if (len > 4 && strcmp(path + len - 4, ".png") == 0) {
+        return readPNG(path, rgba, w, h);
+    } else {
+        return readPPM(path, rgba, w, h);
+    }
+}
+
+/**
+ * Scale RGBA image <src> of size <srcW>x<srcH> to <dst> of size <dstW>x<dstH>
+ * (nearest neighbor).
+ */
+static void scaleImage(const vector<unsigned char> &src, int srcW, int srcH, vector<unsigned char> &dst, int dstW, int dstH) {
+    dst.resize(dstW * dstH * 4);
+    
+    for (int y = 0; y < dstH; y++) {
+        int srcY = y * srcH / dstH;
+        for (int x = 0; x < dstW; x++) {
+            int srcX = x * srcW / dstW;
+            memcpy(&dst[(y * dstW + x) * 4], &src[(srcY * srcW + srcX) * 4], 4);
+        }
+    }
+}
+
+/**
+ * Convert RGBA frame <rgba> of size <w>x<h> to YUV input format <fmt> in <yuv>
+ * (full range BT.601, chroma of 2x2 pixel blocks averaged).
+ */
+static void convToYUV(const vector<unsigned char> &rgba, int w, int h, GLenum fmt, vector<unsigned char> &yuv) {
+    int cw = (w + 1) / 2;
+    int ch = (h + 1) / 2;
+    yuv.assign(w * h + 2 * cw * ch, 0);
+    
+    for (int i = 0; i < w * h; i++) {
+        const unsigned char *px = &rgba[i * 4];
+        yuv[i] = (unsigned char)(0.299f * px[0] + 0.587f * px[1] + 0.114f * px[2] + 0.5f);
+    }
+    
+    unsigned char *chroma = &yuv[w * h];
+    for (int cy = 0; cy < ch; cy++) {
+        for (int cx = 0; cx < cw; cx++) {
+            float u = 0.0f, v = 0.0f;
+            int n = 0;
+            for (int y = cy * 2; y < min(cy * 2 + 2, h); y++) {
+                for (int x = cx * 2; x < min(cx * 2 + 2, w); x++) {
+                    const unsigned char *px = &rgba[(y * w + x) * 4];
+                    u += -0.168736f * px[0] - 0.331264f * px[1] + 0.5f * px[2];
+                    v += 0.5f * px[0] - 0.418688f * px[1] - 0.081312f * px[2];
+                    n++;
+                }
+            }
+            
+            unsigned char u8 = (unsigned char)max(0.0f, min(255.0f, u / n + 128.5f));
+            unsigned char v8 = (unsigned char)max(0.0f, min(255.0f, v / n + 128.5f));
+            int i = cy * cw + cx;
+            
+            if (fmt == ogles_gpgpu::INPUT_FORMAT_I420) {
+                chroma[i] = u8;
+                chroma[cw * ch + i] = v8;
+            } else {
+                chroma[i * 2] = fmt == ogles_gpgpu::INPUT_FORMAT_NV12 ? u8 : v8;
+                chroma[i * 2 + 1] = fmt == ogles_gpgpu::INPUT_FORMAT_NV12 ? v8 : u8;
+            }
+        }
+    }
+}
+
+/**
+ * Create a processor by name <name>. Returns NULL for unknown names.
+ */
+static ogles_gpgpu::ProcInterface *createProc(const string &name) {
+    if (name == "gray") return new ogles_gpgpu::GrayscaleProc();
+    if (name == "thresh") return new ogles_gpgpu::ThreshProc();
+    if (name == "adaptthresh") return new ogles_gpgpu::AdaptThreshProc();
+    if (name == "gauss") return new ogles_gpgpu::GaussProc();
+    
+    return NULL;
+}
+
+/**
+ * Return the p-th percentile of sorted values <v> (nearest rank).
+ */
+static double percentile(const vector<double> &v, double p) {
+    int idx = (int)(p * v.size() + 0.999999) - 1;
+    return v[max(0, min(idx, (int)v.size() - 1))];
+}
+
+/**
+ * Run the benchmark with configuration <conf> for frames <frames> of size <w>x<h>
+ * with <threads> threads of the CPU backend. Returns false if an OpenGL error occurred.
+ */
+static bool runBench(const BenchConf &conf, const vector<vector<unsigned char> > &frames, int w, int h, int threads,
+                     BenchResult &res)
+{
+    ogles_gpgpu::Core *core = ogles_gpgpu::Core::getInstance();
+    vector<ogles_gpgpu::ProcInterface *> procs;
+    
+    for (size_t i = 0; i < conf.pipeline.size(); i++) {
+        procs.push_back(createProc(conf.pipeline[i]));
+        core->addProcToPipeline(procs.back());
+    }
+    
+    core->setFrameRingDepth(conf.ringDepth);
+    core->setUseAsyncReadback(conf.asyncReadback);
+    core->setUseTexPool(conf.texPool);
+    core->setUseShaderFusion(conf.fuse);
+    core->setUseGLStateCache(conf.stateCache);
+    core->setUseVertexBuffers(conf.vertexBuffers);
+    core->setUsePackedGray(conf.packedGray);
+    core->setOutputFormat(conf.outputFormat);
+    core->setROI(conf.roi.x, conf.roi.y, conf.roi.w, conf.roi.h);
+    core->setValidationLevel(conf.validation);
+    core->setBackend(conf.backend);
+    core->setBackendTuningDir(conf.backendTuningDir ? conf.backendTuningDir : "");
+    core->setCPUNumThreads(threads);
+    core->setUseCPUTiling(conf.cpuTiling);
+    core->setProfilingEnabled(true);
+    core->getProfiler()->setWindowSize(conf.iterations);
+    
+    core->init();
+    core->prepare(w, h, inputFormats[conf.inputFormat]);
+    
+    res.w = w;
+    res.h = h;
+    res.outW = core->getOutputFrameW();
+    res.outH = core->getOutputFrameH();
+    res.backend = core->getBackend();
+    res.tuning = core->getBackendTuner()->getResult();
+    res.threads = core->getCPUTilingActive() ? core->getCPUTileExecutor().getNumThreads() : 1;
+    res.bands = core->getCPUTilingActive() ? core->getCPUTileExecutor().getNumBands() : 1;
+    res.fusedProcs = core->getNumFusedProcs();
+    res.packedGrayProcs = core->getNumPackedGrayProcs();
+    res.uploadBytes = core->getInputDataSize();
+    res.inputLumaOnly = core->getInputLumaOnly();
+    res.readbackBytes = core->getOutputDataSize();
+    
+    vector<unsigned char> output(res.readbackBytes);
+    
+    // frames are submitted <inFlight> - 1 frames before their output is read
+    int inFlight = conf.asyncReadback ? max(conf.ringDepth, 2) : conf.ringDepth;
+    int numFrames = conf.warmup + conf.iterations;
+    
+    vector<ogles_gpgpu::FrameHandle> handles(numFrames);
+    vector<double> submitTimes(numFrames);
+    vector<double> latencies;
+    double tStart = 0.0;
+    
+    for (int n = 0; n < numFrames + inFlight - 1; n++) {
+        if (n == conf.warmup) {
+            // all warm-up frames were read back. discard their measurements
+            core->getProfiler()->collectGPUResults();
+            core->getProfiler()->resetSamples();
+            tStart = getTimeMs();
+        }
+        
+        if (n < numFrames) {    // submit frame n
+            submitTimes[n] = getTimeMs();
+            core->setInputData(&frames[n % frames.size()][0]);
+            handles[n] = core->process();
+        }
+        
+        int readN = n - (inFlight - 1);
+        if (readN >= 0 && readN < numFrames) {    // read back an older frame
+            core->getOutputData(&output[0], handles[readN]);
+            
+            if (readN >= conf.warmup) {
+                latencies.push_back(getTimeMs() - submitTimes[readN]);
+            }
+        }
+    }
+    
+    double tTotal = getTimeMs() - tStart;
+    
+    sort(latencies.begin(), latencies.end());
+    
+    double sum = 0.0;
+    for (size_t i = 0; i < latencies.size(); i++) {
+        sum += latencies[i];
+    }
+    
+    res.latencyMin = latencies.front();
+    res.latencyMean = sum / latencies.size();
+    res.latencyP50 = percentile(latencies, 0.5);
+    res.latencyP95 = percentile(latencies, 0.95);
+    res.latencyMax = latencies.back();
+    res.fps = conf.iterations / (tTotal / 1000.0);
+    res.stages = core->getProfilingStats();
+    res.gpuTimerSupport = core->getProfiler()->getGPUTimerSupport();
+    res.glCallsIssued = core->getGLState()->getNumIssued();
+    res.glCallsElided = core->getGLState()->getNumElided();
+    
+    const ogles_gpgpu::TexPool *pool = core->getTexPool();
+    res.poolTextures = pool->getNumTextures();
+    res.poolOutputs = pool->getNumRequests();
+    res.poolMB = pool->getMemSize() / (1024.0 * 1024.0);
+    res.unpooledMB = pool->getRequestedMemSize() * conf.ringDepth / (1024.0 * 1024.0);
+    
+    bool ok = glGetError() == GL_NO_ERROR;
+    
+    ogles_gpgpu::Core::destroy();
+    
+    for (size_t i = 0; i < procs.size(); i++) {
+        delete procs[i];
+    }
+    
+    return ok;
+}
+
+/**
+ * Write the results <results> as CSV to <f>. One row per stage, frame size and number
+ * of CPU threads, the end-to-end latency is reported as stage "end_to_end".
+ */
+static void writeCSV(FILE *f, const BenchConf &conf, const string &pipelineStr, const vector<BenchResult> &results) {
+    fprintf(f, "pipeline,width,height,threads,stage,depth,samples,cpu_min_ms,cpu_mean_ms,cpu_p95_ms,gpu_min_ms,gpu_mean_ms,gpu_p95_ms,fps\n");
+    
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult &r = results[i];
+        
+        fprintf(f, "%s,%d,%d,%d,end_to_end,0,%d,%.4f,%.4f,%.4f,,,,%.2f\n", pipelineStr.c_str(), r.w, r.h, r.threads,
+                conf.iterations, r.latencyMin, r.latencyMean, r.latencyP95, r.fps);
+        
+        for (size_t j = 0; j < r.stages.size(); j++) {
+            const ogles_gpgpu::ProfilerStageStats &st = r.stages[j];
+            
+            fprintf(f, "%s,%d,%d,%d,\"%s\",%d,%u,%.4f,%.4f,%.4f,", pipelineStr.c_str(), r.w, r.h, r.threads,
+                    st.name.c_str(), st.depth, st.cpu.numSamples, st.cpu.min, st.cpu.mean, st.cpu.p95);
+            
+            if (st.gpu.numSamples > 0) {
+                fprintf(f, "%.4f,%.4f,%.4f,\n", st.gpu.min, st.gpu.mean, st.gpu.p95);
+            } else {
+                fprintf(f, ",,,\n");
+            }
+        }
+    }
+}
+
+/**
+ * Write time statistics <st> as JSON object to <f>.
+ */
+static void writeJSONTimeStats(FILE *f, const ogles_gpgpu::ProfilerTimeStats &st) {
+    fprintf(f, "{\"samples\": %u, \"min_ms\": %.4f, \"mean_ms\": %.4f, \"p95_ms\": %.4f}",
+            st.numSamples, st.min, st.mean, st.p95);
+}
+
+/**
+ * Write the results <results> as JSON to <f>.
+ */
+static void writeJSON(FILE *f, const BenchConf &conf, const string &pipelineStr, const vector<BenchResult> &results) {
+    fprintf(f, "{\n");
+    fprintf(f, "  \"renderer\": \"%s\",\n", (const char *)glGetString(GL_RENDERER));
+    fprintf(f, "  \"gl_version\": \"%s\",\n", (const char *)glGetString(GL_VERSION));
+    fprintf(f, "  \"pipeline\": \"%s\",\n", pipelineStr.c_str());
+    fprintf(f, "  \"input\": \"%s\",\n", conf.inputPath ? conf.inputPath : "synthetic");
+    fprintf(f, "  \"warmup\": %d,\n  \"iterations\": %d,\n", conf.warmup, conf.iterations);
+    fprintf(f, "  \"ring_depth\": %d,\n  \"async_readback\": %s,\n", conf.ringDepth, conf.asyncReadback ? "true" : "false");
+    fprintf(f, "  \"tex_pool\": %s,\n", conf.texPool ? "true" : "false");
+    fprintf(f, "  \"shader_fusion\": %s,\n", conf.fuse ? "true" : "false");
+    fprintf(f, "  \"gl_state_cache\": %s,\n", conf.stateCache ? "true" : "false");
+    fprintf(f, "  \"vertex_buffers\": %s,\n", conf.vertexBuffers ? "true" : "false");
+    fprintf(f, "  \"packed_gray\": %s,\n", conf.packedGray ? "true" : "false");
+    fprintf(f, "  \"input_format\": \"%s\",\n", inputFormatNames[conf.inputFormat]);
+    fprintf(f, "  \"output_format\": \"%s\",\n", outputFormatNames[conf.outputFormat]);
+    if (conf.roi.w > 0) {
+        fprintf(f, "  \"roi\": [%d, %d, %d, %d],\n", conf.roi.x, conf.roi.y, conf.roi.w, conf.roi.h);
+    } else {
+        fprintf(f, "  \"roi\": null,\n");
+    }
+    fprintf(f, "  \"validation\": \"%s\",\n", validationNames[conf.validation]);
+    fprintf(f, "  \"backend\": \"%s\",\n", backendNames[conf.backend]);
+    fprintf(f, "  \"cpu_isa\": \"%s\",\n", ogles_gpgpu::CPUKernels::getInstructionSetName(conf.cpuISA));
+    fprintf(f, "  \"cpu_tiling\": %s,\n", conf.cpuTiling ? "true" : "false");
+    fprintf(f, "  \"gpu_timer_support\": %s,\n", !results.empty() && results[0].gpuTimerSupport ? "true" : "false");
+    fprintf(f, "  \"runs\": [\n");
+    
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult &r = results[i];
+        
+        fprintf(f, "    {\n");
+        fprintf(f, "      \"width\": %d, \"height\": %d, \"output_width\": %d, \"output_height\": %d,\n", r.w, r.h, r.outW, r.outH);
+        
+        if (conf.backend == ogles_gpgpu::PROCESSING_BACKEND_AUTO) {
+            fprintf(f, "      \"backend_selected\": \"%s\", \"tuning_gpu_ms\": %.4f, \"tuning_cpu_ms\": %.4f, \"tuning_stored\": %s,\n",
+                    backendNames[r.backend], r.tuning.gpuMs, r.tuning.cpuMs, r.tuning.stored ? "true" : "false");
+        }
+        
+        if (r.backend == ogles_gpgpu::PROCESSING_BACKEND_CPU) {
+            fprintf(f, "      \"threads\": %d, \"cpu_bands\": %d,\n", r.threads, r.bands);
+        }
+        
+        fprintf(f, "      \"end_to_end\": {\"min_ms\": %.4f, \"mean_ms\": %.4f, \"p50_ms\": %.4f, \"p95_ms\": %.4f, \"max_ms\": %.4f, \"fps\": %.2f},\n",
+                r.latencyMin, r.latencyMean, r.latencyP50, r.latencyP95, r.latencyMax, r.fps);
+        
+        if (conf.fuse) {
+            fprintf(f, "      \"fused_procs\": %d,\n", r.fusedProcs);
+        }
+        
+        if (conf.packedGray) {
+            fprintf(f, "      \"packed_gray_procs\": %d,\n", r.packedGrayProcs);
+        }
+        
+        fprintf(f, "      \"upload_bytes\": %d, \"input_luma_only\": %s,\n", r.uploadBytes, r.inputLumaOnly ? "true" : "false");
+        fprintf(f, "      \"readback_bytes\": %d,\n", r.readbackBytes);
+        fprintf(f, "      \"gl_calls_per_frame\": {\"issued\": %d, \"elided\": %d},\n", r.glCallsIssued, r.glCallsElided);
+        
+        if (conf.texPool) {
+            fprintf(f, "      \"tex_pool\": {\"textures\": %d, \"outputs\": %d, \"mb\": %.3f, \"unpooled_mb\": %.3f},\n",
+                    r.poolTextures, r.poolOutputs, r.poolMB, r.unpooledMB);
+        }
+        
+        fprintf(f, "      \"stages\": [\n");
+        
+        for (size_t j = 0; j < r.stages.size(); j++) {
+            const ogles_gpgpu::ProfilerStageStats &st = r.stages[j];
+            
+            fprintf(f, "        {\"name\": \"%s\", \"depth\": %d, \"cpu\": ", st.name.c_str(), st.depth);
+            writeJSONTimeStats(f, st.cpu);
+            fprintf(f, ", \"gpu\": ");
+            
+            if (st.gpu.numSamples > 0) {
+                writeJSONTimeStats(f, st.gpu);
+            } else {
+                fprintf(f, "null");
+            }
+            
+            fprintf(f, "}%s\n", j + 1 < r.stages.size() ? "," : "");
+        }
+        
+        fprintf(f, "      ]\n");
+        fprintf(f, "    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    
+    fprintf(f, "  ]\n}\n");
+}
+
+/**
+ * Print usage information.
+ */
+static void printUsage(const char *prog) {
+    fprintf(stderr, "usage: %s [--pipeline gray,thresh,adaptthresh,gauss] [--size WxH[,WxH...]] [--input file.ppm|file.png]\n"
+                    "       [--warmup n] [--iterations n] [--ring-depth n] [--async-readback] [--tex-pool] [--fuse] [--no-state-cache] [--no-vbo]\n"
+                    "       [--packed-gray] [--input-format rgba|nv12|nv21|i420] [--output-format rgba|gray8|mask1]\n"
+                    "       [--roi x,y,w,h] [--validation off|frame|call] [--backend gpu|cpu|auto] [--backend-tuning-dir dir]\n"
+                    "       [--cpu-isa scalar|sse2|avx2|neon] [--cpu-threads n[,n...]] [--no-cpu-tiling] [--format csv|json]\n"
+                    "       [--output file]\n", prog);
+}
+
+/**
+ * Parse command line arguments <argv> into <conf>. Returns false on error.
+ */
+static bool parseArgs(int argc, char *argv[], BenchConf &conf) {
+    conf.pipeline = ogles_gpgpu::Tools::split("gray,gauss,adaptthresh", ',');
+    conf.inputPath = NULL;
+    conf.warmup = 10;
+    conf.iterations = 100;
+    conf.ringDepth = 1;
+    conf.asyncReadback = false;
+    conf.texPool = false;
+    conf.fuse = false;
+    conf.stateCache = true;
+    conf.vertexBuffers = true;
+    conf.packedGray = false;
+    conf.inputFormat = 0;
+    conf.outputFormat = ogles_gpgpu::OUTPUT_FORMAT_RGBA;
+    conf.roi.x = conf.roi.y = conf.roi.w = conf.roi.h = 0;
+    conf.validation = ogles_gpgpu::Tools::getValidationLevel();    // default level of the build
+    conf.backend = ogles_gpgpu::PROCESSING_BACKEND_GPU;
+    conf.backendTuningDir = NULL;
+    conf.cpuISA = ogles_gpgpu::CPUKernels::getInstructionSet();
+    conf.cpuTiling = true;
+    conf.json = false;
+    conf.outputPath = NULL;
+    
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        bool hasVal = i + 1 < argc;
+        
+        if (arg == "--async-readback") {
+            conf.asyncReadback = true;
+        } else if (arg == "--tex-pool") {
+            conf.texPool = true;
+        } else if (arg == "--fuse") {
+            conf.fuse = true;
+        } else if (arg == "--no-state-cache") {
+            conf.stateCache = false;
+        } else if (arg == "--no-vbo") {
+            conf.vertexBuffers = false;
+        } else if (arg == "--packed-gray") {
+            conf.packedGray = true;
+        } else if (arg == "--no-cpu-tiling") {
+            conf.cpuTiling = false;
+        } else if (!hasVal) {
+            return false;
+        } else if (arg == "--pipeline") {
+            conf.pipeline = ogles_gpgpu::Tools::split(argv[++i], ',');
+        } else if (arg == "--size") {
+            vector<string> sizes = ogles_gpgpu::Tools::split(argv[++i], ',');
+            for (size_t j = 0; j < sizes.size(); j++) {
+                int w, h;
+                if (sscanf(sizes[j].c_str(), "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0) return false;
+                conf.sizes.push_back(pair<int, int>(w, h));
+            }
+        } else if (arg == "--input") {
+            conf.inputPath = argv[++i];
+        } else if (arg == "--warmup") {
+            conf.warmup = atoi(argv[++i]);
+        } else if (arg == "--iterations") {
+            conf.iterations = atoi(argv[++i]);
+        } else if (arg == "--ring-depth") {
+            conf.ringDepth = atoi(argv[++i]);
+        } else if (arg == "--validation") {
+            string level(argv[++i]);
+            int l = 0;
+            while (l < 3 && level != validationNames[l]) l++;
+            if (l == 3) return false;
+            conf.validation = (ogles_gpgpu::ValidationLevel)l;
+        } else if (arg == "--backend") {
+            string backend(argv[++i]);
+            int b = 0;
+            while (b < 3 && backend != backendNames[b]) b++;
+            if (b == 3) return false;
+            conf.backend = (ogles_gpgpu::ProcessingBackend)b;
+        } else if (arg == "--backend-tuning-dir") {
+            conf.backendTuningDir = argv[++i];
+        } else if (arg == "--cpu-isa") {
+            string isa(argv[++i]);
+            int a = 0;
+            while (a <= ogles_gpgpu::CPU_ISA_NEON && isa != ogles_gpgpu::CPUKernels::getInstructionSetName((ogles_gpgpu::CPUInstructionSet)a)) a++;
+            if (a > ogles_gpgpu::CPU_ISA_NEON) return false;
+            conf.cpuISA = (ogles_gpgpu::CPUInstructionSet)a;
+        } else if (arg == "--cpu-threads") {
+            vector<string> threads = ogles_gpgpu::Tools::split(argv[++i], ',');
+            for (size_t j = 0; j < threads.size(); j++) {
+                int n;
+                if (sscanf(threads[j].c_str(), "%d", &n) != 1 || n < 0) return false;
+                conf.cpuThreads.push_back(n);
+            }
+        } else if (arg == "--input-format") {
+            string fmt(argv[++i]);
+            int f = 0;
+            while (f < 4 && fmt != inputFormatNames[f]) f++;
+            if (f == 4) return false;
+            conf.inputFormat = f;
+        } else if (arg == "--output-format") {
+            string fmt(argv[++i]);
+            int f = 0;
+            while (f < 3 && fmt != outputFormatNames[f]) f++;
+            if (f == 3) return false;
+            conf.outputFormat = (ogles_gpgpu::OutputFormat)f;
+        } else if (arg == "--roi") {
+            ogles_gpgpu::ROI &r = conf.roi;
+            if (sscanf(argv[++i], "%d,%d,%d,%d", &r.x, &r.y, &r.w, &r.h) != 4
+                || r.x < 0 || r.y < 0 || r.w <= 0 || r.h <= 0) return false;
+        } else if (arg == "--format") {
+            string fmt(argv[++i]);
+            if (fmt != "csv" && fmt != "json") return false;
+            conf.json = (fmt == "json");
+        } else if (arg == "--output") {
+            conf.outputPath = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    
+    // the GPU backend is benchmarked once per frame size
+    if (conf.cpuThreads.empty() || conf.backend != ogles_gpgpu::PROCESSING_BACKEND_CPU) {
+        conf.cpuThreads.assign(1, 0);
+    }
+    
+    if (conf.pipeline.empty() || conf.warmup < 0 || conf.iterations <= 0
+     || conf.ringDepth < 1 || conf.ringDepth > OGLES_GPGPU_MAX_FRAME_RING_DEPTH)
+    {
+        return false;
+    }
+    
+    for (size_t i = 0; i < conf.pipeline.size(); i++) {
+        ogles_gpgpu::ProcInterface *proc = createProc(conf.pipeline[i]);
+        if (!proc) {
+            fprintf(stderr, "unknown processor '%s'\n", conf.pipeline[i].c_str());
+            return false;
+        }
+        delete proc;
+    }
+    
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    BenchConf conf;
+    
+    if (!parseArgs(argc, argv, conf)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    // get input image
+    vector<unsigned char> inputImage;
+    int inputW = 0, inputH = 0;
+    
+    if (conf.inputPath) {
+        if (!readImage(conf.inputPath, inputImage, inputW, inputH)) {
+            fprintf(stderr, "could not read image from %s\n", conf.inputPath);
+            return 1;
+        }
+        
+        if (conf.sizes.empty()) {
+            conf.sizes.push_back(pair<int, int>(inputW, inputH));
+        }
+    } else if (conf.sizes.empty()) {
+        conf.sizes.push_back(pair<int, int>(640, 480));
+        conf.sizes.push_back(pair<int, int>(1280, 720));
+        conf.sizes.push_back(pair<int, int>(1920, 1080));
+    }
+    
+    // select the CPU kernels (falls back to the scalar kernels if not supported)
+    ogles_gpgpu::CPUKernels::setInstructionSet(conf.cpuISA);
+    conf.cpuISA = ogles_gpgpu::CPUKernels::getInstructionSet();
+    
+    // set up EGL context
+    if (!ogles_gpgpu::EGL::setup()) {
+        fprintf(stderr, "EGL setup failed\n");
+        return 1;
+    }
+    
+    if (!ogles_gpgpu::EGL::getSupportsSurfaceless() && !ogles_gpgpu::EGL::createPBufferSurface(64, 64)) {
+        fprintf(stderr, "EGL pbuffer creation failed\n");
+        return 1;
+    }
+    
+    if (!ogles_gpgpu::EGL::activate()) {
+        fprintf(stderr, "EGL context activation failed\n");
+        return 1;
+    }
+    
+    fprintf(stderr, "GL renderer: %s, version: %s\n", (const char *)glGetString(GL_RENDERER), (const char *)glGetString(GL_VERSION));
+    
+    string pipelineStr;
+    for (size_t i = 0; i < conf.pipeline.size(); i++) {
+        pipelineStr += (i > 0 ? "+" : "") + conf.pipeline[i];
+    }
+    
+    vector<BenchResult> results;
+    
+    for (size_t s = 0; s < conf.sizes.size(); s++) {
+        int w = conf.sizes[s].first;
+        int h = conf.sizes[s].second;
+        
+        // create the input frames
+        vector<vector<unsigned char> > frames;
+        
+        if (conf.inputPath) {
+            frames.resize(1);
+            scaleImage(inputImage, inputW, inputH, frames[0], w, h);
+        } else {
+            frames.resize(NUM_SYNTHETIC_FRAMES);
+            for (int n = 0; n < NUM_SYNTHETIC_FRAMES; n++) {
+                genFrame(frames[n], w, h, n);
+            }
+        }
+        
+        if (conf.inputFormat > 0) {
+            for (size_t n = 0; n < frames.size(); n++) {
+                vector<unsigned char> yuv;
+                convToYUV(frames[n], w, h, inputFormats[conf.inputFormat], yuv);
+                frames[n].swap(yuv);
+            }
+        }
+        
+        for (size_t t = 0; t < conf.cpuThreads.size(); t++) {
+            fprintf(stderr, "running %s at %dx%d: %d warm-up + %d timed iterations\n",
+                    pipelineStr.c_str(), w, h, conf.warmup, conf.iterations);
+            
+            if (conf.backend == ogles_gpgpu::PROCESSING_BACKEND_CPU) {
+                fprintf(stderr, "  CPU threads: %d (0: one per core)\n", conf.cpuThreads[t]);
+            }
+            
+            BenchResult res;
+            if (!runBench(conf, frames, w, h, conf.cpuThreads[t], res)) {
+                fprintf(stderr, "benchmark at %dx%d failed\n", w, h);
+                return 1;
+            }
+            
+            fprintf(stderr, "  end-to-end latency mean %.3f ms, p95 %.3f ms, %.2f fps\n", res.latencyMean, res.latencyP95, res.fps);
+            fprintf(stderr, "  OpenGL state calls per frame: %d issued, %d elided\n", res.glCallsIssued, res.glCallsElided);
+            fprintf(stderr, "  input data per frame: %d bytes (%s%s)\n", res.uploadBytes, inputFormatNames[conf.inputFormat],
+                    res.inputLumaOnly ? ", luma only" : "");
+            fprintf(stderr, "  output data per frame: %d bytes (%s)\n", res.readbackBytes, outputFormatNames[conf.outputFormat]);
+            
+            if (conf.packedGray) {
+                fprintf(stderr, "  processors with packed grayscale output: %d\n", res.packedGrayProcs);
+            }
+            
+            for (size_t j = 0; j < res.stages.size(); j++) {
+                if (res.stages[j].name == "Core::process") {
+                    fprintf(stderr, "  Core::process CPU time per frame: mean %.3f ms, p95 %.3f ms (validation: %s)\n",
+                            res.stages[j].cpu.mean, res.stages[j].cpu.p95, validationNames[conf.validation]);
+                }
+            }
+            
+            if (conf.backend == ogles_gpgpu::PROCESSING_BACKEND_AUTO) {
+                fprintf(stderr, "  backend selection: GPU %.3f ms, CPU %.3f ms per frame (%s), using the %s backend\n",
+                        res.tuning.gpuMs, res.tuning.cpuMs, res.tuning.stored ? "stored" : "measured", backendNames[res.backend]);
+            }
+            
+            if (res.backend == ogles_gpgpu::PROCESSING_BACKEND_CPU) {
+                fprintf(stderr, "  CPU execution: %d threads, %d row bands\n", res.threads, res.bands);
+            }
+            
+            results.push_back(res);
+        }
+    }
+    
+    // speedup of each number of CPU threads over the first one
+    if (conf.cpuThreads.size() > 1) {
+        fprintf(stderr, "CPU thread scaling (throughput relative to the first number of threads):\n");
+        
+        for (size_t i = 0; i < results.size(); i++) {
+            const BenchResult &first = results[i - i % conf.cpuThreads.size()];
+            fprintf(stderr, "  %dx%d, %d threads, %d bands: %.2f fps (%.2fx)\n", results[i].w, results[i].h,
+                    results[i].threads, results[i].bands, results[i].fps, results[i].fps / first.fps);
+        }
+    }
+    
+    // write the report
+    FILE *f = conf.outputPath ? fopen(conf.outputPath, "w") : stdout;
+    
+    if (!f) {
+        fprintf(stderr, "could not open %s\n", conf.outputPath);
+        return 1;
+    }
+    
+    if (conf.json) {
+        writeJSON(f, conf, pipelineStr, results);
+    } else {
+        writeCSV(f, conf, pipelineStr, results);
+    }
+    
+    if (conf.outputPath) {
+        fclose(f);
+        fprintf(stderr, "report written to %s\n", conf.outputPath);
+    }
+    
+    ogles_gpgpu::EGL::shutdown();
+    
+    return 0;
+}
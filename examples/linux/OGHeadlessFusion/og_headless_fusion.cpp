@@ -0,0 +1,202 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Headless Linux example: processes a synthetic video stream with a pipeline that
+ * contains two chains of point operations, with and without shader fusion (see
+ * Core::setUseShaderFusion()):
+ *
+ *   input -> gray -> thresh -> gauss -> gray -> thresh
+ *            \_____________/            \_____________/
+ *               one pass                   one pass
+ *
+ * The thresholds and the grayscale conversion of the first chain change from frame
+ * to frame. The outputs of the fused configurations are compared to the outputs of
+ * the unfused configuration. The profiled configuration prints which processors
+ * were fused and the CPU and GPU times of each pipeline stage.
+ *
+ * Usage: og_headless_fusion [num. frames [width height]]
+ * Returns 1 if the outputs of the configurations differ.
+ */
+
+#include "ogles_gpgpu/ogles_gpgpu.h"
+#include "../common/og_example_tools.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Stream configuration.
+ */
+struct FusionConf {
+    const char *name;
+    bool fusion;
+    bool texPool;
+    bool profile;
+};
+
+/**
+ * Print the profiling measurements <stats>.
+ */
+static void printProfilingStats(const vector<ogles_gpgpu::ProfilerStageStats> &stats) {
+    printf("  %-48s %26s   %26s\n", "stage", "CPU min / mean / p95 [ms]", "GPU min / mean / p95 [ms]");
+    
+    for (size_t i = 0; i < stats.size(); i++) {
+        const ogles_gpgpu::ProfilerStageStats &st = stats[i];
+        printf("  %*s%-*s %8.3f / %6.3f / %6.3f", st.depth * 2, "", 48 - st.depth * 2, st.name.c_str(),
+               st.cpu.min, st.cpu.mean, st.cpu.p95);
+        
+        if (st.gpu.numSamples > 0) {
+            printf("   %8.3f / %6.3f / %6.3f\n", st.gpu.min, st.gpu.mean, st.gpu.p95);
+        } else {
+            printf("   %26s\n", "n/a");
+        }
+    }
+}
+
+/**
+ * Process the frames <frames> of size <w>x<h> with configuration <conf> and return
+ * the outputs in <outputs>. If the configuration is profiled, the measurements are
+ * returned in <stats>. The number of fused processors is returned in <numFused>.
+ */
+static double runStream(const FusionConf &conf, const vector<vector<unsigned char> > &frames, int w, int h,
+                        vector<vector<unsigned char> > &outputs, vector<ogles_gpgpu::ProfilerStageStats> &stats,
+                        int &numFused)
+{
+    ogles_gpgpu::Core *core = ogles_gpgpu::Core::getInstance();
+    ogles_gpgpu::GrayscaleProc grayscaleProc;
+    ogles_gpgpu::ThreshProc threshProc;
+    ogles_gpgpu::GaussProc gaussProc;
+    ogles_gpgpu::GrayscaleProc grayscaleProc2;
+    ogles_gpgpu::ThreshProc threshProc2;
+    
+    threshProc2.setThreshVal(0.25f);
+    
+    core->setUseShaderFusion(conf.fusion);
+    core->setUseTexPool(conf.texPool);
+    core->setProfilingEnabled(conf.profile);
+    
+    core->addProcToPipeline(&grayscaleProc);
+    core->addProcToPipeline(&threshProc);
+    core->addProcToPipeline(&gaussProc);
+    core->addProcToPipeline(&grayscaleProc2);
+    core->addProcToPipeline(&threshProc2);
+    
+    core->init();
+    core->prepare(w, h, GL_RGBA);
+    
+    numFused = core->getNumFusedProcs();
+    
+    int numFrames = (int)frames.size();
+    outputs.assign(numFrames, vector<unsigned char>(core->getOutputFrameW() * core->getOutputFrameH() * 4));
+    
+    double t = getTimeMs();
+    
+    for (int n = 0; n < numFrames; n++) {
+        // the parameters are still set via the processor objects, also if they are fused
+        grayscaleProc.setGrayscaleConvType(n % 2 == 0 ? ogles_gpgpu::GRAYSCALE_INPUT_CONVERSION_RGB
+                                                      : ogles_gpgpu::GRAYSCALE_INPUT_CONVERSION_BGR);
+        threshProc.setThreshVal(0.3f + 0.05f * (n % 5));
+        
+        core->setInputData(&frames[n][0]);
+        ogles_gpgpu::FrameHandle frame = core->process();
+        core->getOutputData(&outputs[n][0], frame);
+    }
+    
+    t = getTimeMs() - t;
+    
+    if (conf.profile) {
+        stats = core->getProfilingStats();
+    }
+    
+    ogles_gpgpu::Core::destroy();
+    
+    return t;
+}
+
+int main(int argc, char *argv[]) {
+    int numFrames = argc > 1 ? atoi(argv[1]) : 30;
+    int w = argc > 3 ? atoi(argv[2]) : 640;
+    int h = argc > 3 ? atoi(argv[3]) : 480;
+    
+    if (numFrames <= 0 || w <= 0 || h <= 0) {
+        fprintf(stderr, "usage: %s [num. frames [width height]]\n", argv[0]);
+        return 1;
+    }
+    
+    // set up EGL context
+    if (!ogles_gpgpu::EGL::setup()) {
+        fprintf(stderr, "EGL setup failed\n");
+        return 1;
+    }
+    
+    if (!ogles_gpgpu::EGL::getSupportsSurfaceless() && !ogles_gpgpu::EGL::createPBufferSurface(w, h)) {
+        fprintf(stderr, "EGL pbuffer creation failed\n");
+        return 1;
+    }
+    
+    if (!ogles_gpgpu::EGL::activate()) {
+        fprintf(stderr, "EGL context activation failed\n");
+        return 1;
+    }
+    
+    printf("GL renderer: %s, version: %s\n", (const char *)glGetString(GL_RENDERER), (const char *)glGetString(GL_VERSION));
+    
+    // generate the input stream
+    vector<vector<unsigned char> > frames(numFrames);
+    for (int n = 0; n < numFrames; n++) {
+        genFrame(frames[n], w, h, n);
+    }
+    
+    // the first configuration is the reference
+    const FusionConf confs[] = {
+        { "unfused", false, false, false },
+        { "fused", true, false, false },
+        { "fused, texture pool", true, true, false },
+        { "fused, profiled", true, false, true }
+    };
+    const int numConfs = sizeof(confs) / sizeof(FusionConf);
+    
+    vector<vector<unsigned char> > refOutputs;
+    bool allEqual = true;
+    
+    printf("processing %d frames of size %dx%d\n", numFrames, w, h);
+    
+    for (int i = 0; i < numConfs; i++) {
+        vector<vector<unsigned char> > outputs;
+        vector<ogles_gpgpu::ProfilerStageStats> stats;
+        int numFused = 0;
+        double t = runStream(confs[i], frames, w, h, outputs, stats, numFused);
+        
+        int numDiff = 0;
+        if (i == 0) {
+            refOutputs = outputs;
+        } else {
+            for (int n = 0; n < numFrames; n++) {
+                if (outputs[n] != refOutputs[n]) numDiff++;
+            }
+        }
+        
+        printf("%-30s %8.3f ms per frame, %d processors fused, %d frames differ from reference\n",
+               confs[i].name, t / numFrames, numFused, numDiff);
+        
+        if (confs[i].profile) {
+            printProfilingStats(stats);
+        }
+        
+        allEqual = allEqual && numDiff == 0 && (numFused > 0) == confs[i].fusion;
+    }
+    
+    ogles_gpgpu::EGL::shutdown();
+    
+    return allEqual ? 0 : 1;
+}
@@ -0,0 +1,269 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Headless Linux example: processes a synthetic video stream with a branching
+ * pipeline. The grayscale output feeds a Gaussian blur branch and a thresholding
+ * branch. The branches are merged by a difference processor (gray - blurred
+ * gray) and by a blending processor (blurred gray and threshold image):
+ *
+ *   input -> gray -+-> gauss -+-> diff(gray, gauss)
+ *                  |          +-> blend(gauss, thresh)
+ *                  +-> thresh ----^
+ *
+ * The output of each processor is read back. The branch outputs are compared to
+ * the outputs of separate linear pipelines (which upload the frames and calculate
+ * the grayscale image once per branch) and the merged outputs are compared to
+ * a CPU calculation. Finally, the graph is run with the output texture pool, keeping
+ * only the merged outputs, which are compared to the outputs without pool.
+ *
+ * Usage: og_headless_graph [num. frames [width height]]
+ * Returns 1 if an output is not as expected.
+ */
+
+#include "ogles_gpgpu/ogles_gpgpu.h"
+#include "../common/og_example_tools.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+
+#define RING_DEPTH      2
+#define MAX_CPU_DIFF    2   // max. difference between GPU and CPU calculation per channel
+
+typedef vector<vector<unsigned char> > FrameList;
+
+/**
+ * Submit all frames <frames> of size <w>x<h> to the prepared pipeline of <core> and
+ * read the output of each processor in <procs> into <outputs> (one frame list per
+ * processor). The output of frame n is read after frame n + 1 was submitted.
+ * Returns the time in ms.
+ */
+static double runFrames(ogles_gpgpu::Core *core, const FrameList &frames,
+                        const vector<ogles_gpgpu::ProcInterface *> &procs, vector<FrameList> &outputs)
+{
+    int numFrames = (int)frames.size();
+    vector<ogles_gpgpu::FrameHandle> handles(numFrames);
+    
+    outputs.resize(procs.size());
+    for (size_t p = 0; p < procs.size(); p++) {
+        size_t outSize = procs[p]->getOutFrameW() * procs[p]->getOutFrameH() * 4;
+        outputs[p].assign(numFrames, vector<unsigned char>(outSize));
+    }
+    
+    double t = getTimeMs();
+    
+    for (int n = 0; n < numFrames + RING_DEPTH - 1; n++) {
+        if (n < numFrames) {    // submit frame n
+            core->setInputData(&frames[n][0]);
+            handles[n] = core->process();
+        }
+        
+        int readN = n - (RING_DEPTH - 1);
+        if (readN >= 0 && readN < numFrames) {    // read back an older frame
+            for (size_t p = 0; p < procs.size(); p++) {
+                core->getOutputData(procs[p], &outputs[p][readN][0], handles[readN]);
+            }
+        }
+    }
+    
+    return getTimeMs() - t;
+}
+
+/**
+ * Set up the branching pipeline on <core> with the processors <procs> (gray, gauss,
+ * thresh, diff, blend) for input frames of size <w>x<h>. If <texPool> is true, the
+ * output texture pool is used and only the outputs of diff and blend are kept.
+ */
+static void prepareGraph(ogles_gpgpu::Core *core, const vector<ogles_gpgpu::ProcInterface *> &procs, int w, int h, bool texPool) {
+    core->setFrameRingDepth(RING_DEPTH);
+    core->setUseTexPool(texPool);
+    
+    core->addProcToPipeline(procs[0]);
+    core->addProcToPipeline(procs[1], procs[0]);
+    core->addProcToPipeline(procs[2], procs[0]);
+    core->addProcToPipeline(procs[3], procs[0], procs[1]);
+    core->addProcToPipeline(procs[4], procs[1], procs[2]);
+    
+    core->setKeepOutput(procs[3]);
+    
+    core->init();
+    core->prepare(w, h, GL_RGBA);
+}
+
+/**
+ * Run a linear pipeline of grayscale processing and processor <branchProc> on
+ * frames <frames> of size <w>x<h> and return its outputs in <outputs>.
+ */
+static void runLinear(ogles_gpgpu::ProcInterface *branchProc, const FrameList &frames, int w, int h, FrameList &outputs) {
+    ogles_gpgpu::Core *core = ogles_gpgpu::Core::getInstance();
+    ogles_gpgpu::GrayscaleProc grayscaleProc;
+    
+    core->setFrameRingDepth(RING_DEPTH);
+    core->addProcToPipeline(&grayscaleProc);
+    core->addProcToPipeline(branchProc);
+    
+    core->init();
+    core->prepare(w, h, GL_RGBA);
+    
+    vector<ogles_gpgpu::ProcInterface *> procs(1, branchProc);
+    vector<FrameList> procOutputs;
+    runFrames(core, frames, procs, procOutputs);
+    outputs = procOutputs[0];
+    
+    ogles_gpgpu::Core::destroy();
+}
+
+/**
+ * Count the frames in <a> that differ from <b> by more than <maxDiff> in any channel.
+ */
+static int countDifferentFrames(const FrameList &a, const FrameList &b, int maxDiff) {
+    int numDiff = 0;
+    
+    for (size_t n = 0; n < a.size(); n++) {
+        for (size_t i = 0; i < a[n].size(); i++) {
+            if (abs((int)a[n][i] - (int)b[n][i]) > maxDiff) {
+                numDiff++;
+                break;
+            }
+        }
+    }
+    
+    return numDiff;
+}
+
+int main(int argc, char *argv[]) {
+    int numFrames = argc > 1 ? atoi(argv[1]) : 10;
+    int w = argc > 3 ? atoi(argv[2]) : 640;
+    int h = argc > 3 ? atoi(argv[3]) : 480;
+    
+    if (numFrames <= 0 || w <= 0 || h <= 0) {
+        fprintf(stderr, "usage: %s [num. frames [width height]]\n", argv[0]);
+        return 1;
+    }
+    
+    // set up EGL context
+    if (!ogles_gpgpu::EGL::setup()) {
+        fprintf(stderr, "EGL setup failed\n");
+        return 1;
+    }
+    
+    if (!ogles_gpgpu::EGL::getSupportsSurfaceless() && !ogles_gpgpu::EGL::createPBufferSurface(w, h)) {
+        fprintf(stderr, "EGL pbuffer creation failed\n");
+        return 1;
+    }
+    
+    if (!ogles_gpgpu::EGL::activate()) {
+        fprintf(stderr, "EGL context activation failed\n");
+        return 1;
+    }
+    
+    printf("GL renderer: %s, version: %s\n", (const char *)glGetString(GL_RENDERER), (const char *)glGetString(GL_VERSION));
+    
+    // generate the input stream
+    FrameList frames(numFrames);
+    for (int n = 0; n < numFrames; n++) {
+        genFrame(frames[n], w, h, n);
+    }
+    
+    printf("processing %d frames of size %dx%d\n", numFrames, w, h);
+    
+    // run the branching pipeline
+    ogles_gpgpu::Core *core = ogles_gpgpu::Core::getInstance();
+    ogles_gpgpu::GrayscaleProc grayscaleProc;
+    ogles_gpgpu::GaussProc gaussProc;
+    ogles_gpgpu::ThreshProc threshProc;
+    ogles_gpgpu::DiffProc diffProc;
+    ogles_gpgpu::BlendProc blendProc;
+    
+    vector<ogles_gpgpu::ProcInterface *> procs;
+    procs.push_back(&grayscaleProc);
+    procs.push_back(&gaussProc);
+    procs.push_back(&threshProc);
+    procs.push_back(&diffProc);
+    procs.push_back(&blendProc);
+    
+    prepareGraph(core, procs, w, h, false);
+    
+    vector<FrameList> outputs;
+    double tGraph = runFrames(core, frames, procs, outputs);
+    
+    printf("branching pipeline: %.3f ms per frame (reading 5 outputs per frame)\n", tGraph / numFrames);
+    
+    ogles_gpgpu::Core::destroy();
+    
+    const FrameList &grayOut = outputs[0];
+    const FrameList &gaussOut = outputs[1];
+    const FrameList &threshOut = outputs[2];
+    const FrameList &diffOut = outputs[3];
+    const FrameList &blendOut = outputs[4];
+    
+    // run each branch as separate linear pipeline
+    ogles_gpgpu::GaussProc refGaussProc;
+    ogles_gpgpu::ThreshProc refThreshProc;
+    FrameList refGaussOut, refThreshOut;
+    runLinear(&refGaussProc, frames, w, h, refGaussOut);
+    runLinear(&refThreshProc, frames, w, h, refThreshOut);
+    
+    // calculate the merged outputs on the CPU
+    FrameList cpuDiffOut(grayOut), cpuBlendOut(grayOut);
+    for (int n = 0; n < numFrames; n++) {
+        for (size_t i = 0; i < grayOut[n].size(); i += 4) {
+            for (int c = 0; c < 3; c++) {
+                cpuDiffOut[n][i + c] = (unsigned char)abs((int)grayOut[n][i + c] - (int)gaussOut[n][i + c]);
+                cpuBlendOut[n][i + c] = (unsigned char)(((int)gaussOut[n][i + c] + (int)threshOut[n][i + c] + 1) / 2);
+            }
+        }
+    }
+    
+    // run the graph with the texture pool and read only the kept outputs
+    ogles_gpgpu::GrayscaleProc poolGrayscaleProc;
+    ogles_gpgpu::GaussProc poolGaussProc;
+    ogles_gpgpu::ThreshProc poolThreshProc;
+    ogles_gpgpu::DiffProc poolDiffProc;
+    ogles_gpgpu::BlendProc poolBlendProc;
+    
+    vector<ogles_gpgpu::ProcInterface *> poolProcs;
+    poolProcs.push_back(&poolGrayscaleProc);
+    poolProcs.push_back(&poolGaussProc);
+    poolProcs.push_back(&poolThreshProc);
+    poolProcs.push_back(&poolDiffProc);
+    poolProcs.push_back(&poolBlendProc);
+    
+    core = ogles_gpgpu::Core::getInstance();
+    prepareGraph(core, poolProcs, w, h, true);
+    
+    const ogles_gpgpu::TexPool *pool = core->getTexPool();
+    printf("texture pool: %d textures for %d intermediate outputs\n", pool->getNumTextures(), pool->getNumRequests());
+    
+    vector<ogles_gpgpu::ProcInterface *> keptProcs(poolProcs.begin() + 3, poolProcs.end());
+    vector<FrameList> poolOutputs;
+    runFrames(core, frames, keptProcs, poolOutputs);
+    
+    ogles_gpgpu::Core::destroy();
+    
+    // compare
+    int numGaussDiff = countDifferentFrames(gaussOut, refGaussOut, 0);
+    int numThreshDiff = countDifferentFrames(threshOut, refThreshOut, 0);
+    int numDiffDiff = countDifferentFrames(diffOut, cpuDiffOut, MAX_CPU_DIFF);
+    int numBlendDiff = countDifferentFrames(blendOut, cpuBlendOut, MAX_CPU_DIFF);
+    
+    printf("gauss branch:  %d frames differ from linear pipeline\n", numGaussDiff);
+    printf("thresh branch: %d frames differ from linear pipeline\n", numThreshDiff);
+    printf("diff merge:    %d frames differ from CPU calculation\n", numDiffDiff);
+    printf("blend merge:   %d frames differ from CPU calculation\n", numBlendDiff);
+    
+    int numPoolDiff = countDifferentFrames(poolOutputs[0], diffOut, 0) + countDifferentFrames(poolOutputs[1], blendOut, 0);
+    
+    printf("texture pool:  %d frames differ from graph without pool\n", numPoolDiff);
+    
+    return numGaussDiff + numThreshDiff + numDiffDiff + numBlendDiff + numPoolDiff > 0 ? 1 : 0;
+}
@@ -0,0 +1,171 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0 
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015 
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Headless Linux example: performs GPU-powered adaptive thresholding on a still image
+ * using a surfaceless EGL context (works with Mesa's software rasterizer).
+ *
+ * Usage: og_headless_still_image [input.ppm [output.ppm]]
+ * Without input image, a synthetic test image is generated.
+ */
+
+#include "ogles_gpgpu/ogles_gpgpu.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Read a binary PPM (P6) image from <path> into RGBA buffer <rgba>.
+ */
+static bool readPPM(const char *path, vector<unsigned char> &rgba, int &w, int &h) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    
+    int maxVal;
+    if (fscanf(f, "P6 %d %d %d", &w, &h, &maxVal) != 3 || maxVal != 255 || fgetc(f) == EOF) {
+        fclose(f);
+        return false;
+    }
+    
+    vector<unsigned char> rgb(w * h * 3);
+    bool ok = fread(&rgb[0], 1, rgb.size(), f) == rgb.size();
+    fclose(f);
+    
+    rgba.resize(w * h * 4);
+    for (int i = 0; i < w * h; i++) {
+        rgba[i * 4    ] = rgb[i * 3    ];
+        rgba[i * 4 + 1] = rgb[i * 3 + 1];
+        rgba[i * 4 + 2] = rgb[i * 3 + 2];
+        rgba[i * 4 + 3] = 255;
+    }
+    
+    return ok;
+}
+
+/**
+ * Write RGBA buffer <rgba> as binary PPM (P6) image to <path>.
+ */
+static bool writePPM(const char *path, const unsigned char *rgba, int w, int h) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    
+    fprintf(f, "P6\n%d %d\n255\n", w, h);
+    for (int i = 0; i < w * h; i++) {
+        fwrite(&rgba[i * 4], 1, 3, f);
+    }
+    
+    fclose(f);
+    
+    return true;
+}
+
+/**
+ * Generate a synthetic RGBA test image of size <w>x<h> (gradient with some circles).
+ */
+static void genTestImage(vector<unsigned char> &rgba, int w, int h) {
+    rgba.resize(w * h * 4);
+    
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            unsigned char *px = &rgba[(y * w + x) * 4];
+            int dx = (x % 128) - 64;
+            int dy = (y % 128) - 64;
+            bool inCircle = dx * dx + dy * dy < 40 * 40;
+            unsigned char bg = (unsigned char)(255 * x / w);
+            
+            px[0] = inCircle ? 20 : bg;
+            px[1] = inCircle ? 30 : (unsigned char)(255 * y / h);
+            px[2] = inCircle ? 40 : bg;
+            px[3] = 255;
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const char *inPath = argc > 1 ? argv[1] : NULL;
+    const char *outPath = argc > 2 ? argv[2] : "og_headless_output.ppm";
+    
+    // get input image
+    vector<unsigned char> inputData;
+    int inW = 1024, inH = 768;
+    
+    if (inPath) {
+        if (!readPPM(inPath, inputData, inW, inH)) {
+            fprintf(stderr, "could not read PPM image from %s\n", inPath);
+            return 1;
+        }
+    } else {
+        genTestImage(inputData, inW, inH);
+    }
+    
+    // set up EGL context
+    if (!ogles_gpgpu::EGL::setup()) {
+        fprintf(stderr, "EGL setup failed\n");
+        return 1;
+    }
+    
+    if (!ogles_gpgpu::EGL::getSupportsSurfaceless() && !ogles_gpgpu::EGL::createPBufferSurface(inW, inH)) {
+        fprintf(stderr, "EGL pbuffer creation failed\n");
+        return 1;
+    }
+    
+    if (!ogles_gpgpu::EGL::activate()) {
+        fprintf(stderr, "EGL context activation failed\n");
+        return 1;
+    }
+    
+    printf("GL renderer: %s\n", (const char *)glGetString(GL_RENDERER));
+    
+    // set up the pipeline
+    ogles_gpgpu::Core *core = ogles_gpgpu::Core::getInstance();
+    ogles_gpgpu::GrayscaleProc grayscaleProc;
+    ogles_gpgpu::AdaptThreshProc adaptThreshProc;
+    
+    grayscaleProc.setOutputSize(0.5f);
+    
+    core->addProcToPipeline(&grayscaleProc);
+    core->addProcToPipeline(&adaptThreshProc);
+    
+    core->init();
+    core->prepare(inW, inH, GL_RGBA);
+    
+    // run the pipeline. processing is asynchronous, so we could do other work
+    // until the frame is done
+    core->setInputData(&inputData[0]);
+    ogles_gpgpu::FrameHandle frame = core->process();
+    
+    vector<unsigned char> outputData(core->getOutputFrameW() * core->getOutputFrameH() * 4);
+    
+    core->waitForFrame(frame);
+    core->getOutputData(&outputData[0]);
+    
+#ifdef OGLES_GPGPU_BENCHMARK
+    vector<double> t = core->getTimeMeasurements();
+    if (t.size() >= 3) {
+        printf("time measurements (input, processing, output): %f ms, %f ms, %f ms\n", t[0], t[1], t[2]);
+    }
+#endif
+    
+    printf("input size %dx%d, output size %dx%d\n",
+           inW, inH, core->getOutputFrameW(), core->getOutputFrameH());
+    
+    if (writePPM(outPath, &outputData[0], core->getOutputFrameW(), core->getOutputFrameH())) {
+        printf("output written to %s\n", outPath);
+    }
+    
+    // cleanup
+    ogles_gpgpu::Core::destroy();
+    ogles_gpgpu::EGL::shutdown();
+    
+    return 0;
+}
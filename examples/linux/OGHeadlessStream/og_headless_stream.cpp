@@ -0,0 +1,219 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Headless Linux example: processes a synthetic video stream with different
+ * frame ring depths, with/without asynchronous readback (pixel pack buffers
+ * on OpenGL ES 3.0 contexts) and with/without the output texture pool. The output
+ * of each frame is compared to the output of the blocking configuration, so this
+ * program also validates the asynchronous and pooled code paths (e.g. on Mesa
+ * without any phone).
+ * The last configuration is profiled and prints the CPU and GPU times of each
+ * pipeline stage. Its timeline is written to og_headless_stream_trace.json, which
+ * can be opened in chrome://tracing or in the Perfetto UI.
+ *
+ * Usage: og_headless_stream [num. frames [width height]]
+ * Returns 1 if the outputs of the configurations differ.
+ */
+
+#include "ogles_gpgpu/ogles_gpgpu.h"
+#include "../common/og_example_tools.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+
+#define TRACE_FILE "og_headless_stream_trace.json"
+
+/**
+ * Stream configuration.
+ */
+struct StreamConf {
+    const char *name;
+    int ringDepth;
+    bool asyncReadback;
+    bool texPool;
+    bool profile;
+};
+
+/**
+ * Print the profiling measurements <stats>.
+ */
+static void printProfilingStats(const vector<ogles_gpgpu::ProfilerStageStats> &stats) {
+    printf("  %-40s %26s   %26s\n", "stage", "CPU min / mean / p95 [ms]", "GPU min / mean / p95 [ms]");
+    
+    for (size_t i = 0; i < stats.size(); i++) {
+        const ogles_gpgpu::ProfilerStageStats &st = stats[i];
+        printf("  %*s%-*s %8.3f / %6.3f / %6.3f", st.depth * 2, "", 40 - st.depth * 2, st.name.c_str(),
+               st.cpu.min, st.cpu.mean, st.cpu.p95);
+        
+        if (st.gpu.numSamples > 0) {
+            printf("   %8.3f / %6.3f / %6.3f\n", st.gpu.min, st.gpu.mean, st.gpu.p95);
+        } else {
+            printf("   %26s\n", "n/a");
+        }
+    }
+}
+
+/**
+ * Process the frames <frames> of size <w>x<h> with configuration <conf> and return
+ * the outputs in <outputs>. The output of frame n is read while frame n + 1 (up to
+ * n + ring depth - 1) is already submitted. If the configuration is profiled, the
+ * measurements are returned in <stats>.
+ */
+static double runStream(const StreamConf &conf, const vector<vector<unsigned char> > &frames, int w, int h,
+                        vector<vector<unsigned char> > &outputs, vector<ogles_gpgpu::ProfilerStageStats> &stats)
+{
+    ogles_gpgpu::Core *core = ogles_gpgpu::Core::getInstance();
+    ogles_gpgpu::GrayscaleProc grayscaleProc;
+    ogles_gpgpu::GaussProc gaussProc;
+    ogles_gpgpu::ThreshProc threshProc;
+    
+    core->setFrameRingDepth(conf.ringDepth);
+    core->setUseAsyncReadback(conf.asyncReadback);
+    core->setUseTexPool(conf.texPool);
+    core->setProfilingEnabled(conf.profile);
+    
+    core->addProcToPipeline(&grayscaleProc);
+    core->addProcToPipeline(&gaussProc);
+    core->addProcToPipeline(&threshProc);
+    
+    core->init();
+    core->prepare(w, h, GL_RGBA);
+    
+    if (conf.texPool) {
+        const ogles_gpgpu::TexPool *pool = core->getTexPool();
+        printf("texture pool: %d textures (%.2f MB) for %d intermediate outputs (%.2f MB without pool)\n",
+               pool->getNumTextures(), pool->getMemSize() / (1024.0 * 1024.0), pool->getNumRequests(),
+               pool->getRequestedMemSize() * conf.ringDepth / (1024.0 * 1024.0));
+    }
+    
+    int numFrames = (int)frames.size();
+    int inFlight = conf.asyncReadback ? max(conf.ringDepth, 2) : conf.ringDepth;
+    size_t outSize = core->getOutputFrameW() * core->getOutputFrameH() * 4;
+    
+    vector<ogles_gpgpu::FrameHandle> handles(numFrames);
+    outputs.assign(numFrames, vector<unsigned char>(outSize));
+    
+    if (conf.profile) {
+        core->startTracing();
+    }
+    
+    double t = getTimeMs();
+    
+    for (int n = 0; n < numFrames + inFlight - 1; n++) {
+        if (n < numFrames) {    // submit frame n
+            core->setInputData(&frames[n][0]);
+            handles[n] = core->process();
+        }
+        
+        int readN = n - (inFlight - 1);
+        if (readN >= 0 && readN < numFrames) {    // read back an older frame
+            core->getOutputData(&outputs[readN][0], handles[readN]);
+        }
+    }
+    
+    t = getTimeMs() - t;
+    
+    if (conf.profile) {
+        core->stopTracing();
+        stats = core->getProfilingStats();
+        
+        if (core->writeTrace(TRACE_FILE)) {
+            printf("trace with %d events written to %s\n", (int)core->getTraceRecorder()->getNumEvents(), TRACE_FILE);
+        }
+    }
+    
+    ogles_gpgpu::Core::destroy();
+    
+    return t;
+}
+
+int main(int argc, char *argv[]) {
+    int numFrames = argc > 1 ? atoi(argv[1]) : 30;
+    int w = argc > 3 ? atoi(argv[2]) : 640;
+    int h = argc > 3 ? atoi(argv[3]) : 480;
+    
+    if (numFrames <= 0 || w <= 0 || h <= 0) {
+        fprintf(stderr, "usage: %s [num. frames [width height]]\n", argv[0]);
+        return 1;
+    }
+    
+    // set up EGL context
+    if (!ogles_gpgpu::EGL::setup()) {
+        fprintf(stderr, "EGL setup failed\n");
+        return 1;
+    }
+    
+    if (!ogles_gpgpu::EGL::getSupportsSurfaceless() && !ogles_gpgpu::EGL::createPBufferSurface(w, h)) {
+        fprintf(stderr, "EGL pbuffer creation failed\n");
+        return 1;
+    }
+    
+    if (!ogles_gpgpu::EGL::activate()) {
+        fprintf(stderr, "EGL context activation failed\n");
+        return 1;
+    }
+    
+    printf("GL renderer: %s, version: %s\n", (const char *)glGetString(GL_RENDERER), (const char *)glGetString(GL_VERSION));
+    
+    // generate the input stream
+    vector<vector<unsigned char> > frames(numFrames);
+    for (int n = 0; n < numFrames; n++) {
+        genFrame(frames[n], w, h, n);
+    }
+    
+    // the first configuration is the reference
+    const StreamConf confs[] = {
+        { "blocking, ring depth 1", 1, false, false, false },
+        { "blocking, ring depth 2", 2, false, false, false },
+        { "async readback, ring depth 1", 1, true, false, false },
+        { "async readback, ring depth 2", 2, true, false, false },
+        { "async readback, ring depth 3", 3, true, false, false },
+        { "texture pool, ring depth 1", 1, false, true, false },
+        { "texture pool, ring depth 3", 3, true, true, false },
+        { "profiled, ring depth 2", 2, true, false, true }
+    };
+    const int numConfs = sizeof(confs) / sizeof(StreamConf);
+    
+    vector<vector<unsigned char> > refOutputs;
+    bool allEqual = true;
+    
+    printf("processing %d frames of size %dx%d\n", numFrames, w, h);
+    
+    for (int i = 0; i < numConfs; i++) {
+        vector<vector<unsigned char> > outputs;
+        vector<ogles_gpgpu::ProfilerStageStats> stats;
+        double t = runStream(confs[i], frames, w, h, outputs, stats);
+        
+        int numDiff = 0;
+        if (i == 0) {
+            refOutputs = outputs;
+        } else {
+            for (int n = 0; n < numFrames; n++) {
+                if (outputs[n] != refOutputs[n]) numDiff++;
+            }
+        }
+        
+        printf("%-30s %8.3f ms per frame, %d frames differ from reference\n",
+               confs[i].name, t / numFrames, numDiff);
+        
+        if (confs[i].profile) {
+            printProfilingStats(stats);
+        }
+        
+        allEqual = allEqual && numDiff == 0;
+    }
+    
+    ogles_gpgpu::EGL::shutdown();
+    
+    return allEqual ? 0 : 1;
+}
@@ -0,0 +1,254 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Headless Linux microbenchmark of the CPU kernels: measures each kernel of the CPU
+ * backend (grayscale conversion, thresholding, Gauss filter passes and adaptive
+ * thresholding passes) with the scalar and each vectorized instruction set that the
+ * CPU supports and checks that all instruction sets produce the same output. Then
+ * measures two pipelines end-to-end (setInputData(), process() and getOutputData())
+ * with the GPU backend and the CPU backend with scalar and the best vectorized kernels.
+ *
+ * Usage: og_kernel_bench [num. iterations]
+ */
+
+#include "ogles_gpgpu/ogles_gpgpu.h"
+#include "ogles_gpgpu/common/cpu/cpukernels.h"
+#include "../common/og_example_tools.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+#define NUM_KERNELS     6
+#define NUM_PIPELINES   2
+
+static const char *kernelNames[NUM_KERNELS] = {
+    "grayscale", "thresh", "gauss (horiz.)", "gauss (vert.)", "adapt. thresh avg", "adapt. thresh"
+};
+
+static const char *pipelineNames[NUM_PIPELINES] = {
+    "gray,thresh", "gray,gauss,adaptthresh"
+};
+
+/**
+ * Run kernel <k> on <src> (and the intermediate image <avg> for the second adaptive
+ * thresholding pass) to <dst>.
+ */
+static void runKernel(int k, const CPUImage &src, const CPUImage &avg, CPUImage &dst) {
+    static const float convVec[3] = { 0.299f, 0.587f, 0.114f };
+    
+    switch (k) {
+        case 0:
+            CPUKernels::grayscale(src, dst, convVec);
+            break;
+        case 1:
+            CPUKernels::thresh(src, dst, 0.5f);
+            break;
+        case 2:
+            CPUKernels::gauss(src, dst, false);
+            break;
+        case 3:
+            CPUKernels::gauss(src, dst, true);
+            break;
+        case 4:
+            CPUKernels::adaptThreshAvg(src, dst);
+            break;
+        default:
+            CPUKernels::adaptThresh(avg, dst);
+            break;
+    }
+}
+
+/**
+ * Run pipeline <p> with backend <backend> on <numIterations> frames of size <w>x<h>
+ * from <frame>. Returns the mean time per frame in ms and the output data of the
+ * last frame in <output>.
+ */
+static double runPipeline(int p, ProcessingBackend backend, int w, int h, const vector<unsigned char> &frame,
+                          int numIterations, vector<unsigned char> &output)
+{
+    GrayscaleProc grayProc;
+    ThreshProc threshProc;
+    GaussProc gaussProc;
+    AdaptThreshProc adaptThreshProc;
+    
+    Core *core = new Core();
+    core->setBackend(backend);
+    
+    core->addProcToPipeline(&grayProc);
+    
+    if (p == 0) {
+        core->addProcToPipeline(&threshProc);
+    } else {
+        core->addProcToPipeline(&gaussProc);
+        core->addProcToPipeline(&adaptThreshProc);
+    }
+    
+    core->init();
+    core->prepare(w, h, GL_RGBA);
+    
+    output.resize(core->getOutputDataSize());
+    
+    // warm-up frame
+    core->setInputData(&frame[0]);
+    core->process();
+    core->getOutputData(&output[0]);
+    
+    double t = getTimeMs();
+    
+    for (int i = 0; i < numIterations; i++) {
+        core->setInputData(&frame[0]);
+        core->process();
+        core->getOutputData(&output[0]);
+    }
+    
+    t = (getTimeMs() - t) / numIterations;
+    
+    delete core;
+    
+    return t;
+}
+
+int main(int argc, char *argv[]) {
+    int numIterations = argc > 1 ? atoi(argv[1]) : 20;
+    
+    if (numIterations <= 0) {
+        fprintf(stderr, "usage: %s [num. iterations]\n", argv[0]);
+        return 1;
+    }
+    
+    // instruction sets to compare
+    vector<CPUInstructionSet> isas;
+    for (int isa = CPU_ISA_SCALAR; isa <= CPU_ISA_NEON; isa++) {
+        if (CPUKernels::getInstructionSetSupport((CPUInstructionSet)isa)) {
+            isas.push_back((CPUInstructionSet)isa);
+        }
+    }
+    
+    CPUInstructionSet bestISA = CPUKernels::getInstructionSet();
+    
+    // the GPU pipelines are skipped without an OpenGL context
+    bool haveGPU = ogles_gpgpu::EGL::setup()
+        && (ogles_gpgpu::EGL::getSupportsSurfaceless() || ogles_gpgpu::EGL::createPBufferSurface(64, 64))
+        && ogles_gpgpu::EGL::activate();
+    
+    if (haveGPU) {
+        printf("GL renderer: %s, version: %s\n", (const char *)glGetString(GL_RENDERER), (const char *)glGetString(GL_VERSION));
+    } else {
+        printf("no OpenGL context, skipping the GPU backend\n");
+    }
+    
+    printf("%d iterations per measurement, mean time per call / frame in ms (speedup over scalar):\n", numIterations);
+    
+    const int sizes[][2] = { { 320, 240 }, { 640, 480 }, { 1280, 720 }, { 1920, 1080 } };
+    int numMismatches = 0;
+    
+    for (int s = 0; s < 4; s++) {
+        int w = sizes[s][0];
+        int h = sizes[s][1];
+        
+        // synthetic input frame with noise
+        vector<unsigned char> frame(w * h * 4);
+        srand(s);
+        for (size_t i = 0; i < frame.size(); i++) {
+            frame[i] = (unsigned char)((((i / 4) % w) + (i / 4 / w) * 3 + rand() % 64) & 0xFF);
+        }
+        
+        CPUImage src, avg;
+        src.resize(w, h);
+        avg.resize(w, h);
+        memcpy(src.getData(), &frame[0], frame.size());
+        CPUKernels::adaptThreshAvg(src, avg);
+        
+        printf("%dx%d:\n", w, h);
+        printf("  %-24s", "kernel");
+        for (size_t i = 0; i < isas.size(); i++) {
+            printf(" %18s", CPUKernels::getInstructionSetName(isas[i]));
+        }
+        printf("\n");
+        
+        // kernels with each instruction set
+        for (int k = 0; k < NUM_KERNELS; k++) {
+            CPUImage ref, dst;
+            ref.resize(w, h);
+            dst.resize(w, h);
+            
+            printf("  %-24s", kernelNames[k]);
+            
+            double scalarMs = 0.0;
+            
+            for (size_t i = 0; i < isas.size(); i++) {
+                CPUKernels::setInstructionSet(isas[i]);
+                runKernel(k, src, avg, dst);    // warm-up
+                
+                double t = getTimeMs();
+                for (int n = 0; n < numIterations; n++) {
+                    runKernel(k, src, avg, dst);
+                }
+                t = (getTimeMs() - t) / numIterations;
+                
+                if (i == 0) {
+                    scalarMs = t;
+                    memcpy(ref.getData(), dst.getData(), dst.getDataSize());
+                } else if (memcmp(ref.getData(), dst.getData(), dst.getDataSize()) != 0) {
+                    fprintf(stderr, "%s with %s differs from scalar kernel at %dx%d\n", kernelNames[k],
+                            CPUKernels::getInstructionSetName(isas[i]), w, h);
+                    numMismatches++;
+                }
+                
+                printf(" %8.3f (%5.2fx)", t, scalarMs / t);
+            }
+            
+            printf("\n");
+        }
+        
+        // pipelines end-to-end
+        for (int p = 0; p < NUM_PIPELINES; p++) {
+            vector<unsigned char> scalarOutput, simdOutput, gpuOutput;
+            
+            CPUKernels::setInstructionSet(CPU_ISA_SCALAR);
+            double scalarMs = runPipeline(p, PROCESSING_BACKEND_CPU, w, h, frame, numIterations, scalarOutput);
+            
+            CPUKernels::setInstructionSet(bestISA);
+            double simdMs = runPipeline(p, PROCESSING_BACKEND_CPU, w, h, frame, numIterations, simdOutput);
+            
+            if (simdOutput != scalarOutput) {
+                fprintf(stderr, "pipeline %s with %s differs from scalar kernels at %dx%d\n", pipelineNames[p],
+                        CPUKernels::getInstructionSetName(bestISA), w, h);
+                numMismatches++;
+            }
+            
+            printf("  pipeline %-24s cpu scalar %8.3f, cpu %s %8.3f (%5.2fx)", pipelineNames[p], scalarMs,
+                   CPUKernels::getInstructionSetName(bestISA), simdMs, scalarMs / simdMs);
+            
+            if (haveGPU) {
+                double gpuMs = runPipeline(p, PROCESSING_BACKEND_GPU, w, h, frame, numIterations, gpuOutput);
+                printf(", gpu %8.3f (%5.2fx)", gpuMs, scalarMs / gpuMs);
+            }
+            
+            printf("\n");
+        }
+    }
+    
+    if (haveGPU) {
+        ogles_gpgpu::EGL::shutdown();
+    }
+    
+    if (numMismatches > 0) {
+        fprintf(stderr, "%d outputs of the vectorized kernels differ from the scalar kernels\n", numMismatches);
+        return 1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,214 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Headless Linux example: runs two independent ogles_gpgpu::Core objects with
+ * different pipelines concurrently in two threads. Each thread has its own EGL
+ * context. The outputs are compared to the outputs of the same pipelines run one
+ * after another in the main thread.
+ *
+ *   thread 0: input -> gray -> gauss
+ *   thread 1: input -> gray -> adaptive thresholding
+ *
+ * Needs an EGL implementation that supports surfaceless contexts.
+ *
+ * Usage: og_multi_core [num. frames [width height]]
+ * Returns 1 if an output is not as expected.
+ */
+
+#include "ogles_gpgpu/ogles_gpgpu.h"
+#include "../common/og_example_tools.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+#define NUM_PIPELINES   2
+#define RING_DEPTH      2
+
+typedef vector<vector<unsigned char> > FrameList;
+
+/**
+ * Result of running a pipeline.
+ */
+struct PipelineRun {
+    FrameList outputs;      // output frames
+    double ms;              // processing time in ms
+    bool ok;                // no errors?
+};
+
+/**
+ * Set up pipeline number <pipelineIdx>, process all frames <frames> of size <w>x<h> in
+ * the current OpenGL context and store the results in <run>. Uses an own Core object
+ * or, if <useDefaultInstance> is true, the default Core instance.
+ */
+static void runPipeline(int pipelineIdx, bool useDefaultInstance, const FrameList &frames, int w, int h, PipelineRun &run) {
+    ogles_gpgpu::GrayscaleProc grayscaleProc;
+    ogles_gpgpu::GaussProc gaussProc;
+    ogles_gpgpu::AdaptThreshProc adaptThreshProc;
+    
+    ogles_gpgpu::Core ownCore;  // independent pipeline (must be destroyed before the processors)
+    ogles_gpgpu::Core *core = useDefaultInstance ? ogles_gpgpu::Core::getInstance() : &ownCore;
+    
+    core->setFrameRingDepth(RING_DEPTH);
+    core->addProcToPipeline(&grayscaleProc);
+    
+    if (pipelineIdx == 0) {
+        core->addProcToPipeline(&gaussProc);
+    } else {
+        core->addProcToPipeline(&adaptThreshProc);
+    }
+    
+    core->init(eglGetCurrentContext());
+    core->prepare(w, h, GL_RGBA);
+    
+    int numFrames = (int)frames.size();
+    vector<ogles_gpgpu::FrameHandle> handles(numFrames);
+    run.outputs.assign(numFrames, vector<unsigned char>(core->getOutputFrameW() * core->getOutputFrameH() * 4));
+    
+    double t = getTimeMs();
+    
+    for (int n = 0; n < numFrames + RING_DEPTH - 1; n++) {
+        if (n < numFrames) {    // submit frame n
+            core->setInputData(&frames[n][0]);
+            handles[n] = core->process();
+        }
+        
+        int readN = n - (RING_DEPTH - 1);
+        if (readN >= 0 && readN < numFrames) {    // read back an older frame
+            core->getOutputData(&run.outputs[readN][0], handles[readN]);
+        }
+    }
+    
+    run.ms = getTimeMs() - t;
+    run.ok = glGetError() == GL_NO_ERROR;
+    
+    if (useDefaultInstance) {
+        ogles_gpgpu::Core::destroy();
+    }
+}
+
+/**
+ * Thread function: create an own EGL context and run pipeline number <pipelineIdx>
+ * with an own Core object in it.
+ */
+static void pipelineThread(int pipelineIdx, const FrameList *frames, int w, int h, PipelineRun *run) {
+    run->ok = false;
+    
+    EGLContext ctx = ogles_gpgpu::EGL::createContext();
+    if (ctx == EGL_NO_CONTEXT || !ogles_gpgpu::EGL::activateContext(ctx)) {
+        fprintf(stderr, "thread %d: EGL context creation failed\n", pipelineIdx);
+        return;
+    }
+    
+    runPipeline(pipelineIdx, false, *frames, w, h, *run);
+    
+    ogles_gpgpu::EGL::activateContext(EGL_NO_CONTEXT);
+    ogles_gpgpu::EGL::destroyContext(ctx);
+}
+
+int main(int argc, char *argv[]) {
+    int numFrames = argc > 1 ? atoi(argv[1]) : 10;
+    int w = argc > 3 ? atoi(argv[2]) : 640;
+    int h = argc > 3 ? atoi(argv[3]) : 480;
+    
+    if (numFrames <= 0 || w <= 0 || h <= 0) {
+        fprintf(stderr, "usage: %s [num. frames [width height]]\n", argv[0]);
+        return 1;
+    }
+    
+    // set up EGL
+    if (!ogles_gpgpu::EGL::setup()) {
+        fprintf(stderr, "EGL setup failed\n");
+        return 1;
+    }
+    
+    if (!ogles_gpgpu::EGL::getSupportsSurfaceless()) {
+        fprintf(stderr, "EGL implementation does not support surfaceless contexts\n");
+        return 1;
+    }
+    
+    // generate the input stream
+    FrameList frames(numFrames);
+    for (int n = 0; n < numFrames; n++) {
+        genFrame(frames[n], w, h, n);
+    }
+    
+    printf("processing %d frames of size %dx%d\n", numFrames, w, h);
+    
+    // run the pipelines concurrently, each with its own context and Core object
+    PipelineRun concurrentRuns[NUM_PIPELINES];
+    thread threads[NUM_PIPELINES];
+    
+    double t = getTimeMs();
+    
+    for (int i = 0; i < NUM_PIPELINES; i++) {
+        threads[i] = thread(pipelineThread, i, &frames, w, h, &concurrentRuns[i]);
+    }
+    
+    for (int i = 0; i < NUM_PIPELINES; i++) {
+        threads[i].join();
+    }
+    
+    double tConcurrent = getTimeMs() - t;
+    
+    // run the same pipelines one after another in the main context
+    if (!ogles_gpgpu::EGL::activate()) {
+        fprintf(stderr, "EGL context activation failed\n");
+        return 1;
+    }
+    
+    printf("GL renderer: %s, version: %s\n", (const char *)glGetString(GL_RENDERER), (const char *)glGetString(GL_VERSION));
+    
+    PipelineRun sequentialRuns[NUM_PIPELINES];
+    
+    t = getTimeMs();
+    
+    for (int i = 0; i < NUM_PIPELINES; i++) {
+        runPipeline(i, true, frames, w, h, sequentialRuns[i]);
+    }
+    
+    double tSequential = getTimeMs() - t;
+    
+    ogles_gpgpu::EGL::shutdown();
+    
+    // compare
+    int numErrors = 0;
+    
+    for (int i = 0; i < NUM_PIPELINES; i++) {
+        const PipelineRun &c = concurrentRuns[i];
+        const PipelineRun &s = sequentialRuns[i];
+        int numDiff = 0;
+        
+        if (!c.ok || !s.ok) {
+            printf("pipeline %d: failed\n", i);
+            numErrors++;
+            continue;
+        }
+        
+        for (int n = 0; n < numFrames; n++) {
+            if (memcmp(&c.outputs[n][0], &s.outputs[n][0], c.outputs[n].size()) != 0) {
+                numDiff++;
+            }
+        }
+        
+        printf("pipeline %d: %.3f ms per frame in own thread, %d frames differ from sequential run\n",
+               i, c.ms / numFrames, numDiff);
+        
+        numErrors += numDiff;
+    }
+    
+    printf("total time: %.3f ms concurrent, %.3f ms sequential\n", tConcurrent, tSequential);
+    
+    return numErrors > 0 ? 1 : 0;
+}
@@ -0,0 +1,200 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Headless Linux example: measures the startup time of a pipeline that uses all
+ * processors (Core::init(), Core::prepare() and the first frame, which includes the
+ * shader compilation) without shader cache, with a cold shader cache (empty
+ * directory) and with a warm shader cache (see Core::setShaderCacheDir()):
+ *
+ *   input -> gray -+-> gauss -+-> diff(gray, gauss)
+ *                  |          +-> blend(gauss, thresh) -> adaptive thresholding
+ *                  +-> thresh ----^
+ *
+ * Each repetition uses a new cache directory below /tmp. The output of the first
+ * frame is compared to the output without cache. The number of shader programs
+ * that the processors share (see Core::getShaderRegistry()) is printed, too.
+ * Note that drivers may have their own shader caches (e.g. Mesa's shader disk cache,
+ * which is also needed for Mesa's program binary support), so that the times without
+ * cache can be lower than for a first start of an application on a device.
+ *
+ * Usage: og_shader_cache [num. repetitions [width height]]
+ * Returns 1 if an output is not as expected or the warm cache was not used.
+ */
+
+#include "ogles_gpgpu/ogles_gpgpu.h"
+#include "../common/og_example_tools.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Startup modes.
+ */
+typedef enum {
+    STARTUP_NO_CACHE = 0,
+    STARTUP_COLD_CACHE,
+    STARTUP_WARM_CACHE,
+    NUM_STARTUP_MODES
+} StartupMode;
+
+static const char *startupModeNames[] = { "no cache", "cold cache", "warm cache" };
+
+/**
+ * Result of a pipeline startup.
+ */
+struct StartupRun {
+    double prepareMs;       // time for Core::init() and Core::prepare() in ms
+    double firstFrameMs;    // time for the first frame in ms
+    int cacheHits;          // number of programs loaded from the cache
+    int cacheStored;        // number of programs stored in the cache
+    int numShaders;         // number of shaders that the processors requested
+    int numPrograms;        // number of distinct shader programs
+    vector<unsigned char> output;   // output of the first frame
+};
+
+/**
+ * Set up the pipeline with shader cache directory <cacheDir> (empty for no cache),
+ * process the frame <frame> of size <w>x<h> and store the times and the output in <run>.
+ */
+static void runStartup(const string &cacheDir, const vector<unsigned char> &frame, int w, int h, StartupRun &run) {
+    ogles_gpgpu::GrayscaleProc grayscaleProc;
+    ogles_gpgpu::GaussProc gaussProc;
+    ogles_gpgpu::ThreshProc threshProc;
+    ogles_gpgpu::DiffProc diffProc;
+    ogles_gpgpu::BlendProc blendProc;
+    ogles_gpgpu::AdaptThreshProc adaptThreshProc;
+    
+    ogles_gpgpu::Core core;     // must be destroyed before the processors
+    
+    core.setShaderCacheDir(cacheDir);
+    
+    core.addProcToPipeline(&grayscaleProc);
+    core.addProcToPipeline(&gaussProc, &grayscaleProc);
+    core.addProcToPipeline(&threshProc, &grayscaleProc);
+    core.addProcToPipeline(&diffProc, &grayscaleProc, &gaussProc);
+    core.addProcToPipeline(&blendProc, &gaussProc, &threshProc);
+    core.addProcToPipeline(&adaptThreshProc, &blendProc);
+    core.setKeepOutput(&diffProc);
+    
+    double t = getTimeMs();
+    
+    core.init(eglGetCurrentContext());
+    core.prepare(w, h, GL_RGBA);
+    glFinish();
+    
+    run.prepareMs = getTimeMs() - t;
+    
+    // the driver might defer some of the work until the shaders are used
+    t = getTimeMs();
+    
+    run.output.resize(core.getOutputFrameW() * core.getOutputFrameH() * 4);
+    core.setInputData(&frame[0]);
+    core.process();
+    core.getOutputData(&run.output[0]);
+    
+    run.firstFrameMs = getTimeMs() - t;
+    
+    run.cacheHits = core.getProgramCache()->getNumHits();
+    run.cacheStored = core.getProgramCache()->getNumStored();
+    run.numShaders = core.getShaderRegistry()->getNumAcquired();
+    run.numPrograms = core.getShaderRegistry()->getNumPrograms();
+}
+
+int main(int argc, char *argv[]) {
+    int numReps = argc > 1 ? atoi(argv[1]) : 5;
+    int w = argc > 3 ? atoi(argv[2]) : 640;
+    int h = argc > 3 ? atoi(argv[3]) : 480;
+    
+    if (numReps <= 0 || w <= 0 || h <= 0) {
+        fprintf(stderr, "usage: %s [num. repetitions [width height]]\n", argv[0]);
+        return 1;
+    }
+    
+    // set up EGL context
+    if (!ogles_gpgpu::EGL::setup()) {
+        fprintf(stderr, "EGL setup failed\n");
+        return 1;
+    }
+    
+    if (!ogles_gpgpu::EGL::getSupportsSurfaceless() && !ogles_gpgpu::EGL::createPBufferSurface(w, h)) {
+        fprintf(stderr, "EGL pbuffer creation failed\n");
+        return 1;
+    }
+    
+    if (!ogles_gpgpu::EGL::activate()) {
+        fprintf(stderr, "EGL context activation failed\n");
+        return 1;
+    }
+    
+    printf("GL renderer: %s, version: %s\n", (const char *)glGetString(GL_RENDERER), (const char *)glGetString(GL_VERSION));
+    
+    vector<unsigned char> frame;
+    genFrame(frame, w, h);
+    
+    double prepareMs[NUM_STARTUP_MODES] = { 0.0 };
+    double firstFrameMs[NUM_STARTUP_MODES] = { 0.0 };
+    int numErrors = 0;
+    int numWarmHits = 0;
+    
+    for (int rep = 0; rep < numReps; rep++) {
+        // new cache directory, so that the first run with cache is a cold start
+        char cacheDir[] = "/tmp/og_shader_cache_XXXXXX";
+        
+        if (!mkdtemp(cacheDir)) {
+            fprintf(stderr, "could not create cache directory\n");
+            return 1;
+        }
+        
+        StartupRun runs[NUM_STARTUP_MODES];
+        runStartup("", frame, w, h, runs[STARTUP_NO_CACHE]);
+        runStartup(cacheDir, frame, w, h, runs[STARTUP_COLD_CACHE]);
+        runStartup(cacheDir, frame, w, h, runs[STARTUP_WARM_CACHE]);
+        
+        for (int m = 0; m < NUM_STARTUP_MODES; m++) {
+            prepareMs[m] += runs[m].prepareMs / numReps;
+            firstFrameMs[m] += runs[m].firstFrameMs / numReps;
+            
+            if (runs[m].output != runs[STARTUP_NO_CACHE].output) {
+                printf("repetition %d, %s: output differs\n", rep, startupModeNames[m]);
+                numErrors++;
+            }
+        }
+        
+        if (rep == 0) {
+            printf("%d shaders requested by the processors, %d distinct shader programs\n",
+                   runs[STARTUP_NO_CACHE].numShaders, runs[STARTUP_NO_CACHE].numPrograms);
+            printf("cache directory %s: %d programs stored in cold start, %d loaded in warm start\n",
+                   cacheDir, runs[STARTUP_COLD_CACHE].cacheStored, runs[STARTUP_WARM_CACHE].cacheHits);
+        }
+        
+        numWarmHits += runs[STARTUP_WARM_CACHE].cacheHits;
+    }
+    
+    ogles_gpgpu::EGL::shutdown();
+    
+    printf("startup times (mean of %d repetitions):\n", numReps);
+    printf("  %-12s %14s %16s %12s\n", "mode", "prepare [ms]", "first frame [ms]", "total [ms]");
+    
+    for (int m = 0; m < NUM_STARTUP_MODES; m++) {
+        printf("  %-12s %14.3f %16.3f %12.3f\n", startupModeNames[m],
+               prepareMs[m], firstFrameMs[m], prepareMs[m] + firstFrameMs[m]);
+    }
+    
+    if (numWarmHits == 0) {
+        printf("the shader cache was not used (no program binary support?)\n");
+        numErrors++;
+    }
+    
+    return numErrors > 0 ? 1 : 0;
+}
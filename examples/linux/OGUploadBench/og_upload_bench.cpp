@@ -0,0 +1,190 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Headless Linux benchmark: measures the per-frame cost of uploading RGBA frames
+ * to the GPU with the different MemTransfer upload paths at 720p and 1080p.
+ * After each upload, a grayscale conversion reads the input texture, so that the
+ * driver has to care about textures that are still in use.
+ *
+ * Usage: og_upload_bench [num. frames]
+ */
+
+#include "ogles_gpgpu/ogles_gpgpu.h"
+#include "ogles_gpgpu/common/gl/memtransfer_pbo.h"
+#include "../common/og_example_tools.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+
+/**
+ * MemTransfer with the previous upload path: reallocates the texture storage with
+ * glTexImage2D() for each frame. Only used as benchmark reference.
+ */
+class MemTransferTexImage : public ogles_gpgpu::MemTransfer {
+public:
+    virtual void toGPU(const unsigned char *buf) {
+        glBindTexture(GL_TEXTURE_2D, inputTexId);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, inputW, inputH, 0, GL_RGBA, GL_UNSIGNED_BYTE, buf);
+        setCommonTextureParams(0);
+    }
+};
+
+/**
+ * Upload path configuration.
+ */
+struct UploadConf {
+    const char *name;
+    int type;           // 0: glTexImage2D, 1: MemTransfer, 2: MemTransferPBO, 3: MemTransferPBO with unpack buffer
+    int rowPadding;     // additional bytes per row
+};
+
+/**
+ * Upload <numFrames> frames of size <w>x<h> with configuration <conf>. Returns the
+ * mean upload call time in <uploadMs> and the mean time per frame including the
+ * rendering in <frameMs>.
+ */
+static void runUpload(const UploadConf &conf, int w, int h, int numFrames, double &uploadMs, double &frameMs) {
+    ogles_gpgpu::MemTransfer *mt;
+
+    switch (conf.type) {
+        case 0:
+            mt = new MemTransferTexImage();
+            break;
+        case 1:
+            mt = new ogles_gpgpu::MemTransfer();
+            break;
+        default: {
+            ogles_gpgpu::MemTransferPBO *mtPBO = new ogles_gpgpu::MemTransferPBO();
+            mtPBO->setUseUnpackBuffer(conf.type == 3);
+            mt = mtPBO;
+            break;
+        }
+    }
+
+    mt->init();
+
+    // input frames (two alternating frames with padded rows)
+    int stride = w * 4 + conf.rowPadding;
+    vector<unsigned char> frames[2];
+    for (int i = 0; i < 2; i++) {
+        frames[i].resize(stride * h);
+        for (size_t j = 0; j < frames[i].size(); j++) {
+            frames[i][j] = (unsigned char)((j * 13 + i * 101) & 0xFF);
+        }
+    }
+
+    GLuint texId = mt->prepareInput(w, h, GL_RGBA);
+    mt->setInputRowStride(conf.rowPadding > 0 ? stride : 0);
+
+    // processor that reads the input texture
+    ogles_gpgpu::GrayscaleProc grayscaleProc;
+    grayscaleProc.setOutputSize(0.25f);
+    grayscaleProc.init(w, h, 0, false);
+    grayscaleProc.createFBOTex(false);
+    grayscaleProc.useTexture(texId);
+
+    glFinish();
+
+    double uploadSum = 0.0;
+    double t = getTimeMs();
+
+    for (int n = 0; n < numFrames; n++) {
+        double t0 = getTimeMs();
+        glActiveTexture(GL_TEXTURE1);
+        mt->toGPU(&frames[n % 2][0]);
+        uploadSum += getTimeMs() - t0;
+
+        grayscaleProc.render();
+        glFlush();
+    }
+
+    glFinish();
+
+    frameMs = (getTimeMs() - t) / numFrames;
+    uploadMs = uploadSum / numFrames;
+
+    grayscaleProc.cleanup();
+    delete mt;
+}
+
+int main(int argc, char *argv[]) {
+    int numFrames = argc > 1 ? atoi(argv[1]) : 100;
+
+    if (numFrames <= 0) {
+        fprintf(stderr, "usage: %s [num. frames]\n", argv[0]);
+        return 1;
+    }
+
+    // set up EGL context
+    if (!ogles_gpgpu::EGL::setup()) {
+        fprintf(stderr, "EGL setup failed\n");
+        return 1;
+    }
+
+    if (!ogles_gpgpu::EGL::getSupportsSurfaceless() && !ogles_gpgpu::EGL::createPBufferSurface(64, 64)) {
+        fprintf(stderr, "EGL pbuffer creation failed\n");
+        return 1;
+    }
+
+    if (!ogles_gpgpu::EGL::activate()) {
+        fprintf(stderr, "EGL context activation failed\n");
+        return 1;
+    }
+
+    printf("GL renderer: %s, version: %s\n", (const char *)glGetString(GL_RENDERER), (const char *)glGetString(GL_VERSION));
+
+    // initialize the core to detect the OpenGL ES version
+    ogles_gpgpu::Core *core = ogles_gpgpu::Core::getInstance();
+    core->init();
+
+    vector<UploadConf> confs;
+    UploadConf confTexImage = { "glTexImage2D (previous)", 0, 0 };
+    UploadConf confSubImage = { "glTexSubImage2D", 1, 0 };
+    UploadConf confSubImagePadded = { "glTexSubImage2D, padded rows", 1, 64 };
+    UploadConf confRowLength = { "glTexSubImage2D + ROW_LENGTH, padded rows", 2, 64 };
+    UploadConf confUnpack = { "unpack buffer", 3, 0 };
+    UploadConf confUnpackPadded = { "unpack buffer, padded rows", 3, 64 };
+
+    confs.push_back(confTexImage);
+    confs.push_back(confSubImage);
+    confs.push_back(confSubImagePadded);
+
+    if (core->getIsGLES3Context()) {
+        confs.push_back(confRowLength);
+        confs.push_back(confUnpack);
+        confs.push_back(confUnpackPadded);
+    }
+
+    const int sizes[][2] = { { 1280, 720 }, { 1920, 1080 } };
+
+    printf("%d frames per measurement. mean upload call time / mean time per frame incl. rendering:\n", numFrames);
+
+    for (int s = 0; s < 2; s++) {
+        int w = sizes[s][0];
+        int h = sizes[s][1];
+
+        printf("%dx%d:\n", w, h);
+
+        for (size_t i = 0; i < confs.size(); i++) {
+            double uploadMs, frameMs;
+            runUpload(confs[i], w, h, numFrames, uploadMs, frameMs);
+
+            printf("  %-45s %8.3f ms / %8.3f ms\n", confs[i].name, uploadMs, frameMs);
+        }
+    }
+
+    ogles_gpgpu::Core::destroy();
+    ogles_gpgpu::EGL::shutdown();
+
+    return 0;
+}
@@ -0,0 +1,48 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Helper functions shared by the Linux example programs.
+ */
+#ifndef OGLES_GPGPU_EXAMPLES_LINUX_EXAMPLE_TOOLS
+#define OGLES_GPGPU_EXAMPLES_LINUX_EXAMPLE_TOOLS
+
+#include <chrono>
+#include <vector>
+
+/**
+ * Generate synthetic RGBA frame number <n> of size <w>x<h> (moving circles on a gradient).
+ */
+inline void genFrame(std::vector<unsigned char> &rgba, int w, int h, int n = 0) {
+    rgba.resize(w * h * 4);
+    
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            unsigned char *px = &rgba[(y * w + x) * 4];
+            int dx = ((x + n * 8) % 96) - 48;
+            int dy = ((y + n * 3) % 96) - 48;
+            bool inCircle = dx * dx + dy * dy < 30 * 30;
+            unsigned char bg = (unsigned char)(255 * x / w);
+            
+            px[0] = inCircle ? 20 : bg;
+            px[1] = inCircle ? 30 : (unsigned char)(255 * y / h);
+            px[2] = inCircle ? 40 : bg;
+            px[3] = 255;
+        }
+    }
+}
+
+/**
+ * Return current time in milliseconds (monotonic clock).
+ */
+inline double getTimeMs() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#endif
@@ -0,0 +1,151 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "backendtuner.h"
+
+#include "cpu/cpukernels.h"
+#include "cpu/cputhreadpool.h"
+
+#include <cstdio>
+#include <sstream>
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+#define OGLES_GPGPU_BACKENDTUNER_VERSION    1
+
+#pragma mark constructor/deconstructor
+
+BackendTuner::BackendTuner() {
+    numFrames = OGLES_GPGPU_BACKEND_TUNING_DEFAULT_FRAMES;
+    retune = false;
+    
+    result.backend = PROCESSING_BACKEND_GPU;
+    result.gpuMs = result.cpuMs = -1.0;
+    result.stored = false;
+}
+
+#pragma mark public methods
+
+void BackendTuner::initDeviceId(bool glContext) {
+    ostringstream id;
+    
+    if (glContext) {
+        const GLenum driverStrings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+        for (int i = 0; i < 3; i++) {
+            const char *str = (const char *)glGetString(driverStrings[i]);
+            id << (str ? str : "") << "\n";
+        }
+    } else {
+        id << "no OpenGL\n";
+    }
+    
+    id << CPUThreadPool::getNumCPUCores() << " CPU cores, "
+       << CPUKernels::getInstructionSetName(CPUKernels::getInstructionSet());
+    
+    deviceId = id.str();
+}
+
+bool BackendTuner::loadResult(const string &pipelineId, BackendTuningResult &res) {
+    if (tuningDir.empty()) return false;
+    
+    unsigned long long key = getKey(pipelineId);
+    string path = getEntryPath(key);
+    
+    FILE *f = fopen(path.c_str(), "r");
+    
+    if (!f) {
+        OG_LOGINF("BackendTuner", "no stored result %s", path.c_str());
+        return false;
+    }
+    
+    unsigned int version;
+    unsigned long long fileKey;
+    int backend;
+    double gpuMs, cpuMs;
+    
+    bool valid = fscanf(f, "OGBT %u %llx %d %lf %lf", &version, &fileKey, &backend, &gpuMs, &cpuMs) == 5
+              && version == OGLES_GPGPU_BACKENDTUNER_VERSION
+              && fileKey == key
+              && (backend == PROCESSING_BACKEND_GPU || backend == PROCESSING_BACKEND_CPU);
+    
+    fclose(f);
+    
+    if (!valid) {
+        OG_LOGERR("BackendTuner", "invalid result file %s", path.c_str());
+        return false;
+    }
+    
+    res.backend = (ProcessingBackend)backend;
+    res.gpuMs = gpuMs;
+    res.cpuMs = cpuMs;
+    res.stored = true;
+    
+    OG_LOGINF("BackendTuner", "loaded result %s", path.c_str());
+    
+    return true;
+}
+
+bool BackendTuner::storeResult(const string &pipelineId, const BackendTuningResult &res) {
+    if (tuningDir.empty()) return false;
+    
+    unsigned long long key = getKey(pipelineId);
+    
+    // write to a temporary file first and rename it, so that other tuner objects
+    // that use the same directory never read a partly written file
+    string path = getEntryPath(key);
+    ostringstream tmpPath;
+    tmpPath << path << ".tmp" << (const void *)this;
+    
+    FILE *f = fopen(tmpPath.str().c_str(), "w");
+    
+    if (!f) {
+        OG_LOGERR("BackendTuner", "could not create result file %s", tmpPath.str().c_str());
+        return false;
+    }
+    
+    bool written = fprintf(f, "OGBT %u %016llx %d %.4f %.4f\n", OGLES_GPGPU_BACKENDTUNER_VERSION, key,
+                           (int)res.backend, res.gpuMs, res.cpuMs) > 0;
+    
+    written = fclose(f) == 0 && written;
+    
+    if (!written || rename(tmpPath.str().c_str(), path.c_str()) != 0) {
+        OG_LOGERR("BackendTuner", "could not write result file %s", path.c_str());
+        remove(tmpPath.str().c_str());
+        return false;
+    }
+    
+    OG_LOGINF("BackendTuner", "stored result %s", path.c_str());
+    
+    return true;
+}
+
+#pragma mark private methods
+
+unsigned long long BackendTuner::getKey(const string &pipelineId) const {
+    unsigned long long hash = OGLES_GPGPU_FNV1A_OFFSET_BASIS;
+    
+    hash = Tools::hashStr(hash, deviceId.c_str());
+    hash = Tools::hashStr(hash, pipelineId.c_str());
+    
+    return hash;
+}
+
+string BackendTuner::getEntryPath(unsigned long long key) const {
+    char name[40];
+    snprintf(name, sizeof(name), "og_backend_%016llx.txt", key);
+    
+    string path(tuningDir);
+    
+    if (path[path.size() - 1] != '/') {
+        path.append("/");
+    }
+    
+    return path.append(name);
+}
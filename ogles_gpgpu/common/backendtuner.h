@@ -0,0 +1,147 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Persistent backend selection of Core for PROCESSING_BACKEND_AUTO.
+ */
+#ifndef OGLES_GPGPU_COMMON_BACKENDTUNER
+#define OGLES_GPGPU_COMMON_BACKENDTUNER
+
+#include "common_includes.h"
+
+#include <string>
+
+#define OGLES_GPGPU_BACKEND_TUNING_DEFAULT_FRAMES   10  // default number of measured frames per backend
+
+using namespace std;
+
+namespace ogles_gpgpu {
+
+/**
+ * Result of the backend selection for a pipeline and frame size.
+ */
+typedef struct {
+    ProcessingBackend backend;  // selected backend
+    double gpuMs;               // median time per frame of the GPU backend in ms (< 0 if not measured)
+    double cpuMs;               // median time per frame of the CPU backend in ms (< 0 if not measured)
+    bool stored;                // the result was loaded from the tuning directory instead of measured
+} BackendTuningResult;
+
+/**
+ * Settings and persistent results of the backend selection of Core (see
+ * PROCESSING_BACKEND_AUTO). Core::prepare() measures a few frames with each backend,
+ * including setInputData() and getOutputData(), and selects the backend with the
+ * lower median time per frame. The result is saved to one file per pipeline in a
+ * directory and loaded the next time the same pipeline is prepared on the same
+ * device, which skips the measurement. The key is a hash of the device fingerprint
+ * (OpenGL vendor, renderer and version string, number of CPU cores and the
+ * instruction set of the CPU kernels) and the pipeline description (processors,
+ * their inputs, output sizes and orientations, input frame size, formats and
+ * settings that affect the speed of a backend), so that results of other devices or driver versions are never used.
+ * Several tuner objects (e.g. of different Core objects) can use the same directory,
+ * also the directory of the ProgramCache.
+ */
+class BackendTuner {
+public:
+    /**
+     * Constructor. Results are not saved until a directory is set.
+     */
+    BackendTuner();
+    
+    /**
+     * Set the directory <dir> in which the results are stored. The directory must
+     * exist. An empty string disables saving and loading results.
+     */
+    void setDir(const string &dir) { tuningDir = dir; }
+    
+    /**
+     * Return the tuning directory.
+     */
+    const string &getDir() const { return tuningDir; }
+    
+    /**
+     * Set the number of measured frames per backend to <num> (default:
+     * OGLES_GPGPU_BACKEND_TUNING_DEFAULT_FRAMES). Two more frames per backend are
+     * processed for warm-up.
+     */
+    void setNumFrames(int num) { assert(num > 0); numFrames = num; }
+    
+    /**
+     * Get the number of measured frames per backend.
+     */
+    int getNumFrames() const { return numFrames; }
+    
+    /**
+     * Ignore stored results and measure again: <retune>. The new result replaces the
+     * stored one (e.g. after a system update that changed the speed of a backend).
+     * Disabled by default.
+     */
+    void setRetune(bool retune) { this->retune = retune; }
+    
+    /**
+     * Get "retune" status.
+     */
+    bool getRetune() const { return retune; }
+    
+    /**
+     * Determine the device fingerprint. <glContext> signals a current OpenGL context,
+     * whose driver strings are then part of the fingerprint.
+     */
+    void initDeviceId(bool glContext);
+    
+    /**
+     * Return the device fingerprint.
+     */
+    const string &getDeviceId() const { return deviceId; }
+    
+    /**
+     * Load the stored result for the pipeline with description <pipelineId> into
+     * <res>. Returns false if there is no stored result.
+     */
+    bool loadResult(const string &pipelineId, BackendTuningResult &res);
+    
+    /**
+     * Save result <res> for the pipeline with description <pipelineId>. Returns true
+     * on success.
+     */
+    bool storeResult(const string &pipelineId, const BackendTuningResult &res);
+    
+    /**
+     * Set the result of the last backend selection to <res>.
+     */
+    void setResult(const BackendTuningResult &res) { result = res; }
+    
+    /**
+     * Get the result of the last backend selection (see Core::prepare()).
+     */
+    const BackendTuningResult &getResult() const { return result; }
+
+private:
+    /**
+     * Return the key for the pipeline with description <pipelineId>.
+     */
+    unsigned long long getKey(const string &pipelineId) const;
+    
+    /**
+     * Return the path of the result file for <key>.
+     */
+    string getEntryPath(unsigned long long key) const;
+    
+    
+    string tuningDir;           // directory of the results. empty if disabled
+    string deviceId;            // device fingerprint
+    int numFrames;              // number of measured frames per backend
+    bool retune;                // ignore stored results?
+    
+    BackendTuningResult result; // result of the last backend selection
+};
+
+}
+
+#endif
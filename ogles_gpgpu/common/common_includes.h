@@ -13,6 +13,7 @@
 
 #include <iostream>
 #include <cassert>
+#include <cstring>
 
 #ifdef __APPLE__
     #include "../platform/ios/gl_includes.h"
@@ -21,8 +22,12 @@
     #include "../platform/android/gl_includes.h"
 	#include "../platform/android/macros.h"
 	#include "../platform/android/egl.h"
+#elif __linux__
+    #include "../platform/linux/gl_includes.h"
+	#include "macros.h"
+	#include "../platform/linux/egl.h"
 #else
-#error platform not supported. either __APPLE__ or __ANDROID__ must be defined.
+#error platform not supported. either __APPLE__, __ANDROID__ or __linux__ must be defined.
 #endif
 
 #include "tools.h"
@@ -10,8 +10,12 @@
 #include "core.h"
 
 #include "proc/disp.h"
+#include "proc/pack.h"
+#include "proc/base/filterprocbase.h"
+#include "cpu/cpukernels.h"
 
 #include <string>
+#include <sstream>
 #include <algorithm>
 
 using namespace std;
@@ -51,10 +55,40 @@ Core::Core() {
     initialized = false;
     useMipmaps = false;
     glExtNPOTMipmaps = false;
+    glExtAppleSync = false;
+    glExtDisjointTimerQuery = false;
+    glExtProgramBinary = false;
+    glExtVertexArrayObject = false;
+    glES3 = false;
+    processingMode = PROCESSING_MODE_ASYNC;
+    backend = PROCESSING_BACKEND_GPU;
+    autoBackend = false;
+    frameRingDepth = 1;
+    useAsyncReadback = false;
+    useTexPool = false;
+    useShaderFusion = false;
+    usePackedGray = false;
+    useVertexBuffers = true;
+    cpuNumThreads = 0;
+    useCPUTiling = true;
+    cpuTileCacheSize = 0;
+    cpuTilingActive = false;
+#ifdef DEBUG
+    validationLevel = VALIDATION_LEVEL_PER_CALL;
+#else
+    validationLevel = VALIDATION_LEVEL_PER_FRAME;
+#endif
     renderDisp = NULL;
+    outputFormat = OUTPUT_FORMAT_RGBA;
+    outputPackProc = NULL;
+    roi.x = roi.y = roi.w = roi.h = 0;
     glContextPtr = NULL;
     inputTexTarget = GL_TEXTURE_2D;
     
+    // new shader programs are built with the program cache
+    shaderRegistry.setProgramCache(&programCache);
+    glState.setTracking(true);
+    
     // reset to defaults
     reset();
 }
@@ -76,19 +110,71 @@ void Core::reset() {
     inputFrameW = inputFrameH = 0;
     outputFrameW = outputFrameH = 0;
     inputTexId = outputTexId = 0;
+    inputChromaTexIds[0] = inputChromaTexIds[1] = 0;
+    inputDataFormat = GL_RGBA;
+    inputLumaOnly = false;
     firstProc = lastProc = NULL;
+    inputWillDownscale = false;
+    schedule.clear();
+    lastFrame = 0;
+    selectedSlot = 0;
+    profStageInput = profStageProcess = profStageOutput = profStageOutputPack = -1;
+    profProcStages.clear();
 }
 
 void Core::addProcToPipeline(ProcInterface *proc) {
+    // use the output of the previously added processor as input
+    addProcToPipeline(proc, pipeline.empty() ? NULL : pipeline.back().proc);
+}
+
+void Core::addProcToPipeline(ProcInterface *proc, ProcInterface *input) {
+    vector<ProcInterface *> inputs(1, input);
+    addProcToPipeline(proc, inputs);
+}
+
+void Core::addProcToPipeline(ProcInterface *proc, ProcInterface *input1, ProcInterface *input2) {
+    vector<ProcInterface *> inputs;
+    inputs.push_back(input1);
+    inputs.push_back(input2);
+    addProcToPipeline(proc, inputs);
+}
+
+void Core::addProcToPipeline(ProcInterface *proc, const vector<ProcInterface *> &inputs) {
+    assert(proc);
+    
     // pipeline needs to be set up before calling init()
     if (initialized) {
         OG_LOGERR("Core", "adding processor failed: pipeline already initialized");
     }
     
+    if (findProcNode(proc) >= 0) {
+        OG_LOGERR("Core", "adding processor failed: processor %s is already in the pipeline", proc->getProcName());
+        return;
+    }
+    
     OG_LOGINF("Core", "adding processor #%u to pipeline", (unsigned int)(pipeline.size() + 1));
     
-    // add not processor to pipeline
-    pipeline.push_back(proc);
+    // add node for the processor to pipeline
+    PipelineNode node;
+    node.proc = proc;
+    node.inputProcs = inputs;
+    node.keepOutput = false;
+    node.fusedInto = -1;
+    pipeline.push_back(node);
+    
+    // the last added processor provides the pipeline output
+    lastProc = proc;
+}
+
+void Core::setKeepOutput(ProcInterface *proc, bool keep) {
+    int n = findProcNode(proc);
+    
+    if (n < 0) {
+        OG_LOGERR("Core", "setKeepOutput: processor %s is not in the pipeline", proc->getProcName());
+        return;
+    }
+    
+    pipeline[n].keepOutput = keep;
 }
 
 Disp *Core::createRenderDisplay(int dispW, int dispH, RenderOrientation orientation) {
@@ -104,14 +190,54 @@ Disp *Core::createRenderDisplay(int dispW, int dispH, RenderOrientation orientat
     return renderDisp;
 }
 
+void Core::setFrameRingDepth(int depth) {
+    if (prepared) {
+        OG_LOGERR("Core", "frame ring depth can not be changed after prepare()");
+        return;
+    }
+    
+    if (depth < 1 || depth > OGLES_GPGPU_MAX_FRAME_RING_DEPTH) {
+        OG_LOGERR("Core", "invalid frame ring depth %d (must be in range 1 to %d)", depth, OGLES_GPGPU_MAX_FRAME_RING_DEPTH);
+        return;
+    }
+    
+    frameRingDepth = depth;
+}
+
 void Core::init(void *glContext) {
     assert(!initialized);
     
-    checkGLExtensions();
+    // checkGLErr() uses the validation level of the calling thread
+    Tools::setValidationLevel(validationLevel);
     
     // set OpenGL context pointer
     glContextPtr = glContext;
     
+    // the backend is selected in prepare(). until then, the GPU backend is initialized
+    autoBackend = backend == PROCESSING_BACKEND_AUTO;
+    
+    if (autoBackend) {
+        backend = PROCESSING_BACKEND_GPU;
+    }
+    
+    // without a current OpenGL context, the pipeline can only be executed on the CPU
+    if (backend == PROCESSING_BACKEND_GPU && !glGetString(GL_VERSION)) {
+        OG_LOGERR("Core", "no current OpenGL context, falling back to the CPU backend");
+        backend = PROCESSING_BACKEND_CPU;
+        autoBackend = false;
+    }
+    
+    backendTuner.initDeviceId(backend == PROCESSING_BACKEND_GPU);
+    
+    // the CPU backend does not use OpenGL
+    if (backend == PROCESSING_BACKEND_CPU) {
+        OG_LOGINF("Core", "using the CPU backend");
+        initialized = true;
+        return;
+    }
+    
+    checkGLExtensions();
+    
     // init opengl
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glDisable(GL_DEPTH_TEST);
@@ -119,101 +245,204 @@ void Core::init(void *glContext) {
     
     Tools::checkGLErr("Core", "init OpenGL");
     
+    // report setup errors here and not with the first frame
+    if (validationLevel == VALIDATION_LEVEL_PER_FRAME) {
+        Tools::checkGLErrNow("Core", "init");
+    }
+    
     initialized = true;
 }
 
 void Core::prepare(int inW, int inH, GLenum inFmt) {
     assert(initialized && inW > 0 && inH > 0 && pipeline.size() > 0);
     
+    Tools::setValidationLevel(validationLevel);
+    
     if (prepared && inputFrameW == inW && inputFrameH == inH) return;   // no change
     
+    if (autoBackend) {
+        prepareAutoBackend(inW, inH, inFmt);
+    } else if (backend == PROCESSING_BACKEND_CPU) {
+        prepareCPU(inW, inH, inFmt);
+    } else {
+        prepareGPU(inW, inH, inFmt);
+    }
+    
+    // report errors of the shader, framebuffer and texture setup here and not with the
+    // first frame. the backend selection also uses OpenGL if it selects the CPU backend
+    if ((backend == PROCESSING_BACKEND_GPU || autoBackend) && validationLevel == VALIDATION_LEVEL_PER_FRAME) {
+        Tools::checkGLErrNow("Core", "prepare");
+    }
+}
+
+void Core::prepareGPU(int inW, int inH, GLenum inFmt) {
+    // resolve the processor graph and determine the render order
+    if (!prepared && !buildSchedule()) {
+        OG_LOGERR("Core", "prepare failed: invalid pipeline");
+        return;
+    }
+    
     // set input frame size
     inputSizeIsPOT = Tools::isPOT(inW) && Tools::isPOT(inH);
     inputFrameW = inW;
     inputFrameH = inH;
 
-    OG_LOGINF("Core", "prepare with input frame size %dx%d (POT: %d), %u processors in pipeline",
-              inputFrameW, inputFrameH, inputSizeIsPOT, (unsigned int)pipeline.size());
+    OG_LOGINF("Core", "prepare with input frame size %dx%d (POT: %d), %u processors in pipeline, frame ring depth %d",
+              inputFrameW, inputFrameH, inputSizeIsPOT, (unsigned int)pipeline.size(), frameRingDepth);
 
-    // initialize the pipeline
-    ProcInterface *prevProc = NULL;
+    // of YUV input, only the Y plane is uploaded if the processors that read the
+    // input only need the luminance
+    if (!prepared) {
+        inputLumaOnly = Tools::isYUVFormat(inFmt) && inFmt != INPUT_FORMAT_Y8 && getInputReadersLumaOnly();
+        inputDataFormat = inputLumaOnly ? INPUT_FORMAT_Y8 : inFmt;
+        
+        if (inputLumaOnly) {
+            OG_LOGINF("Core", "only the Y plane of the YUV input is used");
+        }
+    }
+    
+    // first pipeline processor will get input data (e.g. RGBA pixel data). other
+    // processors that read the pipeline input need its format for YUV conversion
+    for (vector<PipelineNode>::iterator it = pipeline.begin();
+         it != pipeline.end();
+         ++it)
+    {
+        if (it->proc == firstProc || it->inputs[0] < 0) {
+            it->proc->setExternalInputDataFormat(inputDataFormat);
+        }
+    }
+    
+    // the processors get the shared vertex buffers through the OpenGL state
+    if (!prepared) {
+        quadBuffers.initVertexArraySupport(glES3, glExtVertexArrayObject);
+        glState.setQuadBuffers(useVertexBuffers ? &quadBuffers : NULL);
+    }
+    
+    // the processors select their shaders for packed grayscale images in init()
+    if (!prepared) {
+        selectPackedGrayProcs();
+    }
+    
+    // pack the output for the readback in an additional pass, unless the last
+    // processor's output is in the requested format already
+    if (!prepared && (outputFormat == OUTPUT_FORMAT_MASK1
+                  || (outputFormat == OUTPUT_FORMAT_GRAY8 && !lastProc->getPackedGray())))
+    {
+        outputPackProc = new PackProc();
+        outputPackProc->setOutputFormat(outputFormat);
+        outputPackProc->setPackedInput(lastProc->getPackedGray());
+    }
+    
+    // initialize the pipeline in render order, so that the output sizes of
+    // the input processors are known
     unsigned int num = 0;
     int numInitialized = 0;
-    for (list<ProcInterface *>::iterator it = pipeline.begin();
-         it != pipeline.end();
+    for (vector<int>::iterator it = schedule.begin();
+         it != schedule.end();
          ++it)
     {
+        const PipelineNode &node = pipeline[*it];
+        
     	OG_LOGINF("Core", "init proc#%d", num);
 
-        // find out the input frame size for the proc
+        // find out the input frame size for the proc: it is the size of input 0
         int pipelineFrameW, pipelineFrameH;
         
-        if (num == 0) { // special set up for first pipeline processor
-            firstProc = *it;
-            
-            // first pipeline processor will get input data (e.g. RGBA pixel data)
-            firstProc->setExternalInputDataFormat(inFmt);
-            
-            // first pipeline's frame size is the input frame size
+        if (node.inputs[0] < 0) {
+            // frame size of processors that use the pipeline input is the input frame size
             pipelineFrameW = inputFrameW;
             pipelineFrameH = inputFrameH;
         } else {
-            // subsequent pipeline's frame size is the previous processor's output frame size
-            pipelineFrameW = prevProc->getOutFrameW();
-            pipelineFrameH = prevProc->getOutFrameH();
+            // other processors' frame size is their input processor's output frame size
+            pipelineFrameW = pipeline[node.inputs[0]].proc->getOutFrameW();
+            pipelineFrameH = pipeline[node.inputs[0]].proc->getOutFrameH();
         }
         
+        bool externalInput = node.proc == firstProc && inFmt != GL_NONE;
+        
         if (!prepared) {    // for first time preparation
             // initialize current proc
-            numInitialized = (*it)->init(pipelineFrameW, pipelineFrameH, num, num == 0 && inFmt != GL_NONE);
+            node.proc->setGLContextPtr(glContextPtr);
+            node.proc->setShaderRegistry(&shaderRegistry);
+            node.proc->setGLState(&glState);
+            node.proc->setNumFrameSlots(frameRingDepth);
+            numInitialized = node.proc->init(pipelineFrameW, pipelineFrameH, num, externalInput);
         } else {    // for reinitialization with different frame size
-            numInitialized = (*it)->reinit(pipelineFrameW, pipelineFrameH, num == 0 && inFmt != GL_NONE);
-        }
-        
-        // if this proc will downscale, we should generate a mipmap for the previous output
-        if (num > 0) {
-            // create a texture that is attached to an FBO for the output
-            prevProc->createFBOTex(useMipmaps && (*it)->getWillDownscale());
+            numInitialized = node.proc->reinit(pipelineFrameW, pipelineFrameH, externalInput);
         }
         
-        // set pointer to previous proc
-        prevProc = *it;
-        
         num += numInitialized;
     }
     
-    // create the FBO texture for the last processor, too
-    prevProc->createFBOTex(false);
+    // render chains of point operations in one pass
+    if (!prepared && useShaderFusion) {
+        fusePointOps();
+    }
     
-    // concatenate all processors
-    prevProc = NULL;
-    for (list<ProcInterface *>::iterator it = pipeline.begin();
-         it != pipeline.end();
-         ++it)
-    {
-        if (prevProc) {
-            // set input texture id
-            (*it)->useTexture(prevProc->getOutputTexId());  // previous output is this proc's input
+    // create the textures that are attached to an FBO for the output. if a proc
+    // that uses an output will downscale, we should generate a mipmap for this output
+    inputWillDownscale = false;
+    vector<bool> genMipmaps(pipeline.size(), false);
+    
+    for (int n = -1; n < (int)pipeline.size(); n++) {  // n = -1 is the pipeline input
+        bool outputWillBeDownscaled = false;
+        
+        for (vector<PipelineNode>::iterator it = pipeline.begin();
+             it != pipeline.end();
+             ++it)
+        {
+            if (it->proc->getWillDownscale() && find(it->inputs.begin(), it->inputs.end(), n) != it->inputs.end()) {
+                outputWillBeDownscaled = true;
+            }
         }
         
-        // set pointer to previous proc
-        prevProc = *it;
+        if (n < 0) {
+            inputWillDownscale = outputWillBeDownscaled;
+        } else {
+            genMipmaps[n] = useMipmaps && outputWillBeDownscaled;
+        }
     }
     
-    // set last processor
-    lastProc = prevProc;
+    createProcOutputTextures(genMipmaps);
+    
+    if (!prepared) {
+        registerProfilerStages();
+    }
     
-    // get input texture id
+    // get input texture ids
     inputTexId = firstProc->getInputTexId();
+    inputChromaTexIds[0] = firstProc->getInputChromaTexId(0);
+    inputChromaTexIds[1] = firstProc->getInputChromaTexId(1);
+    
+    // connect all processors
+    connectProcInputs();
     
     // set output texture id and size
     outputTexId = lastProc->getOutputTexId();
     outputFrameW = lastProc->getOutFrameW();
     outputFrameH = lastProc->getOutFrameH();
     
+    // initialize the output packing pass if necessary
+    if (outputPackProc) {
+        if (!prepared) {
+            outputPackProc->setGLContextPtr(glContextPtr);
+            outputPackProc->setShaderRegistry(&shaderRegistry);
+            outputPackProc->setGLState(&glState);
+            outputPackProc->setNumFrameSlots(frameRingDepth);
+            num += outputPackProc->init(outputFrameW, outputFrameH, num);
+        } else {
+            outputPackProc->reinit(outputFrameW, outputFrameH);
+        }
+        
+        outputPackProc->createFBOTex(false);
+        outputPackProc->useTexture(outputTexId);
+    }
+    
     // initialize render display if necessary
     if (renderDisp) {
         if (!prepared) {
+            renderDisp->setGLContextPtr(glContextPtr);
+            renderDisp->setShaderRegistry(&shaderRegistry);
             renderDisp->init(outputFrameW, outputFrameH, num);
         } else {
             renderDisp->reinit(outputFrameW, outputFrameH);
@@ -222,14 +451,17 @@ void Core::prepare(int inW, int inH, GLenum inFmt) {
         renderDisp->useTexture(outputTexId);
     }
     
+    // the processors' regions for the new frame sizes
+    applyROI();
+    
     OG_LOGINF("Core", "prepared (input tex %d, output tex %d)", inputTexId, outputTexId);
     
     // print report (to spot errors in the pipeline)
-    for (list<ProcInterface *>::iterator it = pipeline.begin();
-         it != pipeline.end();
+    for (vector<int>::iterator it = schedule.begin();
+         it != schedule.end();
          ++it)
     {
-        (*it)->printInfo();
+        pipeline[*it].proc->printInfo();
     }
 
     glFinish();
@@ -244,18 +476,69 @@ MemTransfer *Core::getInputMemTransfer() const {
 }
 
 MemTransfer *Core::getOutputMemTransfer() const {
-    return lastProc->getMemTransferObj();
+    return getOutputReadProc(lastProc)->getMemTransferObj();
+}
+
+int Core::getOutputDataSize() const {
+    ROI outROI = getROI();
+    int w = outROI.w > 0 ? outROI.w : outputFrameW;
+    int h = outROI.w > 0 ? outROI.h : outputFrameH;
+    
+    if (outputFormat == OUTPUT_FORMAT_MASK1) {
+        return (w + 7) / 8 * h;
+    } else if (outputFormat == OUTPUT_FORMAT_GRAY8 || lastProc->getPackedGray()) {
+        return w * h;
+    } else {
+        return w * h * 4;
+    }
+}
+
+void Core::setROI(int x, int y, int w, int h) {
+    roi.x = x;
+    roi.y = y;
+    roi.w = (w > 0 && h > 0) ? w : 0;
+    roi.h = (w > 0 && h > 0) ? h : 0;
+    
+    if (prepared) {
+        applyROI();
+    }
+}
+
+ROI Core::getROI() const {
+    ROI outROI = Tools::clipROI(roi, outputFrameW, outputFrameH);
+    
+    // whole bytes of the output data with 8 pixels per byte
+    if (outputFormat == OUTPUT_FORMAT_MASK1 && outROI.w > 0) {
+        int x1 = min(outputFrameW, (outROI.x + outROI.w + 7) / 8 * 8);
+        outROI.x = outROI.x / 8 * 8;
+        outROI.w = x1 - outROI.x;
+        outROI = Tools::clipROI(outROI, outputFrameW, outputFrameH);
+    }
+    
+    return outROI;
+}
+
+int Core::getInputDataSize() const {
+    return inputDataFormat != GL_NONE ? MemTransfer::getInputDataSize(inputDataFormat, inputFrameW, inputFrameH) : 0;
 }
 
 void Core::setInputTexId(GLuint inTexId, GLenum inTexTarget) {
+    if (backend == PROCESSING_BACKEND_CPU) {
+        OG_LOGERR("Core", "input textures are not supported by the CPU backend");
+        return;
+    }
+    
     inputTexId = inTexId;
     inputTexTarget = inTexTarget;
+    inputChromaTexIds[0] = inputChromaTexIds[1] = 0;
     
-    firstProc->useTexture(inputTexId, 1, inputTexTarget);
+    connectProcInputs();
 }
 
-void Core::setInputData(const unsigned char *data) {
-    assert(initialized && inputTexId > 0);
+void Core::setInputData(const unsigned char *data, int rowStride) {
+    assert(initialized && (inputTexId > 0 || backend == PROCESSING_BACKEND_CPU));
+    
+    Tools::setValidationLevel(validationLevel);
     
 #ifdef OGLES_GPGPU_BENCHMARK
     Tools::resetTimeMeasurement();
@@ -263,6 +546,25 @@ void Core::setInputData(const unsigned char *data) {
     Tools::startTimeMeasurement();
 #endif
     
+    profiler.setFrame(lastFrame + 1);
+    profiler.beginStage(profStageInput);
+    
+    // the CPU backend converts the input data to RGBA like the first processor's shader
+    if (backend == PROCESSING_BACKEND_CPU) {
+        if (cpuTilingActive) {
+            cpuTileExecutor.convInputData(data, inputDataFormat, rowStride, cpuInput);
+        } else {
+            CPUKernels::convInputData(data, inputDataFormat, rowStride, cpuInput);
+        }
+        
+        profiler.endStage(profStageInput);
+        
+#ifdef OGLES_GPGPU_BENCHMARK
+        Tools::stopTimeMeasurement();
+#endif
+        return;
+    }
+    
     // check set up and input data
     if (useMipmaps && !inputSizeIsPOT && !glExtNPOTMipmaps) {
         OG_LOGINF("Core", "WARNING: NPOT input image provided but NPOT mipmapping not supported!");
@@ -270,14 +572,23 @@ void Core::setInputData(const unsigned char *data) {
         useMipmaps = false;
     }
     
+    // the frame slot for the next frame might still be in use by an older frame
+    int slot = getFrameSlot(lastFrame + 1);
+    frameFences[slot].wait();
+    
+    firstProc->selectFrameSlot(slot);
+    inputTexId = firstProc->getInputTexId();
+    inputChromaTexIds[0] = firstProc->getInputChromaTexId(0);
+    inputChromaTexIds[1] = firstProc->getInputChromaTexId(1);
+    
 	// set texture
     glActiveTexture(GL_TEXTURE1);
     
     // copy data as texture to GPU
-    firstProc->setExternalInputData(data);
+    firstProc->setExternalInputData(data, rowStride);
     
     // mipmapping
-    if (firstProc->getWillDownscale() && useMipmaps) {
+    if (inputWillDownscale && useMipmaps) {
         OG_LOGINF("Core", "generating mipmap for input image");
         // enabled
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -291,102 +602,1263 @@ void Core::setInputData(const unsigned char *data) {
 	
     Tools::checkGLErr("Core", "set texture parameters for input data");
     
-    glFinish();
+    if (processingMode == PROCESSING_MODE_SYNC) {
+        glFinish();
+    }
+    
+    profiler.endStage(profStageInput);
     
 #ifdef OGLES_GPGPU_BENCHMARK
     Tools::stopTimeMeasurement();
 #endif
 }
 
-void Core::process() {
+FrameHandle Core::process() {
     assert(initialized);
     
+    Tools::setValidationLevel(validationLevel);
+    
 #ifdef OGLES_GPGPU_BENCHMARK
     Tools::startTimeMeasurement();
 #endif
     
-    // set input texture id
-    firstProc->useTexture(inputTexId, 1, inputTexTarget);
+    // collect the GPU times of previous frames before new queries are issued
+    if (profiler.getActive()) {
+        profiler.collectGPUResults();
+    }
     
-    // run the processors in the pipeline
-    for (list<ProcInterface *>::iterator it = pipeline.begin();
-         it != pipeline.end();
-         ++it)
+    profiler.setFrame(lastFrame + 1);
+    profiler.beginStage(profStageProcess);
+    
+    // the CPU backend has completed the frame when processCPU() returns
+    if (backend == PROCESSING_BACKEND_CPU) {
+        processCPU(getFrameSlot(lastFrame + 1));
+        lastFrame++;
+        
+        profiler.endStage(profStageProcess);
+        
+#ifdef OGLES_GPGPU_BENCHMARK
+        Tools::stopTimeMeasurement();
+#endif
+        
+        return lastFrame;
+    }
+    
+    // select the frame slot for this frame and connect the processors' textures of this slot
+    // (including the input texture)
+    int slot = getFrameSlot(lastFrame + 1);
+    selectFrameSlot(slot);
+    
+    // the OpenGL state might have been changed since the last frame (e.g. by the
+    // input upload)
+    glState.resetCounters();
+    glState.invalidate();
+    
+    // run the processors in the pipeline in topological order, so that each
+    // processor is rendered once after all its inputs
+    int procIdx = 0;
+    for (vector<int>::iterator it = schedule.begin();
+         it != schedule.end();
+         ++it, procIdx++)
     {
-        (*it)->render();
+        if (pipeline[*it].fusedInto >= 0) continue;   // rendered by the processor it is fused into
         
-        glFinish();
+        profiler.beginStage(profProcStages[procIdx]);
+        
+        pipeline[*it].proc->render();
+        
+        if (processingMode == PROCESSING_MODE_SYNC) {
+            glFinish();
+        }
+        
+        profiler.endStage(profProcStages[procIdx]);
+    }
+    
+    // pack the output for the readback
+    if (outputPackProc) {
+        profiler.beginStage(profStageOutputPack);
+        
+        outputPackProc->render();
+        
+        if (processingMode == PROCESSING_MODE_SYNC) {
+            glFinish();
+        }
+        
+        profiler.endStage(profStageOutputPack);
+    }
+    
+    // unbind the framebuffer and disable the vertex attribute arrays after the last
+    // pass. other code changes the OpenGL state directly until the next frame
+    glState.reset();
+    glState.invalidate();
+    
+    // check for errors of the whole frame at once
+    if (validationLevel == VALIDATION_LEVEL_PER_FRAME) {
+        Tools::checkGLErrNow("Core", "process frame");
+    }
+    
+    // start copying the result to CPU memory space
+    if (useAsyncReadback) {
+        getOutputReadProc(lastProc)->startResultReadback(lastFrame + 1);
+    }
+    
+    // mark the end of this frame's commands in the command stream and submit it
+    frameFences[slot].insert();
+    lastFrame++;
+    
+    // the render display shows the output of this frame
+    outputTexId = lastProc->getOutputTexId();
+    
+    if (renderDisp) {
+        renderDisp->useTexture(outputTexId);
     }
     
+    profiler.endStage(profStageProcess);
+    
 #ifdef OGLES_GPGPU_BENCHMARK
     Tools::stopTimeMeasurement();
 #endif
+    
+    return lastFrame;
 }
 
-void Core::getOutputData(unsigned char *buf) {
-    assert(initialized);
+bool Core::isFrameDone(FrameHandle frame) {
+    assert(frame > 0 && frame <= lastFrame);
     
-    glFinish();
+    // commands are executed in order, so a frame whose slot was reused
+    // already is done when the newer frame in this slot is done
+    return frameFences[getFrameSlot(frame)].isSignaled();
+}
+
+bool Core::waitForFrame(FrameHandle frame, double timeoutMs) {
+    assert(frame > 0 && frame <= lastFrame);
+    
+    Fence &fence = frameFences[getFrameSlot(frame)];
+    
+    if (timeoutMs < 0.0) {
+        return fence.wait();
+    } else {
+        return fence.wait((unsigned long long)(timeoutMs * 1000000.0));
+    }
+}
+
+void Core::getOutputData(ProcInterface *proc, unsigned char *buf, FrameHandle frame) {
+    assert(initialized && proc);
+    
+    Tools::setValidationLevel(validationLevel);
+    
+    int n = findProcNode(proc);
+    
+    if (n < 0) {
+        OG_LOGERR("Core", "getOutputData: processor %s is not in the pipeline", proc->getProcName());
+        return;
+    }
+    
+    if (pipeline[n].fusedInto >= 0) {
+        OG_LOGERR("Core", "getOutputData: processor %s is fused into processor %s and has no output",
+                  proc->getProcName(), pipeline[pipeline[n].fusedInto].proc->getProcName());
+        return;
+    }
+    
+    if ((useTexPool || cpuTilingActive) && !pipeline[n].keepOutput && proc != lastProc) {
+        OG_LOGERR("Core", "getOutputData: output of processor %s is not kept (see setKeepOutput())", proc->getProcName());
+        return;
+    }
+    
+    if (frame == 0) {
+        frame = lastFrame;
+    }
+    
+    if (backend == PROCESSING_BACKEND_CPU) {
+        getOutputDataCPU(n, buf, frame);
+        return;
+    }
+    
+    // the packed output is read instead of the last processor's output
+    proc = getOutputReadProc(proc);
+    
+    // select the output slot of this frame
+    int slot = frame > 0 ? getFrameSlot(frame) : 0;
+    proc->selectFrameSlot(slot);
+    
+    // check if an asynchronous readback for this frame is pending
+    bool readbackPending = frame > 0 && proc->getMemTransferObj()->selectReadback(frame);
+    
+    // wait until processing of the frame was completed. a pending readback
+    // will wait by itself
+    if (frame > 0 && !readbackPending) {
+        if (frame + frameRingDepth <= lastFrame) {
+            OG_LOGERR("Core", "output of frame %lu was already overwritten (last frame %lu, frame ring depth %d)",
+                      frame, lastFrame, frameRingDepth);
+        }
+        
+        waitForFrame(frame);
+    } else if (frame == 0) {
+        glFinish();
+    }
 
 #ifdef OGLES_GPGPU_BENCHMARK
     Tools::startTimeMeasurement();
 #endif
     
+    profiler.setFrame(frame);
+    profiler.beginStage(profStageOutput);
+    
     // will copy the result data from the GPU's memory space to <buf>
-    lastProc->getResultData(buf);
+    proc->getResultData(buf);
+    
+    // restore the selected slot
+    proc->selectFrameSlot(selectedSlot);
+    
+    profiler.endStage(profStageOutput);
     
 #ifdef OGLES_GPGPU_BENCHMARK
     Tools::stopTimeMeasurement();
 #endif
 }
 
-#pragma mark helper methods
+#pragma mark profiling methods
 
-void Core::checkGLExtensions() {
-    // get string with extensions seperated by a SPACE
-    string glExtString((const char *)glGetString(GL_EXTENSIONS));
+void Core::startTracing(size_t capacity) {
+    traceRecorder.start(capacity);
+    profiler.setTraceRecorder(&traceRecorder);
+}
+
+void Core::stopTracing() {
+    if (!profiler.getTraceRecorder()) return;
     
-    // get extensions as vector
-    vector<string> glExt = Tools::split(glExtString);
+    // record the GPU events of all submitted frames
+    glFinish();
+    profiler.collectGPUResults();
     
-    // check extensions
-//    OG_LOGINF("Core", "list of extensions:");
-    for (vector<string>::iterator it = glExt.begin();
-         it != glExt.end();
-         ++it)
-    {
-        // get lowercase extension string
-        string extName = *it;
-        transform(extName.begin(), extName.end(), extName.begin(), ::tolower);
-        
-//        OG_LOGINF("Core", "> %s", extName.c_str());
+    profiler.setTraceRecorder(NULL);
+    
+    OG_LOGINF("Core", "stopped tracing with %d events (%lu dropped)",
+              (int)traceRecorder.getNumEvents(), traceRecorder.getNumDroppedEvents());
+}
+
+#pragma mark backend selection methods
+
+void Core::prepareAutoBackend(int inW, int inH, GLenum inFmt) {
+    // the GPU pipeline is always prepared, so that the backend can be switched
+    backend = PROCESSING_BACKEND_GPU;
+    prepareGPU(inW, inH, inFmt);
+    
+    if (!prepared) return;  // invalid pipeline
+    
+    BackendTuningResult res;
+    res.backend = PROCESSING_BACKEND_GPU;
+    res.gpuMs = res.cpuMs = -1.0;
+    res.stored = false;
+    
+    if (!getCPUBackendSupport(inFmt)) {
+        OG_LOGINF("Core", "backend selection: the pipeline is not supported by the CPU backend");
+    } else {
+        string pipelineId = getPipelineId();
         
-        // check for NPOT mipmapping support
-        if (it->compare("gl_arb_texture_non_power_of_two") == 0
-         || it->compare("gl_oes_texture_npot") == 0)
-        {
-            glExtNPOTMipmaps = true;
+        if (backendTuner.getRetune() || !backendTuner.loadResult(pipelineId, res)) {
+            // measure both backends with the same input data
+            res.gpuMs = measureFrameTime(backendTuner.getNumFrames());
+            
+            backend = PROCESSING_BACKEND_CPU;
+            prepareCPU(inW, inH, inFmt);
+            res.cpuMs = measureFrameTime(backendTuner.getNumFrames());
+            
+            res.backend = res.cpuMs < res.gpuMs ? PROCESSING_BACKEND_CPU : PROCESSING_BACKEND_GPU;
+            res.stored = false;
+            
+            backendTuner.storeResult(pipelineId, res);
+            
+            // prepareCPU() has set the frame sizes of the processors for the CPU,
+            // which differ for GPU passes that swap rows and columns
+            if (res.backend == PROCESSING_BACKEND_GPU) {
+                backend = PROCESSING_BACKEND_GPU;
+                prepareGPU(inW, inH, inFmt);
+            }
+        } else if (res.backend == PROCESSING_BACKEND_CPU) {
+            backend = PROCESSING_BACKEND_CPU;
+            prepareCPU(inW, inH, inFmt);
         }
     }
     
-    OG_LOGINF("Core", "NPOT mipmaps support: %d", glExtNPOTMipmaps);
+    backend = res.backend;
+    backendTuner.setResult(res);
+    
+    // free the outputs and threads of the CPU backend if it is not used
+    if (backend == PROCESSING_BACKEND_GPU) {
+        cpuOutputs.clear();
+        cpuTileExecutor.cleanup();
+        cpuTilingActive = false;
+    }
+    
+    OG_LOGINF("Core", "backend selection at %dx%d: GPU %.3f ms, CPU %.3f ms per frame (%s), using the %s backend",
+              inW, inH, res.gpuMs, res.cpuMs, res.stored ? "stored" : "measured",
+              backend == PROCESSING_BACKEND_CPU ? "CPU" : "GPU");
+    
+    // the measured frames do not belong to the profiled frames
+    profiler.collectGPUResults();
+    profiler.resetSamples();
 }
 
-void Core::cleanup() {
-    if (renderDisp) {
-        OG_LOGINF("Core", "deleting render display object");
-        delete renderDisp;
-        renderDisp = NULL;
+bool Core::getCPUBackendSupport(GLenum inFmt) const {
+    if (renderDisp || (inFmt != GL_RGBA && !Tools::isYUVFormat(inFmt))) {
+        return false;
     }
     
-    // call cleanup() on processors
-    for (list<ProcInterface *>::iterator it = pipeline.begin();
+    for (vector<PipelineNode>::const_iterator it = pipeline.begin();
          it != pipeline.end();
          ++it)
     {
-        (*it)->cleanup();
+        if (!it->proc->getCPUSupport()) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+string Core::getPipelineId() const {
+    ostringstream id;
+    
+    id << inputFrameW << "x" << inputFrameH << ", input format " << inputDataFormat
+       << ", output format " << outputFormat << ", frame ring depth " << frameRingDepth
+       << ", async readback " << useAsyncReadback << ", tex pool " << useTexPool
+       << ", shader fusion " << useShaderFusion << ", packed gray " << usePackedGray
+       << ", mipmaps " << useMipmaps << ", CPU threads " << cpuNumThreads
+       << ", CPU tiling " << useCPUTiling << ", CPU tile cache size " << cpuTileCacheSize << "\n";
+    
+    // the output size and orientation of each processor determine its cost
+    for (size_t i = 0; i < pipeline.size(); i++) {
+        ProcInterface *proc = pipeline[i].proc;
+        
+        id << i << ": " << proc->getProcName() << " (inputs";
+        
+        for (size_t j = 0; j < pipeline[i].inputs.size(); j++) {
+            id << " " << pipeline[i].inputs[j];
+        }
+        
+        id << "), output " << proc->getOutFrameW() << "x" << proc->getOutFrameH()
+           << ", orientation " << proc->getOutputRenderOrientation() << "\n";
     }
     
+    return id.str();
+}
+
+double Core::measureFrameTime(int numFrames) {
+    // synthetic input data with some variation
+    vector<unsigned char> input(getInputDataSize());
+    vector<unsigned char> output(getOutputDataSize());
+    
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = (unsigned char)((i * 7 + i / 1024) & 0xFF);
+    }
+    
+    // the frames are processed like by an application that uses the frame ring: the
+    // output of a frame is read after the next frameRingDepth - 1 frames were submitted,
+    // so that the time per frame is the throughput with frames in flight
+    const int numWarmup = 2;
+    int numSubmitted = numWarmup + numFrames + frameRingDepth - 1;
+    vector<FrameHandle> frames(numSubmitted);
+    FrameHandle prevLastFrame = lastFrame;
+    vector<double> times;
+    
+    for (int n = 0; n < numSubmitted; n++) {
+        chrono::steady_clock::time_point t = chrono::steady_clock::now();
+        
+        setInputData(&input[0]);
+        frames[n] = process();
+        
+        int readN = n - (frameRingDepth - 1);
+        if (readN >= 0) {
+            getOutputData(&output[0], frames[readN]);
+        }
+        
+        if (readN >= numWarmup) {
+            times.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - t).count());
+        }
+    }
+    
+    // read the frames that are still in flight
+    for (int readN = max(0, numSubmitted - frameRingDepth + 1); readN < numSubmitted; readN++) {
+        getOutputData(&output[0], frames[readN]);
+    }
+    
+    // all measured frames are completed. restore the frame counter and release their
+    // fences, so that the application's frames continue after the last frame before
+    for (int i = 0; i < OGLES_GPGPU_MAX_FRAME_RING_DEPTH; i++) {
+        frameFences[i].release();
+    }
+    
+    lastFrame = prevLastFrame;
+    
+    sort(times.begin(), times.end());
+    
+    return times[times.size() / 2];
+}
+
+#pragma mark CPU backend methods
+
+void Core::prepareCPU(int inW, int inH, GLenum inFmt) {
+    if (!prepared && !buildSchedule()) {
+        OG_LOGERR("Core", "prepare failed: invalid pipeline");
+        return;
+    }
+    
+    for (vector<PipelineNode>::iterator it = pipeline.begin();
+         it != pipeline.end();
+         ++it)
+    {
+        if (!it->proc->getCPUSupport()) {
+            OG_LOGERR("Core", "prepare failed: processor %s is not supported by the CPU backend", it->proc->getProcName());
+            return;
+        }
+    }
+    
+    if (inFmt == GL_NONE) {
+        OG_LOGERR("Core", "prepare failed: the CPU backend needs input data (input textures are not supported)");
+        return;
+    }
+    
+    // set input frame size
+    inputSizeIsPOT = Tools::isPOT(inW) && Tools::isPOT(inH);
+    inputFrameW = inW;
+    inputFrameH = inH;
+    
+    OG_LOGINF("Core", "prepare for the CPU backend with input frame size %dx%d, %u processors in pipeline, frame ring depth %d",
+              inputFrameW, inputFrameH, (unsigned int)pipeline.size(), frameRingDepth);
+    
+    // of YUV input, only the Y plane is converted if the processors that read the
+    // input only need the luminance (like on the GPU)
+    if (!prepared) {
+        inputLumaOnly = Tools::isYUVFormat(inFmt) && inFmt != INPUT_FORMAT_Y8 && getInputReadersLumaOnly();
+        inputDataFormat = inputLumaOnly ? INPUT_FORMAT_Y8 : inFmt;
+    }
+    
+    cpuInput.resize(inputFrameW, inputFrameH);
+    
+    // set the frame sizes of the pipeline in render order, so that the output sizes
+    // of the input processors are known
+    for (vector<int>::iterator it = schedule.begin();
+         it != schedule.end();
+         ++it)
+    {
+        const PipelineNode &node = pipeline[*it];
+        
+        if (node.inputs[0] < 0) {
+            node.proc->prepareCPU(inputFrameW, inputFrameH);
+        } else {
+            node.proc->prepareCPU(pipeline[node.inputs[0]].proc->getOutFrameW(), pipeline[node.inputs[0]].proc->getOutFrameH());
+        }
+    }
+    
+    // each frame slot keeps the outputs of all processors. with tiled execution, only
+    // the kept outputs are whole frames
+    cpuOutputs.assign(frameRingDepth, vector<CPUImage>(pipeline.size()));
+    cpuTilingActive = useCPUTiling && prepareCPUTiling();
+    
+    if (cpuTilingActive) {
+        for (int slot = 0; slot < frameRingDepth; slot++) {
+            for (size_t i = 0; i < pipeline.size(); i++) {
+                if (pipeline[i].keepOutput || pipeline[i].proc == lastProc) {
+                    cpuOutputs[slot][i].resize(pipeline[i].proc->getOutFrameW(), pipeline[i].proc->getOutFrameH());
+                }
+            }
+        }
+    }
+    
+    outputFrameW = lastProc->getOutFrameW();
+    outputFrameH = lastProc->getOutFrameH();
+    
+    if (renderDisp) {
+        OG_LOGERR("Core", "the render display is not supported by the CPU backend");
+    }
+    
+    if (!prepared) {
+        registerProfilerStages();
+    }
+    
+    prepared = true;
+}
+
+bool Core::prepareCPUTiling() {
+    vector<CPUTileStage> stages;
+    vector<int> nodeLastStage(pipeline.size(), -1);   // stage that writes the output of each node
+    vector<ProcInterface *> passes;
+    
+    cpuTileOutputNodes.clear();
+    
+    for (vector<int>::iterator it = schedule.begin();
+         it != schedule.end();
+         ++it)
+    {
+        const PipelineNode &node = pipeline[*it];
+        
+        passes.clear();
+        node.proc->getCPUPasses(passes);
+        
+        for (size_t p = 0; p < passes.size(); p++) {
+            // each output row must only depend on the input rows near it
+            if (passes[p]->getOutFrameW() != inputFrameW || passes[p]->getOutFrameH() != inputFrameH
+                || passes[p]->getCPURenderOrientation() != RenderOrientationStd)
+            {
+                OG_LOGINF("Core", "processor %s changes the frame size or orientation, no tiled execution",
+                          node.proc->getProcName());
+                return false;
+            }
+            
+            CPUTileStage stage;
+            stage.proc = passes[p];
+            stage.keepOutput = false;
+            
+            // the first pass reads the node's inputs, the others the previous pass
+            if (p == 0) {
+                for (size_t i = 0; i < node.inputs.size(); i++) {
+                    stage.inputs.push_back(node.inputs[i] < 0 ? -1 : nodeLastStage[node.inputs[i]]);
+                }
+            } else {
+                stage.inputs.push_back((int)stages.size() - 1);
+            }
+            
+            stages.push_back(stage);
+            cpuTileOutputNodes.push_back(-1);
+        }
+        
+        nodeLastStage[*it] = (int)stages.size() - 1;
+        
+        if (node.keepOutput || node.proc == lastProc) {
+            stages.back().keepOutput = true;
+            cpuTileOutputNodes.back() = *it;
+        }
+    }
+    
+    cpuTileExecutor.prepare(stages, inputFrameW, inputFrameH, cpuNumThreads, cpuTileCacheSize);
+    cpuTileOutputs.assign(stages.size(), NULL);
+    
+    return true;
+}
+
+void Core::processCPU(int slot) {
+    vector<CPUImage> &outputs = cpuOutputs[slot];
+    
+    // all passes per row band. the processors are not measured separately
+    if (cpuTilingActive) {
+        for (size_t s = 0; s < cpuTileOutputNodes.size(); s++) {
+            cpuTileOutputs[s] = cpuTileOutputNodes[s] < 0 ? NULL : &outputs[cpuTileOutputNodes[s]];
+        }
+        
+        cpuTileExecutor.process(cpuInput, cpuTileOutputs);
+        selectedSlot = slot;
+        
+        return;
+    }
+    
+    vector<const CPUImage *> inputs;
+    
+    int procIdx = 0;
+    for (vector<int>::iterator it = schedule.begin();
+         it != schedule.end();
+         ++it, procIdx++)
+    {
+        const PipelineNode &node = pipeline[*it];
+        
+        // the inputs were processed before in this frame
+        inputs.clear();
+        for (size_t i = 0; i < node.inputs.size(); i++) {
+            inputs.push_back(node.inputs[i] < 0 ? &cpuInput : &outputs[node.inputs[i]]);
+        }
+        
+        profiler.beginStage(profProcStages[procIdx]);
+        
+        node.proc->processCPU(inputs, outputs[*it]);
+        
+        profiler.endStage(profProcStages[procIdx]);
+    }
+    
+    selectedSlot = slot;
+}
+
+void Core::getOutputDataCPU(int n, unsigned char *buf, FrameHandle frame) {
+    if (frame + frameRingDepth <= lastFrame) {
+        OG_LOGERR("Core", "output of frame %lu was already overwritten (last frame %lu, frame ring depth %d)",
+                  frame, lastFrame, frameRingDepth);
+    }
+    
+#ifdef OGLES_GPGPU_BENCHMARK
+    Tools::startTimeMeasurement();
+#endif
+    
+    profiler.setFrame(frame);
+    profiler.beginStage(profStageOutput);
+    
+    const CPUImage *output = &cpuOutputs[frame > 0 ? getFrameSlot(frame) : 0][n];
+    
+    // copy the region of interest of the output
+    ROI outROI = getROI();
+    
+    if (pipeline[n].proc == lastProc && outROI.w > 0) {
+        cpuROIOutput.resize(outROI.w, outROI.h);
+        
+        for (int y = 0; y < outROI.h; y++) {
+            memcpy(cpuROIOutput.getRow(y), output->getRow(outROI.y + y) + outROI.x * 4, outROI.w * 4);
+        }
+        
+        output = &cpuROIOutput;
+    }
+    
+    // the output format only applies to the last added processor. the outputs of
+    // packed processors (of a GPU pipeline, see PROCESSING_BACKEND_AUTO) are read
+    // with one byte per pixel like on the GPU
+    if (pipeline[n].proc == lastProc && outputFormat == OUTPUT_FORMAT_MASK1) {
+        CPUKernels::packMask1(*output, buf);
+    } else if ((pipeline[n].proc == lastProc && outputFormat == OUTPUT_FORMAT_GRAY8) || pipeline[n].proc->getPackedGray()) {
+        CPUKernels::packGray8(*output, buf);
+    } else {
+        memcpy(buf, output->getData(), output->getDataSize());
+    }
+    
+    profiler.endStage(profStageOutput);
+    
+#ifdef OGLES_GPGPU_BENCHMARK
+    Tools::stopTimeMeasurement();
+#endif
+}
+
+#pragma mark helper methods
+
+void Core::selectFrameSlot(int slot) {
+    for (vector<PipelineNode>::iterator it = pipeline.begin();
+         it != pipeline.end();
+         ++it)
+    {
+        it->proc->selectFrameSlot(slot);
+    }
+    
+    if (outputPackProc) {
+        outputPackProc->selectFrameSlot(slot);
+    }
+    
+    // the outputs of this slot are the inputs of the following processors
+    connectProcInputs();
+    
+    selectedSlot = slot;
+}
+
+void Core::connectProcInputs() {
+    for (vector<PipelineNode>::iterator it = pipeline.begin();
+         it != pipeline.end();
+         ++it)
+    {
+        if (it->fusedInto >= 0) continue;   // not rendered
+        
+        for (size_t i = 0; i < it->inputs.size(); i++) {
+            int src = resolveFusedInput(it->inputs[i]);
+            
+            if (src < 0) {  // pipeline input
+                it->proc->useInputTexture((int)i, inputTexId, inputTexTarget);
+                
+                if (i == 0) it->proc->useInputChromaTextures(inputChromaTexIds[0], inputChromaTexIds[1]);
+            } else {        // output of another processor
+                it->proc->useInputTexture((int)i, pipeline[src].proc->getOutputTexId());
+            }
+        }
+    }
+    
+    if (outputPackProc) {
+        outputPackProc->useInputTexture(0, lastProc->getOutputTexId());
+    }
+}
+
+bool Core::buildSchedule() {
+    int numNodes = (int)pipeline.size();
+    
+    // resolve the input processors to node indices
+    vector<int> numPendingInputs(numNodes, 0);
+    firstProc = NULL;
+    
+    for (int n = 0; n < numNodes; n++) {
+        PipelineNode &node = pipeline[n];
+        
+        if ((int)node.inputProcs.size() != node.proc->getNumInputs()) {
+            OG_LOGERR("Core", "processor %s needs %d inputs, but %d were set",
+                      node.proc->getProcName(), node.proc->getNumInputs(), (int)node.inputProcs.size());
+            return false;
+        }
+        
+        node.inputs.clear();
+        for (size_t i = 0; i < node.inputProcs.size(); i++) {
+            int src = node.inputProcs[i] ? findProcNode(node.inputProcs[i]) : -1;
+            
+            if (node.inputProcs[i] && src < 0) {
+                OG_LOGERR("Core", "input processor %s of processor %s is not in the pipeline",
+                          node.inputProcs[i]->getProcName(), node.proc->getProcName());
+                return false;
+            }
+            
+            node.inputs.push_back(src);
+            
+            if (src >= 0) numPendingInputs[n]++;
+        }
+    }
+    
+    // sort topologically (Kahn's algorithm). nodes that are ready are scheduled
+    // in the order in which they were added, so a linear pipeline keeps its order
+    schedule.clear();
+    vector<bool> scheduled(numNodes, false);
+    
+    while ((int)schedule.size() < numNodes) {
+        int next = -1;
+        for (int n = 0; n < numNodes && next < 0; n++) {
+            if (!scheduled[n] && numPendingInputs[n] == 0) next = n;
+        }
+        
+        if (next < 0) {
+            OG_LOGERR("Core", "pipeline contains a cycle");
+            return false;
+        }
+        
+        schedule.push_back(next);
+        scheduled[next] = true;
+        
+        // all inputs that refer to this node are resolved now
+        for (int n = 0; n < numNodes; n++) {
+            numPendingInputs[n] -= (int)count(pipeline[n].inputs.begin(), pipeline[n].inputs.end(), next);
+        }
+    }
+    
+    // the first processor in render order that uses the pipeline input as input 0
+    // gets the input data. all other processors that use the pipeline input share
+    // its input texture
+    for (vector<int>::iterator it = schedule.begin();
+         it != schedule.end() && !firstProc;
+         ++it)
+    {
+        if (pipeline[*it].inputs[0] < 0) firstProc = pipeline[*it].proc;
+    }
+    
+    if (!firstProc) {
+        OG_LOGERR("Core", "no processor uses the pipeline input as first input");
+        return false;
+    }
+    
+    return true;
+}
+
+void Core::createProcOutputTextures(const vector<bool> &genMipmaps) {
+    texPool.release();
+    
+    if (!useTexPool) {  // each processor creates its own textures
+        for (size_t n = 0; n < pipeline.size(); n++) {
+            if (pipeline[n].fusedInto >= 0) continue;   // not rendered, no output texture needed
+            
+            pipeline[n].proc->setFBOTexPool(NULL, 0, 0, true);
+            pipeline[n].proc->createFBOTex(genMipmaps[n]);
+        }
+        
+        return;
+    }
+    
+    // number the render passes in render order (one step per pass) and find the
+    // last step in which the output of each node is read
+    vector<int> firstStep(pipeline.size(), 0);
+    vector<int> lastStep(pipeline.size(), 0);
+    int step = 0;
+    
+    for (vector<int>::iterator it = schedule.begin();
+         it != schedule.end();
+         ++it)
+    {
+        if (pipeline[*it].fusedInto >= 0) continue;     // not rendered
+        
+        firstStep[*it] = step;
+        step += pipeline[*it].proc->getNumPasses();
+        lastStep[*it] = step - 1;
+    }
+    
+    for (size_t n = 0; n < pipeline.size(); n++) {
+        if (pipeline[n].fusedInto >= 0) continue;
+        
+        const vector<int> &inputs = pipeline[n].inputs;
+        
+        for (vector<int>::const_iterator in = inputs.begin();
+             in != inputs.end();
+             ++in)
+        {
+            int src = resolveFusedInput(*in);
+            
+            if (src >= 0) {     // the input is read in the first pass of this node
+                lastStep[src] = max(lastStep[src], firstStep[n]);
+            }
+        }
+    }
+    
+    // assign the textures in render order
+    for (vector<int>::iterator it = schedule.begin();
+         it != schedule.end();
+         ++it)
+    {
+        PipelineNode &node = pipeline[*it];
+        
+        if (node.fusedInto >= 0) continue;
+        
+        bool keep = node.keepOutput || node.proc == lastProc;
+        
+        node.proc->setFBOTexPool(&texPool, firstStep[*it], lastStep[*it], keep);
+        node.proc->createFBOTex(genMipmaps[*it]);
+    }
+    
+    OG_LOGINF("Core", "texture pool: %d textures (%d KB) for %d outputs (%d KB per frame slot without pool)",
+              texPool.getNumTextures(), (int)(texPool.getMemSize() / 1024),
+              texPool.getNumRequests(), (int)(texPool.getRequestedMemSize() / 1024));
+}
+
+void Core::fusePointOps() {
+    // count the processors that read the output of each node
+    vector<int> numConsumers(pipeline.size(), 0);
+    
+    for (vector<PipelineNode>::iterator it = pipeline.begin();
+         it != pipeline.end();
+         ++it)
+    {
+        for (vector<int>::iterator in = it->inputs.begin();
+             in != it->inputs.end();
+             ++in)
+        {
+            if (*in >= 0) numConsumers[*in]++;
+        }
+    }
+    
+    // extend the chains in render order, so that the chain that ends in the input
+    // node of a processor is already known
+    for (vector<int>::iterator it = schedule.begin();
+         it != schedule.end();
+         ++it)
+    {
+        PipelineNode &node = pipeline[*it];
+        
+        if (!node.proc->getIsPointOp() || node.inputs.size() != 1 || node.inputs[0] < 0) continue;
+        
+        int src = node.inputs[0];
+        PipelineNode &srcNode = pipeline[src];
+        
+        // the output of the input node must only be used by this processor
+        if (!srcNode.proc->getIsPointOp() || numConsumers[src] != 1
+            || srcNode.keepOutput || srcNode.proc == lastProc)
+        {
+            continue;
+        }
+        
+        // the fused shader renders with the output size and orientation of the first
+        // processor of the chain
+        if (node.proc->getOutputRenderOrientation() != RenderOrientationStd
+            || node.proc->getOutFrameW() != srcNode.proc->getOutFrameW()
+            || node.proc->getOutFrameH() != srcNode.proc->getOutFrameH())
+        {
+            continue;
+        }
+        
+        // take over the chain of the input node
+        node.fusedStages = srcNode.fusedStages;
+        node.fusedStages.push_back(src);
+        srcNode.fusedStages.clear();
+        
+        for (vector<int>::iterator stage = node.fusedStages.begin();
+             stage != node.fusedStages.end();
+             ++stage)
+        {
+            pipeline[*stage].fusedInto = *it;
+        }
+    }
+    
+    // create the fused shaders. point operations are always derived from FilterProcBase
+    for (vector<PipelineNode>::iterator it = pipeline.begin();
+         it != pipeline.end();
+         ++it)
+    {
+        if (it->fusedInto >= 0 || it->fusedStages.empty()) continue;
+        
+        vector<FilterProcBase *> stages;
+        
+        for (vector<int>::iterator stage = it->fusedStages.begin();
+             stage != it->fusedStages.end();
+             ++stage)
+        {
+            stages.push_back(static_cast<FilterProcBase *>(pipeline[*stage].proc));
+            
+            OG_LOGINF("Core", "fusing point operation %s into %s",
+                      pipeline[*stage].proc->getProcName(), it->proc->getProcName());
+        }
+        
+        // the fused shader reads the input of the first stage, which might be the YUV
+        // pipeline input
+        if (pipeline[it->fusedStages[0]].inputs[0] < 0) {
+            it->proc->setExternalInputDataFormat(inputDataFormat);
+        }
+        
+        static_cast<FilterProcBase *>(it->proc)->setFusedStages(stages);
+    }
+}
+
+void Core::selectPackedGrayProcs() {
+    int numNodes = (int)pipeline.size();
+    vector<bool> packed(numNodes, false);
+    
+    if (usePackedGray) {
+        // in render order: grayscale conversions pack unpacked input, other processors
+        // keep packed input packed
+        for (vector<int>::iterator it = schedule.begin();
+             it != schedule.end();
+             ++it)
+        {
+            const PipelineNode &node = pipeline[*it];
+            PackedGraySupport support = node.proc->getPackedGraySupport();
+            
+            if (support == PACKED_GRAY_PACK) {
+                packed[*it] = true;
+                
+                for (size_t i = 0; i < node.inputs.size(); i++) {
+                    if (node.inputs[i] >= 0 && packed[node.inputs[i]]) packed[*it] = false;
+                }
+            } else if (support == PACKED_GRAY_KEEP) {
+                packed[*it] = node.inputs.size() == 1 && node.inputs[0] >= 0 && packed[node.inputs[0]];
+            }
+        }
+        
+        // in reverse render order: an output can only be packed if all its consumers
+        // read packed input. the render display needs unpacked output
+        for (vector<int>::reverse_iterator it = schedule.rbegin();
+             it != schedule.rend();
+             ++it)
+        {
+            if (!packed[*it]) continue;
+            
+            if (renderDisp && pipeline[*it].proc == lastProc) {
+                packed[*it] = false;
+            }
+            
+            for (int n = 0; n < numNodes && packed[*it]; n++) {
+                const vector<int> &inputs = pipeline[n].inputs;
+                
+                if (!packed[n] && find(inputs.begin(), inputs.end(), *it) != inputs.end()) {
+                    packed[*it] = false;
+                }
+            }
+        }
+        
+        // in render order again: processors that keep packed input whose input is not
+        // packed anymore
+        for (vector<int>::iterator it = schedule.begin();
+             it != schedule.end();
+             ++it)
+        {
+            if (pipeline[*it].proc->getPackedGraySupport() == PACKED_GRAY_KEEP && packed[*it]) {
+                packed[*it] = packed[pipeline[*it].inputs[0]];
+            }
+        }
+    }
+    
+    for (int n = 0; n < numNodes; n++) {
+        pipeline[n].proc->setPackedGray(packed[n]);
+        
+        if (packed[n]) {
+            OG_LOGINF("Core", "processor %s writes packed grayscale output", pipeline[n].proc->getProcName());
+        }
+    }
+}
+
+int Core::resolveFusedInput(int src) const {
+    // a fused node's input is read by the node that renders its point operation
+    while (src >= 0 && pipeline[src].fusedInto >= 0) {
+        src = pipeline[src].inputs[0];
+    }
+    
+    return src;
+}
+
+ProcInterface *Core::getOutputReadProc(ProcInterface *proc) const {
+    return (proc == lastProc && outputPackProc) ? outputPackProc : proc;
+}
+
+void Core::applyROI() {
+    // the CPU backend processes whole frames (see getOutputDataCPU())
+    if (backend == PROCESSING_BACKEND_CPU) return;
+    
+    ROI outROI = getROI();
+    
+    if (outROI.w <= 0) {
+        outROI.x = outROI.y = 0;
+        outROI.w = outputFrameW;
+        outROI.h = outputFrameH;
+    }
+    
+    // region of the output of each node that is read. h = 0 if it is not read
+    ROI noROI = { 0, 0, 0, 0 };
+    vector<ROI> regions(pipeline.size(), noROI);
+    
+    int lastNode = findProcNode(lastProc);
+    regions[lastNode] = outROI;
+    
+    // the packing pass renders the region and reads whole texels of the last
+    // processor's output
+    if (outputPackProc) {
+        outputPackProc->setRenderROI(outROI);
+        regions[lastNode] = outputPackProc->getInputROI(outputFrameW, outputFrameH);
+    }
+    
+    getOutputReadProc(lastProc)->setReadbackROI(outROI);
+    
+    // go backwards through the render order, so that the regions of all consumers
+    // of a node are known before the node's region is set
+    for (vector<int>::reverse_iterator it = schedule.rbegin();
+         it != schedule.rend();
+         ++it)
+    {
+        const PipelineNode &node = pipeline[*it];
+        
+        if (node.fusedInto >= 0) continue;   // rendered by the processor it is fused into
+        
+        ROI &region = regions[*it];
+        
+        // kept outputs and outputs that nothing reads are rendered completely
+        if (node.keepOutput || region.h <= 0) {
+            region.x = region.y = 0;
+            region.w = node.proc->getOutFrameW();
+            region.h = node.proc->getOutFrameH();
+        }
+        
+        node.proc->setRenderROI(region);
+        
+        // extend the regions of the nodes that render the inputs by the input
+        // regions that this node reads
+        for (size_t i = 0; i < node.inputs.size(); i++) {
+            int src = resolveFusedInput(node.inputs[i]);
+            if (src < 0) continue;
+            
+            ROI in = node.proc->getInputROI(pipeline[src].proc->getOutFrameW(), pipeline[src].proc->getOutFrameH());
+            ROI &srcRegion = regions[src];
+            
+            if (srcRegion.h <= 0) {
+                srcRegion = in;
+            } else {
+                int x1 = max(srcRegion.x + srcRegion.w, in.x + in.w);
+                int y1 = max(srcRegion.y + srcRegion.h, in.y + in.h);
+                srcRegion.x = min(srcRegion.x, in.x);
+                srcRegion.y = min(srcRegion.y, in.y);
+                srcRegion.w = x1 - srcRegion.x;
+                srcRegion.h = y1 - srcRegion.y;
+            }
+        }
+    }
+    
+    OG_LOGINF("Core", "region of interest %d,%d %dx%d of the output frame %dx%d",
+              outROI.x, outROI.y, outROI.w, outROI.h, outputFrameW, outputFrameH);
+}
+
+bool Core::getInputReadersLumaOnly() const {
+    for (vector<PipelineNode>::const_iterator it = pipeline.begin();
+         it != pipeline.end();
+         ++it)
+    {
+        for (size_t i = 0; i < it->inputs.size(); i++) {
+            if (it->inputs[i] < 0 && (i > 0 || !it->proc->getReadsLumaOnly())) return false;
+        }
+    }
+    
+    return true;
+}
+
+int Core::getNumPackedGrayProcs() const {
+    int num = 0;
+    
+    for (vector<PipelineNode>::const_iterator it = pipeline.begin();
+         it != pipeline.end();
+         ++it)
+    {
+        if (it->proc->getPackedGray()) num++;
+    }
+    
+    return num;
+}
+
+int Core::getNumFusedProcs() const {
+    int num = 0;
+    
+    for (vector<PipelineNode>::const_iterator it = pipeline.begin();
+         it != pipeline.end();
+         ++it)
+    {
+        if (it->fusedInto >= 0) num++;
+    }
+    
+    return num;
+}
+
+int Core::findProcNode(const ProcInterface *proc) const {
+    for (size_t i = 0; i < pipeline.size(); i++) {
+        if (pipeline[i].proc == proc) return (int)i;
+    }
+    
+    return -1;
+}
+
+void Core::registerProfilerStages() {
+    profiler.clear();
+    profProcStages.clear();
+    
+    profStageInput = profiler.addStage("Core::setInputData");
+    profStageProcess = profiler.addStage("Core::process");
+    
+    unsigned int num = 0;
+    for (vector<int>::iterator it = schedule.begin();
+         it != schedule.end();
+         ++it)
+    {
+        const PipelineNode &node = pipeline[*it];
+        ProcInterface *proc = node.proc;
+        
+        ostringstream name;
+        name << "proc#" << num++ << " " << proc->getProcName();
+        
+        if (node.fusedInto >= 0) {  // not rendered, so nothing to measure
+            profProcStages.push_back(-1);
+            continue;
+        }
+        
+        // show which processors are rendered in the shader of this processor
+        if (!node.fusedStages.empty()) {
+            name << " (fused:";
+            
+            for (size_t i = 0; i < node.fusedStages.size(); i++) {
+                name << " " << pipeline[node.fusedStages[i]].proc->getProcName();
+            }
+            
+            name << ")";
+        }
+        
+        int stage = profiler.addStage(name.str(), profStageProcess);
+        profProcStages.push_back(stage);
+        
+        // let multipass processors register their passes
+        proc->setProfiler(&profiler, stage);
+    }
+    
+    profStageOutputPack = outputPackProc ? profiler.addStage("output packing", profStageProcess) : -1;
+    profStageOutput = profiler.addStage("Core::getOutputData");
+}
+
+void Core::checkGLExtensions() {
+    // get string with extensions seperated by a SPACE
+    string glExtString((const char *)glGetString(GL_EXTENSIONS));
+    
+    // get extensions as vector
+    vector<string> glExt = Tools::split(glExtString);
+    
+    // check extensions
+//    OG_LOGINF("Core", "list of extensions:");
+    for (vector<string>::iterator it = glExt.begin();
+         it != glExt.end();
+         ++it)
+    {
+        // get lowercase extension string
+        string extName = *it;
+        transform(extName.begin(), extName.end(), extName.begin(), ::tolower);
+        
+//        OG_LOGINF("Core", "> %s", extName.c_str());
+        
+        // check for NPOT mipmapping support
+        if (extName.compare("gl_arb_texture_non_power_of_two") == 0
+         || extName.compare("gl_oes_texture_npot") == 0)
+        {
+            glExtNPOTMipmaps = true;
+        }
+        
+        // check for fence sync support on iOS
+        if (extName.compare("gl_apple_sync") == 0) {
+            glExtAppleSync = true;
+        }
+        
+        // check for GPU timer query support
+        if (extName.compare("gl_ext_disjoint_timer_query") == 0) {
+            glExtDisjointTimerQuery = true;
+        }
+        
+        // check for program binary support
+        if (extName.compare("gl_oes_get_program_binary") == 0) {
+            glExtProgramBinary = true;
+        }
+        
+        // check for vertex array object support
+        if (extName.compare("gl_oes_vertex_array_object") == 0) {
+            glExtVertexArrayObject = true;
+        }
+    }
+    
+    // check for OpenGL ES 3.0 context
+    glES3 = Tools::isGLES3Context();
+    
+    // set up fence support for asynchronous processing in this context
+    FenceType fenceType = Fence::initFenceSupport(glES3, glExtAppleSync);
+    for (int i = 0; i < OGLES_GPGPU_MAX_FRAME_RING_DEPTH; i++) {
+        frameFences[i].setFenceType(fenceType);
+    }
+    
+    // GPU times for profiling
+    profiler.initGPUTimerSupport(glExtDisjointTimerQuery);
+    
+    // program binaries for the shader cache
+    programCache.initProgramBinarySupport(glES3, glExtProgramBinary);
+    
+    OG_LOGINF("Core", "NPOT mipmaps support: %d", glExtNPOTMipmaps);
+    OG_LOGINF("Core", "OpenGL ES 3 context: %d (%s)", glES3, (const char *)glGetString(GL_VERSION));
+}
+
+void Core::cleanup() {
+    // delete sync objects
+    for (int i = 0; i < OGLES_GPGPU_MAX_FRAME_RING_DEPTH; i++) {
+        frameFences[i].release();
+    }
+    
+    // delete profiler stages and their queries
+    profiler.clear();
+    
+    if (renderDisp) {
+        OG_LOGINF("Core", "deleting render display object");
+        delete renderDisp;
+        renderDisp = NULL;
+    }
+    
+    if (outputPackProc) {
+        delete outputPackProc;
+        outputPackProc = NULL;
+    }
+    
+    // call cleanup() on processors
+    for (vector<PipelineNode>::iterator it = pipeline.begin();
+         it != pipeline.end();
+         ++it)
+    {
+        it->proc->setProfiler(NULL, -1);
+        it->proc->cleanup();
+        it->proc->setShaderRegistry(NULL);
+        it->proc->setGLState(NULL);
+        it->proc->setPackedGray(false);
+    }
+    
+    // delete the shared vertex buffers after the processors' vertex array objects
+    glState.setQuadBuffers(NULL);
+    quadBuffers.release();
+    
+    // delete pooled output textures
+    texPool.release();
+    
+    // free the outputs of the CPU backend and stop its threads
+    cpuOutputs.clear();
+    cpuTileExecutor.cleanup();
+    cpuTilingActive = false;
+    
+    // all shader programs were released by the processors
+    shaderRegistry.clear();
+    shaderRegistry.resetCounters();
+    
     // clear processor pipeline. this only deletes the pointers to the processors
     // the processor objects are not deleted in this class, because it only
     // stores weak references
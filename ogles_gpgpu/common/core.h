@@ -17,33 +17,69 @@
 #include "common_includes.h"
 #include "proc/base/procinterface.h"
 #include "gl/memtransfer.h"
+#include "gl/fence.h"
+#include "gl/texpool.h"
+#include "gl/programcache.h"
+#include "gl/shaderregistry.h"
+#include "gl/glstate.h"
+#include "gl/quadbuffers.h"
+#include "profiler.h"
+#include "backendtuner.h"
+#include "cpu/cpuimage.h"
+#include "cpu/cputileexecutor.h"
 
-#include <list>
 #include <vector>
 
 using namespace std;
 
+#define OGLES_GPGPU_MAX_FRAME_RING_DEPTH    4
+
 namespace ogles_gpgpu {
 
 class Disp;
+class PackProc;
+
+/**
+ * Processing modes for Core::process().
+ */
+typedef enum {
+    PROCESSING_MODE_ASYNC = 0,  // submit the whole pipeline as one command stream and track its completion with a fence (default)
+    PROCESSING_MODE_SYNC        // block with glFinish() after each processor (useful for debugging)
+} ProcessingMode;
+
+/**
+ * Handle to a frame that was submitted with Core::process(). Can be used to poll
+ * or wait for the completion of the frame. Valid handles are > 0.
+ */
+typedef unsigned long FrameHandle;
 
 /**
  * main processing handler. set up and initialize processing pipeline.
  * set processing input, run the processing tasks, get the processing output.
- * is a singleton class that returns an object via getInstance().
+ * Several Core objects can be created, each with its own pipeline and its own
+ * OpenGL context (or contexts that share their objects). A Core object and its
+ * processors must only be used in the thread in which its OpenGL context is current,
+ * but different Core objects can be used concurrently in different threads.
+ * For convenience, a default instance is available via getInstance().
  */
 class Core {
 public:
     /**
-     * Get singleton instance.
+     * Get the default instance. It is created on first use. Not thread-safe.
      */
     static Core *getInstance();
     
     /**
-     * Destroy singleton instance.
+     * Destroy the default instance.
      */
     static void destroy();
     
+    /**
+     * Constructor. Creates an independent processing pipeline, which is used in
+     * the OpenGL context that is current when init() is called.
+     */
+    Core();
+    
     /**
      * Deconstructor. Will call cleanup().
      */
@@ -56,13 +92,42 @@ public:
     
     /**
      * Add a weak ref pointer to a GPGPU processor object to the pipeline.
+     * Its input is the output of the previously added processor, or the pipeline
+     * input if it is the first processor, so that consecutive calls define a
+     * linear pipeline.
      * Note: OpenGL context must be initialized before a ProcInterface object
      * was created!
      */
     void addProcToPipeline(ProcInterface *proc);
     
     /**
-     * Create an object that renders the last processor's output to the screen.
+     * Add a weak ref pointer to a GPGPU processor object to the pipeline and use
+     * the output of processor <input> as its input. Pass NULL as <input> to use the
+     * pipeline input. Several processors can use the same input, so that the
+     * pipeline branches. <input> must be added to the pipeline, too (it may be
+     * added later).
+     */
+    void addProcToPipeline(ProcInterface *proc, ProcInterface *input);
+    
+    /**
+     * Add a weak ref pointer to a GPGPU processor object with two inputs (e.g.
+     * DiffProc, BlendProc) to the pipeline and use the outputs of processors
+     * <input1> and <input2> as its inputs. Pass NULL to use the pipeline input.
+     */
+    void addProcToPipeline(ProcInterface *proc, ProcInterface *input1, ProcInterface *input2);
+    
+    /**
+     * Add a weak ref pointer to a GPGPU processor object to the pipeline and use
+     * the outputs of processors <inputs> as its inputs (one processor per input,
+     * see ProcInterface::getNumInputs()). Pass NULL to use the pipeline input.
+     * The processors form a directed acyclic graph. In prepare(), they are sorted
+     * topologically, so that each processor is rendered after its inputs and
+     * exactly once per frame, no matter how many processors use its output.
+     */
+    void addProcToPipeline(ProcInterface *proc, const vector<ProcInterface *> &inputs);
+    
+    /**
+     * Create an object that renders the last added processor's output to the screen.
      * Return it as weak ref.
      * Parameters <dispW>, <dispH> and <orientation> set the render display properties.
      * They do not have to be set at this point, you can later use the methods of the
@@ -84,8 +149,14 @@ public:
     
     /**
      * Prepare the processing pipeline for incoming frames of size <inW> x <inH>
-     * and pixel format <inFmt>.
-     * Can be called several times (will re-initialize the pipeline).
+     * and pixel format <inFmt>. Besides GL_RGBA, <inFmt> can be one of the YUV formats
+     * (see InputYUVFormat), e.g. camera frames in INPUT_FORMAT_NV21. Their planes are
+     * uploaded as separate textures and converted to RGBA in the shaders of the
+     * processors that read the pipeline input. If these processors only need the
+     * luminance (e.g. GrayscaleProc, see getInputLumaOnly()), only the Y plane is
+     * uploaded. Pass GL_NONE for input via setInputTexId().
+     * Can be called several times (will re-initialize the pipeline), but <inFmt>
+     * must stay the same.
      * Note OpenGL context must be initialized before the pipeline was
      * defined!
      * Note that init() must have been called before.
@@ -98,12 +169,12 @@ public:
     Disp *getRenderDisplay() const { return renderDisp; }
     
     /**
-     * Get pointer to input memory transfer handler
+     * Get pointer to input memory transfer handler (of the currently selected frame slot)
      */
     MemTransfer *getInputMemTransfer() const;
     
     /**
-     * Get pointer to output memory transfer handler
+     * Get pointer to output memory transfer handler (of the currently selected frame slot)
      */
     MemTransfer *getOutputMemTransfer() const;
     
@@ -118,31 +189,438 @@ public:
      */
     bool getUseMipmaps() const { return useMipmaps; }
     
+    /**
+     * Set the frame ring depth to <depth> (1 to OGLES_GPGPU_MAX_FRAME_RING_DEPTH,
+     * default is 1). With a depth > 1, each processor allocates <depth> frame slots
+     * with separate input and output textures and FBOs. Consecutive frames are
+     * processed in consecutive slots, so that the upload of the next frame, the
+     * rendering of the current frame and the readback of a previous frame do not
+     * depend on the same textures and can overlap.
+     * Up to <depth> frames can be in flight. The result of a frame can be retrieved
+     * with getOutputData() until <depth> newer frames have been submitted.
+     * Must be called before the first call to prepare().
+     */
+    void setFrameRingDepth(int depth);
+    
+    /**
+     * Get the frame ring depth.
+     */
+    int getFrameRingDepth() const { return frameRingDepth; }
+    
+    /**
+     * Enable asynchronous readback: <use>. If enabled, process() starts copying the
+     * output of each frame to CPU memory space, so that this copy overlaps the
+     * processing of the following frames. getOutputData() then only has to wait
+     * for this copy. Needs a MemTransfer implementation that supports this (i.e.
+     * MemTransferPBO, which is used in OpenGL ES 3.0 contexts without platform
+     * optimizations). Otherwise getOutputData() reads the output directly.
+     */
+    void setUseAsyncReadback(bool use) { useAsyncReadback = use; }
+    
+    /**
+     * Get "use asynchronous readback" status.
+     */
+    bool getUseAsyncReadback() const { return useAsyncReadback; }
+    
+    /**
+     * Use a texture pool for the output textures: <use>. If enabled, prepare() determines
+     * in which render pass the output of each processor (and of each pass of multipass
+     * processors) is used for the last time during a frame. Outputs whose lifetimes do
+     * not overlap share the same texture, and intermediate outputs are shared by all frame
+     * slots. Only the outputs of the last added processor and of the processors passed
+     * to setKeepOutput() get their own textures and can be read with getOutputData().
+     * Disabled by default. Must be set before prepare().
+     */
+    void setUseTexPool(bool use) { useTexPool = use; }
+    
+    /**
+     * Get "use texture pool" status.
+     */
+    bool getUseTexPool() const { return useTexPool; }
+    
+    /**
+     * Keep the output of processor <proc>: <keep>. A kept output gets its own textures
+     * when the texture pool is used, so that it can be read with getOutputData() or
+     * used as texture after process(). The output of the last added processor is always
+     * kept. Must be called after <proc> was added to the pipeline and before prepare().
+     */
+    void setKeepOutput(ProcInterface *proc, bool keep = true);
+    
+    /**
+     * Get the texture pool (e.g. to find out how much memory it uses).
+     */
+    const TexPool *getTexPool() const { return &texPool; }
+    
+    /**
+     * Store the linked shader programs of the processors in directory <dir> and load
+     * them from there the next time (see ProgramCache). This speeds up prepare(), because
+     * the shaders do not need to be compiled again. The directory must exist. Needs
+     * OpenGL ES 3.0 or the OES_get_program_binary extension, otherwise the shaders are
+     * always compiled. An empty string disables the cache (default).
+     * Must be set before prepare().
+     */
+    void setShaderCacheDir(const string &dir) { programCache.setDir(dir); }
+    
+    /**
+     * Get the program cache (e.g. to find out how many programs were loaded from it).
+     */
+    const ProgramCache *getProgramCache() const { return &programCache; }
+    
+    /**
+     * Get the registry of the processors' shader programs. Processors that use the same
+     * shaders share one program (e.g. to find out how many programs are used).
+     */
+    const ShaderRegistry *getShaderRegistry() const { return &shaderRegistry; }
+    
+    /**
+     * Skip OpenGL calls in process() that would not change the OpenGL state: <use>.
+     * The processors change the state through a shadow copy (see GLState), so that e.g.
+     * the input texture of a pass is not bound again if it is still bound, and the
+     * framebuffer is not unbound after each pass, but only after the last one.
+     * Enabled by default.
+     */
+    void setUseGLStateCache(bool use) { glState.setTracking(use); }
+    
+    /**
+     * Get "use GL state cache" status.
+     */
+    bool getUseGLStateCache() const { return glState.getTracking(); }
+    
+    /**
+     * Render the fullscreen quads of the processors from vertex buffer objects that are
+     * shared by all processors with the same render orientation instead of copying the
+     * vertices from client memory in each draw call: <use>. With OpenGL ES 3.0 or the
+     * OES_vertex_array_object extension, each processor also records its vertex
+     * attribute setup in a vertex array object.
+     * Enabled by default. Must be set before the first prepare() call.
+     */
+    void setUseVertexBuffers(bool use) { useVertexBuffers = use; }
+    
+    /**
+     * Get "use vertex buffers" status.
+     */
+    bool getUseVertexBuffers() const { return useVertexBuffers; }
+    
+    /**
+     * Get the shared quad buffers (e.g. to find out how many buffers are used).
+     */
+    const QuadBuffers *getQuadBuffers() const { return &quadBuffers; }
+    
+    /**
+     * Get the shadow OpenGL state. Its counters contain the numbers of issued and
+     * elided OpenGL calls of the last process() call.
+     */
+    const GLState *getGLState() const { return &glState; }
+    
+    /**
+     * Set the OpenGL error checking level to <level>. VALIDATION_LEVEL_PER_CALL calls
+     * glGetError() after each render step of each processor and after other OpenGL
+     * operations, and logs the processor name and the failed step. Because glGetError()
+     * may synchronize with the driver, this is only the default in DEBUG builds.
+     * VALIDATION_LEVEL_PER_FRAME (default in other builds) checks for errors once at
+     * the end of init(), prepare() and process(). VALIDATION_LEVEL_OFF does not check
+     * at all.
+     * The level applies to all calls of this Core object (also when several Core
+     * objects are used in different threads).
+     */
+    void setValidationLevel(ValidationLevel level) { validationLevel = level; Tools::setValidationLevel(level); }
+    
+    /**
+     * Get the OpenGL error checking level.
+     */
+    ValidationLevel getValidationLevel() const { return validationLevel; }
+    
+    /**
+     * Fuse chains of point operation processors into one shader: <use>. If enabled,
+     * prepare() looks for processors that are point operations (see
+     * ProcInterface::getIsPointOp()), have one input and write to a texture of the size
+     * of their input, and that read the output of another point operation which is
+     * used by nothing else. Such a chain is rendered in one pass by the last processor
+     * of the chain, which saves the render passes and intermediate textures of the
+     * other processors. Their outputs can not be read anymore. Use setKeepOutput() to
+     * exclude a processor from fusion as the source of a chain.
+     * Disabled by default. Must be set before the first prepare() call.
+     */
+    void setUseShaderFusion(bool use) { useShaderFusion = use; }
+    
+    /**
+     * Get "use shader fusion" status.
+     */
+    bool getUseShaderFusion() const { return useShaderFusion; }
+    
+    /**
+     * Return the number of processors that were fused into the shader of another
+     * processor in prepare().
+     */
+    int getNumFusedProcs() const;
+    
+    /**
+     * Process grayscale images in packed form: <use>. If enabled, prepare() lets
+     * processors that convert to grayscale (see ProcInterface::getPackedGraySupport())
+     * write 4 horizontally adjacent gray pixels into the RGBA channels of one texel,
+     * and the processors that read such an image and support it (ThreshProc, GaussProc,
+     * AdaptThreshProc) use shader variants for packed images. This renders a fourth of
+     * the fragments and moves a fourth of the bytes. A processor's output is only
+     * packed if all processors that read it (and the render display) support packed
+     * input. Border pixels may differ slightly from unpacked processing. The output of
+     * packed processors is returned by getOutputData() as one byte per pixel.
+     * Disabled by default. Must be set before the first prepare() call.
+     */
+    void setUsePackedGray(bool use) { usePackedGray = use; }
+    
+    /**
+     * Get "use packed gray" status.
+     */
+    bool getUsePackedGray() const { return usePackedGray; }
+    
+    /**
+     * Return the number of processors that write packed grayscale output.
+     */
+    int getNumPackedGrayProcs() const;
+    
+    /**
+     * Set the format of the output data that getOutputData() returns to <fmt>.
+     * OUTPUT_FORMAT_GRAY8 returns 1 byte per pixel, OUTPUT_FORMAT_MASK1 1 bit per pixel
+     * (e.g. for thresholding outputs, see OutputFormat). Both are packed on the GPU by
+     * an additional render pass after the pipeline (see PackProc), so that only these
+     * bytes are read back. The output texture (getOutputTexId()) and the render
+     * display keep the RGBA output. Default is OUTPUT_FORMAT_RGBA.
+     * Must be set before the first prepare() call.
+     */
+    void setOutputFormat(OutputFormat fmt) { assert(!prepared); outputFormat = fmt; }
+    
+    /**
+     * Get the output data format.
+     */
+    OutputFormat getOutputFormat() const { return outputFormat; }
+    
+    /**
+     * Return the number of bytes that getOutputData() writes (for the output of the
+     * last added processor). With a region of interest, this is the size of the
+     * region's data (see setROI()).
+     */
+    int getOutputDataSize() const;
+    
+    /**
+     * Restrict processing to the region of interest at position <x>, <y> with size
+     * <w>x<h> in pixels of the output frame (row 0 is the first row of the output
+     * data). The region is propagated backwards through the pipeline: each processor
+     * only renders (with the scissor test) the region that the following processors
+     * read, i.e. their region grown by their filter radius and mapped through their
+     * scaling and render orientation. getOutputData() returns the rows of the region
+     * one after another (see getOutputDataSize()). For OUTPUT_FORMAT_MASK1, the region
+     * is extended to whole bytes, i.e. multiples of 8 pixels in x direction (see
+     * getROI()). The outputs of kept processors (see setKeepOutput()) are rendered
+     * completely. Other outputs, including the output texture and the render display,
+     * are only valid inside the rendered regions. The CPU backend processes the whole
+     * frame and only returns the region.
+     * Can be called at any time. After prepare(), it applies to the following
+     * process() calls, so the outputs of frames that were processed before must be
+     * read before. A size of 0x0 processes the whole frame (default, see clearROI()).
+     */
+    void setROI(int x, int y, int w, int h);
+    
+    /**
+     * Process the whole frame again.
+     */
+    void clearROI() { setROI(0, 0, 0, 0); }
+    
+    /**
+     * Get the region of interest of the output frame as it is processed, i.e. clipped
+     * to the output frame and extended for the output format. Returns a region with
+     * w = 0 if the whole frame is processed. Valid after prepare().
+     */
+    ROI getROI() const;
+    
+    /**
+     * Returns true if only the Y plane of YUV input is uploaded, because all
+     * processors that read the pipeline input only need the luminance.
+     */
+    bool getInputLumaOnly() const { return inputLumaOnly; }
+    
+    /**
+     * Return the number of bytes that setInputData() uploads per frame (0 for input
+     * via setInputTexId()).
+     */
+    int getInputDataSize() const;
+    
     /**
      * Set input as OpenGL texture id.
      */
     void setInputTexId(GLuint inTexId, GLenum inTexTarget = GL_TEXTURE_2D);
     
     /**
-     * Set input as RGBA byte data of size <w> x <h>.
+     * Set input as RGBA byte data of size <w> x <h> (or in the YUV format that was
+     * passed to prepare(), with the chroma planes following the Y plane).
+     * <rowStride> is the number of bytes between rows in <data>, so that padded buffers
+     * can be passed without copying them first. 0 means tightly packed rows (<w> * 4 bytes).
+     * For YUV input, <rowStride> is the row stride of the Y plane (see
+     * MemTransfer::setInputRowStride()).
+     * The data is copied to the input texture of the frame slot for the next call to
+     * process(). If the slot is still in use by an older frame, this blocks until
+     * the GPU has completed the older frame.
      */
-    void setInputData(const unsigned char *data);
+    void setInputData(const unsigned char *data, int rowStride = 0);
     
     /**
      * Process input data by executing the GPGPU processors defined in
      * the pipeline.
+     * In PROCESSING_MODE_ASYNC, this only submits the OpenGL commands and returns
+     * immediately. Use the returned frame handle with isFrameDone() or waitForFrame()
+     * to find out when the GPU has finished processing. getOutputData() will wait
+     * automatically.
+     */
+    FrameHandle process();
+    
+    /**
+     * Poll the processing state of frame <frame>. Returns true if the GPU has
+     * completed all processing for this frame.
+     */
+    bool isFrameDone(FrameHandle frame);
+    
+    /**
+     * Block until the GPU has completed all processing for frame <frame> or until
+     * <timeoutMs> milliseconds have passed (a negative value means no timeout).
+     * Returns true if the frame was completed.
+     */
+    bool waitForFrame(FrameHandle frame, double timeoutMs = -1.0);
+    
+    /**
+     * Get the handle of the last frame that was submitted with process().
+     * Returns 0 if no frame was submitted so far.
+     */
+    FrameHandle getLastFrame() const { return lastFrame; }
+    
+    /**
+     * Set the processing mode to <mode>. See ProcessingMode definition.
+     */
+    void setProcessingMode(ProcessingMode mode) { processingMode = mode; }
+    
+    /**
+     * Get the processing mode.
+     */
+    ProcessingMode getProcessingMode() const { return processingMode; }
+    
+    /**
+     * Set the backend that executes the pipeline to <b>. With PROCESSING_BACKEND_CPU,
+     * no OpenGL context is needed. All processors must support it (see
+     * ProcInterface::getCPUSupport()). The results match those of the GPU within a
+     * small tolerance (see README), but shader fusion, packed grayscale processing and
+     * mipmaps are not applied, and input and output are only possible as bytes (no
+     * setInputTexId(), getOutputTexId() or render display). Useful as golden reference
+     * for the GPU results and as fallback if no OpenGL context can be created. init()
+     * falls back to the CPU backend by itself if no OpenGL context is current.
+     * With PROCESSING_BACKEND_AUTO, prepare() measures a few frames with both backends
+     * and selects the faster one for the pipeline and frame size (see BackendTuner and
+     * setBackendTuningDir()). The GPU pipeline is always prepared then, so that each
+     * prepare() with another frame size can select the backend again. The CPU backend
+     * is only considered if it supports the pipeline, the input data format and the
+     * settings (e.g. no render display). Setting PROCESSING_BACKEND_GPU or
+     * PROCESSING_BACKEND_CPU overrides the selection.
+     * Must be set before init().
+     */
+    void setBackend(ProcessingBackend b) { assert(!initialized); backend = b; }
+    
+    /**
+     * Get the processing backend (with PROCESSING_BACKEND_AUTO the selected backend
+     * after prepare()).
+     */
+    ProcessingBackend getBackend() const { return backend; }
+    
+    /**
+     * Store the backend selection results of PROCESSING_BACKEND_AUTO in directory
+     * <dir> and load them from there the next time the same pipeline is prepared with
+     * the same frame size on the same device (see BackendTuner). This skips the
+     * measurement in prepare(). The directory must exist. An empty string disables
+     * storing the results (default). Must be set before prepare().
+     */
+    void setBackendTuningDir(const string &dir) { backendTuner.setDir(dir); }
+    
+    /**
+     * Get the backend tuner (e.g. to change its settings or to get the measurements
+     * of the last backend selection).
+     */
+    BackendTuner *getBackendTuner() { return &backendTuner; }
+    
+    /**
+     * Set the number of threads of the CPU backend to <num> including the thread that
+     * calls process() (0 for one thread per CPU core, the default). The threads are
+     * only used with tiled execution (see setUseCPUTiling()). Must be set before prepare().
+     */
+    void setCPUNumThreads(int num) { cpuNumThreads = num; }
+    
+    /**
+     * Get the number of threads of the CPU backend (0 for one thread per CPU core).
+     */
+    int getCPUNumThreads() const { return cpuNumThreads; }
+    
+    /**
+     * Use tiled execution of the pipeline with the CPU backend: <use>. If enabled,
+     * prepare() checks if all processors keep the input frame size and orientation.
+     * Then the frames are split into row bands that fit into the CPU cache, all
+     * processors are executed per band, and the bands are executed in parallel (see
+     * CPUTileExecutor). The results are the same as without tiling. Like with the texture
+     * pool, only the outputs of the last added processor and of the processors passed
+     * to setKeepOutput() can be read with getOutputData(). Enabled by default. Must be
+     * set before prepare().
+     */
+    void setUseCPUTiling(bool use) { useCPUTiling = use; }
+    
+    /**
+     * Get "use tiled execution with the CPU backend" status.
+     */
+    bool getUseCPUTiling() const { return useCPUTiling; }
+    
+    /**
+     * Returns true if the CPU backend executes the pipeline in row bands after
+     * prepare() (see setUseCPUTiling()).
+     */
+    bool getCPUTilingActive() const { return cpuTilingActive; }
+    
+    /**
+     * Set the cache size in <bytes> that the band images of tiled execution should fit
+     * into (0 for the L2 cache size of the CPU, the default; see CPUTileExecutor::getCPUCacheSize()).
+     * Must be set before prepare().
+     */
+    void setCPUTileCacheSize(int bytes) { cpuTileCacheSize = bytes; }
+    
+    /**
+     * Get the cache size for tiled execution with the CPU backend.
+     */
+    int getCPUTileCacheSize() const { return cpuTileCacheSize; }
+    
+    /**
+     * Get the executor of tiled execution with the CPU backend, e.g. to query the
+     * number of threads and bands after prepare().
+     */
+    const CPUTileExecutor &getCPUTileExecutor() const { return cpuTileExecutor; }
+    
+    /**
+     * Get output as OpenGL texture id (of the last processed frame). The output
+     * of the pipeline is the output of the last added processor. Returns 0 for
+     * the CPU backend.
      */
-    void process();
+    GLuint getOutputTexId() const { assert(lastProc); return backend == PROCESSING_BACKEND_CPU ? 0 : lastProc->getOutputTexId(); }
     
     /**
-     * Get output as OpenGL texture id.
+     * Get output as bytes. Will copy the output texture of frame <frame> from the GPU
+     * to <buf>, which must hold getOutputDataSize() bytes (see setOutputFormat()).
+     * Pass 0 as <frame> to get the output of the last processed frame.
+     * With a frame ring, <frame> must be one of the last <depth> submitted frames.
      */
-    GLuint getOutputTexId() const { assert(lastProc); return lastProc->getOutputTexId(); }
+    void getOutputData(unsigned char *buf, FrameHandle frame = 0) { getOutputData(lastProc, buf, frame); }
     
     /**
-     * Get output as bytes. Will copy the output texture from the GPU to <buf>.
+     * Get the output of processor <proc> of the pipeline as bytes, e.g. the output
+     * of an intermediate processor or of another pipeline branch. Will copy its
+     * output texture of frame <frame> from the GPU to <buf>, which must hold
+     * proc->getOutFrameW() * proc->getOutFrameH() * 4 bytes (or 1 byte per pixel if
+     * proc->getPackedGray() is true, see setUsePackedGray()). The output format (see
+     * setOutputFormat()) only applies to the last added processor. Pass 0 as <frame>
+     * to get the output of the last processed frame. Asynchronous readback is only used
+     * for the output of the last added processor.
      */
-    void getOutputData(unsigned char *buf);
+    void getOutputData(ProcInterface *proc, unsigned char *buf, FrameHandle frame = 0);
     
     /**
      * Get output frame width.
@@ -159,7 +637,74 @@ public:
      */
     void *getGLContextPtr() const { return glContextPtr; }
     
+    /**
+     * Returns true if an OpenGL ES 3.0 (or later) context was detected in init().
+     */
+    bool getIsGLES3Context() const { return glES3; }
+    
+    /**
+     * Enable profiling of the pipeline stages: <enabled>. If enabled, the CPU and
+     * GPU times of setInputData(), process(), getOutputData() and of each processor
+     * and each pass of multipass processors are measured. Disabled by default.
+     * See Profiler class.
+     */
+    void setProfilingEnabled(bool enabled) { profiler.setEnabled(enabled); }
+    
+    /**
+     * Get "profiling enabled" status.
+     */
+    bool getProfilingEnabled() const { return profiler.getEnabled(); }
+    
+    /**
+     * Return the aggregated measurements (rolling min, mean, 95th percentile) of all
+     * pipeline stages. Processor stages follow the process() stage, pass stages follow
+     * their processor's stage. The stages are registered in the first call to prepare().
+     */
+    vector<ProfilerStageStats> getProfilingStats() { return profiler.getStats(); }
+    
+    /**
+     * Get the profiler (e.g. to adjust the window size or to print the measurements).
+     */
+    Profiler *getProfiler() { return &profiler; }
+    
+    /**
+     * Start recording a trace of the pipeline execution with a ring buffer of
+     * <capacity> events. The CPU times of setInputData(), process(), getOutputData()
+     * and of each processor's and pass' render() call are recorded, as well as their
+     * GPU times if GPU timer queries are available (see Profiler). If the ring buffer
+     * is full, the oldest events are overwritten. Discards a previously recorded trace.
+     */
+    void startTracing(size_t capacity = OGLES_GPGPU_TRACE_DEFAULT_CAPACITY);
+    
+    /**
+     * Stop recording the trace. Waits for the GPU, so that the GPU events of all
+     * submitted frames are recorded. The recorded events are kept until the next call
+     * to startTracing().
+     */
+    void stopTracing();
+    
+    /**
+     * Returns true if a trace is being recorded.
+     */
+    bool getIsTracing() const { return profiler.getTraceRecorder() != NULL; }
+    
+    /**
+     * Write the recorded trace as Chrome trace JSON (for chrome://tracing or the
+     * Perfetto UI) to file <path>. Returns true on success.
+     */
+    bool writeTrace(const char *path) const { return traceRecorder.writeJSONFile(path); }
+    
+    /**
+     * Get the trace recorder (e.g. to write the trace to a stream).
+     */
+    TraceRecorder *getTraceRecorder() { return &traceRecorder; }
+    
 #ifdef OGLES_GPGPU_BENCHMARK
+    /**
+     * Return the wall clock times in ms of the last setInputData(), process() and
+     * getOutputData() calls. Note that these benchmark timers are kept per thread,
+     * not per Core object.
+     */
     vector<double> getTimeMeasurements() const {  return Tools::getTimeMeasurements(); }
 #endif
     
@@ -170,14 +715,157 @@ public:
     
 private:
     /**
-     * Private constructor for singleton instance.
+     * Empty copy constructor. Core objects can not be copied.
      */
-    Core();
+    Core (const Core&) {}
     
     /**
-     * Empty copy constructor.
+     * Node of the processing pipeline graph.
      */
-    Core (const Core&) {}
+    typedef struct {
+        ProcInterface *proc;                // weak ref
+        vector<ProcInterface *> inputProcs; // source processor of each input (NULL for the pipeline input). weak refs
+        vector<int> inputs;                 // index of the source node of each input (-1 for the pipeline input)
+        bool keepOutput;                    // output is not taken from the texture pool (and not fused)
+        int fusedInto;                      // index of the node that renders this node's point operation in its shader (-1 if not fused)
+        vector<int> fusedStages;            // indices of the nodes whose point operations are fused into this node's shader
+    } PipelineNode;
+    
+    /**
+     * Prepare the pipeline for the GPU backend with input frames of size <inW>x<inH>
+     * in format <inFmt> (see prepare()).
+     */
+    void prepareGPU(int inW, int inH, GLenum inFmt);
+    
+    /**
+     * Prepare the pipeline for both backends with input frames of size <inW>x<inH>
+     * in format <inFmt> and select the faster one (see PROCESSING_BACKEND_AUTO).
+     */
+    void prepareAutoBackend(int inW, int inH, GLenum inFmt);
+    
+    /**
+     * Returns true if the CPU backend can execute the pipeline with input data in
+     * format <inFmt>.
+     */
+    bool getCPUBackendSupport(GLenum inFmt) const;
+    
+    /**
+     * Return a description of the prepared pipeline for the backend selection:
+     * processors, their inputs, output sizes and orientations, input frame size,
+     * formats and the settings that affect the speed of a backend.
+     */
+    string getPipelineId() const;
+    
+    /**
+     * Process <numFrames> frames of synthetic input data with the current backend
+     * including setInputData() and getOutputData() after two warm-up frames. Keeps
+     * up to frameRingDepth frames in flight and restores the frame counter and the
+     * frame fences afterwards. Returns the median time per frame in ms.
+     */
+    double measureFrameTime(int numFrames);
+    
+    /**
+     * Prepare the pipeline for the CPU backend with input frames of size <inW>x<inH>
+     * in format <inFmt> (see prepare()).
+     */
+    void prepareCPU(int inW, int inH, GLenum inFmt);
+    
+    /**
+     * Split the processors into their passes as stages of the tile executor and prepare
+     * it if all passes keep the input frame size and orientation. Returns false if the
+     * pipeline can not be executed in row bands.
+     */
+    bool prepareCPUTiling();
+    
+    /**
+     * Run the processors on the CPU in render order (or all passes per row band with
+     * tiled execution) for the frame in slot <slot>.
+     */
+    void processCPU(int slot);
+    
+    /**
+     * Copy the output of pipeline node <n> of frame <frame> that was processed on the
+     * CPU to <buf> in the output format (see getOutputData()).
+     */
+    void getOutputDataCPU(int n, unsigned char *buf, FrameHandle frame);
+    
+    /**
+     * Resolve the inputs of all pipeline nodes and sort the nodes topologically
+     * into <schedule>. Returns false if the pipeline graph is invalid.
+     */
+    bool buildSchedule();
+    
+    /**
+     * Connect the inputs of all processors to the output textures of their source
+     * processors or to the pipeline input texture.
+     */
+    void connectProcInputs();
+    
+    /**
+     * Create the output textures of all processors. <genMipmaps> defines for each
+     * pipeline node if a mipmap is needed. If the texture pool is used, the textures
+     * of all outputs that are not kept are assigned by their lifetime.
+     */
+    void createProcOutputTextures(const vector<bool> &genMipmaps);
+    
+    /**
+     * Find the chains of point operations in the pipeline and fuse each chain into
+     * the shader of its last processor.
+     */
+    void fusePointOps();
+    
+    /**
+     * Decide for each processor if it writes packed grayscale output and set it
+     * (see setUsePackedGray()). Must be called before the processors are initialized.
+     */
+    void selectPackedGrayProcs();
+    
+    /**
+     * Returns true if all processors that read the pipeline input read it as input 0
+     * and only need its luminance (see ProcInterface::getReadsLumaOnly()).
+     */
+    bool getInputReadersLumaOnly() const;
+    
+    /**
+     * Return the processor whose output getOutputData() reads for the output of
+     * processor <proc>: the output packing processor for the last added processor
+     * if it is used, otherwise <proc>.
+     */
+    ProcInterface *getOutputReadProc(ProcInterface *proc) const;
+    
+    /**
+     * Set the render regions of the processors and the readback region of the output
+     * for the region of interest (see setROI()).
+     */
+    void applyROI();
+    
+    /**
+     * Return the index of the node that actually renders the output which is read
+     * from node <src> (-1 for the pipeline input), skipping nodes that were fused into
+     * their consumer.
+     */
+    int resolveFusedInput(int src) const;
+    
+    /**
+     * Return the index of the pipeline node of processor <proc> or -1 if it is
+     * not in the pipeline.
+     */
+    int findProcNode(const ProcInterface *proc) const;
+    
+    /**
+     * Return the frame slot that is used for frame <frame>.
+     */
+    int getFrameSlot(FrameHandle frame) const { return (int)((frame - 1) % (FrameHandle)frameRingDepth); }
+    
+    /**
+     * Select frame slot <slot> for all processors in the pipeline.
+     */
+    void selectFrameSlot(int slot);
+    
+    /**
+     * Register the profiler stages for the Core methods and all processors.
+     */
+    void registerProfilerStages();
     
     /**
      * Check which OpenGL extensions are available.
@@ -193,22 +881,79 @@ private:
     void cleanup();
     
     
-    static Core *instance;  // singleton instance
+    static Core *instance;  // default instance
     
     void *glContextPtr;     // pointer to OpenGL context (platform specific type), weak ref.
     
-    list<ProcInterface *> pipeline;  // contains weak refs to ProcBase objects
+    vector<PipelineNode> pipeline;  // contains weak refs to ProcBase objects in the order in which they were added
+    vector<int> schedule;           // indices of the pipeline nodes in topological order (render order)
     
-    ProcInterface *firstProc;    // pointer to first processor in pipeline
-    ProcInterface *lastProc;     // pointer to last processor in pipeline
+    ProcInterface *firstProc;    // pointer to the processor that gets the input data
+    ProcInterface *lastProc;     // pointer to the last added processor (pipeline output)
+    
+    bool inputWillDownscale;     // is true if a processor that uses the pipeline input will downscale
     
     Disp *renderDisp;       // render-to-display object. strong ref.
     
+    OutputFormat outputFormat;  // format of the output data
+    PackProc *outputPackProc;   // packs the output for the readback. strong ref. NULL if not used
+    ROI roi;                    // region of interest of the output frame (w = 0 for the whole frame)
+    
     bool initialized;       // pipeline initialized?
     bool prepared;          // input prepared?
     
     bool useMipmaps;        // use mipmaps?
     bool glExtNPOTMipmaps;  // hardware supports NPOT mipmapping?
+    bool glExtAppleSync;    // hardware supports GL_APPLE_sync?
+    bool glExtDisjointTimerQuery;   // hardware supports GL_EXT_disjoint_timer_query?
+    bool glExtProgramBinary;        // hardware supports GL_OES_get_program_binary?
+    bool glExtVertexArrayObject;    // hardware supports GL_OES_vertex_array_object?
+    bool glES3;             // OpenGL ES 3.0 context?
+    
+    ProcessingMode processingMode;  // processing mode for process()
+    ProcessingBackend backend;      // backend that executes the pipeline
+    bool autoBackend;               // select the backend in prepare()?
+    BackendTuner backendTuner;      // settings and results of the backend selection
+    bool useAsyncReadback;          // start readback of the output in process()?
+    
+    bool useTexPool;        // take output textures from <texPool>?
+    TexPool texPool;        // pool of output textures that are shared between processors
+    
+    bool useShaderFusion;   // fuse chains of point operations in prepare()?
+    bool usePackedGray;     // process grayscale images in packed form?
+    
+    ProgramCache programCache;  // persistent cache for the processors' shader programs
+    ShaderRegistry shaderRegistry;  // shared shader programs of the processors
+    GLState glState;            // shadow OpenGL state for the processors' render passes
+    QuadBuffers quadBuffers;    // shared vertex buffers of the processors' fullscreen quads
+    bool useVertexBuffers;      // render the quads from vertex buffers?
+    
+    ValidationLevel validationLevel;    // OpenGL error checking level
+    
+    int frameRingDepth;     // number of frame slots
+    int selectedSlot;       // currently selected frame slot
+    
+    CPUImage cpuInput;                      // converted input data for the CPU backend
+    vector<vector<CPUImage> > cpuOutputs;   // outputs of the pipeline nodes per frame slot for the CPU backend
+    int cpuNumThreads;                      // number of threads of the CPU backend (0 for one per core)
+    bool useCPUTiling;                      // execute the pipeline in row bands with the CPU backend?
+    int cpuTileCacheSize;                   // cache size for the band height of tiled execution (0 for the L2 cache size)
+    bool cpuTilingActive;                   // the pipeline is executed in row bands
+    CPUTileExecutor cpuTileExecutor;        // executes the passes of the pipeline in row bands
+    vector<int> cpuTileOutputNodes;         // pipeline node whose output each tile stage writes (-1 if not kept)
+    vector<CPUImage *> cpuTileOutputs;      // output frame of each tile stage for the current frame slot
+    CPUImage cpuROIOutput;                  // region of interest of the output frame for getOutputData()
+    
+    Fence frameFences[OGLES_GPGPU_MAX_FRAME_RING_DEPTH];  // fence after the commands of the last submitted frame per frame slot
+    FrameHandle lastFrame;  // handle of the last submitted frame
+    
+    Profiler profiler;          // measures the pipeline stages if enabled
+    TraceRecorder traceRecorder;    // records the profiler's measurements while tracing
+    int profStageInput;         // profiler stage id of setInputData()
+    int profStageProcess;       // profiler stage id of process()
+    int profStageOutput;        // profiler stage id of getOutputData()
+    int profStageOutputPack;    // profiler stage id of the output packing pass (-1 if not used)
+    vector<int> profProcStages; // profiler stage id of each processor in the render order
     
     bool inputSizeIsPOT;    // input frame size is POT?
     
@@ -219,6 +964,9 @@ private:
 
     GLuint inputTexId;      // input texture id
     GLenum inputTexTarget;  // input texture target
+    GLuint inputChromaTexIds[2];    // chroma plane texture ids of YUV input (0 if not used)
+    GLenum inputDataFormat; // pixel format of the input data as it is uploaded and read by the processors
+    bool inputLumaOnly;     // only the Y plane of YUV input is uploaded?
     GLuint outputTexId;     // output texture id
 };
     
@@ -0,0 +1,118 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Image in CPU memory for the CPU backend.
+ */
+#ifndef OGLES_GPGPU_COMMON_CPU_CPUIMAGE
+#define OGLES_GPGPU_COMMON_CPU_CPUIMAGE
+
+#include <cassert>
+#include <vector>
+
+using namespace std;
+
+namespace ogles_gpgpu {
+
+/**
+ * RGBA image with 8 bits per channel in CPU memory. It takes the place of an output
+ * texture when a pipeline is executed by the CPU backend (see Core::setBackend()).
+ * Rows are tightly packed and stored top to bottom in the order of the input data,
+ * like the rows that getOutputData() returns.
+ * An image can also hold only a band of consecutive rows of a frame (see
+ * resizeRows() and setRowsView()), so that a frame can be processed in row bands.
+ * Rows are always addressed with their frame row number.
+ */
+class CPUImage {
+public:
+    /**
+     * Constructor. Creates an empty image.
+     */
+    CPUImage() : w(0), h(0), firstRow(0), numRows(0), viewData(NULL) { }
+    
+    /**
+     * Set the image size to <width>x<height>. The pixel data is undefined afterwards.
+     */
+    void resize(int width, int height) { resizeRows(width, height, 0, height); }
+    
+    /**
+     * Set the frame size to <width>x<height>, but only hold the <rows> rows from row
+     * <first> on. The pixel data is undefined afterwards.
+     */
+    void resizeRows(int width, int height, int first, int rows) {
+        w = width; h = height; firstRow = first; numRows = rows; viewData = NULL;
+        data.resize(w * numRows * 4);
+    }
+    
+    /**
+     * Make this image a view of the <rows> rows from row <first> on of image <img>,
+     * which must hold them. The view does not own its pixel data, so it is only valid
+     * as long as <img> is not resized.
+     */
+    void setRowsView(CPUImage &img, int first, int rows) {
+        w = img.w; h = img.h; firstRow = first; numRows = rows; viewData = img.getRow(first);
+    }
+    
+    /**
+     * Get the image width.
+     */
+    int getWidth() const { return w; }
+    
+    /**
+     * Get the image (frame) height.
+     */
+    int getHeight() const { return h; }
+    
+    /**
+     * Get the number of the first row that the image holds.
+     */
+    int getFirstRow() const { return firstRow; }
+    
+    /**
+     * Get the number of rows that the image holds (the height unless it holds a band).
+     */
+    int getNumRows() const { return numRows; }
+    
+    /**
+     * Return the number of bytes of the pixel data.
+     */
+    int getDataSize() const { return w * numRows * 4; }
+    
+    /**
+     * Return a pointer to the pixel data (of the first row that the image holds).
+     */
+    unsigned char *getData() { return viewData ? viewData : (data.empty() ? NULL : &data[0]); }
+    
+    /**
+     * Return a pointer to the pixel data (of the first row that the image holds).
+     */
+    const unsigned char *getData() const { return viewData ? viewData : (data.empty() ? NULL : &data[0]); }
+    
+    /**
+     * Return a pointer to the first pixel of row <y>.
+     */
+    unsigned char *getRow(int y) { assert(y >= firstRow && y < firstRow + numRows); return getData() + (y - firstRow) * w * 4; }
+    
+    /**
+     * Return a pointer to the first pixel of row <y>.
+     */
+    const unsigned char *getRow(int y) const { assert(y >= firstRow && y < firstRow + numRows); return getData() + (y - firstRow) * w * 4; }
+
+private:
+    int w;          // width in pixels
+    int h;          // frame height in pixels
+    int firstRow;   // first row that the image holds
+    int numRows;    // number of rows that the image holds
+    unsigned char *viewData;        // pixel data of the image that this image is a view of (NULL if it owns its data)
+    vector<unsigned char> data;     // RGBA pixel data
+};
+
+}
+
+#endif
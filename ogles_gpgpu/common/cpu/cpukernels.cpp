@@ -0,0 +1,485 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "cpukernels.h"
+#include "cpukernels_simd.h"
+
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+/**
+ * Round <v> in 8 bit units (0.0 .. 255.0) to a byte like the write of a color to an
+ * RGBA texture.
+ */
+static inline unsigned char toByte(float v) {
+    return v <= 0.0f ? 0 : (v >= 255.0f ? 255 : (unsigned char)(v + 0.5f));
+}
+
+/**
+ * Clamp coordinate <v> to the range 0 .. <size> - 1 like a texture with GL_CLAMP_TO_EDGE.
+ */
+static inline int clampCoord(int v, int size) {
+    return v < 0 ? 0 : (v >= size ? size - 1 : v);
+}
+
+/**
+ * Sample plane <plane> of size <w>x<h> with <rowStride> bytes per row and <bytesPerPx>
+ * bytes per pixel (1 to 4) bilinearly at pixel coordinates <x>, <y> (pixel centers at
+ * integers). Return the sample of each byte of the pixel in <v>.
+ */
+static void samplePlane(const unsigned char *plane, int w, int h, int rowStride, int bytesPerPx, float x, float y, float *v) {
+    int x0 = (int)floor(x);
+    int y0 = (int)floor(y);
+    float ax = x - x0;
+    float ay = y - y0;
+    int x1 = clampCoord(x0 + 1, w) * bytesPerPx;
+    int y1 = clampCoord(y0 + 1, h) * rowStride;
+    x0 = clampCoord(x0, w) * bytesPerPx;
+    y0 = clampCoord(y0, h) * rowStride;
+    
+    for (int c = 0; c < bytesPerPx; c++) {
+        float top = plane[y0 + x0 + c] * (1.0f - ax) + plane[y0 + x1 + c] * ax;
+        float bottom = plane[y1 + x0 + c] * (1.0f - ax) + plane[y1 + x1 + c] * ax;
+        v[c] = top * (1.0f - ay) + bottom * ay;
+    }
+}
+
+/**
+ * 7-tap Gauss filter of all channels of the pixel at byte offset <offset> of the
+ * pixels <taps> (at offsets -3 .. 3 in filter direction). Writes the result to <out>.
+ */
+static inline void gaussPx(const unsigned char *const taps[7], int offset, unsigned char *out) {
+    for (int c = 0; c < 4; c++) {
+        float sum = gaussWeights[0] * taps[3][offset + c];
+        
+        for (int k = 1; k <= 3; k++) {
+            sum += gaussWeights[k] * (taps[3 - k][offset + c] + taps[3 + k][offset + c]);
+        }
+        
+        out[c] = toByte(sum);
+    }
+}
+
+/**
+ * Return the vectorized kernels for instruction set <isa> or NULL if they are not
+ * available on this CPU.
+ */
+static const CPUKernelFuncs *getKernelFuncs(CPUInstructionSet isa) {
+    switch (isa) {
+#ifdef OGLES_GPGPU_CPU_HAVE_SSE2
+        case CPU_ISA_SSE2:
+            return &cpuKernelFuncsSSE2;
+#endif
+#ifdef OGLES_GPGPU_CPU_HAVE_AVX2
+        case CPU_ISA_AVX2:
+            __builtin_cpu_init();   // might be called before the static constructors
+            return __builtin_cpu_supports("avx2") ? &cpuKernelFuncsAVX2 : NULL;
+#endif
+#ifdef OGLES_GPGPU_CPU_HAVE_NEON
+        case CPU_ISA_NEON:
+            return &cpuKernelFuncsNEON;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+/**
+ * Return the best instruction set that this CPU supports.
+ */
+static CPUInstructionSet getBestInstructionSet() {
+    for (int isa = CPU_ISA_NEON; isa > CPU_ISA_SCALAR; isa--) {
+        if (getKernelFuncs((CPUInstructionSet)isa)) return (CPUInstructionSet)isa;
+    }
+    
+    return CPU_ISA_SCALAR;
+}
+
+// the selection can change while Core objects in other threads run the kernels. each
+// kernel call loads the vectorized kernels once
+static atomic<CPUInstructionSet> selectedISA(getBestInstructionSet());                  // instruction set of the kernels
+static atomic<const CPUKernelFuncs *> simdFuncs(getKernelFuncs(selectedISA.load()));    // vectorized kernels (NULL for scalar kernels)
+
+static const char *isaNames[] = { "scalar", "sse2", "avx2", "neon" };
+
+#pragma mark public methods
+
+void CPUKernels::setInstructionSet(CPUInstructionSet isa) {
+    if (!getInstructionSetSupport(isa)) {
+        OG_LOGERR("CPUKernels", "instruction set %s is not supported, using the scalar kernels", getInstructionSetName(isa));
+        isa = CPU_ISA_SCALAR;
+    }
+    
+    simdFuncs.store(getKernelFuncs(isa));
+    selectedISA.store(isa);
+    
+    OG_LOGINF("CPUKernels", "using instruction set %s", getInstructionSetName(isa));
+}
+
+CPUInstructionSet CPUKernels::getInstructionSet() {
+    return selectedISA.load();
+}
+
+bool CPUKernels::getInstructionSetSupport(CPUInstructionSet isa) {
+    return isa == CPU_ISA_SCALAR || getKernelFuncs(isa) != NULL;
+}
+
+const char *CPUKernels::getInstructionSetName(CPUInstructionSet isa) {
+    return isa >= CPU_ISA_SCALAR && isa <= CPU_ISA_NEON ? isaNames[isa] : "unknown";
+}
+
+
+void CPUKernels::convInputData(const unsigned char *data, GLenum fmt, int rowStride, CPUImage &dst) {
+    int w = dst.getWidth();
+    int h = dst.getHeight();
+    int y0 = dst.getFirstRow();
+    int y1 = y0 + dst.getNumRows();
+    
+    if (fmt == GL_RGBA) {
+        int srcRowStride = rowStride > 0 ? rowStride : w * 4;
+        
+        for (int y = y0; y < y1; y++) {
+            memcpy(dst.getRow(y), data + y * srcRowStride, w * 4);
+        }
+        
+        return;
+    }
+    
+    if (!Tools::isYUVFormat(fmt)) {
+        OG_LOGERR("CPUKernels", "input data format %d is not supported", fmt);
+        return;
+    }
+    
+    int lumaRowStride = rowStride > 0 ? rowStride : w;
+    int chromaW = (w + 1) / 2;
+    int chromaH = (h + 1) / 2;
+    const unsigned char *chroma = data + lumaRowStride * h;
+    
+    // the chroma planes have the same layout as their textures (see MemTransfer)
+    int chromaRowStride = 0;
+    const unsigned char *chroma1 = NULL;
+    
+    if (fmt == INPUT_FORMAT_NV12 || fmt == INPUT_FORMAT_NV21) {
+        chromaRowStride = rowStride > 0 ? rowStride : chromaW * 2;
+    } else if (fmt == INPUT_FORMAT_I420) {
+        chromaRowStride = rowStride > 0 ? rowStride / 2 : chromaW;
+        chroma1 = chroma + chromaRowStride * chromaH;
+    }
+    
+    for (int y = y0; y < y1; y++) {
+        const unsigned char *luma = data + y * lumaRowStride;
+        unsigned char *out = dst.getRow(y);
+        
+        // chroma sample position of the pixel center in chroma pixel coordinates
+        float cy = (y + 0.5f) * chromaH / h - 0.5f;
+        
+        for (int x = 0; x < w; x++, out += 4) {
+            if (fmt == INPUT_FORMAT_Y8) {   // the luminance is the gray value
+                out[0] = out[1] = out[2] = luma[x];
+                out[3] = 255;
+                continue;
+            }
+            
+            float cx = (x + 0.5f) * chromaW / w - 0.5f;
+            float uv[2];
+            
+            if (fmt == INPUT_FORMAT_I420) {
+                samplePlane(chroma, chromaW, chromaH, chromaRowStride, 1, cx, cy, &uv[0]);
+                samplePlane(chroma1, chromaW, chromaH, chromaRowStride, 1, cx, cy, &uv[1]);
+            } else {
+                samplePlane(chroma, chromaW, chromaH, chromaRowStride, 2, cx, cy, uv);
+                
+                if (fmt == INPUT_FORMAT_NV21) swap(uv[0], uv[1]);
+            }
+            
+            // full range BT.601 with chroma values centered at 128
+            float yv = luma[x];
+            float u = uv[0] - 128.0f;
+            float v = uv[1] - 128.0f;
+            
+            out[0] = toByte(yv + 1.402f * v);
+            out[1] = toByte(yv - 0.344136f * u - 0.714136f * v);
+            out[2] = toByte(yv + 1.772f * u);
+            out[3] = 255;
+        }
+    }
+}
+
+void CPUKernels::resample(const CPUImage &src, CPUImage &dst, RenderOrientation o) {
+    int srcW = src.getWidth();
+    int srcH = src.getHeight();
+    int dstW = dst.getWidth();
+    int dstH = dst.getHeight();
+    
+    assert(src.getNumRows() == srcH && dst.getNumRows() == dstH);
+    
+    bool mirrored = o == RenderOrientationStdMirrored || o == RenderOrientationFlippedMirrored;
+    bool flipped = o == RenderOrientationFlipped || o == RenderOrientationFlippedMirrored;
+    
+    for (int y = 0; y < dstH; y++) {
+        unsigned char *out = dst.getRow(y);
+        
+        for (int x = 0; x < dstW; x++, out += 4) {
+            // texture coordinates of the pixel center
+            float s = (x + 0.5f) / dstW;
+            float t = (y + 0.5f) / dstH;
+            
+            if (o == RenderOrientationDiagonal) swap(s, t);
+            if (mirrored) s = 1.0f - s;
+            if (flipped) t = 1.0f - t;
+            
+            float px[4];
+            samplePlane(src.getData(), srcW, srcH, srcW * 4, 4, s * srcW - 0.5f, t * srcH - 0.5f, px);
+            
+            for (int c = 0; c < 4; c++) {
+                out[c] = toByte(px[c]);
+            }
+        }
+    }
+}
+
+void CPUKernels::grayscale(const CPUImage &src, CPUImage &dst, const float convVec[3]) {
+    assert(src.getWidth() == dst.getWidth() && src.getHeight() == dst.getHeight());
+    
+    const CPUKernelFuncs *funcs = simdFuncs.load();
+    
+    int n = dst.getWidth() * dst.getNumRows();
+    const unsigned char *in = src.getRow(dst.getFirstRow());
+    unsigned char *out = dst.getData();
+    int i = funcs ? funcs->grayscale(in, out, n, convVec) : 0;
+    
+    in += i * 4;
+    out += i * 4;
+    
+    for (; i < n; i++, in += 4, out += 4) {
+        unsigned char gray = toByte(in[0] * convVec[0] + in[1] * convVec[1] + in[2] * convVec[2]);
+        out[0] = out[1] = out[2] = gray;
+        out[3] = 255;
+    }
+}
+
+void CPUKernels::thresh(const CPUImage &src, CPUImage &dst, float threshVal) {
+    assert(src.getWidth() == dst.getWidth() && src.getHeight() == dst.getHeight());
+    
+    const CPUKernelFuncs *funcs = simdFuncs.load();
+    
+    // the vectorized kernels compare the red channel with the smallest value that
+    // passes the threshold (256 if none passes)
+    int minVal = 0;
+    while (minVal < 256 && !(minVal / 255.0f >= threshVal)) minVal++;
+    
+    int n = dst.getWidth() * dst.getNumRows();
+    const unsigned char *in = src.getRow(dst.getFirstRow());
+    unsigned char *out = dst.getData();
+    int i = funcs ? funcs->thresh(in, out, n, minVal) : 0;
+    
+    in += i * 4;
+    out += i * 4;
+    
+    for (; i < n; i++, in += 4, out += 4) {
+        unsigned char bin = in[0] / 255.0f >= threshVal ? 255 : 0;
+        out[0] = out[1] = out[2] = bin;
+        out[3] = 255;
+    }
+}
+
+void CPUKernels::gauss(const CPUImage &src, CPUImage &dst, bool vertical) {
+    assert(src.getWidth() == dst.getWidth() && src.getHeight() == dst.getHeight());
+    
+    const CPUKernelFuncs *funcs = simdFuncs.load();
+    
+    int w = src.getWidth();
+    int h = src.getHeight();
+    const unsigned char *taps[7];
+    
+    for (int y = dst.getFirstRow(); y < dst.getFirstRow() + dst.getNumRows(); y++) {
+        unsigned char *out = dst.getRow(y);
+        
+        if (vertical) {
+            // all pixels of a row have their taps in the same 7 rows
+            for (int k = 0; k < 7; k++) {
+                taps[k] = src.getRow(clampCoord(y + k - 3, h));
+            }
+            
+            int x = funcs ? funcs->gauss(taps, out, w) : 0;
+            
+            for (; x < w; x++) {
+                gaussPx(taps, x * 4, out + x * 4);
+            }
+        } else {
+            const unsigned char *in = src.getRow(y);
+            
+            // the vectorized kernel processes the pixels whose taps are all inside the row
+            int simdBegin = 3;
+            int simdEnd = simdBegin;
+            
+            if (funcs && w > 6) {
+                for (int k = 0; k < 7; k++) {
+                    taps[k] = in + k * 4;
+                }
+                
+                simdEnd += funcs->gauss(taps, out + simdBegin * 4, w - 6);
+            }
+            
+            for (int x = 0; x < w; x++) {
+                if (x == simdBegin) x = simdEnd;
+                if (x >= w) break;
+                
+                for (int k = 0; k < 7; k++) {
+                    taps[k] = in + clampCoord(x + k - 3, w) * 4;
+                }
+                
+                gaussPx(taps, 0, out + x * 4);
+            }
+        }
+    }
+}
+
+void CPUKernels::adaptThreshAvg(const CPUImage &src, CPUImage &dst) {
+    assert(src.getWidth() == dst.getWidth() && src.getHeight() == dst.getHeight());
+    
+    const CPUKernelFuncs *funcs = simdFuncs.load();
+    
+    int w = src.getWidth();
+    const unsigned char *taps[5];
+    
+    for (int y = dst.getFirstRow(); y < dst.getFirstRow() + dst.getNumRows(); y++) {
+        const unsigned char *in = src.getRow(y);
+        unsigned char *out = dst.getRow(y);
+        
+        // the vectorized kernel processes the pixels whose taps are all inside the row
+        int simdBegin = 2;
+        int simdEnd = simdBegin;
+        
+        if (funcs && w > 4) {
+            for (int k = 0; k < 5; k++) {
+                taps[k] = in + k * 4;
+            }
+            
+            simdEnd += funcs->adaptThreshAvg(taps, out + simdBegin * 4, w - 4);
+        }
+        
+        for (int x = 0; x < w; x++) {
+            if (x == simdBegin) x = simdEnd;
+            if (x >= w) break;
+            
+            float sum = 0.0f;
+            
+            for (int k = -2; k <= 2; k++) {
+                sum += in[clampCoord(x + k, w) * 4];
+            }
+            
+            // average and original value
+            out[x * 4] = toByte(sum / 5.0f);
+            out[x * 4 + 1] = in[x * 4];
+            out[x * 4 + 2] = 0;
+            out[x * 4 + 3] = 255;
+        }
+    }
+}
+
+void CPUKernels::adaptThresh(const CPUImage &src, CPUImage &dst) {
+    assert(src.getWidth() == dst.getWidth() && src.getHeight() == dst.getHeight());
+    
+    const CPUKernelFuncs *funcs = simdFuncs.load();
+    
+    int w = src.getWidth();
+    int h = src.getHeight();
+    const unsigned char *taps[5];
+    
+    for (int y = dst.getFirstRow(); y < dst.getFirstRow() + dst.getNumRows(); y++) {
+        unsigned char *out = dst.getRow(y);
+        
+        for (int k = 0; k < 5; k++) {
+            taps[k] = src.getRow(clampCoord(y + k - 2, h));
+        }
+        
+        int x = funcs ? funcs->adaptThresh(taps, out, w) : 0;
+        
+        for (; x < w; x++) {
+            float sum = 0.0f;
+            
+            for (int k = 0; k < 5; k++) {
+                sum += taps[k][x * 4];
+            }
+            
+            // inverted binary value: set if the original value is below the local average
+            float avg = sum / 5.0f;
+            unsigned char bin = taps[2][x * 4 + 1] < avg - OGLES_GPGPU_CPU_ADAPT_THRESH_C ? 255 : 0;
+            out[x * 4] = out[x * 4 + 1] = out[x * 4 + 2] = bin;
+            out[x * 4 + 3] = 255;
+        }
+    }
+}
+
+void CPUKernels::blend(const CPUImage &a, const CPUImage &b, CPUImage &dst, float weight) {
+    assert(a.getWidth() == dst.getWidth() && a.getHeight() == dst.getHeight());
+    assert(b.getWidth() == dst.getWidth() && b.getHeight() == dst.getHeight());
+    
+    const unsigned char *inA = a.getRow(dst.getFirstRow());
+    const unsigned char *inB = b.getRow(dst.getFirstRow());
+    unsigned char *out = dst.getData();
+    
+    for (int i = 0; i < dst.getWidth() * dst.getNumRows(); i++, inA += 4, inB += 4, out += 4) {
+        for (int c = 0; c < 3; c++) {
+            out[c] = toByte(inA[c] * (1.0f - weight) + inB[c] * weight);
+        }
+        
+        out[3] = 255;
+    }
+}
+
+void CPUKernels::diff(const CPUImage &a, const CPUImage &b, CPUImage &dst, float gain) {
+    assert(a.getWidth() == dst.getWidth() && a.getHeight() == dst.getHeight());
+    assert(b.getWidth() == dst.getWidth() && b.getHeight() == dst.getHeight());
+    
+    const unsigned char *inA = a.getRow(dst.getFirstRow());
+    const unsigned char *inB = b.getRow(dst.getFirstRow());
+    unsigned char *out = dst.getData();
+    
+    for (int i = 0; i < dst.getWidth() * dst.getNumRows(); i++, inA += 4, inB += 4, out += 4) {
+        for (int c = 0; c < 3; c++) {
+            out[c] = toByte(abs(inA[c] - inB[c]) * gain);
+        }
+        
+        out[3] = 255;
+    }
+}
+
+void CPUKernels::packGray8(const CPUImage &src, unsigned char *dst) {
+    assert(src.getNumRows() == src.getHeight());
+    
+    const unsigned char *in = src.getData();
+    
+    for (int i = 0; i < src.getWidth() * src.getHeight(); i++, in += 4) {
+        dst[i] = in[0];
+    }
+}
+
+void CPUKernels::packMask1(const CPUImage &src, unsigned char *dst) {
+    assert(src.getNumRows() == src.getHeight());
+    
+    int w = src.getWidth();
+    int rowLen = (w + 7) / 8;
+    
+    // first pixel in the lowest bit, rows padded to whole bytes (see PackProc)
+    for (int y = 0; y < src.getHeight(); y++) {
+        const unsigned char *in = src.getRow(y);
+        unsigned char *out = dst + y * rowLen;
+        memset(out, 0, rowLen);
+        
+        for (int x = 0; x < w; x++) {
+            if (in[x * 4] >= 128) out[x / 8] |= 1 << (x % 8);
+        }
+    }
+}
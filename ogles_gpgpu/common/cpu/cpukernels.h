@@ -0,0 +1,149 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Image processing kernels of the CPU backend.
+ */
+#ifndef OGLES_GPGPU_COMMON_CPU_CPUKERNELS
+#define OGLES_GPGPU_COMMON_CPU_CPUKERNELS
+
+#include "../common_includes.h"
+
+#include "cpuimage.h"
+
+namespace ogles_gpgpu {
+
+/**
+ * Instruction sets for the vectorized CPU kernels (see CPUKernels::setInstructionSet()).
+ */
+typedef enum {
+    CPU_ISA_SCALAR = 0, // plain C++
+    CPU_ISA_SSE2,       // x86 SSE2, 4 pixels per instruction
+    CPU_ISA_AVX2,       // x86 AVX2, 8 pixels per instruction
+    CPU_ISA_NEON        // ARM NEON, 16 pixels per instruction (4 for the Gauss filter)
+} CPUInstructionSet;
+
+/**
+ * Reference implementations of the processors' shaders for the CPU backend
+ * (see Core::setBackend()). Each kernel computes what the fragment shader computes
+ * for each pixel, in single precision and with the same clamp-to-edge sampling, and
+ * rounds the result to 8 bits like the write to an RGBA texture. The destination
+ * image must have the size of the (first) source image, unless noted otherwise.
+ * The kernels compute the rows that the destination image holds (see
+ * CPUImage::resizeRows()), so that a frame can be processed in row bands. The source
+ * images must hold these rows and the neighboring rows that the kernel reads.
+ *
+ * Grayscale conversion, thresholding, the Gauss filter and adaptive thresholding
+ * have vectorized versions for SSE2, AVX2 and NEON. The NEON kernels are only built
+ * with OGLES_GPGPU_CPU_ENABLE_NEON defined, because they are not yet verified on ARM
+ * hardware. The best instruction set that the CPU supports is selected at runtime. The vectorized kernels produce the same
+ * results as the scalar ones.
+ */
+class CPUKernels {
+public:
+    /**
+     * Select instruction set <isa> for the kernels. Falls back to the scalar kernels
+     * if the CPU does not support it. This is a global setting. It may be changed while
+     * Core objects in other threads are processing: each kernel call uses either the
+     * previous or the new instruction set.
+     */
+    static void setInstructionSet(CPUInstructionSet isa);
+    
+    /**
+     * Get the selected instruction set. By default, this is the best instruction
+     * set that the CPU supports.
+     */
+    static CPUInstructionSet getInstructionSet();
+    
+    /**
+     * Returns true if the CPU supports instruction set <isa> and the library was
+     * built with kernels for it.
+     */
+    static bool getInstructionSetSupport(CPUInstructionSet isa);
+    
+    /**
+     * Return the name of instruction set <isa> (e.g. "sse2").
+     */
+    static const char *getInstructionSetName(CPUInstructionSet isa);
+    
+    /**
+     * Convert input data <data> in pixel format <fmt> (GL_RGBA or one of the
+     * InputYUVFormat formats) with <rowStride> bytes between the rows (0 for tightly
+     * packed rows, see Core::setInputData()) to RGBA image <dst>, which has the input
+     * frame size. Chroma planes are sampled bilinearly like the chroma textures.
+     */
+    static void convInputData(const unsigned char *data, GLenum fmt, int rowStride, CPUImage &dst);
+    
+    /**
+     * Sample <src> bilinearly for the pixel centers of <dst> (which defines the output
+     * size) with the texture coordinates of render orientation <o>, like a processor
+     * that scales its input or changes its orientation. Only for whole images.
+     */
+    static void resample(const CPUImage &src, CPUImage &dst, RenderOrientation o);
+    
+    /**
+     * Grayscale conversion of <src> to <dst> with the RGB weights <convVec>
+     * (see GrayscaleProc).
+     */
+    static void grayscale(const CPUImage &src, CPUImage &dst, const float convVec[3]);
+    
+    /**
+     * Simple thresholding of the red channel of <src> with threshold <threshVal>
+     * (0.0 .. 1.0) to <dst> (see ThreshProc).
+     */
+    static void thresh(const CPUImage &src, CPUImage &dst, float threshVal);
+    
+    /**
+     * Smoothing of all channels of <src> with the 7-tap Gauss kernel of GaussProcPass
+     * in horizontal or <vertical> direction to <dst>.
+     */
+    static void gauss(const CPUImage &src, CPUImage &dst, bool vertical);
+    
+    /**
+     * First pass of adaptive thresholding (see AdaptThreshProcPass): horizontal 5 pixel
+     * average of the red channel of <src> in the red channel of <dst>, the original
+     * value in the green channel.
+     */
+    static void adaptThreshAvg(const CPUImage &src, CPUImage &dst);
+    
+    /**
+     * Second pass of adaptive thresholding: vertical 5 pixel average of the averages
+     * of <src> (output of adaptThreshAvg()). Writes the inverted binary result of
+     * comparing the original value with this average to <dst>.
+     */
+    static void adaptThresh(const CPUImage &src, CPUImage &dst);
+    
+    /**
+     * Linear blending of <a> and <b> with weight <weight> of <b> to <dst>
+     * (see BlendProc).
+     */
+    static void blend(const CPUImage &a, const CPUImage &b, CPUImage &dst, float weight);
+    
+    /**
+     * Absolute difference of <a> and <b>, multiplied by <gain>, to <dst>
+     * (see DiffProc).
+     */
+    static void diff(const CPUImage &a, const CPUImage &b, CPUImage &dst, float gain);
+    
+    /**
+     * Write the red channel of whole image <src> to <dst> with 1 byte per pixel
+     * (OUTPUT_FORMAT_GRAY8).
+     */
+    static void packGray8(const CPUImage &src, unsigned char *dst);
+    
+    /**
+     * Write the thresholded red channel of whole image <src> to <dst> with 1 bit per
+     * pixel (OUTPUT_FORMAT_MASK1).
+     */
+    static void packMask1(const CPUImage &src, unsigned char *dst);
+};
+
+}
+
+#endif
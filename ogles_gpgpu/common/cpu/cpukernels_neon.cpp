@@ -0,0 +1,233 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "cpukernels_simd.h"
+
+#ifdef OGLES_GPGPU_CPU_HAVE_NEON
+
+#include <arm_neon.h>
+
+using namespace ogles_gpgpu;
+
+// The kernels deinterleave 16 RGBA pixels into one vector per channel where possible
+// and compute with the same single precision operations in the same order as the
+// scalar kernels. The averages of adaptive thresholding are computed with integers,
+// which is exact for the possible sums. Note that the compiler may contract the
+// multiplications and additions to fused multiply-adds, which can change results by 1.
+
+// threshold offset of adaptive thresholding in the integer comparison 2 * sum > 10 * G + C10,
+// which is equivalent to G < sum / 5 - C
+#define ADAPT_THRESH_C10    ((int)(10.0f * OGLES_GPGPU_CPU_ADAPT_THRESH_C))
+
+// (x * DIV5_MUL) >> 16 equals x / 5 for 0 <= x < 2^14
+#define DIV5_MUL            13108
+
+#pragma mark helper functions
+
+/**
+ * Round the values <v> in 8 bit units to integers like the scalar kernels.
+ */
+static inline uint32x4_t toBytesNEON(float32x4_t v) {
+    v = vminq_f32(vmaxq_f32(v, vdupq_n_f32(0.0f)), vdupq_n_f32(255.0f));
+    return vcvtq_u32_f32(vaddq_f32(v, vdupq_n_f32(0.5f)));
+}
+
+/**
+ * Convert the 4 values <v> to floats.
+ */
+static inline float32x4_t toFloatNEON(uint16x4_t v) {
+    return vcvtq_f32_u32(vmovl_u16(v));
+}
+
+/**
+ * Narrow the 16 values <a>, <b>, <c>, <d> (0 .. 255) to bytes.
+ */
+static inline uint8x16_t narrowNEON(uint32x4_t a, uint32x4_t b, uint32x4_t c, uint32x4_t d) {
+    uint16x8_t lo = vcombine_u16(vmovn_u32(a), vmovn_u32(b));
+    uint16x8_t hi = vcombine_u16(vmovn_u32(c), vmovn_u32(d));
+    return vcombine_u8(vmovn_u16(lo), vmovn_u16(hi));
+}
+
+/**
+ * Store 16 opaque RGBA pixels with value <v> in the RGB channels to <out>.
+ */
+static inline void storeGrayNEON(unsigned char *out, uint8x16_t v) {
+    uint8x16x4_t px;
+    px.val[0] = px.val[1] = px.val[2] = v;
+    px.val[3] = vdupq_n_u8(255);
+    vst4q_u8(out, px);
+}
+
+/**
+ * Return the 7-tap Gauss filter result of the channel values <c> at the center and
+ * the sums <s1>, <s2>, <s3> of the channel values at the offsets -1/1, -2/2 and -3/3.
+ */
+static inline uint32x4_t gaussSumNEON(uint16x4_t c, uint16x4_t s1, uint16x4_t s2, uint16x4_t s3) {
+    float32x4_t sum = vmulq_f32(vdupq_n_f32(gaussWeights[0]), toFloatNEON(c));
+    sum = vaddq_f32(sum, vmulq_f32(vdupq_n_f32(gaussWeights[1]), toFloatNEON(s1)));
+    sum = vaddq_f32(sum, vmulq_f32(vdupq_n_f32(gaussWeights[2]), toFloatNEON(s2)));
+    sum = vaddq_f32(sum, vmulq_f32(vdupq_n_f32(gaussWeights[3]), toFloatNEON(s3)));
+    
+    return toBytesNEON(sum);
+}
+
+/**
+ * Load the red channels of the 16 pixels at <taps> with offset <offset> and return
+ * their sums in <lo> (first 8 pixels) and <hi> (last 8 pixels).
+ */
+static inline void sum5NEON(const unsigned char *const taps[5], int offset, uint16x8_t &lo, uint16x8_t &hi) {
+    uint8x16_t r = vld4q_u8(taps[0] + offset).val[0];
+    lo = vmovl_u8(vget_low_u8(r));
+    hi = vmovl_u8(vget_high_u8(r));
+    
+    for (int k = 1; k < 5; k++) {
+        r = vld4q_u8(taps[k] + offset).val[0];
+        lo = vaddw_u8(lo, vget_low_u8(r));
+        hi = vaddw_u8(hi, vget_high_u8(r));
+    }
+}
+
+/**
+ * Return the 8 rounded averages (sum + 2) / 5 of the sums <sum>.
+ */
+static inline uint8x8_t avg5NEON(uint16x8_t sum) {
+    sum = vaddq_u16(sum, vdupq_n_u16(2));
+    uint16x4_t lo = vshrn_n_u32(vmull_u16(vget_low_u16(sum), vdup_n_u16(DIV5_MUL)), 16);
+    uint16x4_t hi = vshrn_n_u32(vmull_u16(vget_high_u16(sum), vdup_n_u16(DIV5_MUL)), 16);
+    return vmovn_u16(vcombine_u16(lo, hi));
+}
+
+/**
+ * Return the inverted binary values of adaptive thresholding of the 8 original values
+ * <orig> with the sums <sum>.
+ */
+static inline uint8x8_t adaptThreshBinNEON(uint16x8_t sum, uint8x8_t orig) {
+    uint16x8_t limit = vmlaq_n_u16(vdupq_n_u16(ADAPT_THRESH_C10), vmovl_u8(orig), 10);
+    return vmovn_u16(vcgtq_u16(vshlq_n_u16(sum, 1), limit));
+}
+
+#pragma mark kernels
+
+static int grayscaleNEON(const unsigned char *in, unsigned char *out, int n, const float convVec[3]) {
+    const float32x4_t c0 = vdupq_n_f32(convVec[0]);
+    const float32x4_t c1 = vdupq_n_f32(convVec[1]);
+    const float32x4_t c2 = vdupq_n_f32(convVec[2]);
+    
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x4_t px = vld4q_u8(in + i * 4);
+        uint16x8_t r[2] = { vmovl_u8(vget_low_u8(px.val[0])), vmovl_u8(vget_high_u8(px.val[0])) };
+        uint16x8_t g[2] = { vmovl_u8(vget_low_u8(px.val[1])), vmovl_u8(vget_high_u8(px.val[1])) };
+        uint16x8_t b[2] = { vmovl_u8(vget_low_u8(px.val[2])), vmovl_u8(vget_high_u8(px.val[2])) };
+        uint32x4_t res[4];
+        
+        for (int q = 0; q < 4; q++) {
+            uint16x4_t rq = q % 2 ? vget_high_u16(r[q / 2]) : vget_low_u16(r[q / 2]);
+            uint16x4_t gq = q % 2 ? vget_high_u16(g[q / 2]) : vget_low_u16(g[q / 2]);
+            uint16x4_t bq = q % 2 ? vget_high_u16(b[q / 2]) : vget_low_u16(b[q / 2]);
+            float32x4_t gray = vaddq_f32(vaddq_f32(vmulq_f32(toFloatNEON(rq), c0), vmulq_f32(toFloatNEON(gq), c1)),
+                                         vmulq_f32(toFloatNEON(bq), c2));
+            res[q] = toBytesNEON(gray);
+        }
+        
+        storeGrayNEON(out + i * 4, narrowNEON(res[0], res[1], res[2], res[3]));
+    }
+    
+    return i;
+}
+
+static int threshNEON(const unsigned char *in, unsigned char *out, int n, int minVal) {
+    if (minVal > 255) return 0;     // nothing passes, left to the scalar kernel
+    
+    const uint8x16_t limit = vdupq_n_u8((uint8_t)minVal);
+    
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t r = vld4q_u8(in + i * 4).val[0];
+        storeGrayNEON(out + i * 4, vcgeq_u8(r, limit));
+    }
+    
+    return i;
+}
+
+static int gaussNEON(const unsigned char *const taps[7], unsigned char *out, int n) {
+    // 4 pixels = 16 channel values per iteration
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int offset = i * 4;
+        
+        // center values and sums of the symmetric taps with 16 bits
+        uint8x16_t c = vld1q_u8(taps[3] + offset);
+        uint16x8_t lo[4], hi[4];
+        lo[0] = vmovl_u8(vget_low_u8(c));
+        hi[0] = vmovl_u8(vget_high_u8(c));
+        
+        for (int k = 1; k <= 3; k++) {
+            uint8x16_t a = vld1q_u8(taps[3 - k] + offset);
+            uint8x16_t b = vld1q_u8(taps[3 + k] + offset);
+            lo[k] = vaddl_u8(vget_low_u8(a), vget_low_u8(b));
+            hi[k] = vaddl_u8(vget_high_u8(a), vget_high_u8(b));
+        }
+        
+        // filter 4 channel values at a time
+        uint32x4_t res0 = gaussSumNEON(vget_low_u16(lo[0]), vget_low_u16(lo[1]), vget_low_u16(lo[2]), vget_low_u16(lo[3]));
+        uint32x4_t res1 = gaussSumNEON(vget_high_u16(lo[0]), vget_high_u16(lo[1]), vget_high_u16(lo[2]), vget_high_u16(lo[3]));
+        uint32x4_t res2 = gaussSumNEON(vget_low_u16(hi[0]), vget_low_u16(hi[1]), vget_low_u16(hi[2]), vget_low_u16(hi[3]));
+        uint32x4_t res3 = gaussSumNEON(vget_high_u16(hi[0]), vget_high_u16(hi[1]), vget_high_u16(hi[2]), vget_high_u16(hi[3]));
+        
+        vst1q_u8(out + offset, narrowNEON(res0, res1, res2, res3));
+    }
+    
+    return i;
+}
+
+static int adaptThreshAvgNEON(const unsigned char *const taps[5], unsigned char *out, int n) {
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        int offset = i * 4;
+        uint16x8_t lo, hi;
+        sum5NEON(taps, offset, lo, hi);
+        
+        // average and original value
+        uint8x16x4_t px;
+        px.val[0] = vcombine_u8(avg5NEON(lo), avg5NEON(hi));
+        px.val[1] = vld4q_u8(taps[2] + offset).val[0];
+        px.val[2] = vdupq_n_u8(0);
+        px.val[3] = vdupq_n_u8(255);
+        vst4q_u8(out + offset, px);
+    }
+    
+    return i;
+}
+
+static int adaptThreshNEON(const unsigned char *const taps[5], unsigned char *out, int n) {
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        int offset = i * 4;
+        uint16x8_t lo, hi;
+        sum5NEON(taps, offset, lo, hi);
+        
+        uint8x16_t orig = vld4q_u8(taps[2] + offset).val[1];
+        uint8x16_t bin = vcombine_u8(adaptThreshBinNEON(lo, vget_low_u8(orig)),
+                                     adaptThreshBinNEON(hi, vget_high_u8(orig)));
+        storeGrayNEON(out + offset, bin);
+    }
+    
+    return i;
+}
+
+const CPUKernelFuncs ogles_gpgpu::cpuKernelFuncsNEON = {
+    grayscaleNEON,
+    threshNEON,
+    gaussNEON,
+    adaptThreshAvgNEON,
+    adaptThreshNEON
+};
+
+#endif  // OGLES_GPGPU_CPU_HAVE_NEON
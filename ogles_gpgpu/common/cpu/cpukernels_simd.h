@@ -0,0 +1,94 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Vectorized parts of the CPU kernels. Only used by CPUKernels.
+ */
+#ifndef OGLES_GPGPU_COMMON_CPU_CPUKERNELS_SIMD
+#define OGLES_GPGPU_COMMON_CPU_CPUKERNELS_SIMD
+
+#include "cpukernels.h"
+
+// x86 kernels. AVX2 kernels are compiled with a function target attribute, so that
+// the library runs on CPUs without AVX2
+#if defined(__SSE2__) || defined(_M_X64)
+#define OGLES_GPGPU_CPU_HAVE_SSE2
+#if defined(__GNUC__) || defined(__clang__)
+#define OGLES_GPGPU_CPU_HAVE_AVX2
+#endif
+#endif
+
+// ARM kernels. NEON is available on all CPUs for which the library is built with it.
+// the kernels are not yet verified on ARM hardware (og_kernel_bench compares them to
+// the scalar kernels), so they must be enabled explicitly
+#if (defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(OGLES_GPGPU_CPU_ENABLE_NEON)
+#define OGLES_GPGPU_CPU_HAVE_NEON
+#endif
+
+// offset of the threshold from the local average in adaptive thresholding (in 8 bit units)
+#define OGLES_GPGPU_CPU_ADAPT_THRESH_C  9.5f
+
+namespace ogles_gpgpu {
+
+// weights of the 7-tap Gauss kernel from the center to the border (see GaussProcPass)
+static const float gaussWeights[4] = { 0.382f, 0.242f, 0.061f, 0.006f };
+
+/**
+ * Vectorized kernel functions for one instruction set. Each function processes <n>
+ * consecutive RGBA pixels (of which it may leave a rest of less than its vector
+ * width) and returns the number of processed pixels. The scalar kernels process the
+ * rest and the border pixels.
+ */
+typedef struct {
+    /**
+     * Grayscale conversion of <in> to <out> with the RGB weights <convVec>.
+     */
+    int (*grayscale)(const unsigned char *in, unsigned char *out, int n, const float convVec[3]);
+    
+    /**
+     * Thresholding of <in> to <out>: set if the red channel is >= <minVal>
+     * (0 .. 256, see CPUKernels::thresh()).
+     */
+    int (*thresh)(const unsigned char *in, unsigned char *out, int n, int minVal);
+    
+    /**
+     * 7-tap Gauss filter of all channels to <out>. <taps> point to the pixels at
+     * offsets -3 .. 3 of the first pixel in filter direction (in a row or in a column).
+     * The following pixels' taps follow in each row.
+     */
+    int (*gauss)(const unsigned char *const taps[7], unsigned char *out, int n);
+    
+    /**
+     * First pass of adaptive thresholding to <out>. <taps> point to the pixels at
+     * offsets -2 .. 2 of the first pixel in its row.
+     */
+    int (*adaptThreshAvg)(const unsigned char *const taps[5], unsigned char *out, int n);
+    
+    /**
+     * Second pass of adaptive thresholding to <out>. <taps> point to the pixels at
+     * offsets -2 .. 2 of the first pixel in its column.
+     */
+    int (*adaptThresh)(const unsigned char *const taps[5], unsigned char *out, int n);
+} CPUKernelFuncs;
+
+#ifdef OGLES_GPGPU_CPU_HAVE_SSE2
+extern const CPUKernelFuncs cpuKernelFuncsSSE2;     // SSE2 kernels (cpukernels_x86.cpp)
+#endif
+
+#ifdef OGLES_GPGPU_CPU_HAVE_AVX2
+extern const CPUKernelFuncs cpuKernelFuncsAVX2;     // AVX2 kernels (cpukernels_x86.cpp)
+#endif
+
+#ifdef OGLES_GPGPU_CPU_HAVE_NEON
+extern const CPUKernelFuncs cpuKernelFuncsNEON;     // NEON kernels (cpukernels_neon.cpp)
+#endif
+
+}
+
+#endif
@@ -0,0 +1,361 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "cpukernels_simd.h"
+
+#ifdef OGLES_GPGPU_CPU_HAVE_SSE2
+
+#include <emmintrin.h>
+
+#ifdef OGLES_GPGPU_CPU_HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+using namespace ogles_gpgpu;
+
+// The kernels keep one pixel per 32 bit lane where possible and compute with the same
+// single precision operations in the same order as the scalar kernels, so that they
+// produce identical results. The averages of adaptive thresholding are computed with
+// integers, which is exact for the possible sums.
+
+// threshold offset of adaptive thresholding in the integer comparison 2 * sum > 10 * G + C10,
+// which is equivalent to G < sum / 5 - C
+#define ADAPT_THRESH_C10    ((int)(10.0f * OGLES_GPGPU_CPU_ADAPT_THRESH_C))
+
+// (x * DIV5_MUL) >> 16 equals x / 5 for 0 <= x < 2^14
+#define DIV5_MUL            13108
+
+#pragma mark SSE2 helper functions
+
+/**
+ * Round the values <v> in 8 bit units to integers like the scalar kernels.
+ */
+static inline __m128i toBytesSSE2(__m128 v) {
+    v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+    return _mm_cvttps_epi32(_mm_add_ps(v, _mm_set1_ps(0.5f)));
+}
+
+/**
+ * Return the channel at bit offset <shift> of the RGBA pixels <px>.
+ */
+static inline __m128i channelSSE2(__m128i px, int shift) {
+    return _mm_and_si128(_mm_srli_epi32(px, shift), _mm_set1_epi32(0xFF));
+}
+
+/**
+ * Return opaque RGBA pixels with value <v> in the RGB channels.
+ */
+static inline __m128i grayPxSSE2(__m128i v) {
+    __m128i rg = _mm_or_si128(v, _mm_slli_epi32(v, 8));
+    return _mm_or_si128(_mm_or_si128(rg, _mm_slli_epi32(v, 16)), _mm_set1_epi32((int)0xFF000000));
+}
+
+/**
+ * Return the 7-tap Gauss filter result of the channel values <c> at the center and
+ * the sums <s1>, <s2>, <s3> of the channel values at the offsets -1/1, -2/2 and -3/3.
+ */
+static inline __m128i gaussSumSSE2(__m128i c, __m128i s1, __m128i s2, __m128i s3) {
+    __m128 sum = _mm_mul_ps(_mm_set1_ps(gaussWeights[0]), _mm_cvtepi32_ps(c));
+    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(gaussWeights[1]), _mm_cvtepi32_ps(s1)));
+    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(gaussWeights[2]), _mm_cvtepi32_ps(s2)));
+    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(gaussWeights[3]), _mm_cvtepi32_ps(s3)));
+    
+    return toBytesSSE2(sum);
+}
+
+/**
+ * Return the sum of the red channels of the pixels at <taps> with offset <offset>.
+ */
+static inline __m128i sum5SSE2(const unsigned char *const taps[5], int offset) {
+    __m128i sum = _mm_setzero_si128();
+    
+    for (int k = 0; k < 5; k++) {
+        sum = _mm_add_epi32(sum, channelSSE2(_mm_loadu_si128((const __m128i *)(taps[k] + offset)), 0));
+    }
+    
+    return sum;
+}
+
+#pragma mark SSE2 kernels
+
+static int grayscaleSSE2(const unsigned char *in, unsigned char *out, int n, const float convVec[3]) {
+    const __m128 c0 = _mm_set1_ps(convVec[0]);
+    const __m128 c1 = _mm_set1_ps(convVec[1]);
+    const __m128 c2 = _mm_set1_ps(convVec[2]);
+    
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i px = _mm_loadu_si128((const __m128i *)(in + i * 4));
+        __m128 r = _mm_cvtepi32_ps(channelSSE2(px, 0));
+        __m128 g = _mm_cvtepi32_ps(channelSSE2(px, 8));
+        __m128 b = _mm_cvtepi32_ps(channelSSE2(px, 16));
+        __m128 gray = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, c0), _mm_mul_ps(g, c1)), _mm_mul_ps(b, c2));
+        
+        _mm_storeu_si128((__m128i *)(out + i * 4), grayPxSSE2(toBytesSSE2(gray)));
+    }
+    
+    return i;
+}
+
+static int threshSSE2(const unsigned char *in, unsigned char *out, int n, int minVal) {
+    const __m128i limit = _mm_set1_epi32(minVal - 1);
+    
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i px = _mm_loadu_si128((const __m128i *)(in + i * 4));
+        __m128i bin = _mm_and_si128(_mm_cmpgt_epi32(channelSSE2(px, 0), limit), _mm_set1_epi32(0xFF));
+        
+        _mm_storeu_si128((__m128i *)(out + i * 4), grayPxSSE2(bin));
+    }
+    
+    return i;
+}
+
+static int gaussSSE2(const unsigned char *const taps[7], unsigned char *out, int n) {
+    const __m128i zero = _mm_setzero_si128();
+    
+    // 4 pixels = 16 channel values per iteration
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int offset = i * 4;
+        
+        // center values and sums of the symmetric taps with 16 bits
+        __m128i c = _mm_loadu_si128((const __m128i *)(taps[3] + offset));
+        __m128i lo[4], hi[4];
+        lo[0] = _mm_unpacklo_epi8(c, zero);
+        hi[0] = _mm_unpackhi_epi8(c, zero);
+        
+        for (int k = 1; k <= 3; k++) {
+            __m128i a = _mm_loadu_si128((const __m128i *)(taps[3 - k] + offset));
+            __m128i b = _mm_loadu_si128((const __m128i *)(taps[3 + k] + offset));
+            lo[k] = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+            hi[k] = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+        }
+        
+        // filter 4 channel values with 32 bits at a time
+        __m128i res0 = gaussSumSSE2(_mm_unpacklo_epi16(lo[0], zero), _mm_unpacklo_epi16(lo[1], zero),
+                                    _mm_unpacklo_epi16(lo[2], zero), _mm_unpacklo_epi16(lo[3], zero));
+        __m128i res1 = gaussSumSSE2(_mm_unpackhi_epi16(lo[0], zero), _mm_unpackhi_epi16(lo[1], zero),
+                                    _mm_unpackhi_epi16(lo[2], zero), _mm_unpackhi_epi16(lo[3], zero));
+        __m128i res2 = gaussSumSSE2(_mm_unpacklo_epi16(hi[0], zero), _mm_unpacklo_epi16(hi[1], zero),
+                                    _mm_unpacklo_epi16(hi[2], zero), _mm_unpacklo_epi16(hi[3], zero));
+        __m128i res3 = gaussSumSSE2(_mm_unpackhi_epi16(hi[0], zero), _mm_unpackhi_epi16(hi[1], zero),
+                                    _mm_unpackhi_epi16(hi[2], zero), _mm_unpackhi_epi16(hi[3], zero));
+        
+        __m128i res = _mm_packus_epi16(_mm_packs_epi32(res0, res1), _mm_packs_epi32(res2, res3));
+        _mm_storeu_si128((__m128i *)(out + offset), res);
+    }
+    
+    return i;
+}
+
+static int adaptThreshAvgSSE2(const unsigned char *const taps[5], unsigned char *out, int n) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int offset = i * 4;
+        
+        // rounded average (sum + 2) / 5 (< 2^16, so that the upper 16 bits stay 0)
+        __m128i sum = _mm_add_epi32(sum5SSE2(taps, offset), _mm_set1_epi32(2));
+        __m128i avg = _mm_mulhi_epu16(sum, _mm_set1_epi32(DIV5_MUL));
+        
+        // average and original value
+        __m128i orig = channelSSE2(_mm_loadu_si128((const __m128i *)(taps[2] + offset)), 0);
+        __m128i res = _mm_or_si128(_mm_or_si128(avg, _mm_slli_epi32(orig, 8)), _mm_set1_epi32((int)0xFF000000));
+        
+        _mm_storeu_si128((__m128i *)(out + offset), res);
+    }
+    
+    return i;
+}
+
+static int adaptThreshSSE2(const unsigned char *const taps[5], unsigned char *out, int n) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int offset = i * 4;
+        
+        __m128i sum2 = _mm_slli_epi32(sum5SSE2(taps, offset), 1);
+        __m128i orig = channelSSE2(_mm_loadu_si128((const __m128i *)(taps[2] + offset)), 8);
+        __m128i limit = _mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(orig, 3), _mm_slli_epi32(orig, 1)),
+                                      _mm_set1_epi32(ADAPT_THRESH_C10));
+        __m128i bin = _mm_and_si128(_mm_cmpgt_epi32(sum2, limit), _mm_set1_epi32(0xFF));
+        
+        _mm_storeu_si128((__m128i *)(out + offset), grayPxSSE2(bin));
+    }
+    
+    return i;
+}
+
+const CPUKernelFuncs ogles_gpgpu::cpuKernelFuncsSSE2 = {
+    grayscaleSSE2,
+    threshSSE2,
+    gaussSSE2,
+    adaptThreshAvgSSE2,
+    adaptThreshSSE2
+};
+
+#ifdef OGLES_GPGPU_CPU_HAVE_AVX2
+
+// AVX2 code is only generated for these functions, which are only called if the CPU
+// supports AVX2
+#define AVX2_FUNC   __attribute__((target("avx2")))
+
+#pragma mark AVX2 helper functions
+
+AVX2_FUNC static inline __m256i toBytesAVX2(__m256 v) {
+    v = _mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), _mm256_set1_ps(255.0f));
+    return _mm256_cvttps_epi32(_mm256_add_ps(v, _mm256_set1_ps(0.5f)));
+}
+
+AVX2_FUNC static inline __m256i channelAVX2(__m256i px, int shift) {
+    return _mm256_and_si256(_mm256_srli_epi32(px, shift), _mm256_set1_epi32(0xFF));
+}
+
+AVX2_FUNC static inline __m256i grayPxAVX2(__m256i v) {
+    __m256i rg = _mm256_or_si256(v, _mm256_slli_epi32(v, 8));
+    return _mm256_or_si256(_mm256_or_si256(rg, _mm256_slli_epi32(v, 16)), _mm256_set1_epi32((int)0xFF000000));
+}
+
+AVX2_FUNC static inline __m256i gaussSumAVX2(__m256i c, __m256i s1, __m256i s2, __m256i s3) {
+    __m256 sum = _mm256_mul_ps(_mm256_set1_ps(gaussWeights[0]), _mm256_cvtepi32_ps(c));
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(gaussWeights[1]), _mm256_cvtepi32_ps(s1)));
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(gaussWeights[2]), _mm256_cvtepi32_ps(s2)));
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(gaussWeights[3]), _mm256_cvtepi32_ps(s3)));
+    
+    return toBytesAVX2(sum);
+}
+
+AVX2_FUNC static inline __m256i sum5AVX2(const unsigned char *const taps[5], int offset) {
+    __m256i sum = _mm256_setzero_si256();
+    
+    for (int k = 0; k < 5; k++) {
+        sum = _mm256_add_epi32(sum, channelAVX2(_mm256_loadu_si256((const __m256i *)(taps[k] + offset)), 0));
+    }
+    
+    return sum;
+}
+
+#pragma mark AVX2 kernels
+
+// these are the SSE2 kernels with 8 instead of 4 pixels per iteration
+
+AVX2_FUNC static int grayscaleAVX2(const unsigned char *in, unsigned char *out, int n, const float convVec[3]) {
+    const __m256 c0 = _mm256_set1_ps(convVec[0]);
+    const __m256 c1 = _mm256_set1_ps(convVec[1]);
+    const __m256 c2 = _mm256_set1_ps(convVec[2]);
+    
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i px = _mm256_loadu_si256((const __m256i *)(in + i * 4));
+        __m256 r = _mm256_cvtepi32_ps(channelAVX2(px, 0));
+        __m256 g = _mm256_cvtepi32_ps(channelAVX2(px, 8));
+        __m256 b = _mm256_cvtepi32_ps(channelAVX2(px, 16));
+        __m256 gray = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r, c0), _mm256_mul_ps(g, c1)), _mm256_mul_ps(b, c2));
+        
+        _mm256_storeu_si256((__m256i *)(out + i * 4), grayPxAVX2(toBytesAVX2(gray)));
+    }
+    
+    return i;
+}
+
+AVX2_FUNC static int threshAVX2(const unsigned char *in, unsigned char *out, int n, int minVal) {
+    const __m256i limit = _mm256_set1_epi32(minVal - 1);
+    
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i px = _mm256_loadu_si256((const __m256i *)(in + i * 4));
+        __m256i bin = _mm256_and_si256(_mm256_cmpgt_epi32(channelAVX2(px, 0), limit), _mm256_set1_epi32(0xFF));
+        
+        _mm256_storeu_si256((__m256i *)(out + i * 4), grayPxAVX2(bin));
+    }
+    
+    return i;
+}
+
+AVX2_FUNC static int gaussAVX2(const unsigned char *const taps[7], unsigned char *out, int n) {
+    const __m256i zero = _mm256_setzero_si256();
+    
+    // 8 pixels = 32 channel values per iteration. Unpacking and packing work within
+    // the 128 bit lanes, so that the channel values end up in their original order
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int offset = i * 4;
+        
+        __m256i c = _mm256_loadu_si256((const __m256i *)(taps[3] + offset));
+        __m256i lo[4], hi[4];
+        lo[0] = _mm256_unpacklo_epi8(c, zero);
+        hi[0] = _mm256_unpackhi_epi8(c, zero);
+        
+        for (int k = 1; k <= 3; k++) {
+            __m256i a = _mm256_loadu_si256((const __m256i *)(taps[3 - k] + offset));
+            __m256i b = _mm256_loadu_si256((const __m256i *)(taps[3 + k] + offset));
+            lo[k] = _mm256_add_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero));
+            hi[k] = _mm256_add_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero));
+        }
+        
+        __m256i res0 = gaussSumAVX2(_mm256_unpacklo_epi16(lo[0], zero), _mm256_unpacklo_epi16(lo[1], zero),
+                                    _mm256_unpacklo_epi16(lo[2], zero), _mm256_unpacklo_epi16(lo[3], zero));
+        __m256i res1 = gaussSumAVX2(_mm256_unpackhi_epi16(lo[0], zero), _mm256_unpackhi_epi16(lo[1], zero),
+                                    _mm256_unpackhi_epi16(lo[2], zero), _mm256_unpackhi_epi16(lo[3], zero));
+        __m256i res2 = gaussSumAVX2(_mm256_unpacklo_epi16(hi[0], zero), _mm256_unpacklo_epi16(hi[1], zero),
+                                    _mm256_unpacklo_epi16(hi[2], zero), _mm256_unpacklo_epi16(hi[3], zero));
+        __m256i res3 = gaussSumAVX2(_mm256_unpackhi_epi16(hi[0], zero), _mm256_unpackhi_epi16(hi[1], zero),
+                                    _mm256_unpackhi_epi16(hi[2], zero), _mm256_unpackhi_epi16(hi[3], zero));
+        
+        __m256i res = _mm256_packus_epi16(_mm256_packs_epi32(res0, res1), _mm256_packs_epi32(res2, res3));
+        _mm256_storeu_si256((__m256i *)(out + offset), res);
+    }
+    
+    return i;
+}
+
+AVX2_FUNC static int adaptThreshAvgAVX2(const unsigned char *const taps[5], unsigned char *out, int n) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int offset = i * 4;
+        
+        __m256i sum = _mm256_add_epi32(sum5AVX2(taps, offset), _mm256_set1_epi32(2));
+        __m256i avg = _mm256_mulhi_epu16(sum, _mm256_set1_epi32(DIV5_MUL));
+        
+        __m256i orig = channelAVX2(_mm256_loadu_si256((const __m256i *)(taps[2] + offset)), 0);
+        __m256i res = _mm256_or_si256(_mm256_or_si256(avg, _mm256_slli_epi32(orig, 8)), _mm256_set1_epi32((int)0xFF000000));
+        
+        _mm256_storeu_si256((__m256i *)(out + offset), res);
+    }
+    
+    return i;
+}
+
+AVX2_FUNC static int adaptThreshAVX2(const unsigned char *const taps[5], unsigned char *out, int n) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int offset = i * 4;
+        
+        __m256i sum2 = _mm256_slli_epi32(sum5AVX2(taps, offset), 1);
+        __m256i orig = channelAVX2(_mm256_loadu_si256((const __m256i *)(taps[2] + offset)), 8);
+        __m256i limit = _mm256_add_epi32(_mm256_mullo_epi32(orig, _mm256_set1_epi32(10)),
+                                         _mm256_set1_epi32(ADAPT_THRESH_C10));
+        __m256i bin = _mm256_and_si256(_mm256_cmpgt_epi32(sum2, limit), _mm256_set1_epi32(0xFF));
+        
+        _mm256_storeu_si256((__m256i *)(out + offset), grayPxAVX2(bin));
+    }
+    
+    return i;
+}
+
+const CPUKernelFuncs ogles_gpgpu::cpuKernelFuncsAVX2 = {
+    grayscaleAVX2,
+    threshAVX2,
+    gaussAVX2,
+    adaptThreshAvgAVX2,
+    adaptThreshAVX2
+};
+
+#endif  // OGLES_GPGPU_CPU_HAVE_AVX2
+
+#endif  // OGLES_GPGPU_CPU_HAVE_SSE2
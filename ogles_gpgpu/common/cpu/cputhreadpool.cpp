@@ -0,0 +1,247 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "cputhreadpool.h"
+
+#include "../common_includes.h"
+
+#include <unistd.h>
+
+using namespace ogles_gpgpu;
+
+#pragma mark constructor / deconstructor
+
+CPUThreadPool::CPUThreadPool() : jobNum(0),
+                                 numBusyWorkers(0),
+                                 stopping(false),
+                                 jobFunc(NULL),
+                                 jobCtx(NULL)
+{
+    pthread_mutex_init(&mutex, NULL);
+    pthread_cond_init(&jobCond, NULL);
+    pthread_cond_init(&doneCond, NULL);
+    
+    // only the calling thread
+    queues.resize(1);
+    pthread_mutex_init(&queues[0].mutex, NULL);
+    queues[0].begin = queues[0].end = 0;
+}
+
+CPUThreadPool::~CPUThreadPool() {
+    stop();
+    
+    pthread_mutex_destroy(&queues[0].mutex);
+    pthread_cond_destroy(&doneCond);
+    pthread_cond_destroy(&jobCond);
+    pthread_mutex_destroy(&mutex);
+}
+
+#pragma mark public methods
+
+void CPUThreadPool::start(int numThreads) {
+    stop();
+    
+    if (numThreads <= 0) {
+        numThreads = getNumCPUCores();
+    }
+    
+    // the queues are not copied after their mutexes were initialized
+    pthread_mutex_destroy(&queues[0].mutex);
+    queues.resize(numThreads);
+    
+    for (int i = 0; i < numThreads; i++) {
+        pthread_mutex_init(&queues[i].mutex, NULL);
+        queues[i].begin = queues[i].end = 0;
+    }
+    
+    stopping = false;
+    workerCtxs.resize(numThreads - 1);
+    workers.resize(numThreads - 1);
+    
+    for (int i = 0; i < numThreads - 1; i++) {
+        workerCtxs[i].pool = this;
+        workerCtxs[i].thread = i + 1;
+        
+        if (pthread_create(&workers[i], NULL, workerMain, &workerCtxs[i]) != 0) {
+            OG_LOGERR("CPUThreadPool", "could not create worker thread %d", i + 1);
+            workers.resize(i);
+            break;
+        }
+    }
+    
+    // threads without worker thread get no tasks
+    int numCreated = (int)workers.size() + 1;
+    
+    for (int i = numCreated; i < numThreads; i++) {
+        pthread_mutex_destroy(&queues[i].mutex);
+    }
+    
+    queues.resize(numCreated);
+    
+    OG_LOGINF("CPUThreadPool", "started with %d threads", numCreated);
+}
+
+void CPUThreadPool::stop() {
+    if (workers.empty()) return;
+    
+    pthread_mutex_lock(&mutex);
+    stopping = true;
+    pthread_cond_broadcast(&jobCond);
+    pthread_mutex_unlock(&mutex);
+    
+    for (size_t i = 0; i < workers.size(); i++) {
+        pthread_join(workers[i], NULL);
+    }
+    
+    workers.clear();
+    workerCtxs.clear();
+    
+    for (size_t i = 1; i < queues.size(); i++) {
+        pthread_mutex_destroy(&queues[i].mutex);
+    }
+    
+    queues.resize(1);
+}
+
+void CPUThreadPool::run(CPUTaskFunc func, void *ctx, int numTasks) {
+    int numThreads = getNumThreads();
+    
+    // contiguous ranges of tasks for all threads. the workers are waiting, so the
+    // queues can be set without locking
+    for (int i = 0; i < numThreads; i++) {
+        queues[i].begin = (int)((long)numTasks * i / numThreads);
+        queues[i].end = (int)((long)numTasks * (i + 1) / numThreads);
+    }
+    
+    if (numThreads > 1) {
+        pthread_mutex_lock(&mutex);
+        jobFunc = func;
+        jobCtx = ctx;
+        numBusyWorkers = numThreads - 1;
+        jobNum++;
+        pthread_cond_broadcast(&jobCond);
+        pthread_mutex_unlock(&mutex);
+    } else {
+        jobFunc = func;
+        jobCtx = ctx;
+    }
+    
+    runTasks(0);
+    
+    // wait for the tasks of the workers
+    if (numThreads > 1) {
+        pthread_mutex_lock(&mutex);
+        
+        while (numBusyWorkers > 0) {
+            pthread_cond_wait(&doneCond, &mutex);
+        }
+        
+        pthread_mutex_unlock(&mutex);
+    }
+}
+
+int CPUThreadPool::getNumCPUCores() {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    
+    return n > 0 ? (int)n : 1;
+}
+
+#pragma mark private methods
+
+void *CPUThreadPool::workerMain(void *arg) {
+    WorkerCtx *workerCtx = (WorkerCtx *)arg;
+    CPUThreadPool *pool = workerCtx->pool;
+    unsigned long lastJobNum = 0;
+    
+    for (;;) {
+        // wait for the next job
+        pthread_mutex_lock(&pool->mutex);
+        
+        while (pool->jobNum == lastJobNum && !pool->stopping) {
+            pthread_cond_wait(&pool->jobCond, &pool->mutex);
+        }
+        
+        if (pool->stopping) {
+            pthread_mutex_unlock(&pool->mutex);
+            break;
+        }
+        
+        lastJobNum = pool->jobNum;
+        pthread_mutex_unlock(&pool->mutex);
+        
+        pool->runTasks(workerCtx->thread);
+        
+        // report the completion
+        pthread_mutex_lock(&pool->mutex);
+        
+        if (--pool->numBusyWorkers == 0) {
+            pthread_cond_signal(&pool->doneCond);
+        }
+        
+        pthread_mutex_unlock(&pool->mutex);
+    }
+    
+    return NULL;
+}
+
+void CPUThreadPool::runTasks(int thread) {
+    int task;
+    
+    while (getTask(thread, task)) {
+        jobFunc(jobCtx, task, thread);
+    }
+}
+
+bool CPUThreadPool::getTask(int thread, int &task) {
+    // next task of the own range
+    TaskQueue &own = queues[thread];
+    pthread_mutex_lock(&own.mutex);
+    bool found = own.begin < own.end;
+    
+    if (found) {
+        task = own.begin++;
+    }
+    
+    pthread_mutex_unlock(&own.mutex);
+    
+    if (found) return true;
+    
+    // steal the upper half of the remaining range of the next thread that has tasks
+    int numThreads = getNumThreads();
+    
+    for (int i = 1; i < numThreads; i++) {
+        TaskQueue &victim = queues[(thread + i) % numThreads];
+        int stolenBegin = 0;
+        int stolenEnd = 0;
+        
+        pthread_mutex_lock(&victim.mutex);
+        
+        if (victim.begin < victim.end) {
+            stolenEnd = victim.end;
+            stolenBegin = victim.end - (victim.end - victim.begin + 1) / 2;
+            victim.end = stolenBegin;
+        }
+        
+        pthread_mutex_unlock(&victim.mutex);
+        
+        if (stolenBegin < stolenEnd) {
+            // execute the first stolen task now, the others later
+            task = stolenBegin;
+            
+            pthread_mutex_lock(&own.mutex);
+            own.begin = stolenBegin + 1;
+            own.end = stolenEnd;
+            pthread_mutex_unlock(&own.mutex);
+            
+            return true;
+        }
+    }
+    
+    return false;
+}
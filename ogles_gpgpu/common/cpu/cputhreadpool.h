@@ -0,0 +1,135 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Work-stealing thread pool of the CPU backend.
+ */
+#ifndef OGLES_GPGPU_COMMON_CPU_CPUTHREADPOOL
+#define OGLES_GPGPU_COMMON_CPU_CPUTHREADPOOL
+
+#include <pthread.h>
+#include <vector>
+
+using namespace std;
+
+namespace ogles_gpgpu {
+
+/**
+ * Task function for CPUThreadPool::run(): executes task number <task> with the
+ * context <ctx> in thread number <thread> (0 is the calling thread).
+ */
+typedef void (*CPUTaskFunc)(void *ctx, int task, int thread);
+
+/**
+ * Thread pool that executes numbered tasks in parallel. Each thread gets a
+ * contiguous range of the tasks, so that neighboring tasks (e.g. neighboring row
+ * bands of a frame) are executed by the same thread. A thread that has completed its
+ * range steals the upper half of the remaining range of another thread, so that the
+ * threads stay busy when the tasks take different times.
+ * The calling thread executes tasks, too, so a pool with one thread has no worker
+ * threads and executes all tasks in the calling thread.
+ */
+class CPUThreadPool {
+public:
+    /**
+     * Constructor. The pool has one thread (the calling thread) until start() is called.
+     */
+    CPUThreadPool();
+    
+    /**
+     * Destructor. Stops the worker threads.
+     */
+    ~CPUThreadPool();
+    
+    /**
+     * Start the pool with <numThreads> threads including the calling thread
+     * (0 for one thread per CPU core). Stops previously started worker threads.
+     */
+    void start(int numThreads);
+    
+    /**
+     * Stop the worker threads.
+     */
+    void stop();
+    
+    /**
+     * Get the number of threads including the calling thread.
+     */
+    int getNumThreads() const { return (int)queues.size(); }
+    
+    /**
+     * Execute tasks 0 .. <numTasks> - 1 with function <func> and context <ctx> in all
+     * threads and return when all tasks have been executed. Must not be called from
+     * a task.
+     */
+    void run(CPUTaskFunc func, void *ctx, int numTasks);
+    
+    /**
+     * Return the number of CPU cores that are online.
+     */
+    static int getNumCPUCores();
+
+private:
+    /**
+     * Range of tasks of one thread.
+     */
+    typedef struct {
+        pthread_mutex_t mutex;  // protects <begin> and <end>
+        int begin;              // next task
+        int end;                // task after the last task
+        char padding[64];       // keep the ranges of different threads in different cache lines
+    } TaskQueue;
+    
+    /**
+     * Context of a worker thread.
+     */
+    typedef struct {
+        CPUThreadPool *pool;
+        int thread;             // thread number
+    } WorkerCtx;
+    
+    /**
+     * Copying is not possible.
+     */
+    CPUThreadPool(const CPUThreadPool &) {}
+    
+    /**
+     * Entry function of the worker threads with context <arg> (a WorkerCtx).
+     */
+    static void *workerMain(void *arg);
+    
+    /**
+     * Execute tasks in thread <thread> until no thread has tasks left.
+     */
+    void runTasks(int thread);
+    
+    /**
+     * Get the next task <task> for thread <thread>: the next one of its own range or
+     * one stolen from another thread. Returns false if there are no tasks left.
+     */
+    bool getTask(int thread, int &task);
+    
+    vector<TaskQueue> queues;       // task range of each thread
+    vector<pthread_t> workers;      // worker threads (threads 1 .. n - 1)
+    vector<WorkerCtx> workerCtxs;   // contexts of the worker threads
+    
+    pthread_mutex_t mutex;          // protects the job state below
+    pthread_cond_t jobCond;         // signals a new job or stopping to the workers
+    pthread_cond_t doneCond;        // signals the completion of all workers
+    unsigned long jobNum;           // number of the current job
+    int numBusyWorkers;             // number of workers that have not completed the current job
+    bool stopping;                  // workers should exit
+    
+    CPUTaskFunc jobFunc;            // task function of the current job
+    void *jobCtx;                   // task context of the current job
+};
+
+}
+
+#endif
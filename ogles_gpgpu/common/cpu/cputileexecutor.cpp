@@ -0,0 +1,192 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "cputileexecutor.h"
+
+#include "cpukernels.h"
+#include "../proc/base/procinterface.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unistd.h>
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+#pragma mark constructor / deconstructor
+
+CPUTileExecutor::CPUTileExecutor() : frameW(0),
+                                     frameH(0),
+                                     bandRows(0),
+                                     numBands(0),
+                                     curInput(NULL),
+                                     curOutputs(NULL),
+                                     curInputData(NULL),
+                                     curInputFmt(GL_NONE),
+                                     curInputRowStride(0),
+                                     curInputDst(NULL)
+{
+}
+
+#pragma mark public methods
+
+void CPUTileExecutor::prepare(const vector<CPUTileStage> &tileStages, int w, int h, int numThreads, int cacheSize) {
+    stages = tileStages;
+    frameW = w;
+    frameH = h;
+    
+    // a stage computes the rows that the stages that read its output need, which
+    // is their band plus their filter radius
+    int numStages = (int)stages.size();
+    halos.assign(numStages, 0);
+    
+    for (int s = numStages - 1; s >= 0; s--) {
+        int rx, ry;
+        stages[s].proc->getFilterRadius(rx, ry);
+        
+        for (size_t i = 0; i < stages[s].inputs.size(); i++) {
+            int src = stages[s].inputs[i];
+            if (src >= 0) halos[src] = max(halos[src], halos[s] + ry);
+        }
+    }
+    
+    // number of band images per thread. kept outputs without halo are written to
+    // their output frames directly
+    int maxHalo = 0;
+    int numBandImages = 0;
+    
+    for (int s = 0; s < numStages; s++) {
+        maxHalo = max(maxHalo, halos[s]);
+        if (!stages[s].keepOutput || halos[s] > 0) numBandImages++;
+    }
+    
+    if (pool.getNumThreads() != (numThreads > 0 ? numThreads : CPUThreadPool::getNumCPUCores())) {
+        pool.start(numThreads);
+    }
+    
+    // the band images and the rows of the input frame should fit into the cache
+    if (cacheSize <= 0) {
+        cacheSize = getCPUCacheSize();
+    }
+    
+    bandRows = cacheSize / (w * 4 * (numBandImages + 1));
+    bandRows = max(bandRows, max(OGLES_GPGPU_CPU_TILE_MIN_ROWS, OGLES_GPGPU_CPU_TILE_MIN_ROWS_PER_HALO * maxHalo));
+    
+    // at least one band per thread
+    int threads = pool.getNumThreads();
+    bandRows = min(bandRows, (h + threads - 1) / threads);
+    bandRows = max(1, min(bandRows, h));
+    numBands = (h + bandRows - 1) / bandRows;
+    
+    // allocate the band images for the largest bands
+    bandImages.assign(threads, vector<CPUImage>(numStages));
+    
+    for (int t = 0; t < threads; t++) {
+        for (int s = 0; s < numStages; s++) {
+            if (!stages[s].keepOutput || halos[s] > 0) {
+                bandImages[t][s].resizeRows(w, h, 0, min(h, bandRows + 2 * halos[s]));
+            }
+        }
+    }
+    
+    OG_LOGINF("CPUTileExecutor", "%d stages, frame size %dx%d, %d threads, %d bands of %d rows, max. halo %d rows",
+              numStages, w, h, threads, numBands, bandRows, maxHalo);
+}
+
+void CPUTileExecutor::cleanup() {
+    pool.stop();
+    bandImages.clear();
+    stages.clear();
+    halos.clear();
+}
+
+void CPUTileExecutor::convInputData(const unsigned char *data, GLenum fmt, int rowStride, CPUImage &dst) {
+    assert(dst.getWidth() == frameW && dst.getHeight() == frameH);
+    
+    curInputData = data;
+    curInputFmt = fmt;
+    curInputRowStride = rowStride;
+    curInputDst = &dst;
+    
+    pool.run(convInputBandTask, this, numBands);
+}
+
+void CPUTileExecutor::process(const CPUImage &input, const vector<CPUImage *> &outputs) {
+    assert(input.getWidth() == frameW && input.getHeight() == frameH);
+    assert(outputs.size() == stages.size());
+    
+    curInput = &input;
+    curOutputs = &outputs;
+    
+    pool.run(processBandTask, this, numBands);
+}
+
+int CPUTileExecutor::getCPUCacheSize() {
+    long size = 0;
+    
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+    
+    return size > 0 ? (int)size : OGLES_GPGPU_CPU_TILE_DEFAULT_CACHE_SIZE;
+}
+
+#pragma mark private methods
+
+void CPUTileExecutor::processBandTask(void *ctx, int band, int thread) {
+    ((CPUTileExecutor *)ctx)->processBand(band, thread);
+}
+
+void CPUTileExecutor::convInputBandTask(void *ctx, int band, int thread) {
+    CPUTileExecutor *exec = (CPUTileExecutor *)ctx;
+    int y0 = band * exec->bandRows;
+    int y1 = min(exec->frameH, y0 + exec->bandRows);
+    
+    CPUImage dstRows;
+    dstRows.setRowsView(*exec->curInputDst, y0, y1 - y0);
+    CPUKernels::convInputData(exec->curInputData, exec->curInputFmt, exec->curInputRowStride, dstRows);
+}
+
+void CPUTileExecutor::processBand(int band, int thread) {
+    int y0 = band * bandRows;
+    int y1 = min(frameH, y0 + bandRows);
+    
+    vector<CPUImage> &images = bandImages[thread];
+    vector<const CPUImage *> inputs;
+    
+    for (size_t s = 0; s < stages.size(); s++) {
+        const CPUTileStage &stage = stages[s];
+        CPUImage *output = (*curOutputs)[s];
+        CPUImage &img = images[s];
+        
+        // the band and the halo rows, or the band of the output frame
+        if (output && halos[s] == 0) {
+            img.setRowsView(*output, y0, y1 - y0);
+        } else {
+            int first = max(0, y0 - halos[s]);
+            int last = min(frameH, y1 + halos[s]);
+            img.resizeRows(frameW, frameH, first, last - first);
+        }
+        
+        // the input stages have computed the rows that this stage reads
+        inputs.clear();
+        for (size_t i = 0; i < stage.inputs.size(); i++) {
+            inputs.push_back(stage.inputs[i] < 0 ? curInput : &images[stage.inputs[i]]);
+        }
+        
+        stage.proc->processCPU(inputs, img);
+        
+        // the halo rows belong to the neighboring bands
+        if (output && halos[s] > 0) {
+            for (int y = y0; y < y1; y++) {
+                memcpy(output->getRow(y), img.getRow(y), frameW * 4);
+            }
+        }
+    }
+}
@@ -0,0 +1,157 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Multithreaded execution of a pipeline in row bands for the CPU backend.
+ */
+#ifndef OGLES_GPGPU_COMMON_CPU_CPUTILEEXECUTOR
+#define OGLES_GPGPU_COMMON_CPU_CPUTILEEXECUTOR
+
+#include "../common_includes.h"
+
+#include "cpuimage.h"
+#include "cputhreadpool.h"
+
+#define OGLES_GPGPU_CPU_TILE_DEFAULT_CACHE_SIZE     (1024 * 1024)   // L2 cache size per core if it can not be queried
+#define OGLES_GPGPU_CPU_TILE_MIN_ROWS               8               // minimum number of rows of a band
+#define OGLES_GPGPU_CPU_TILE_MIN_ROWS_PER_HALO      8               // minimum ratio of band rows to halo rows
+
+namespace ogles_gpgpu {
+
+class ProcInterface;
+
+/**
+ * Stage of a pipeline that is executed in row bands: one pass of a processor.
+ */
+typedef struct {
+    ProcInterface *proc;    // single pass processor (see ProcInterface::getCPUPasses()). weak ref
+    vector<int> inputs;     // index of the stage of each input (-1 for the pipeline input)
+    bool keepOutput;        // the whole output frame is needed (e.g. to read it with Core::getOutputData())
+} CPUTileStage;
+
+/**
+ * Executes a pipeline whose stages all have the size of the input frame and do not
+ * change the orientation (so that each output row only depends on input rows near
+ * it) in horizontal row bands of the frame. All stages are executed for one band
+ * before the next band, so that the intermediate outputs of a band stay in the cache
+ * of a CPU core instead of streaming whole frames between the stages. The bands are
+ * executed in parallel by a CPUThreadPool.
+ * A stage with a neighborhood filter needs some rows above and below the band from its
+ * input stages. Therefore the stages before it compute these "halo" rows, too, which
+ * are also computed for the neighboring bands. Only the stages whose output is kept
+ * write to whole output frames, the others write to band images of each thread.
+ */
+class CPUTileExecutor {
+public:
+    /**
+     * Constructor.
+     */
+    CPUTileExecutor();
+    
+    /**
+     * Prepare the execution of the stages <stages> (in execution order) for frames of
+     * size <w>x<h> with <numThreads> threads (0 for one thread per CPU core). The band
+     * height is chosen so that the band images of all stages fit into <cacheSize>
+     * bytes (0 for getCPUCacheSize()), but a band has at least OGLES_GPGPU_CPU_TILE_MIN_ROWS
+     * rows and OGLES_GPGPU_CPU_TILE_MIN_ROWS_PER_HALO times the largest halo (so that the
+     * halo rows are not computed too often) and there are at least as many bands as
+     * threads if possible.
+     */
+    void prepare(const vector<CPUTileStage> &stages, int w, int h, int numThreads, int cacheSize);
+    
+    /**
+     * Stop the threads and free the band images.
+     */
+    void cleanup();
+    
+    /**
+     * Convert input data <data> in pixel format <fmt> with <rowStride> bytes between
+     * the rows to the whole frame <dst> in parallel (see CPUKernels::convInputData()).
+     */
+    void convInputData(const unsigned char *data, GLenum fmt, int rowStride, CPUImage &dst);
+    
+    /**
+     * Execute all stages for the whole frame <input>. <outputs> contains the output
+     * frame of each stage whose output is kept (NULL for the other stages), which must
+     * have the output frame size.
+     */
+    void process(const CPUImage &input, const vector<CPUImage *> &outputs);
+    
+    /**
+     * Return the L2 cache size per CPU core in bytes if it can be queried, otherwise
+     * OGLES_GPGPU_CPU_TILE_DEFAULT_CACHE_SIZE.
+     */
+    static int getCPUCacheSize();
+    
+    /**
+     * Get the number of threads.
+     */
+    int getNumThreads() const { return pool.getNumThreads(); }
+    
+    /**
+     * Get the number of rows of a band (except the last one).
+     */
+    int getBandRows() const { return bandRows; }
+    
+    /**
+     * Get the number of bands of a frame.
+     */
+    int getNumBands() const { return numBands; }
+    
+    /**
+     * Get the number of rows above and below a band that stage <s> computes.
+     */
+    int getHaloRows(int s) const { return halos[s]; }
+
+private:
+    /**
+     * Copying is not possible.
+     */
+    CPUTileExecutor(const CPUTileExecutor &) {}
+    
+    /**
+     * Task function of the thread pool for process(): execute all stages for band
+     * <band> in thread <thread> with context <ctx> (the executor).
+     */
+    static void processBandTask(void *ctx, int band, int thread);
+    
+    /**
+     * Task function of the thread pool for convInputData(): convert the rows of band
+     * <band> in thread <thread> with context <ctx> (the executor).
+     */
+    static void convInputBandTask(void *ctx, int band, int thread);
+    
+    /**
+     * Execute all stages for band <band> with the band images of thread <thread>.
+     */
+    void processBand(int band, int thread);
+    
+    CPUThreadPool pool;             // threads that execute the bands
+    
+    vector<CPUTileStage> stages;    // stages in execution order
+    vector<int> halos;              // number of rows above and below the band that each stage computes
+    int frameW;                     // frame width
+    int frameH;                     // frame height
+    int bandRows;                   // number of rows of a band
+    int numBands;                   // number of bands of a frame
+    
+    vector<vector<CPUImage> > bandImages;   // output band image (or view of the output frame) of each stage per thread
+    
+    // parameters of the current process() or convInputData() call
+    const CPUImage *curInput;
+    const vector<CPUImage *> *curOutputs;
+    const unsigned char *curInputData;
+    GLenum curInputFmt;
+    int curInputRowStride;
+    CPUImage *curInputDst;
+};
+
+}
+
+#endif
@@ -12,29 +12,61 @@
 using namespace std;
 using namespace ogles_gpgpu;
 
-FBO::FBO() {
+FBO::FBO(int numSlots, void *glContext) {
+    assert(numSlots > 0);
+    
     // set defaults
 	id = 0;
 	texW = texH = 0;
     attachedTexId = 0;
     glTexUnit = 0;
+    curSlot = 0;
+    texPool = NULL;
+    texPoolFirstStep = texPoolLastStep = 0;
+    
+    // create a dedicated MemTransfer object for each frame slot of this FBO
+    for (int i = 0; i < numSlots; i++) {
+        MemTransfer *mt = MemTransferFactory::createInstance(glContext);
+        mt->init();
+        
+        slotMemTransfers.push_back(mt);
+    }
     
-    // get singleton Core instance
-    core = Core::getInstance();
-    
-    // create a dedicated MemTransfer object for this FBO
-    memTransfer = MemTransferFactory::createInstance();
-    memTransfer->init();
+    slotAttachedTexIds.resize(numSlots, 0);
     
-    // generate a FBO id
+    // generate FBO ids
     generateIds();
+    
+    selectSlot(0);
 }
 
 FBO::~FBO() {
     destroyFramebuffer();
     
-    // attached texture will be destroyed together with memTransfer instance
-    delete memTransfer;
+    // attached textures will be destroyed together with the memTransfer instances
+    for (vector<MemTransfer *>::iterator it = slotMemTransfers.begin();
+         it != slotMemTransfers.end();
+         ++it)
+    {
+        delete *it;
+    }
+    
+    slotMemTransfers.clear();
+}
+
+void FBO::selectSlot(int slot) {
+    assert(slot >= 0 && slot < (int)slotIds.size());
+    
+    curSlot = slot;
+    id = slotIds[slot];
+    attachedTexId = slotAttachedTexIds[slot];
+    memTransfer = slotMemTransfers[slot];
+}
+
+void FBO::setTexPool(TexPool *pool, int firstStep, int lastStep) {
+    texPool = pool;
+    texPoolFirstStep = firstStep;
+    texPoolLastStep = lastStep;
 }
 
 void FBO::bind() {
@@ -46,23 +78,34 @@ void FBO::unbind() {
 }
 
 void FBO::destroyFramebuffer() {
-    OG_LOGINF("FBO", "freeing FBO with ID %d", id);
+    if (slotIds.empty()) return;
+    
+    OG_LOGINF("FBO", "freeing %d FBO(s) starting with ID %d", (int)slotIds.size(), slotIds[0]);
+    
+	glDeleteFramebuffers((GLsizei)slotIds.size(), &slotIds[0]);
+    
+    for (size_t i = 0; i < slotIds.size(); i++) {
+        slotIds[i] = 0;
+    }
     
-	glDeleteFramebuffers(1, &id);
+    id = 0;
 }
 
 void FBO::destroyAttachedTex() {
-    assert(memTransfer);
+    // will release attached textures
+    for (size_t i = 0; i < slotMemTransfers.size(); i++) {
+        slotMemTransfers[i]->releaseOutput();
+        slotAttachedTexIds[i] = 0;
+    }
     
-    // will release attached texture
-    memTransfer->releaseOutput();
+    attachedTexId = 0;
 }
 
 void FBO::createAttachedTex(int w, int h, bool genMipmap, GLenum attachment) {
 	assert(memTransfer && w > 0 && h > 0);
     
     // get a corrected width and height when we use a mipmap
-    if (genMipmap && core->getUseMipmaps()) {
+    if (genMipmap) {
         w = Tools::getBiggerPOTValue(w);
         h = Tools::getBiggerPOTValue(h);
     }
@@ -70,12 +113,38 @@ void FBO::createAttachedTex(int w, int h, bool genMipmap, GLenum attachment) {
     texW = w;
 	texH = h;
     
+    // a pooled texture is shared by all frame slots
+    GLuint pooledTexId = 0;
+    
+    if (texPool) {
+        glActiveTexture(GL_TEXTURE0 + glTexUnit);
+        pooledTexId = texPool->acquire(texW, texH, genMipmap, texPoolFirstStep, texPoolLastStep);
+    }
+    
+    // create the attached texture for each frame slot
+    int prevSlot = curSlot;
+    
+    for (int slot = 0; slot < getNumSlots(); slot++) {
+        selectSlot(slot);
+        createAttachedTexForSlot(genMipmap, attachment, pooledTexId);
+    }
+    
+    selectSlot(prevSlot);
+}
+
+void FBO::createAttachedTexForSlot(bool genMipmap, GLenum attachment, GLuint pooledTexId) {
     // bind FBO
     bind();
     
-    // create attached texture
+    // create attached texture or use the pooled texture
     glActiveTexture(GL_TEXTURE0 + glTexUnit);
-    attachedTexId = memTransfer->prepareOutput(texW, texH);
+    
+    if (pooledTexId > 0) {
+        attachedTexId = pooledTexId;
+        glBindTexture(GL_TEXTURE_2D, attachedTexId);
+    } else {
+        attachedTexId = memTransfer->prepareOutput(texW, texH);
+    }
     
 	// set further texture parameters
 	if (genMipmap) {
@@ -101,15 +170,17 @@ void FBO::createAttachedTex(int w, int h, bool genMipmap, GLenum attachment) {
         attachedTexId = 0;
 	} else {
         OG_LOGINF("FBO", "FBO with ID %d: created attached texture %d of size %dx%d (mipmap: %d)",
-                  id, attachedTexId, w, h, genMipmap);
+                  id, attachedTexId, texW, texH, genMipmap);
     }
     
+    slotAttachedTexIds[curSlot] = attachedTexId;
+    
     // unbind FBO
 	unbind();
 }
 
 void FBO::readBuffer(unsigned char *buf) {
-	assert(memTransfer && attachedTexId > 0 && texW > 0 && texH > 0);
+	assert(memTransfer && attachedTexId > 0 && texW > 0 && texH > 0 && !texPool);
     
     // bind the FBO
 	bind();
@@ -121,6 +192,20 @@ void FBO::readBuffer(unsigned char *buf) {
 	unbind();
 }
 
+void FBO::startReadback(unsigned long tag) {
+	assert(memTransfer && attachedTexId > 0 && texW > 0 && texH > 0 && !texPool);
+    
+    // bind the FBO
+	bind();
+    
+    // start copying the contents of its attached texture
+    memTransfer->startReadback(tag);
+    
+    // unbind again
+	unbind();
+}
+
 void FBO::generateIds() {
-    glGenFramebuffers(1, &id);
+    slotIds.resize(slotMemTransfers.size(), 0);
+    glGenFramebuffers((GLsizei)slotIds.size(), &slotIds[0]);
 }
\ No newline at end of file
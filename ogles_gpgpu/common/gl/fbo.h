@@ -14,23 +14,33 @@
 #define OGLES_GPGPU_COMMON_GL_FBO
 
 #include "../common_includes.h"
-#include "../core.h"
 #include "memtransfer_factory.h"
+#include "texpool.h"
 
-namespace ogles_gpgpu {
+#include <vector>
+
+using namespace std;
 
-class Core;
+namespace ogles_gpgpu {
 
 /**
  * Framebuffer object handler. Set up an OpenGL framebuffer with an attached texture
  * for the framebuffer output.
+ * An FBO can hold several frame slots for a frame ring (see Core::setFrameRingDepth()).
+ * Each slot has its own framebuffer, attached texture and MemTransfer object (and
+ * hence its own input texture). The methods of this class refer to the currently
+ * selected slot, except where noted otherwise.
+ * Alternatively, the attached texture can be taken from a texture pool (see
+ * setTexPool()). Such a texture is shared by all frame slots and can not be read back.
  */
 class FBO {
 public:
     /**
-     * Constructor.
+     * Constructor. Create an FBO with <numSlots> frame slots. <glContext> is the
+     * OpenGL context pointer (platform specific type), which is passed to the
+     * MemTransfer objects (see MemTransferFactory::createInstance()).
      */
-    FBO();
+    FBO(int numSlots = 1, void *glContext = NULL);
     
     /**
      * Deconstructor.
@@ -55,13 +65,28 @@ public:
     /**
      * Set the FBO id manually (usually not necessary).
      */
-	void setId(GLuint fboId) { id = fboId; }
+	void setId(GLuint fboId) { id = fboId; slotIds[curSlot] = fboId; }
     
     /**
      * Return the FBO id.
      */
 	GLuint getId() const { return id; }
     
+    /**
+     * Return the number of frame slots.
+     */
+    int getNumSlots() const { return (int)slotIds.size(); }
+    
+    /**
+     * Select frame slot <slot>. Following calls refer to this slot.
+     */
+    void selectSlot(int slot);
+    
+    /**
+     * Return the currently selected frame slot.
+     */
+    int getSelectedSlot() const { return curSlot; }
+    
     /**
      * Bind FBO.
      */
@@ -72,9 +97,22 @@ public:
      */
     void unbind();
     
+    /**
+     * Take the attached texture from texture pool <pool> (weak ref.) in the following
+     * createAttachedTex() calls. The output is written in step <firstStep> and read until
+     * step <lastStep> (see TexPool). Set <pool> to NULL to create own textures.
+     */
+    void setTexPool(TexPool *pool, int firstStep = 0, int lastStep = 0);
+    
+    /**
+     * Returns true if the attached texture is taken from a texture pool.
+     */
+    bool getUsesTexPool() const { return texPool != NULL; }
+    
     /**
      * Will create a framebuffer output texture with texture id <attachedTexId>
-     * and will bind it to this FBO.
+     * and will bind it to this FBO. This is done for all frame slots. If a texture
+     * pool is set, the texture is taken from the pool.
      */
     virtual void createAttachedTex(int w, int h, bool genMipmap = false, GLenum attachment = GL_COLOR_ATTACHMENT0);
     
@@ -85,12 +123,18 @@ public:
 	virtual void readBuffer(unsigned char *buf);
     
     /**
-     * Free the framebuffer.
+     * Start an asynchronous readback of the framebuffer data, tagged with <tag>
+     * (see MemTransfer::startReadback()). A later readBuffer() call returns the data.
+     */
+    virtual void startReadback(unsigned long tag);
+    
+    /**
+     * Free the framebuffers of all frame slots.
      */
     virtual void destroyFramebuffer();
     
     /**
-     * Free the attached texture for framebuffer output.
+     * Free the attached textures for framebuffer output of all frame slots.
      */
     virtual void destroyAttachedTex();
     
@@ -111,18 +155,31 @@ public:
     
 protected:
     /**
-     * Generate an FBO id.
+     * Generate FBO ids for all frame slots.
      */
     virtual void generateIds();
     
+    /**
+     * Create the attached texture for the currently selected frame slot or use the
+     * texture <pooledTexId> if it is not 0.
+     */
+    virtual void createAttachedTexForSlot(bool genMipmap, GLenum attachment, GLuint pooledTexId = 0);
     
-    Core *core;                 // Core singleton
     
-    MemTransfer *memTransfer;   // MemTransfer object associated with this FBO
+    MemTransfer *memTransfer;   // MemTransfer object associated with this FBO (current slot)
     
-	GLuint id;                  // OpenGL FBO id
+	GLuint id;                  // OpenGL FBO id (current slot)
     GLuint glTexUnit;           // GL texture unit (to be used in glActiveTexture()) for output texture
-	GLuint attachedTexId;       // output texture id
+	GLuint attachedTexId;       // output texture id (current slot)
+    
+    int curSlot;                            // currently selected frame slot
+    vector<GLuint> slotIds;                 // OpenGL FBO id per frame slot
+    vector<GLuint> slotAttachedTexIds;      // output texture id per frame slot
+    vector<MemTransfer *> slotMemTransfers; // MemTransfer object per frame slot. strong refs.
+    
+    TexPool *texPool;       // texture pool for the attached texture. weak ref. may be NULL
+    int texPoolFirstStep;   // step in which the output is written (see TexPool)
+    int texPoolLastStep;    // last step in which the output is read (see TexPool)
     
 	int texW;   // output texture width
 	int texH;   // output texture height
@@ -0,0 +1,221 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "fence.h"
+
+#if defined(__ANDROID__) || defined(__linux__)
+#define OGLES_GPGPU_FENCE_USE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#if defined(__APPLE__) && defined(GL_APPLE_sync)
+#define OGLES_GPGPU_FENCE_USE_APPLE
+#endif
+
+#include <string>
+#include <mutex>
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+#ifdef OGLES_GPGPU_FENCE_USE_EGL
+// function pointers to EGL_KHR_fence_sync functions
+static PFNEGLCREATESYNCKHRPROC eglExtCreateSync = NULL;
+static PFNEGLDESTROYSYNCKHRPROC eglExtDestroySync = NULL;
+static PFNEGLCLIENTWAITSYNCKHRPROC eglExtClientWaitSync = NULL;
+
+// the function pointers are the same for all contexts, so they are loaded only once
+static once_flag eglSyncFuncsLoaded;
+
+static void loadEGLSyncFuncs() {
+    eglExtCreateSync = (PFNEGLCREATESYNCKHRPROC)eglGetProcAddress("eglCreateSyncKHR");
+    eglExtDestroySync = (PFNEGLDESTROYSYNCKHRPROC)eglGetProcAddress("eglDestroySyncKHR");
+    eglExtClientWaitSync = (PFNEGLCLIENTWAITSYNCKHRPROC)eglGetProcAddress("eglClientWaitSyncKHR");
+}
+#endif
+
+#pragma mark static methods
+
+FenceType Fence::initFenceSupport(bool glES3, bool glExtAppleSync) {
+    FenceType fenceType = FENCE_TYPE_NONE;
+
+#ifdef OGLES_GPGPU_OPENGL_ES3
+    if (glES3) {
+        fenceType = FENCE_TYPE_GLES3;
+    }
+#endif
+
+#ifdef OGLES_GPGPU_FENCE_USE_EGL
+    if (fenceType == FENCE_TYPE_NONE) {
+        EGLDisplay disp = eglGetCurrentDisplay();
+        const char *eglExtStr = disp != EGL_NO_DISPLAY ? eglQueryString(disp, EGL_EXTENSIONS) : NULL;
+        
+        if (eglExtStr && string(eglExtStr).find("EGL_KHR_fence_sync") != string::npos) {
+            call_once(eglSyncFuncsLoaded, loadEGLSyncFuncs);
+            
+            if (eglExtCreateSync && eglExtDestroySync && eglExtClientWaitSync) {
+                fenceType = FENCE_TYPE_EGL_KHR;
+            }
+        }
+    }
+#endif
+
+#ifdef OGLES_GPGPU_FENCE_USE_APPLE
+    if (fenceType == FENCE_TYPE_NONE && glExtAppleSync) {
+        fenceType = FENCE_TYPE_APPLE;
+    }
+#endif
+    
+    OG_LOGINF("Fence", "using fence type %d", fenceType);
+    
+    return fenceType;
+}
+
+#pragma mark constructor/deconstructor
+
+Fence::Fence() {
+    fenceType = FENCE_TYPE_NONE;
+    syncObj = NULL;
+    syncDisp = NULL;
+    pending = false;
+}
+
+Fence::~Fence() {
+    release();
+}
+
+#pragma mark public methods
+
+void Fence::insert() {
+    release();
+    
+    switch (fenceType) {
+#ifdef OGLES_GPGPU_OPENGL_ES3
+        case FENCE_TYPE_GLES3:
+            syncObj = (void *)glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            break;
+#endif
+#ifdef OGLES_GPGPU_FENCE_USE_EGL
+        case FENCE_TYPE_EGL_KHR:
+            syncDisp = (void *)eglGetCurrentDisplay();
+            syncObj = (void *)eglExtCreateSync((EGLDisplay)syncDisp, EGL_SYNC_FENCE_KHR, NULL);
+            if ((EGLSyncKHR)syncObj == EGL_NO_SYNC_KHR) syncObj = NULL;
+            break;
+#endif
+#ifdef OGLES_GPGPU_FENCE_USE_APPLE
+        case FENCE_TYPE_APPLE:
+            syncObj = (void *)glFenceSyncAPPLE(GL_SYNC_GPU_COMMANDS_COMPLETE_APPLE, 0);
+            break;
+#endif
+        default:
+            break;
+    }
+    
+    if (fenceType != FENCE_TYPE_NONE && !syncObj) {
+        OG_LOGERR("Fence", "could not create sync object (fence type %d)", fenceType);
+    }
+    
+    // submit the command stream, so that the fence will eventually be signaled
+    glFlush();
+    
+    pending = true;
+}
+
+bool Fence::isSignaled() {
+    if (!pending) return true;
+    
+    if (!syncObj) {     // no sync objects available
+        glFinish();
+        pending = false;
+        return true;
+    }
+    
+    return wait(0);
+}
+
+bool Fence::wait(unsigned long long timeoutNs) {
+    if (!pending) return true;
+    
+    bool signaled = false;
+    
+    if (!syncObj) {
+        glFinish();
+        signaled = true;
+    } else {
+        switch (fenceType) {
+#ifdef OGLES_GPGPU_OPENGL_ES3
+            case FENCE_TYPE_GLES3: {
+                GLenum res = glClientWaitSync((GLsync)syncObj, GL_SYNC_FLUSH_COMMANDS_BIT, (GLuint64)timeoutNs);
+                signaled = (res == GL_ALREADY_SIGNALED || res == GL_CONDITION_SATISFIED);
+                if (res == GL_WAIT_FAILED) {
+                    OG_LOGERR("Fence", "glClientWaitSync failed");
+                }
+                break;
+            }
+#endif
+#ifdef OGLES_GPGPU_FENCE_USE_EGL
+            case FENCE_TYPE_EGL_KHR: {
+                EGLint res = eglExtClientWaitSync((EGLDisplay)syncDisp, (EGLSyncKHR)syncObj,
+                                                  EGL_SYNC_FLUSH_COMMANDS_BIT_KHR, (EGLTimeKHR)timeoutNs);
+                signaled = (res == EGL_CONDITION_SATISFIED_KHR);
+                if (res == EGL_FALSE) {
+                    OG_LOGERR("Fence", "eglClientWaitSyncKHR failed: %d", eglGetError());
+                }
+                break;
+            }
+#endif
+#ifdef OGLES_GPGPU_FENCE_USE_APPLE
+            case FENCE_TYPE_APPLE: {
+                GLenum res = glClientWaitSyncAPPLE((GLsync)syncObj, GL_SYNC_FLUSH_COMMANDS_BIT_APPLE, (GLuint64)timeoutNs);
+                signaled = (res == GL_ALREADY_SIGNALED_APPLE || res == GL_CONDITION_SATISFIED_APPLE);
+                break;
+            }
+#endif
+            default:
+                glFinish();
+                signaled = true;
+                break;
+        }
+    }
+    
+    if (signaled) {
+        pending = false;
+    }
+    
+    return signaled;
+}
+
+void Fence::release() {
+    if (syncObj) {
+        switch (fenceType) {
+#ifdef OGLES_GPGPU_OPENGL_ES3
+            case FENCE_TYPE_GLES3:
+                glDeleteSync((GLsync)syncObj);
+                break;
+#endif
+#ifdef OGLES_GPGPU_FENCE_USE_EGL
+            case FENCE_TYPE_EGL_KHR:
+                eglExtDestroySync((EGLDisplay)syncDisp, (EGLSyncKHR)syncObj);
+                break;
+#endif
+#ifdef OGLES_GPGPU_FENCE_USE_APPLE
+            case FENCE_TYPE_APPLE:
+                glDeleteSyncAPPLE((GLsync)syncObj);
+                break;
+#endif
+            default:
+                break;
+        }
+    }
+    
+    syncObj = NULL;
+    syncDisp = NULL;
+    pending = false;
+}
@@ -0,0 +1,118 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Fence sync object wrapper.
+ */
+#ifndef OGLES_GPGPU_COMMON_GL_FENCE
+#define OGLES_GPGPU_COMMON_GL_FENCE
+
+#include "../common_includes.h"
+
+namespace ogles_gpgpu {
+
+/**
+ * Define fence implementation types.
+ */
+typedef enum {
+    FENCE_TYPE_NONE = 0,    // no sync objects available. waiting falls back to glFinish()
+    FENCE_TYPE_GLES3,       // OpenGL ES 3.0 glFenceSync()
+    FENCE_TYPE_EGL_KHR,     // EGL_KHR_fence_sync extension
+    FENCE_TYPE_APPLE        // GL_APPLE_sync extension (iOS)
+} FenceType;
+
+/**
+ * Fence sync object wrapper. A fence is inserted into the OpenGL command stream
+ * and becomes signaled when the GPU has completed all commands before it. This
+ * allows to poll or wait for the completion of submitted work without a full
+ * glFinish() after each command.
+ * The available implementation is determined per OpenGL context with initFenceSupport()
+ * and set for each fence with setFenceType(). If no sync objects are available,
+ * waiting for a fence falls back to glFinish().
+ */
+class Fence {
+public:
+    /**
+     * Determine the fence implementation to use for the current OpenGL context.
+     * <glES3> and <glExtAppleSync> signal the availability of an OpenGL ES 3.0 context
+     * and the GL_APPLE_sync extension, respectively. EGL_KHR_fence_sync availability
+     * is checked here on EGL platforms.
+     * Returns the fence implementation type.
+     */
+    static FenceType initFenceSupport(bool glES3, bool glExtAppleSync);
+    
+    /**
+     * Constructor. The fence implementation type is FENCE_TYPE_NONE.
+     */
+    Fence();
+    
+    /**
+     * Deconstructor. Deletes the sync object.
+     */
+    ~Fence();
+    
+    /**
+     * Set the fence implementation type to <type> (see initFenceSupport()). Releases
+     * an inserted sync object.
+     */
+    void setFenceType(FenceType type) { release(); fenceType = type; }
+    
+    /**
+     * Return the fence implementation type.
+     */
+    FenceType getFenceType() const { return fenceType; }
+    
+    /**
+     * Insert the fence into the OpenGL command stream after all previously submitted
+     * commands and flush the command stream. A previously inserted sync object
+     * is replaced.
+     */
+    void insert();
+    
+    /**
+     * Poll the fence. Returns true if all commands before the fence were completed
+     * or if no fence was inserted. Does not block, except if no sync objects are
+     * available (then glFinish() is called).
+     */
+    bool isSignaled();
+    
+    /**
+     * Block until the fence is signaled or <timeoutNs> nanoseconds have passed.
+     * Returns true if the fence was signaled, false on timeout or error.
+     */
+    bool wait(unsigned long long timeoutNs = 0xFFFFFFFFFFFFFFFFull);
+    
+    /**
+     * Returns true if a sync object was inserted and has not been signaled yet
+     * (as far as known by this object).
+     */
+    bool getIsPending() const { return pending; }
+    
+    /**
+     * Delete the sync object.
+     */
+    void release();
+
+private:
+    /**
+     * Empty copy constructor. Fences can not be copied.
+     */
+    Fence(const Fence&) {}
+    
+    
+    FenceType fenceType;    // used fence implementation
+    
+    void *syncObj;      // platform specific sync object handle (GLsync, EGLSyncKHR or GLsync APPLE)
+    void *syncDisp;     // EGL display for EGL_KHR_fence_sync (weak ref)
+    bool pending;       // inserted and not signaled yet
+};
+
+}
+
+#endif
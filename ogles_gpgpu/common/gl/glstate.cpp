@@ -0,0 +1,263 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "glstate.h"
+
+using namespace ogles_gpgpu;
+
+#pragma mark constructor/deconstructor
+
+GLState::GLState() {
+    tracking = false;
+    quadBuffers = NULL;
+    numIssued = numElided = 0;
+    
+    invalidate();
+}
+
+#pragma mark public methods
+
+void GLState::setTracking(bool enabled) {
+    if (tracking && !enabled) {
+        reset();
+    }
+    
+    tracking = enabled;
+    invalidate();
+}
+
+void GLState::invalidate() {
+    program = fbo = activeUnit = vertexArray = arrayBuffer = -1;
+    
+    for (int i = 0; i < OGLES_GPGPU_GLSTATE_MAX_TEX_UNITS; i++) {
+        boundTex[i][0] = boundTex[i][1] = -1;
+    }
+    
+    viewportParams[0] = viewportParams[1] = viewportParams[3] = 0;
+    viewportParams[2] = -1;
+    
+    scissorEnabled = -1;
+    scissorParams[0] = scissorParams[1] = scissorParams[3] = 0;
+    scissorParams[2] = -1;
+    
+    for (int i = 0; i < OGLES_GPGPU_GLSTATE_MAX_ATTRIBS; i++) {
+        attribEnabled[i] = -1;
+    }
+}
+
+void GLState::reset() {
+    if (!tracking) return;
+    
+    // only the calls that change the state are issued
+    bindFramebuffer(0);
+    disableScissor();
+    
+    if (vertexArray > 0) {
+        quadBuffers->bindVertexArray(0);
+        vertexArray = 0;
+        numIssued++;
+    }
+    
+    if (arrayBuffer > 0) {
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        arrayBuffer = 0;
+        numIssued++;
+    }
+    
+    for (GLuint i = 0; i < OGLES_GPGPU_GLSTATE_MAX_ATTRIBS; i++) {
+        if (attribEnabled[i] == 1) {
+            glDisableVertexAttribArray(i);
+            attribEnabled[i] = 0;
+            numIssued++;
+        }
+    }
+}
+
+void GLState::useProgram(GLuint programId) {
+    if (tracking && program == (GLint)programId) {
+        numElided++;
+        return;
+    }
+    
+    glUseProgram(programId);
+    program = programId;
+    numIssued++;
+}
+
+void GLState::bindFramebuffer(GLuint fboId) {
+    if (tracking && fbo == (GLint)fboId) {
+        numElided++;
+        return;
+    }
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, fboId);
+    fbo = fboId;
+    numIssued++;
+}
+
+void GLState::unbindFramebuffer() {
+    if (tracking) {     // deferred until the next bindFramebuffer() or reset() call
+        numElided++;
+        return;
+    }
+    
+    bindFramebuffer(0);
+}
+
+void GLState::viewport(GLint x, GLint y, GLsizei w, GLsizei h) {
+    if (tracking && viewportParams[0] == x && viewportParams[1] == y
+                 && viewportParams[2] == w && viewportParams[3] == h)
+    {
+        numElided++;
+        return;
+    }
+    
+    glViewport(x, y, w, h);
+    viewportParams[0] = x;
+    viewportParams[1] = y;
+    viewportParams[2] = w;
+    viewportParams[3] = h;
+    numIssued++;
+}
+
+void GLState::scissor(GLint x, GLint y, GLsizei w, GLsizei h) {
+    if (tracking && scissorEnabled == 1) {
+        numElided++;
+    } else {
+        glEnable(GL_SCISSOR_TEST);
+        scissorEnabled = 1;
+        numIssued++;
+    }
+    
+    if (tracking && scissorParams[0] == x && scissorParams[1] == y
+                 && scissorParams[2] == w && scissorParams[3] == h)
+    {
+        numElided++;
+        return;
+    }
+    
+    glScissor(x, y, w, h);
+    scissorParams[0] = x;
+    scissorParams[1] = y;
+    scissorParams[2] = w;
+    scissorParams[3] = h;
+    numIssued++;
+}
+
+void GLState::disableScissor() {
+    if (tracking && scissorEnabled == 0) {
+        numElided++;
+        return;
+    }
+    
+    glDisable(GL_SCISSOR_TEST);
+    scissorEnabled = 0;
+    numIssued++;
+}
+
+void GLState::releaseScissor() {
+    if (tracking) {     // deferred until the next disableScissor() or reset() call
+        numElided++;
+        return;
+    }
+    
+    disableScissor();
+}
+
+void GLState::activeTexture(GLuint unit) {
+    if (tracking && activeUnit == (GLint)unit) {
+        numElided++;
+        return;
+    }
+    
+    glActiveTexture(GL_TEXTURE0 + unit);
+    activeUnit = unit;
+    numIssued++;
+}
+
+void GLState::bindTexture(GLenum target, GLuint texId) {
+    // the texture of an unknown or untracked unit is always bound
+    bool known = activeUnit >= 0 && activeUnit < OGLES_GPGPU_GLSTATE_MAX_TEX_UNITS;
+    GLint *bound = known ? &boundTex[activeUnit][getTexTargetIdx(target)] : NULL;
+    
+    if (tracking && bound && *bound == (GLint)texId) {
+        numElided++;
+        return;
+    }
+    
+    glBindTexture(target, texId);
+    if (bound) *bound = texId;
+    numIssued++;
+}
+
+void GLState::enableVertexAttribArray(GLuint index) {
+    bool known = index < OGLES_GPGPU_GLSTATE_MAX_ATTRIBS;
+    
+    if (tracking && known && attribEnabled[index] == 1) {
+        numElided++;
+        return;
+    }
+    
+    glEnableVertexAttribArray(index);
+    if (known) attribEnabled[index] = 1;
+    numIssued++;
+}
+
+void GLState::disableVertexAttribArray(GLuint index) {
+    if (tracking && index < OGLES_GPGPU_GLSTATE_MAX_ATTRIBS) {   // deferred until reset()
+        numElided++;
+        return;
+    }
+    
+    glDisableVertexAttribArray(index);
+    if (index < OGLES_GPGPU_GLSTATE_MAX_ATTRIBS) attribEnabled[index] = 0;
+    numIssued++;
+}
+
+void GLState::bindVertexArray(GLuint vao) {
+    assert(quadBuffers && quadBuffers->getVertexArraySupport());
+    
+    if (tracking && vertexArray == (GLint)vao) {
+        numElided++;
+        return;
+    }
+    
+    quadBuffers->bindVertexArray(vao);
+    vertexArray = vao;
+    numIssued++;
+}
+
+void GLState::unbindVertexArray() {
+    if (tracking) {     // deferred until the next bindVertexArray() or reset() call
+        numElided++;
+        return;
+    }
+    
+    bindVertexArray(0);
+}
+
+void GLState::bindArrayBuffer(GLuint vbo) {
+    if (tracking && arrayBuffer == (GLint)vbo) {
+        numElided++;
+        return;
+    }
+    
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    arrayBuffer = vbo;
+    numIssued++;
+}
+
+void GLState::unbindArrayBuffer() {
+    if (tracking) {     // deferred until the next bindArrayBuffer() or reset() call
+        numElided++;
+        return;
+    }
+    
+    bindArrayBuffer(0);
+}
@@ -0,0 +1,205 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Shadow copy of the OpenGL state that is changed by the render passes.
+ */
+#ifndef OGLES_GPGPU_COMMON_GL_GLSTATE
+#define OGLES_GPGPU_COMMON_GL_GLSTATE
+
+#include "../common_includes.h"
+#include "quadbuffers.h"
+
+#define OGLES_GPGPU_GLSTATE_MAX_TEX_UNITS   8
+#define OGLES_GPGPU_GLSTATE_MAX_ATTRIBS     16
+
+namespace ogles_gpgpu {
+
+/**
+ * Shadow copy of the OpenGL state that the processors change in each render pass:
+ * the used shader program, the bound framebuffer, the active texture unit, the
+ * bound textures of each texture unit, the viewport, the scissor test, the enabled
+ * vertex attribute arrays and the bound vertex buffer and vertex array object. If
+ * tracking is enabled, calls that would not change the state are skipped (elided).
+ * Unbinding the framebuffer, the vertex buffer and the vertex array object and
+ * disabling the scissor test and vertex attribute arrays after a pass is deferred
+ * until reset(), because the next pass usually binds its own framebuffer and enables
+ * the same arrays again.
+ * The shadow copy is only valid as long as no other code changes the OpenGL state,
+ * so invalidate() must be called when other code might have changed it.
+ * If tracking is disabled (default), all calls are issued.
+ * The numbers of issued and elided calls are counted.
+ * The state object also gives the processors access to the shared quad buffers of
+ * the OpenGL context (see QuadBuffers).
+ */
+class GLState {
+public:
+    /**
+     * Constructor. Tracking is disabled.
+     */
+    GLState();
+    
+    /**
+     * Enable or disable tracking: <enabled>. Disabling it also resets the state (see
+     * reset()).
+     */
+    void setTracking(bool enabled);
+    
+    /**
+     * Return true if tracking is enabled.
+     */
+    bool getTracking() const { return tracking; }
+    
+    /**
+     * Set the shared quad buffers <buffers> of the OpenGL context (may be NULL).
+     */
+    void setQuadBuffers(QuadBuffers *buffers) { quadBuffers = buffers; }
+    
+    /**
+     * Return the shared quad buffers of the OpenGL context or NULL if the processors
+     * should use client-side vertex arrays.
+     */
+    QuadBuffers *getQuadBuffers() const { return quadBuffers; }
+    
+    /**
+     * Forget the shadow copy, so that the next call of each kind is issued.
+     */
+    void invalidate();
+    
+    /**
+     * Issue the deferred calls: unbind the framebuffer, the vertex array object and the
+     * vertex buffer and disable the scissor test and the vertex attribute arrays that
+     * were enabled with enableVertexAttribArray().
+     */
+    void reset();
+    
+    /**
+     * Use shader program <programId>.
+     */
+    void useProgram(GLuint programId);
+    
+    /**
+     * Bind framebuffer <fboId>.
+     */
+    void bindFramebuffer(GLuint fboId);
+    
+    /**
+     * Bind the default framebuffer (deferred if tracking is enabled).
+     */
+    void unbindFramebuffer();
+    
+    /**
+     * Set the viewport to position <x>, <y> and size <w>x<h>.
+     */
+    void viewport(GLint x, GLint y, GLsizei w, GLsizei h);
+    
+    /**
+     * Enable the scissor test with the scissor box at position <x>, <y> and of size
+     * <w>x<h>.
+     */
+    void scissor(GLint x, GLint y, GLsizei w, GLsizei h);
+    
+    /**
+     * Disable the scissor test.
+     */
+    void disableScissor();
+    
+    /**
+     * Disable the scissor test after a pass (deferred if tracking is enabled).
+     */
+    void releaseScissor();
+    
+    /**
+     * Make texture unit <unit> (as index, not as GL_TEXTUREi enum) the active unit.
+     */
+    void activeTexture(GLuint unit);
+    
+    /**
+     * Bind texture <texId> to texture target <target> of the active texture unit.
+     */
+    void bindTexture(GLenum target, GLuint texId);
+    
+    /**
+     * Enable the vertex attribute array <index>.
+     */
+    void enableVertexAttribArray(GLuint index);
+    
+    /**
+     * Disable the vertex attribute array <index> (deferred if tracking is enabled).
+     */
+    void disableVertexAttribArray(GLuint index);
+    
+    /**
+     * Bind vertex array object <vao> (needs quad buffers with vertex array object
+     * support).
+     */
+    void bindVertexArray(GLuint vao);
+    
+    /**
+     * Bind vertex array object 0 (deferred if tracking is enabled).
+     */
+    void unbindVertexArray();
+    
+    /**
+     * Bind vertex buffer <vbo> to GL_ARRAY_BUFFER.
+     */
+    void bindArrayBuffer(GLuint vbo);
+    
+    /**
+     * Bind buffer 0 to GL_ARRAY_BUFFER (deferred if tracking is enabled).
+     */
+    void unbindArrayBuffer();
+    
+    /**
+     * Return the number of issued calls since the last resetCounters() call.
+     */
+    int getNumIssued() const { return numIssued; }
+    
+    /**
+     * Return the number of elided (skipped or deferred) calls since the last
+     * resetCounters() call. The calls that reset() issues for deferred calls are
+     * counted as issued.
+     */
+    int getNumElided() const { return numElided; }
+    
+    /**
+     * Reset the issued and elided counters.
+     */
+    void resetCounters() { numIssued = numElided = 0; }
+
+private:
+    /**
+     * Return the index of texture target <target> in <boundTex>.
+     */
+    static int getTexTargetIdx(GLenum target) { return target == GL_TEXTURE_2D ? 0 : 1; }
+    
+    
+    bool tracking;          // skip calls that would not change the state?
+    
+    // shadow copy. -1 means unknown
+    GLint program;          // used shader program
+    GLint fbo;              // bound framebuffer
+    GLint activeUnit;       // active texture unit
+    GLint boundTex[OGLES_GPGPU_GLSTATE_MAX_TEX_UNITS][2];  // bound GL_TEXTURE_2D and other texture per unit
+    GLint viewportParams[4];        // viewport x, y, w, h. w = -1 means unknown
+    GLint scissorEnabled;           // scissor test enabled (1) or disabled (0)
+    GLint scissorParams[4];         // scissor box x, y, w, h. w = -1 means unknown
+    GLint attribEnabled[OGLES_GPGPU_GLSTATE_MAX_ATTRIBS];  // vertex attribute array enabled (1) or disabled (0)
+    GLint vertexArray;      // bound vertex array object
+    GLint arrayBuffer;      // bound GL_ARRAY_BUFFER
+    
+    QuadBuffers *quadBuffers;   // shared quad buffers. weak ref. may be NULL
+    
+    int numIssued;          // number of issued calls
+    int numElided;          // number of elided calls
+};
+
+}
+
+#endif
@@ -19,17 +19,35 @@ bool MemTransfer::initPlatformOptimizations() {
     return false;
 }
 
+int MemTransfer::getInputDataSize(GLenum fmt, int w, int h) {
+    int chromaSize = ((w + 1) / 2) * ((h + 1) / 2);
+    
+    switch (fmt) {
+        case INPUT_FORMAT_Y8:
+            return w * h;
+        case INPUT_FORMAT_NV12:
+        case INPUT_FORMAT_NV21:
+        case INPUT_FORMAT_I420:
+            return w * h + 2 * chromaSize;
+        default:
+            return w * h * 4;
+    }
+}
+
 #pragma mark constructor/deconstructor
 
 MemTransfer::MemTransfer() {
     // set defaults
     inputW = inputH = outputW = outputH = 0;
+    readX = readY = readW = readH = 0;
     inputTexId = 0;
+    inputChromaTexIds[0] = inputChromaTexIds[1] = 0;
     outputTexId = 0;
     initialized = false;
     preparedInput = false;
     preparedOutput = false;
     inputPixelFormat = GL_RGBA;
+    inputRowStride = 0;
 }
 
 MemTransfer::~MemTransfer() {
@@ -56,6 +74,10 @@ GLuint MemTransfer::prepareInput(int inTexW, int inTexH, GLenum inputPxFormat, v
     inputH = inTexH;
     inputPixelFormat = inputPxFormat;
     
+    if (Tools::isYUVFormat(inputPixelFormat)) {     // one texture per plane
+        return prepareInputPlanes();
+    }
+    
     // generate texture id
     glGenTextures(1, &inputTexId);
     
@@ -64,6 +86,15 @@ GLuint MemTransfer::prepareInput(int inTexW, int inTexH, GLenum inputPxFormat, v
         return 0;
     }
     
+    // will bind the texture, too:
+    setCommonTextureParams(inputTexId);
+    
+    // allocate the texture storage once. toGPU() will only update it with glTexSubImage2D(),
+    // so that the driver does not need to reallocate it for each frame
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, inputW, inputH, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    
+    Tools::checkGLErr("MemTransfer", "input texture creation");
+    
     // done
     preparedInput = true;
     
@@ -118,6 +149,13 @@ void MemTransfer::releaseInput() {
         glDeleteTextures(1, &inputTexId);
         inputTexId = 0;
     }
+    
+    for (int i = 0; i < 2; i++) {
+        if (inputChromaTexIds[i] > 0) {
+            glDeleteTextures(1, &inputChromaTexIds[i]);
+            inputChromaTexIds[i] = 0;
+        }
+    }
 }
 
 void MemTransfer::releaseOutput() {
@@ -125,29 +163,64 @@ void MemTransfer::releaseOutput() {
         glDeleteTextures(1, &outputTexId);
         outputTexId = 0;
     }
+    
+    // prepareOutput() creates a new texture even if the size does not change
+    outputW = outputH = 0;
+    readW = 0;
+    preparedOutput = false;
 }
 
 void MemTransfer::toGPU(const unsigned char *buf) {
     assert(preparedInput && inputTexId > 0 && buf);
     
+    if (Tools::isYUVFormat(inputPixelFormat)) {
+        planesToGPU(buf);
+        return;
+    }
+    
 	glBindTexture(GL_TEXTURE_2D, inputTexId);	// bind input texture
-
-    // copy data as texture to GPU
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, inputW, inputH, 0, GL_RGBA, GL_UNSIGNED_BYTE, buf);
+    
+    int rowLen = inputW * 4;
+    
+    // copy data to the texture on the GPU
+    if (getInputRowsArePacked()) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, inputW, inputH, GL_RGBA, GL_UNSIGNED_BYTE, buf);
+    } else if (inputRowStride == ((rowLen + 7) & ~7)) {
+        // rows are padded to 8 bytes: can be described by GL_UNPACK_ALIGNMENT
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 8);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, inputW, inputH, GL_RGBA, GL_UNSIGNED_BYTE, buf);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    } else {
+        // OpenGL ES 2.0 has no GL_UNPACK_ROW_LENGTH: copy row by row
+        for (int y = 0; y < inputH; y++) {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, inputW, 1, GL_RGBA, GL_UNSIGNED_BYTE, buf + y * inputRowStride);
+        }
+    }
     
     // check for error
-    Tools::checkGLErr("MemTransfer", "toGPU (glTexImage2D)");
+    Tools::checkGLErr("MemTransfer", "toGPU (glTexSubImage2D)");
     
     setCommonTextureParams(0);
 }
 
+void MemTransfer::setOutputReadRect(int x, int y, int w, int h) {
+    assert(w <= 0 || (x >= 0 && y >= 0 && h > 0));
+    
+    readX = x;
+    readY = y;
+    readW = w > 0 ? w : 0;
+    readH = h;
+}
+
 void MemTransfer::fromGPU(unsigned char *buf) {
     assert(preparedOutput && outputTexId > 0 && buf);
     
 	glBindTexture(GL_TEXTURE_2D, outputTexId);
     
 	// default (and slow) way using glReadPixels:
-    glReadPixels(0, 0, outputW, outputH, GL_RGBA, GL_UNSIGNED_BYTE, buf);
+    int x, y, w, h;
+    getOutputReadRect(x, y, w, h);
+    glReadPixels(x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, buf);
 
     // check for error
     Tools::checkGLErr("MemTransfer", "fromGPU (glReadPixels)");
@@ -155,6 +228,120 @@ void MemTransfer::fromGPU(unsigned char *buf) {
 
 #pragma mark protected methods
 
+void MemTransfer::getOutputReadRect(int &x, int &y, int &w, int &h) const {
+    if (readW <= 0) {
+        x = y = 0;
+        w = outputW;
+        h = outputH;
+    } else {
+        assert(readX + readW <= outputW && readY + readH <= outputH);
+        
+        x = readX;
+        y = readY;
+        w = readW;
+        h = readH;
+    }
+}
+
+void MemTransfer::copyOutputReadRect(const unsigned char *texData, unsigned char *buf) const {
+    int x, y, w, h;
+    getOutputReadRect(x, y, w, h);
+    
+    if (w == outputW) {     // whole rows
+        memcpy(buf, texData + y * outputW * 4, w * h * 4);
+        return;
+    }
+    
+    for (int row = 0; row < h; row++) {
+        memcpy(buf + row * w * 4, texData + ((y + row) * outputW + x) * 4, w * 4);
+    }
+}
+
+GLuint MemTransfer::prepareInputPlanes() {
+    int numChromaPlanes = inputPixelFormat == INPUT_FORMAT_Y8 ? 0 : (inputPixelFormat == INPUT_FORMAT_I420 ? 2 : 1);
+    
+    // generate texture ids
+    GLuint texIds[3];
+    glGenTextures(1 + numChromaPlanes, texIds);
+    
+    inputTexId = texIds[0];
+    inputChromaTexIds[0] = numChromaPlanes > 0 ? texIds[1] : 0;
+    inputChromaTexIds[1] = numChromaPlanes > 1 ? texIds[2] : 0;
+    
+    if (inputTexId == 0) {
+        OG_LOGERR("MemTransfer", "no valid input texture generated");
+        return 0;
+    }
+    
+    // allocate the texture storage once: 1 byte per pixel in the Y plane and in the
+    // I420 chroma planes, 2 bytes per pixel in the NV12/NV21 chroma plane
+    for (int i = 0; i <= numChromaPlanes; i++) {
+        GLenum fmt = (i > 0 && numChromaPlanes == 1) ? GL_LUMINANCE_ALPHA : GL_LUMINANCE;
+        int w = i > 0 ? (inputW + 1) / 2 : inputW;
+        int h = i > 0 ? (inputH + 1) / 2 : inputH;
+        
+        // will bind the texture, too:
+        setCommonTextureParams(texIds[i]);
+        
+        // the chroma samples are interpolated between the pixels
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        
+        glTexImage2D(GL_TEXTURE_2D, 0, fmt, w, h, 0, fmt, GL_UNSIGNED_BYTE, NULL);
+    }
+    
+    Tools::checkGLErr("MemTransfer", "input plane texture creation");
+    
+    // done
+    preparedInput = true;
+    
+    return inputTexId;
+}
+
+void MemTransfer::planesToGPU(const unsigned char *buf) {
+    int chromaW = (inputW + 1) / 2;
+    int chromaH = (inputH + 1) / 2;
+    int lumaRowStride = inputRowStride > 0 ? inputRowStride : inputW;
+    const unsigned char *chroma = buf + lumaRowStride * inputH;
+    
+    // copy the chroma planes first, so that the Y plane texture stays bound (Core
+    // sets its texture parameters after the upload)
+    if (inputPixelFormat == INPUT_FORMAT_NV12 || inputPixelFormat == INPUT_FORMAT_NV21) {
+        glBindTexture(GL_TEXTURE_2D, inputChromaTexIds[0]);
+        planeToGPU(chroma, chromaW, chromaH, GL_LUMINANCE_ALPHA, 2, inputRowStride > 0 ? inputRowStride : chromaW * 2);
+    } else if (inputPixelFormat == INPUT_FORMAT_I420) {
+        int chromaRowStride = inputRowStride > 0 ? inputRowStride / 2 : chromaW;
+        
+        glBindTexture(GL_TEXTURE_2D, inputChromaTexIds[0]);
+        planeToGPU(chroma, chromaW, chromaH, GL_LUMINANCE, 1, chromaRowStride);
+        
+        glBindTexture(GL_TEXTURE_2D, inputChromaTexIds[1]);
+        planeToGPU(chroma + chromaRowStride * chromaH, chromaW, chromaH, GL_LUMINANCE, 1, chromaRowStride);
+    }
+    
+    glBindTexture(GL_TEXTURE_2D, inputTexId);
+    planeToGPU(buf, inputW, inputH, GL_LUMINANCE, 1, lumaRowStride);
+    
+    // check for error
+    Tools::checkGLErr("MemTransfer", "toGPU (input planes)");
+}
+
+void MemTransfer::planeToGPU(const unsigned char *data, int w, int h, GLenum fmt, int bytesPerPx, int rowStride) {
+    // the rows of a plane are not necessarily aligned to 4 bytes
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    
+    if (rowStride == w * bytesPerPx) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, fmt, GL_UNSIGNED_BYTE, data);
+    } else {
+        // OpenGL ES 2.0 has no GL_UNPACK_ROW_LENGTH: copy row by row
+        for (int y = 0; y < h; y++) {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, w, 1, fmt, GL_UNSIGNED_BYTE, data + y * rowStride);
+        }
+    }
+    
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
 void MemTransfer::setCommonTextureParams(GLuint texId) {
     if (texId > 0) {
         glBindTexture(GL_TEXTURE_2D, texId);
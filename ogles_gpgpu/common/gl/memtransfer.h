@@ -42,6 +42,9 @@ public:
     
     /**
      * Prepare for input frames of size <inTexW>x<inTexH>. Return a texture id for the input frames.
+     * The texture storage is allocated here once, toGPU() only updates its contents.
+     * For YUV formats (see InputYUVFormat), the returned texture contains the Y plane and
+     * the chroma planes get own textures (see getInputChromaTexId()).
      */
     virtual GLuint prepareInput(int inTexW, int inTexH, GLenum inputPxFormat = GL_RGBA, void *inputDataPtr = NULL);
     
@@ -65,13 +68,42 @@ public:
      */
     virtual GLuint getInputTexId() const { return inputTexId; }
     
+    /**
+     * Get the texture id of chroma plane <plane> of YUV input: the interleaved chroma
+     * samples of NV12/NV21 input (plane 0) or the U (plane 0) and V (plane 1) samples of
+     * I420 input. Returns 0 if there is no such plane.
+     */
+    GLuint getInputChromaTexId(int plane) const { assert(plane >= 0 && plane < 2); return inputChromaTexIds[plane]; }
+    
     /**
      * Get output texture id.
      */
     virtual GLuint getOutputTexId() const { return outputTexId; }
     
     /**
-     * Map data in <buf> to GPU.
+     * Set the row stride of the input data for toGPU() to <stride> bytes. This allows
+     * to pass padded buffers (e.g. from a camera) without copying them first.
+     * A value of 0 means tightly packed rows (input width * 4 bytes).
+     * For YUV input, <stride> is the row stride of the Y plane. The chroma planes
+     * then start at <stride> * height and have the row stride <stride> (NV12/NV21)
+     * or <stride> / 2 (I420).
+     */
+    virtual void setInputRowStride(int stride) { assert(stride >= 0); inputRowStride = stride; }
+    
+    /**
+     * Get the row stride of the input data in bytes (0 means tightly packed rows).
+     */
+    int getInputRowStride() const { return inputRowStride; }
+    
+    /**
+     * Restrict the following fromGPU() and startReadback() calls to the texels at
+     * position <x>, <y> with size <w>x<h> of the output texture. fromGPU() then writes
+     * <w> * <h> * 4 bytes. A value of 0 for <w> reads the whole texture (default).
+     */
+    void setOutputReadRect(int x, int y, int w, int h);
+    
+    /**
+     * Map data in <buf> to GPU. Rows in <buf> are expected to be <inputRowStride> bytes apart.
      */
     virtual void toGPU(const unsigned char *buf);
     
@@ -80,6 +112,25 @@ public:
      */
     virtual void fromGPU(unsigned char *buf);
     
+    /**
+     * Start an asynchronous readback of the output texture, tagged with <tag>.
+     * The output framebuffer must be bound. Does nothing here, because this class
+     * only implements a blocking readback in fromGPU().
+     */
+    virtual void startReadback(unsigned long tag) { }
+    
+    /**
+     * Select the readback with tag <tag> for the next fromGPU() call. Returns true if
+     * such a readback is pending. Returns always false here.
+     */
+    virtual bool selectReadback(unsigned long tag) { return false; }
+    
+    /**
+     * Return the size in bytes of tightly packed input data of size <w>x<h> in pixel
+     * format <fmt> (GL_RGBA, GL_BGRA or a YUV format).
+     */
+    static int getInputDataSize(GLenum fmt, int w, int h);
+    
     /**
      * Try to initialize platform optimizations. Returns true on success, else false.
      * Is only fully implemented in platform-specialized classes of MemTransfer.
@@ -93,6 +144,40 @@ protected:
      */
     virtual void setCommonTextureParams(GLuint texId);
     
+    /**
+     * Return true if the input rows are tightly packed, i.e. the row stride is
+     * 0 or equals the row length.
+     */
+    bool getInputRowsArePacked() const { return inputRowStride == 0 || inputRowStride == inputW * 4; }
+    
+    /**
+     * Create the plane textures for YUV input (see prepareInput()).
+     */
+    GLuint prepareInputPlanes();
+    
+    /**
+     * Copy the planes of YUV input data in <buf> to the plane textures.
+     */
+    void planesToGPU(const unsigned char *buf);
+    
+    /**
+     * Copy <w>x<h> pixels of format <fmt> with <bytesPerPx> bytes per pixel from
+     * <data> with a row stride of <rowStride> bytes to the bound texture.
+     */
+    virtual void planeToGPU(const unsigned char *data, int w, int h, GLenum fmt, int bytesPerPx, int rowStride);
+    
+    /**
+     * Get the read rectangle at <x>, <y> with size <w>x<h> in texels of the output
+     * texture (see setOutputReadRect()).
+     */
+    void getOutputReadRect(int &x, int &y, int &w, int &h) const;
+    
+    /**
+     * Copy the read rectangle from the data of the whole output texture <texData>
+     * (e.g. a mapped buffer) to <buf>.
+     */
+    void copyOutputReadRect(const unsigned char *texData, unsigned char *buf) const;
+    
     
     bool initialized;       // is initialized?
     
@@ -104,10 +189,18 @@ protected:
     int outputW;            // output texture width
     int outputH;            // output texture heights
     
+    int readX;              // read rectangle x position in texels
+    int readY;              // read rectangle y position in texels
+    int readW;              // read rectangle width in texels (0 for the whole output texture)
+    int readH;              // read rectangle height in texels
+    
     GLuint inputTexId;      // input texture id
+    GLuint inputChromaTexIds[2];    // chroma plane texture ids for YUV input (0 if not used)
     GLuint outputTexId;     // output texture id
     
     GLenum inputPixelFormat;    // input texture pixel format
+    
+    int inputRowStride;     // input data row stride in bytes (0 means tightly packed rows)
 };
 
 }
@@ -8,7 +8,8 @@
 //
 
 #include "memtransfer_factory.h"
-#include "../core.h"
+#include "../tools.h"
+#include "memtransfer_pbo.h"
 
 #ifdef __APPLE__
 #include "../../platform/ios/memtransfer_ios.h"
@@ -20,17 +21,23 @@ using namespace ogles_gpgpu;
 
 bool MemTransferFactory::usePlatformOptimizations = false;
 
-MemTransfer *MemTransferFactory::createInstance() {
+MemTransfer *MemTransferFactory::createInstance(void *glContext) {
     MemTransfer *instance = NULL;
     
     if (usePlatformOptimizations) {   // create specialized instance
 #ifdef __APPLE__
-        instance = (MemTransfer *)new MemTransferIOS();
+        instance = (MemTransfer *)new MemTransferIOS(glContext);
 #elif __ANDROID__
         instance = (MemTransfer *)new MemTransferAndroid();
 #endif
     }
     
+#ifdef OGLES_GPGPU_OPENGL_ES3
+    if (!instance && Tools::isGLES3Context()) {    // create instance with asynchronous readback
+        instance = new MemTransferPBO();
+    }
+#endif
+    
     if (!instance) {    // create default instance
         instance = new MemTransfer();
     }
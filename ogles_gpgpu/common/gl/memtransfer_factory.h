@@ -27,9 +27,13 @@ namespace ogles_gpgpu {
 class MemTransferFactory {
 public:
     /**
-     * Create a new MemTransfer instance.
+     * Create a new MemTransfer instance for the current OpenGL context. <glContext>
+     * is the pointer to this context (platform specific type), which is needed
+     * by some platform optimizations (iOS). If the current context is an OpenGL
+     * ES 3.0 context, MemTransferPBO instances are created (if platform optimizations
+     * are not enabled).
      */
-    static MemTransfer *createInstance();
+    static MemTransfer *createInstance(void *glContext = NULL);
     
     /**
      * Try to enable platform optimizations. Returns true on success, else false.
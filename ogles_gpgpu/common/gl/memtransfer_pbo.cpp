@@ -0,0 +1,251 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "memtransfer_pbo.h"
+
+#ifdef OGLES_GPGPU_OPENGL_ES3
+
+using namespace ogles_gpgpu;
+
+#pragma mark constructor/deconstructor
+
+MemTransferPBO::MemTransferPBO() : MemTransfer() {
+    // set defaults
+    for (int i = 0; i < OGLES_GPGPU_MEMTRANSFER_PBO_RING_SIZE; i++) {
+        pbos[i] = 0;
+        pboTags[i] = 0;
+        pboDataSizes[i] = 0;
+    }
+    
+    oldestPending = 0;
+    numPending = 0;
+    pboSize = 0;
+    readDirectly = false;
+    unpackPbo = 0;
+    useUnpackBuffer = false;
+}
+
+MemTransferPBO::~MemTransferPBO() {
+    // release in- and output
+    releaseInput();
+    releaseOutput();
+}
+
+#pragma mark public methods
+
+GLuint MemTransferPBO::prepareOutput(int outTexW, int outTexH) {
+    if (outputW != outTexW || outputH != outTexH) {   // pending readbacks have the wrong size
+        releaseOutput();
+    }
+    
+    return MemTransfer::prepareOutput(outTexW, outTexH);
+}
+
+void MemTransferPBO::releaseInput() {
+    if (unpackPbo > 0) {
+        glDeleteBuffers(1, &unpackPbo);
+        unpackPbo = 0;
+    }
+    
+    MemTransfer::releaseInput();
+}
+
+void MemTransferPBO::releaseOutput() {
+    if (pbos[0] > 0) {
+        glDeleteBuffers(OGLES_GPGPU_MEMTRANSFER_PBO_RING_SIZE, pbos);
+        
+        for (int i = 0; i < OGLES_GPGPU_MEMTRANSFER_PBO_RING_SIZE; i++) {
+            pbos[i] = 0;
+        }
+    }
+    
+    oldestPending = 0;
+    numPending = 0;
+    pboSize = 0;
+    
+    MemTransfer::releaseOutput();
+}
+
+void MemTransferPBO::toGPU(const unsigned char *buf) {
+    assert(preparedInput && inputTexId > 0 && buf);
+    
+    if (Tools::isYUVFormat(inputPixelFormat)) {
+        planesToGPU(buf);
+        return;
+    }
+    
+    if (inputRowStride % 4 != 0) {   // can not be described in pixels with GL_UNPACK_ROW_LENGTH
+        MemTransfer::toGPU(buf);
+        return;
+    }
+    
+    bool packed = getInputRowsArePacked();
+    const unsigned char *src = buf;
+    
+    if (useUnpackBuffer) {
+        size_t size = packed ? inputW * inputH * 4 : (inputH - 1) * inputRowStride + inputW * 4;
+        
+        if (unpackPbo == 0) {
+            glGenBuffers(1, &unpackPbo);
+        }
+        
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackPbo);
+        
+        // orphan the old buffer storage, so that we do not need to wait until the GPU
+        // has finished the previous upload
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+        
+        void *mappedPtr = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        
+        if (mappedPtr) {
+            memcpy(mappedPtr, buf, size);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            src = NULL;     // offset 0 in the unpack buffer
+        } else {
+            OG_LOGERR("MemTransferPBO", "could not map pixel unpack buffer %d", unpackPbo);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+    }
+	
+	glBindTexture(GL_TEXTURE_2D, inputTexId);	// bind input texture
+    
+    if (!packed) {
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, inputRowStride / 4);
+    }
+    
+    // copy data to the texture on the GPU
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, inputW, inputH, GL_RGBA, GL_UNSIGNED_BYTE, src);
+    
+    if (!packed) {
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+    
+    if (useUnpackBuffer) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    
+    // check for error
+    Tools::checkGLErr("MemTransferPBO", "toGPU (glTexSubImage2D)");
+    
+    setCommonTextureParams(0);
+}
+
+void MemTransferPBO::startReadback(unsigned long tag) {
+    assert(preparedOutput && outputTexId > 0);
+    
+    size_t size = outputW * outputH * 4;
+    
+    if (pbos[0] == 0) {     // create buffers on first use
+        glGenBuffers(OGLES_GPGPU_MEMTRANSFER_PBO_RING_SIZE, pbos);
+        pboSize = 0;
+    }
+    
+    if (pboSize != size) {  // (re)allocate buffer storage
+        for (int i = 0; i < OGLES_GPGPU_MEMTRANSFER_PBO_RING_SIZE; i++) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[i]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+        }
+        
+        pboSize = size;
+        oldestPending = 0;
+        numPending = 0;
+        
+        OG_LOGINF("MemTransferPBO", "allocated %d pixel pack buffers of %d bytes",
+                  OGLES_GPGPU_MEMTRANSFER_PBO_RING_SIZE, (int)size);
+    }
+    
+    if (numPending == OGLES_GPGPU_MEMTRANSFER_PBO_RING_SIZE) {  // all buffers in use
+        OG_LOGINF("MemTransferPBO", "discarding readback %lu", pboTags[oldestPending]);
+        discardOldestReadback();
+    }
+    
+    int idx = (oldestPending + numPending) % OGLES_GPGPU_MEMTRANSFER_PBO_RING_SIZE;
+    
+    // copy the read rectangle of the framebuffer to the buffer. returns immediately
+    int x, y, w, h;
+    getOutputReadRect(x, y, w, h);
+    
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[idx]);
+    glReadPixels(x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    
+    Tools::checkGLErr("MemTransferPBO", "startReadback (glReadPixels)");
+    
+    pboTags[idx] = tag;
+    pboDataSizes[idx] = w * h * 4;
+    numPending++;
+}
+
+bool MemTransferPBO::selectReadback(unsigned long tag) {
+    // discard older readbacks
+    while (numPending > 0 && pboTags[oldestPending] < tag) {
+        discardOldestReadback();
+    }
+    
+    readDirectly = (numPending == 0 || pboTags[oldestPending] != tag);
+    
+    return !readDirectly;
+}
+
+void MemTransferPBO::fromGPU(unsigned char *buf) {
+    assert(preparedOutput && outputTexId > 0 && buf);
+    
+    if (numPending == 0 || readDirectly) {   // no readback pending -> blocking glReadPixels()
+        readDirectly = false;
+        MemTransfer::fromGPU(buf);
+        return;
+    }
+    
+    // map the oldest buffer. this waits until its glReadPixels() call was completed
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[oldestPending]);
+    
+    size_t dataSize = pboDataSizes[oldestPending];
+    const unsigned char *mappedPtr = (const unsigned char *)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, dataSize, GL_MAP_READ_BIT);
+    
+    if (mappedPtr) {
+        memcpy(buf, mappedPtr, dataSize);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+        OG_LOGERR("MemTransferPBO", "could not map pixel pack buffer %d", pbos[oldestPending]);
+    }
+    
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    
+    Tools::checkGLErr("MemTransferPBO", "fromGPU (glMapBufferRange)");
+    
+    discardOldestReadback();
+}
+
+#pragma mark protected methods
+
+void MemTransferPBO::planeToGPU(const unsigned char *data, int w, int h, GLenum fmt, int bytesPerPx, int rowStride) {
+    if (rowStride % bytesPerPx != 0) {   // can not be described in pixels with GL_UNPACK_ROW_LENGTH
+        MemTransfer::planeToGPU(data, w, h, fmt, bytesPerPx, rowStride);
+        return;
+    }
+    
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, rowStride / bytesPerPx);
+    
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, fmt, GL_UNSIGNED_BYTE, data);
+    
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+#pragma mark private methods
+
+void MemTransferPBO::discardOldestReadback() {
+    assert(numPending > 0);
+    
+    oldestPending = (oldestPending + 1) % OGLES_GPGPU_MEMTRANSFER_PBO_RING_SIZE;
+    numPending--;
+}
+
+#endif
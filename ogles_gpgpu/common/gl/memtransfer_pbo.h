@@ -0,0 +1,136 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * MemTransferPBO implements asynchronous readback with pixel pack buffers and
+ * buffer-backed uploads (OpenGL ES 3.0).
+ */
+
+#ifndef OGLES_GPGPU_COMMON_GL_MEMTRANSFER_PBO
+#define OGLES_GPGPU_COMMON_GL_MEMTRANSFER_PBO
+
+#include "memtransfer.h"
+
+#ifdef OGLES_GPGPU_OPENGL_ES3
+
+#define OGLES_GPGPU_MEMTRANSFER_PBO_RING_SIZE  3
+
+namespace ogles_gpgpu {
+
+/**
+ * MemTransferPBO implements asynchronous readback with pixel pack buffers (PBOs).
+ * It is platform independent, but needs an OpenGL ES 3.0 context.
+ * startReadback() issues glReadPixels() into the next PBO of a ring of
+ * OGLES_GPGPU_MEMTRANSFER_PBO_RING_SIZE buffers, which returns immediately.
+ * fromGPU() maps the oldest pending PBO and copies its contents. So the readback
+ * of a frame can overlap the rendering of the following frame(s).
+ * Without a pending readback, fromGPU() falls back to a blocking glReadPixels().
+ * Padded input rows are described with GL_UNPACK_ROW_LENGTH. Optionally, input
+ * data is uploaded via a pixel unpack buffer (see setUseUnpackBuffer()).
+ */
+class MemTransferPBO : public MemTransfer {
+public:
+    /**
+     * Constructor. Set defaults.
+     */
+    MemTransferPBO();
+    
+    /**
+     * Deconstructor. Release in- and outputs.
+     */
+    virtual ~MemTransferPBO();
+    
+    /**
+     * Prepare for output frames of size <outTexW>x<outTexH>. Return a texture id for the output frames.
+     */
+    virtual GLuint prepareOutput(int outTexW, int outTexH);
+    
+    /**
+     * Delete input texture and pixel unpack buffer.
+     */
+    virtual void releaseInput();
+    
+    /**
+     * Delete output texture and pixel pack buffers.
+     */
+    virtual void releaseOutput();
+    
+    /**
+     * Upload input data via a pixel unpack buffer: <use>. The data is copied into a
+     * freshly orphaned buffer, from which the texture is updated by the GPU.
+     * Only used for RGBA input, not for YUV input. Disabled by default.
+     */
+    void setUseUnpackBuffer(bool use) { useUnpackBuffer = use; }
+    
+    /**
+     * Get "use unpack buffer" status.
+     */
+    bool getUseUnpackBuffer() const { return useUnpackBuffer; }
+    
+    /**
+     * Map data in <buf> to GPU. Rows in <buf> are expected to be <inputRowStride> bytes apart.
+     */
+    virtual void toGPU(const unsigned char *buf);
+    
+    /**
+     * Start an asynchronous readback of the read rectangle of the output texture (see
+     * setOutputReadRect()) into the next pixel pack buffer, tagged with <tag>. The
+     * output framebuffer must be bound. If all buffers are pending, the oldest readback
+     * is discarded.
+     */
+    virtual void startReadback(unsigned long tag);
+    
+    /**
+     * Discard all pending readbacks with a tag older than <tag>. Returns true if the
+     * oldest remaining readback is tagged with <tag>, so that the next fromGPU() call
+     * will map it. Otherwise the next fromGPU() call reads the output texture directly.
+     */
+    virtual bool selectReadback(unsigned long tag);
+    
+    /**
+     * Map data from GPU to <buf>. Maps the oldest pending pixel pack buffer or
+     * reads the output texture directly if no readback is pending.
+     */
+    virtual void fromGPU(unsigned char *buf);
+
+protected:
+    /**
+     * Copy <w>x<h> pixels of format <fmt> with <bytesPerPx> bytes per pixel from
+     * <data> with a row stride of <rowStride> bytes to the bound texture. Padded
+     * rows are described with GL_UNPACK_ROW_LENGTH.
+     */
+    virtual void planeToGPU(const unsigned char *data, int w, int h, GLenum fmt, int bytesPerPx, int rowStride);
+
+private:
+    /**
+     * Discard the oldest pending readback.
+     */
+    void discardOldestReadback();
+    
+    
+    GLuint pbos[OGLES_GPGPU_MEMTRANSFER_PBO_RING_SIZE];             // pixel pack buffer ids
+    unsigned long pboTags[OGLES_GPGPU_MEMTRANSFER_PBO_RING_SIZE];   // tags of the pending readbacks
+    
+    int oldestPending;  // ring index of the oldest pending readback
+    int numPending;     // number of pending readbacks
+    
+    size_t pboSize;     // size of each pixel pack buffer in bytes
+    size_t pboDataSizes[OGLES_GPGPU_MEMTRANSFER_PBO_RING_SIZE];    // size of the read rectangle of the pending readbacks in bytes
+    
+    GLuint unpackPbo;       // pixel unpack buffer id for input
+    bool useUnpackBuffer;   // upload input via <unpackPbo>?
+    
+    bool readDirectly;  // next fromGPU() call should ignore pending readbacks
+};
+
+}
+
+#endif
+
+#endif
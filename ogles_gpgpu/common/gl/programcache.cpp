@@ -0,0 +1,297 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "programcache.h"
+
+#if defined(GL_OES_get_program_binary) && (defined(__ANDROID__) || defined(__linux__))
+#define OGLES_GPGPU_PROGRAMCACHE_USE_OES
+#include <EGL/egl.h>
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+#define OGLES_GPGPU_PROGRAMCACHE_MAGIC      0x4250474f  // "OGPB"
+#define OGLES_GPGPU_PROGRAMCACHE_VERSION    1
+
+// program binary enums (same values in OpenGL ES 3.0 and OES_get_program_binary)
+#define OGLES_GPGPU_PROGRAM_BINARY_LENGTH       0x8741
+#define OGLES_GPGPU_NUM_PROGRAM_BINARY_FORMATS  0x87FE
+
+#ifdef OGLES_GPGPU_PROGRAMCACHE_USE_OES
+// function pointers to OES_get_program_binary functions
+static PFNGLGETPROGRAMBINARYOESPROC glExtGetProgramBinary = NULL;
+static PFNGLPROGRAMBINARYOESPROC glExtProgramBinary = NULL;
+
+// the function pointers are the same for all contexts, so they are loaded only once
+static once_flag programBinaryFuncsLoaded;
+
+static void loadProgramBinaryFuncs() {
+    glExtGetProgramBinary = (PFNGLGETPROGRAMBINARYOESPROC)eglGetProcAddress("glGetProgramBinaryOES");
+    glExtProgramBinary = (PFNGLPROGRAMBINARYOESPROC)eglGetProcAddress("glProgramBinaryOES");
+}
+#endif
+
+/**
+ * Header of a cache file. It is followed by the program binary.
+ */
+typedef struct {
+    unsigned int magic;         // OGLES_GPGPU_PROGRAMCACHE_MAGIC
+    unsigned int version;       // OGLES_GPGPU_PROGRAMCACHE_VERSION
+    unsigned long long key;     // cache key of the program
+    unsigned int format;        // program binary format
+    unsigned int length;        // program binary length in bytes
+} ProgramCacheFileHeader;
+
+#pragma mark constructor/deconstructor
+
+ProgramCache::ProgramCache() {
+    binarySupport = BINARY_SUPPORT_NONE;
+    numHits = numMisses = numStored = 0;
+}
+
+#pragma mark public methods
+
+bool ProgramCache::initProgramBinarySupport(bool glES3, bool glExtProgramBinary) {
+    binarySupport = BINARY_SUPPORT_NONE;
+
+#ifdef OGLES_GPGPU_OPENGL_ES3
+    if (glES3) {
+        binarySupport = BINARY_SUPPORT_GLES3;
+    }
+#endif
+
+#ifdef OGLES_GPGPU_PROGRAMCACHE_USE_OES
+    if (binarySupport == BINARY_SUPPORT_NONE && glExtProgramBinary) {
+        call_once(programBinaryFuncsLoaded, loadProgramBinaryFuncs);
+        
+        if (glExtGetProgramBinary && glExtProgramBinary) {
+            binarySupport = BINARY_SUPPORT_OES;
+        }
+    }
+#endif
+    
+    // program binaries are useless if the driver does not support any binary format
+    if (binarySupport != BINARY_SUPPORT_NONE) {
+        GLint numFormats = 0;
+        glGetIntegerv(OGLES_GPGPU_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+        
+        if (numFormats <= 0) {
+            binarySupport = BINARY_SUPPORT_NONE;
+        }
+    }
+    
+    // the binaries are only valid for the same driver
+    driverId.clear();
+    
+    const GLenum driverStrings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    for (int i = 0; i < 3; i++) {
+        const char *str = (const char *)glGetString(driverStrings[i]);
+        driverId.append(str ? str : "").append("\n");
+    }
+    
+    // report and clear the errors regardless of the validation level, so that they are
+    // not taken for errors of the program binary calls later
+    Tools::checkGLErrNow("ProgramCache", "check program binary support");
+    
+    OG_LOGINF("ProgramCache", "program binary support: %d", binarySupport);
+    
+    return binarySupport != BINARY_SUPPORT_NONE;
+}
+
+GLuint ProgramCache::loadProgram(const char *vshSrc, const char *fshSrc) {
+    assert(getActive());
+    
+    unsigned long long key = getKey(vshSrc, fshSrc);
+    string path = getEntryPath(key);
+    
+    FILE *f = fopen(path.c_str(), "rb");
+    
+    if (!f) {
+        OG_LOGINF("ProgramCache", "no cached program binary %s", path.c_str());
+        numMisses++;
+        return 0;
+    }
+    
+    // read and check the header, then the binary
+    ProgramCacheFileHeader header;
+    vector<unsigned char> binary;
+    bool valid = fread(&header, sizeof(ProgramCacheFileHeader), 1, f) == 1
+              && header.magic == OGLES_GPGPU_PROGRAMCACHE_MAGIC
+              && header.version == OGLES_GPGPU_PROGRAMCACHE_VERSION
+              && header.key == key
+              && header.length > 0;
+    
+    if (valid) {
+        binary.resize(header.length);
+        valid = fread(&binary[0], 1, header.length, f) == header.length;
+    }
+    
+    fclose(f);
+    
+    if (!valid) {
+        OG_LOGERR("ProgramCache", "invalid cache file %s", path.c_str());
+        numMisses++;
+        return 0;
+    }
+    
+    // create the program from the binary
+    GLuint programId = glCreateProgram();
+    
+    if (programId == 0) {
+        OG_LOGERR("ProgramCache", "could not create shader program");
+        numMisses++;
+        return 0;
+    }
+    
+    // errors of earlier calls must not be taken for a rejected binary
+    Tools::checkGLErrNow("ProgramCache", "before program binary upload");
+
+#ifdef OGLES_GPGPU_OPENGL_ES3
+    if (binarySupport == BINARY_SUPPORT_GLES3) {
+        glProgramBinary(programId, header.format, &binary[0], (GLsizei)header.length);
+    }
+#endif
+
+#ifdef OGLES_GPGPU_PROGRAMCACHE_USE_OES
+    if (binarySupport == BINARY_SUPPORT_OES) {
+        glExtProgramBinary(programId, header.format, &binary[0], (GLint)header.length);
+    }
+#endif
+    
+    // the driver rejects binaries in an unsupported format (GL_INVALID_ENUM), invalid
+    // binaries (GL_INVALID_VALUE) and binaries that it can not use anymore (link status)
+    GLenum binaryErr = glGetError();
+    bool binaryRejected = binaryErr == GL_INVALID_ENUM || binaryErr == GL_INVALID_VALUE;
+    
+    if (binaryErr != GL_NO_ERROR && !binaryRejected) {
+        OG_LOGERR("ProgramCache", "program binary upload - GL error '%d' (%s) occured", binaryErr, Tools::getGLErrName(binaryErr));
+    }
+    
+    GLint linkStatus = GL_FALSE;
+    glGetProgramiv(programId, GL_LINK_STATUS, &linkStatus);
+    
+    if (binaryRejected || linkStatus != GL_TRUE) {
+        OG_LOGINF("ProgramCache", "cached program binary %s was rejected by the driver", path.c_str());
+        glDeleteProgram(programId);
+        numMisses++;
+        return 0;
+    }
+    
+    OG_LOGINF("ProgramCache", "loaded program binary %s (%u bytes)", path.c_str(), header.length);
+    
+    numHits++;
+    
+    return programId;
+}
+
+bool ProgramCache::storeProgram(GLuint programId, const char *vshSrc, const char *fshSrc) {
+    assert(getActive() && programId > 0);
+    
+    // errors of earlier calls must not be taken for a failed binary query
+    Tools::checkGLErrNow("ProgramCache", "before getting the program binary");
+    
+    // get the program binary
+    GLint length = 0;
+    glGetProgramiv(programId, OGLES_GPGPU_PROGRAM_BINARY_LENGTH, &length);
+    
+    if (length <= 0) {
+        OG_LOGERR("ProgramCache", "program binary not available");
+        return false;
+    }
+    
+    vector<unsigned char> binary(length);
+    GLenum format = 0;
+    GLsizei writtenLength = 0;
+
+#ifdef OGLES_GPGPU_OPENGL_ES3
+    if (binarySupport == BINARY_SUPPORT_GLES3) {
+        glGetProgramBinary(programId, length, &writtenLength, &format, &binary[0]);
+    }
+#endif
+
+#ifdef OGLES_GPGPU_PROGRAMCACHE_USE_OES
+    if (binarySupport == BINARY_SUPPORT_OES) {
+        glExtGetProgramBinary(programId, length, &writtenLength, &format, &binary[0]);
+    }
+#endif
+    
+    if (Tools::checkGLErrNow("ProgramCache", "get program binary") || writtenLength <= 0) {
+        OG_LOGERR("ProgramCache", "could not get program binary");
+        return false;
+    }
+    
+    ProgramCacheFileHeader header;
+    memset(&header, 0, sizeof(ProgramCacheFileHeader));
+    header.magic = OGLES_GPGPU_PROGRAMCACHE_MAGIC;
+    header.version = OGLES_GPGPU_PROGRAMCACHE_VERSION;
+    header.key = getKey(vshSrc, fshSrc);
+    header.format = format;
+    header.length = (unsigned int)writtenLength;
+    
+    // write to a temporary file first and rename it, so that other cache objects
+    // that use the same directory never read a partly written file
+    string path = getEntryPath(header.key);
+    ostringstream tmpPath;
+    tmpPath << path << ".tmp" << (const void *)this;
+    
+    FILE *f = fopen(tmpPath.str().c_str(), "wb");
+    
+    if (!f) {
+        OG_LOGERR("ProgramCache", "could not create cache file %s", tmpPath.str().c_str());
+        return false;
+    }
+    
+    bool written = fwrite(&header, sizeof(ProgramCacheFileHeader), 1, f) == 1
+                && fwrite(&binary[0], 1, header.length, f) == header.length;
+    
+    written = fclose(f) == 0 && written;
+    
+    if (!written || rename(tmpPath.str().c_str(), path.c_str()) != 0) {
+        OG_LOGERR("ProgramCache", "could not write cache file %s", path.c_str());
+        remove(tmpPath.str().c_str());
+        return false;
+    }
+    
+    OG_LOGINF("ProgramCache", "stored program binary %s (%u bytes)", path.c_str(), header.length);
+    
+    numStored++;
+    
+    return true;
+}
+
+#pragma mark private methods
+
+unsigned long long ProgramCache::getKey(const char *vshSrc, const char *fshSrc) const {
+    unsigned long long hash = OGLES_GPGPU_FNV1A_OFFSET_BASIS;
+    
+    hash = Tools::hashStr(hash, driverId.c_str());
+    hash = Tools::hashStr(hash, vshSrc);
+    hash = Tools::hashStr(hash, fshSrc);
+    
+    return hash;
+}
+
+string ProgramCache::getEntryPath(unsigned long long key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "og_%016llx.bin", key);
+    
+    string path(cacheDir);
+    
+    if (path[path.size() - 1] != '/') {
+        path.append("/");
+    }
+    
+    return path.append(name);
+}
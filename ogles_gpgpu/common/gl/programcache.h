@@ -0,0 +1,143 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Persistent cache for linked shader program binaries.
+ */
+#ifndef OGLES_GPGPU_COMMON_GL_PROGRAMCACHE
+#define OGLES_GPGPU_COMMON_GL_PROGRAMCACHE
+
+#include "../common_includes.h"
+
+#include <string>
+
+using namespace std;
+
+namespace ogles_gpgpu {
+
+/**
+ * Persistent cache for linked shader program binaries. Linked programs are saved
+ * with glGetProgramBinary() (OpenGL ES 3.0 or the OES_get_program_binary extension)
+ * to one file per program in a directory and loaded with glProgramBinary() the next
+ * time a program with the same shader sources is built, which skips compiling and
+ * linking. The cache key is a hash of the vertex and fragment shader sources and the
+ * driver identity (vendor, renderer and version string), so that binaries of another
+ * driver are never used. If the driver rejects a cached binary (e.g. after a driver
+ * update with the same version string), the program is compiled again and its binary
+ * replaces the cached one.
+ * A cache object can be used by several Shader objects in the same OpenGL context.
+ * Several cache objects (e.g. of different Core objects) can use the same directory.
+ */
+class ProgramCache {
+public:
+    /**
+     * Constructor. The cache is disabled until a directory is set.
+     */
+    ProgramCache();
+    
+    /**
+     * Set the directory <dir> in which the program binaries are stored. The directory
+     * must exist. An empty string disables the cache.
+     */
+    void setDir(const string &dir) { cacheDir = dir; }
+    
+    /**
+     * Return the cache directory.
+     */
+    const string &getDir() const { return cacheDir; }
+    
+    /**
+     * Check program binary support in the current OpenGL context. <glES3> signals an
+     * OpenGL ES 3.0 context, <glExtProgramBinary> the availability of the
+     * OES_get_program_binary extension. Needs to be called before loadProgram() and
+     * storeProgram() in the OpenGL context in which the cache will be used.
+     * Returns true if program binaries are supported.
+     */
+    bool initProgramBinarySupport(bool glES3, bool glExtProgramBinary);
+    
+    /**
+     * Returns true if a directory is set and program binaries are supported.
+     */
+    bool getActive() const { return !cacheDir.empty() && binarySupport != BINARY_SUPPORT_NONE; }
+    
+    /**
+     * Returns true if OpenGL ES 3.0 program binaries are used, so that programs
+     * should be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+     */
+    bool getNeedsRetrievableHint() const { return binarySupport == BINARY_SUPPORT_GLES3; }
+    
+    /**
+     * Create a program from the cached binary of the program with vertex shader source
+     * <vshSrc> and fragment shader source <fshSrc>. Returns the program id or 0 if
+     * there is no usable cached binary.
+     */
+    GLuint loadProgram(const char *vshSrc, const char *fshSrc);
+    
+    /**
+     * Save the binary of the linked program <programId> with vertex shader source
+     * <vshSrc> and fragment shader source <fshSrc> to the cache. Returns true on success.
+     */
+    bool storeProgram(GLuint programId, const char *vshSrc, const char *fshSrc);
+    
+    /**
+     * Return the number of programs that were loaded from the cache.
+     */
+    int getNumHits() const { return numHits; }
+    
+    /**
+     * Return the number of programs that were not found in the cache (or that the
+     * driver rejected).
+     */
+    int getNumMisses() const { return numMisses; }
+    
+    /**
+     * Return the number of programs that were saved to the cache.
+     */
+    int getNumStored() const { return numStored; }
+    
+    /**
+     * Reset the hit, miss and store counters.
+     */
+    void resetCounters() { numHits = numMisses = numStored = 0; }
+
+private:
+    /**
+     * Program binary implementation types.
+     */
+    typedef enum {
+        BINARY_SUPPORT_NONE = 0,    // no program binaries
+        BINARY_SUPPORT_GLES3,       // OpenGL ES 3.0 glGetProgramBinary()
+        BINARY_SUPPORT_OES          // OES_get_program_binary extension
+    } BinarySupport;
+    
+    /**
+     * Return the cache key for the program with vertex shader source <vshSrc> and
+     * fragment shader source <fshSrc>.
+     */
+    unsigned long long getKey(const char *vshSrc, const char *fshSrc) const;
+    
+    /**
+     * Return the path of the cache file for <key>.
+     */
+    string getEntryPath(unsigned long long key) const;
+    
+    
+    string cacheDir;            // cache directory. empty if disabled
+    string driverId;            // vendor, renderer and version string of the OpenGL driver
+    
+    BinarySupport binarySupport;    // program binary implementation
+    
+    int numHits;                // number of programs loaded from the cache
+    int numMisses;              // number of programs not found in the cache
+    int numStored;              // number of programs saved to the cache
+};
+
+}
+
+#endif
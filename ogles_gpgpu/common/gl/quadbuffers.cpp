@@ -0,0 +1,166 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "quadbuffers.h"
+
+#if defined(GL_OES_vertex_array_object) && (defined(__ANDROID__) || defined(__linux__))
+#define OGLES_GPGPU_QUADBUFFERS_USE_OES
+#include <EGL/egl.h>
+#endif
+
+#include <mutex>
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+// quad layout in each buffer: 4 vertices (x, y, z), followed by 4 texture coordinates (s, t)
+#define OGLES_GPGPU_QUADBUFFERS_VERTEX_FLOATS   (4 * 3)
+#define OGLES_GPGPU_QUADBUFFERS_TEXCOORD_FLOATS (4 * 2)
+
+#ifdef OGLES_GPGPU_QUADBUFFERS_USE_OES
+// function pointers to OES_vertex_array_object functions
+static PFNGLGENVERTEXARRAYSOESPROC glExtGenVertexArrays = NULL;
+static PFNGLDELETEVERTEXARRAYSOESPROC glExtDeleteVertexArrays = NULL;
+static PFNGLBINDVERTEXARRAYOESPROC glExtBindVertexArray = NULL;
+
+// the function pointers are the same for all contexts, so they are loaded only once
+static once_flag vertexArrayFuncsLoaded;
+
+static void loadVertexArrayFuncs() {
+    glExtGenVertexArrays = (PFNGLGENVERTEXARRAYSOESPROC)eglGetProcAddress("glGenVertexArraysOES");
+    glExtDeleteVertexArrays = (PFNGLDELETEVERTEXARRAYSOESPROC)eglGetProcAddress("glDeleteVertexArraysOES");
+    glExtBindVertexArray = (PFNGLBINDVERTEXARRAYOESPROC)eglGetProcAddress("glBindVertexArrayOES");
+}
+#endif
+
+#pragma mark constructor/deconstructor
+
+QuadBuffers::QuadBuffers() {
+    memset(vbos, 0, sizeof(vbos));
+    vaoSupport = VAO_SUPPORT_NONE;
+}
+
+QuadBuffers::~QuadBuffers() {
+    release();
+}
+
+#pragma mark public methods
+
+void QuadBuffers::initVertexArraySupport(bool glES3, bool glExtVertexArrayObject) {
+    vaoSupport = VAO_SUPPORT_NONE;
+
+#ifdef OGLES_GPGPU_OPENGL_ES3
+    if (glES3) {
+        vaoSupport = VAO_SUPPORT_GLES3;
+    }
+#endif
+
+#ifdef OGLES_GPGPU_QUADBUFFERS_USE_OES
+    if (vaoSupport == VAO_SUPPORT_NONE && glExtVertexArrayObject) {
+        call_once(vertexArrayFuncsLoaded, loadVertexArrayFuncs);
+        
+        if (glExtGenVertexArrays && glExtDeleteVertexArrays && glExtBindVertexArray) {
+            vaoSupport = VAO_SUPPORT_OES;
+        }
+    }
+#endif
+    
+    OG_LOGINF("QuadBuffers", "vertex array object support: %d", vaoSupport);
+}
+
+GLuint QuadBuffers::getVBO(RenderOrientation o, const GLfloat *vertices, const GLfloat *texCoords) {
+    assert(o >= 0 && o < OGLES_GPGPU_QUADBUFFERS_NUM_ORIENTATIONS);
+    
+    if (vbos[o] > 0) return vbos[o];
+    
+    // create the buffer for this orientation
+    GLfloat data[OGLES_GPGPU_QUADBUFFERS_VERTEX_FLOATS + OGLES_GPGPU_QUADBUFFERS_TEXCOORD_FLOATS];
+    memcpy(data, vertices, OGLES_GPGPU_QUADBUFFERS_VERTEX_FLOATS * sizeof(GLfloat));
+    memcpy(data + OGLES_GPGPU_QUADBUFFERS_VERTEX_FLOATS, texCoords, OGLES_GPGPU_QUADBUFFERS_TEXCOORD_FLOATS * sizeof(GLfloat));
+    
+    glGenBuffers(1, &vbos[o]);
+    glBindBuffer(GL_ARRAY_BUFFER, vbos[o]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(data), data, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    
+    Tools::checkGLErr("QuadBuffers", "create vertex buffer");
+    
+    OG_LOGINF("QuadBuffers", "created vertex buffer %d for render orientation %d", vbos[o], o);
+    
+    return vbos[o];
+}
+
+void QuadBuffers::release() {
+    for (int i = 0; i < OGLES_GPGPU_QUADBUFFERS_NUM_ORIENTATIONS; i++) {
+        if (vbos[i] > 0) {
+            glDeleteBuffers(1, &vbos[i]);
+            vbos[i] = 0;
+        }
+    }
+}
+
+const GLvoid *QuadBuffers::getTexCoordOffset() {
+    return (const GLvoid *)(OGLES_GPGPU_QUADBUFFERS_VERTEX_FLOATS * sizeof(GLfloat));
+}
+
+int QuadBuffers::getNumVBOs() const {
+    int num = 0;
+    
+    for (int i = 0; i < OGLES_GPGPU_QUADBUFFERS_NUM_ORIENTATIONS; i++) {
+        if (vbos[i] > 0) num++;
+    }
+    
+    return num;
+}
+
+GLuint QuadBuffers::genVertexArray() {
+    GLuint vao = 0;
+
+#ifdef OGLES_GPGPU_OPENGL_ES3
+    if (vaoSupport == VAO_SUPPORT_GLES3) {
+        glGenVertexArrays(1, &vao);
+    }
+#endif
+
+#ifdef OGLES_GPGPU_QUADBUFFERS_USE_OES
+    if (vaoSupport == VAO_SUPPORT_OES) {
+        glExtGenVertexArrays(1, &vao);
+    }
+#endif
+    
+    return vao;
+}
+
+void QuadBuffers::deleteVertexArray(GLuint vao) {
+#ifdef OGLES_GPGPU_OPENGL_ES3
+    if (vaoSupport == VAO_SUPPORT_GLES3) {
+        glDeleteVertexArrays(1, &vao);
+    }
+#endif
+
+#ifdef OGLES_GPGPU_QUADBUFFERS_USE_OES
+    if (vaoSupport == VAO_SUPPORT_OES) {
+        glExtDeleteVertexArrays(1, &vao);
+    }
+#endif
+}
+
+void QuadBuffers::bindVertexArray(GLuint vao) {
+#ifdef OGLES_GPGPU_OPENGL_ES3
+    if (vaoSupport == VAO_SUPPORT_GLES3) {
+        glBindVertexArray(vao);
+    }
+#endif
+
+#ifdef OGLES_GPGPU_QUADBUFFERS_USE_OES
+    if (vaoSupport == VAO_SUPPORT_OES) {
+        glExtBindVertexArray(vao);
+    }
+#endif
+}
@@ -0,0 +1,116 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Shared vertex buffers for the fullscreen quad.
+ */
+#ifndef OGLES_GPGPU_COMMON_GL_QUADBUFFERS
+#define OGLES_GPGPU_COMMON_GL_QUADBUFFERS
+
+#include "../common_includes.h"
+
+#define OGLES_GPGPU_QUADBUFFERS_NUM_ORIENTATIONS    5
+
+namespace ogles_gpgpu {
+
+/**
+ * Vertex buffer objects with the vertices and texture coordinates of the fullscreen
+ * quad for one OpenGL context. There is one buffer per render orientation, which is
+ * shared by all processors with this orientation, so that the quad is uploaded once
+ * instead of being copied from client memory in each draw call.
+ * Additionally wraps vertex array objects (OpenGL ES 3.0 or the
+ * OES_vertex_array_object extension), with which each processor can record its
+ * vertex attribute setup once.
+ */
+class QuadBuffers {
+public:
+    /**
+     * Constructor.
+     */
+    QuadBuffers();
+    
+    /**
+     * Deconstructor. Deletes the buffers.
+     */
+    ~QuadBuffers();
+    
+    /**
+     * Check vertex array object support in the current OpenGL context. <glES3> signals
+     * an OpenGL ES 3.0 context, <glExtVertexArrayObject> the availability of the
+     * OES_vertex_array_object extension.
+     */
+    void initVertexArraySupport(bool glES3, bool glExtVertexArrayObject);
+    
+    /**
+     * Return the buffer for render orientation <o>. On the first request for <o>, the
+     * buffer is created with the quad vertices <vertices> and texture coordinates
+     * <texCoords> (OGLES_GPGPU_QUAD_VERTICES vertices each). Binds buffer 0 to
+     * GL_ARRAY_BUFFER in that case.
+     */
+    GLuint getVBO(RenderOrientation o, const GLfloat *vertices, const GLfloat *texCoords);
+    
+    /**
+     * Delete all buffers.
+     */
+    void release();
+    
+    /**
+     * Return the offset of the vertices in each buffer.
+     */
+    static const GLvoid *getVertexOffset() { return (const GLvoid *)0; }
+    
+    /**
+     * Return the offset of the texture coordinates in each buffer.
+     */
+    static const GLvoid *getTexCoordOffset();
+    
+    /**
+     * Return the number of created buffers.
+     */
+    int getNumVBOs() const;
+    
+    /**
+     * Returns true if vertex array objects are supported.
+     */
+    bool getVertexArraySupport() const { return vaoSupport != VAO_SUPPORT_NONE; }
+    
+    /**
+     * Create a vertex array object and return its id (0 on error).
+     */
+    GLuint genVertexArray();
+    
+    /**
+     * Delete vertex array object <vao>.
+     */
+    void deleteVertexArray(GLuint vao);
+    
+    /**
+     * Bind vertex array object <vao>.
+     */
+    void bindVertexArray(GLuint vao);
+
+private:
+    /**
+     * Vertex array object implementation types.
+     */
+    typedef enum {
+        VAO_SUPPORT_NONE = 0,   // no vertex array objects
+        VAO_SUPPORT_GLES3,      // OpenGL ES 3.0 vertex array objects
+        VAO_SUPPORT_OES         // OES_vertex_array_object extension
+    } VAOSupport;
+    
+    
+    GLuint vbos[OGLES_GPGPU_QUADBUFFERS_NUM_ORIENTATIONS];     // buffer per render orientation. 0 if not created
+    
+    VAOSupport vaoSupport;      // vertex array object implementation
+};
+
+}
+
+#endif
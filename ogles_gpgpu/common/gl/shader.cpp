@@ -14,6 +14,7 @@ using namespace ogles_gpgpu;
 
 Shader::Shader() {
 	programId = 0;
+    vshId = fshId = 0;
 }
 
 Shader::~Shader() {
@@ -23,8 +24,22 @@ Shader::~Shader() {
 	}
 }
 
-bool Shader::buildFromSrc(const char *vshSrc, const char *fshSrc) {
-	programId = create(vshSrc, fshSrc, &vshId, &fshId);
+bool Shader::buildFromSrc(const char *vshSrc, const char *fshSrc, ProgramCache *cache) {
+    bool useCache = cache && cache->getActive();
+    
+    // try to load the linked program from the cache
+    if (useCache) {
+        programId = cache->loadProgram(vshSrc, fshSrc);
+        
+        if (programId > 0) return true;
+    }
+    
+    // compile and link the program and save its binary for the next time
+	programId = create(vshSrc, fshSrc, &vshId, &fshId, useCache && cache->getNeedsRetrievableHint());
+    
+    if (useCache && programId > 0) {
+        cache->storeProgram(programId, vshSrc, fshSrc);
+    }
     
 	return (programId > 0);
 }
@@ -34,6 +49,12 @@ void Shader::use() {
 }
 
 GLint Shader::getParam(ShaderParamType type, const char *name) const {
+    // look up the cached position
+    map<string, GLint> &positions = (type == ATTR) ? attrPositions : unifPositions;
+    map<string, GLint>::const_iterator it = positions.find(name);
+    
+    if (it != positions.end()) return it->second;
+    
     // get position according to type and name
 	GLint id = (type == ATTR) ?
         glGetAttribLocation(programId, name) :
@@ -43,10 +64,12 @@ GLint Shader::getParam(ShaderParamType type, const char *name) const {
         OG_LOGERR("Shader", "could not get parameter id for param %s", name);
 	}
     
+    positions[name] = id;
+    
 	return id;
 }
 
-GLuint Shader::create(const char *vshSrc, const char *fshSrc, GLuint *vshId, GLuint *fshId) {
+GLuint Shader::create(const char *vshSrc, const char *fshSrc, GLuint *vshId, GLuint *fshId, bool retrievable) {
     // compile shaders for full shader program
 	*vshId = compile(GL_VERTEX_SHADER, vshSrc);
 	*fshId = compile(GL_FRAGMENT_SHADER, fshSrc);
@@ -61,6 +84,13 @@ GLuint Shader::create(const char *vshSrc, const char *fshSrc, GLuint *vshId, GLu
     
 	glAttachShader(programId, *vshId);   // add the vertex shader to program
 	glAttachShader(programId, *fshId);   // add the fragment shader to program
+    
+#ifdef OGLES_GPGPU_OPENGL_ES3
+    if (retrievable) {  // needed to get the program binary afterwards
+        glProgramParameteri(programId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+#endif
+    
 	glLinkProgram(programId);   // link both shaders to a full program
     
 	// check link status
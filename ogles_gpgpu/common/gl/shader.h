@@ -14,6 +14,12 @@
 #define OGLES_GPGPU_COMMON_GL_SHADER
 
 #include "../common_includes.h"
+#include "programcache.h"
+
+#include <map>
+#include <string>
+
+using namespace std;
 
 namespace ogles_gpgpu {
 
@@ -39,27 +45,35 @@ public:
     
     /**
      * Build an OpenGL shader object from vertex and fragment shader source code
-     * <vshSrc> and <fshSrc>.
+     * <vshSrc> and <fshSrc>. If an active program cache <cache> is passed, the program
+     * is loaded from the cache if possible, otherwise it is compiled and stored in the
+     * cache.
      */
-	bool buildFromSrc(const char *vshSrc, const char *fshSrc);
+	bool buildFromSrc(const char *vshSrc, const char *fshSrc, ProgramCache *cache = NULL);
     
     /**
      * Use the shader program.
      */
 	void use();
     
+    /**
+     * Return the shader program id.
+     */
+    GLuint getProgramId() const { return programId; }
+    
     /**
      * Get a shader parameter position for a parameter of type <type> and with
-     * <name>.
+     * <name>. The positions are queried once and then cached.
      */
 	GLint getParam(ShaderParamType type, const char *name) const;
     
 private:
     /**
      * Create a shader program from sources <vshSrc> and <fshSrc>. Save shader ids in
-     * <vshId> and <fshId>.
+     * <vshId> and <fshId>. Set <retrievable> to true to link the program with
+     * GL_PROGRAM_BINARY_RETRIEVABLE_HINT.
      */
-	static GLuint create(const char *vshSrc, const char *fshSrc, GLuint *vshId, GLuint *fshId);
+	static GLuint create(const char *vshSrc, const char *fshSrc, GLuint *vshId, GLuint *fshId, bool retrievable = false);
     
     /**
      * Compile a shader of type <type> and source <src> and return its id.
@@ -70,6 +84,9 @@ private:
 	GLuint programId;   // full shader program id
 	GLuint vshId;       // vertex shader id
 	GLuint fshId;       // fragment shader id
+    
+    mutable map<string, GLint> attrPositions;   // cached attribute positions by name
+    mutable map<string, GLint> unifPositions;   // cached uniform positions by name
 
 };
     
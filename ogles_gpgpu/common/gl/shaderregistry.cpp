@@ -0,0 +1,94 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "shaderregistry.h"
+
+#include <sstream>
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+#pragma mark constructor/deconstructor
+
+ShaderRegistry::ShaderRegistry() {
+    programCache = NULL;
+    numAcquired = numShared = 0;
+}
+
+ShaderRegistry::~ShaderRegistry() {
+    clear();
+}
+
+#pragma mark public methods
+
+Shader *ShaderRegistry::acquire(const char *vshSrc, const char *fshSrc, GLenum target) {
+    numAcquired++;
+    
+    // the key contains the texture target and both sources, separated by 0 bytes
+    ostringstream keyStream;
+    keyStream << target << '\0' << vshSrc << '\0' << fshSrc;
+    string key = keyStream.str();
+    
+    ShaderRegistryMap::iterator it = entries.find(key);
+    
+    if (it != entries.end()) {
+        it->second.refCount++;
+        numShared++;
+        
+        OG_LOGINF("ShaderRegistry", "sharing shader program (%d users)", it->second.refCount);
+        
+        return it->second.shader;
+    }
+    
+    // build a new program
+    Shader *shader = new Shader();
+    
+    if (!shader->buildFromSrc(vshSrc, fshSrc, programCache)) {
+        delete shader;
+        return NULL;
+    }
+    
+    ShaderRegistryEntry entry;
+    entry.shader = shader;
+    entry.refCount = 1;
+    entries[key] = entry;
+    
+    return shader;
+}
+
+void ShaderRegistry::release(Shader *shader) {
+    assert(shader);
+    
+    for (ShaderRegistryMap::iterator it = entries.begin();
+         it != entries.end();
+         ++it)
+    {
+        if (it->second.shader != shader) continue;
+        
+        if (--it->second.refCount == 0) {
+            delete shader;
+            entries.erase(it);
+        }
+        
+        return;
+    }
+    
+    OG_LOGERR("ShaderRegistry", "released shader is not in the registry");
+}
+
+void ShaderRegistry::clear() {
+    for (ShaderRegistryMap::iterator it = entries.begin();
+         it != entries.end();
+         ++it)
+    {
+        delete it->second.shader;
+    }
+    
+    entries.clear();
+}
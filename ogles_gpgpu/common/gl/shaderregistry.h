@@ -0,0 +1,117 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Registry of shared shader programs.
+ */
+#ifndef OGLES_GPGPU_COMMON_GL_SHADERREGISTRY
+#define OGLES_GPGPU_COMMON_GL_SHADERREGISTRY
+
+#include "../common_includes.h"
+#include "shader.h"
+
+#include <map>
+#include <string>
+
+using namespace std;
+
+namespace ogles_gpgpu {
+
+/**
+ * Reference counted registry of shader programs for one OpenGL context. Processors
+ * that need a program with the same shader sources and input texture target (e.g.
+ * both passes of a GaussProc or several GrayscaleProc objects in the same pipeline)
+ * get the same Shader object, so that the program is only compiled and linked once
+ * and its attribute and uniform locations are only queried once (see
+ * Shader::getParam()). This works because all processors set their uniforms before
+ * each render pass.
+ * Programs can not be shared between OpenGL contexts that are not in the same share
+ * group, so each Core object has its own registry.
+ */
+class ShaderRegistry {
+public:
+    /**
+     * Constructor.
+     */
+    ShaderRegistry();
+    
+    /**
+     * Deconstructor. Deletes the remaining programs.
+     */
+    ~ShaderRegistry();
+    
+    /**
+     * Set the program cache <cache> that is used to build new programs (may be NULL).
+     */
+    void setProgramCache(ProgramCache *cache) { programCache = cache; }
+    
+    /**
+     * Return a shader with vertex shader source <vshSrc> and fragment shader source
+     * <fshSrc> for input texture target <target>. The program is built if the registry
+     * does not contain it yet, otherwise its reference count is increased.
+     * Returns NULL if the program could not be built. Each returned shader must be
+     * given back with release().
+     */
+    Shader *acquire(const char *vshSrc, const char *fshSrc, GLenum target);
+    
+    /**
+     * Decrease the reference count of shader <shader>, which was returned by
+     * acquire(). The program is deleted when it is not used anymore.
+     */
+    void release(Shader *shader);
+    
+    /**
+     * Delete all programs.
+     */
+    void clear();
+    
+    /**
+     * Return the number of programs in the registry.
+     */
+    int getNumPrograms() const { return (int)entries.size(); }
+    
+    /**
+     * Return the number of acquire() calls since the last resetCounters() call.
+     */
+    int getNumAcquired() const { return numAcquired; }
+    
+    /**
+     * Return the number of acquire() calls that returned an existing program since the
+     * last resetCounters() call.
+     */
+    int getNumShared() const { return numShared; }
+    
+    /**
+     * Reset the acquire counters.
+     */
+    void resetCounters() { numAcquired = numShared = 0; }
+
+private:
+    /**
+     * Registry entry for a program.
+     */
+    typedef struct {
+        Shader *shader;     // strong ref.
+        int refCount;       // number of users
+    } ShaderRegistryEntry;
+    
+    typedef map<string, ShaderRegistryEntry> ShaderRegistryMap;
+    
+    
+    ShaderRegistryMap entries;  // programs by key (texture target and shader sources)
+    
+    ProgramCache *programCache; // cache for building new programs. weak ref. may be NULL
+    
+    int numAcquired;            // number of acquire() calls
+    int numShared;              // number of acquire() calls that returned an existing program
+};
+
+}
+
+#endif
@@ -0,0 +1,116 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "texpool.h"
+
+#include "../tools.h"
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+#pragma mark constructor/deconstructor
+
+TexPool::TexPool() {
+    numRequests = 0;
+    requestedMemSize = 0;
+}
+
+TexPool::~TexPool() {
+    release();
+}
+
+#pragma mark public methods
+
+GLuint TexPool::acquire(int w, int h, bool genMipmap, int firstStep, int lastStep) {
+    assert(w > 0 && h > 0 && firstStep <= lastStep);
+    
+    numRequests++;
+    requestedMemSize += getTexMemSize(w, h, genMipmap);
+    
+    // reuse a texture of the same kind that is not read anymore in <firstStep>
+    for (vector<TexPoolEntry>::iterator it = entries.begin();
+         it != entries.end();
+         ++it)
+    {
+        if (it->w == w && it->h == h && it->mipmap == genMipmap && it->busyUntil < firstStep) {
+            it->busyUntil = lastStep;
+            glBindTexture(GL_TEXTURE_2D, it->texId);
+            
+            OG_LOGINF("TexPool", "reusing texture %d of size %dx%d for steps %d to %d", it->texId, w, h, firstStep, lastStep);
+            
+            return it->texId;
+        }
+    }
+    
+    // create a new texture
+    TexPoolEntry entry;
+    entry.w = w;
+    entry.h = h;
+    entry.mipmap = genMipmap;
+    entry.busyUntil = lastStep;
+    
+    glGenTextures(1, &entry.texId);
+    
+    if (entry.texId == 0) {
+        OG_LOGERR("TexPool", "no valid texture generated");
+        return 0;
+    }
+    
+    glBindTexture(GL_TEXTURE_2D, entry.texId);
+	
+	// set clamping (allows NPOT textures)
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    
+    Tools::checkGLErr("TexPool", "texture creation");
+    
+    entries.push_back(entry);
+    
+    OG_LOGINF("TexPool", "created texture %d of size %dx%d for steps %d to %d", entry.texId, w, h, firstStep, lastStep);
+    
+    return entry.texId;
+}
+
+void TexPool::release() {
+    for (vector<TexPoolEntry>::iterator it = entries.begin();
+         it != entries.end();
+         ++it)
+    {
+        glDeleteTextures(1, &it->texId);
+    }
+    
+    entries.clear();
+    
+    numRequests = 0;
+    requestedMemSize = 0;
+}
+
+size_t TexPool::getMemSize() const {
+    size_t memSize = 0;
+    
+    for (vector<TexPoolEntry>::const_iterator it = entries.begin();
+         it != entries.end();
+         ++it)
+    {
+        memSize += getTexMemSize(it->w, it->h, it->mipmap);
+    }
+    
+    return memSize;
+}
+
+#pragma mark private methods
+
+size_t TexPool::getTexMemSize(int w, int h, bool mipmap) {
+    size_t memSize = (size_t)w * (size_t)h * 4;
+    
+    // a full mipmap chain needs about a third more memory
+    return mipmap ? memSize + memSize / 3 : memSize;
+}
@@ -0,0 +1,105 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Pool of FBO output textures that are shared between pipeline stages.
+ */
+#ifndef OGLES_GPGPU_COMMON_GL_TEXPOOL
+#define OGLES_GPGPU_COMMON_GL_TEXPOOL
+
+#include "../common_includes.h"
+
+#include <vector>
+
+using namespace std;
+
+namespace ogles_gpgpu {
+
+/**
+ * Pool of FBO output textures. The render passes of a frame are numbered in the
+ * order in which they are rendered ("steps"). Each pooled output is written in
+ * one step and read until a later step. A texture is handed out again as soon as
+ * the output that used it was read for the last time, so that intermediate outputs
+ * whose lifetimes do not overlap share the same texture storage.
+ * Since intermediate outputs are only used during the processing of a frame, a
+ * pooled texture is shared by all frame slots.
+ */
+class TexPool {
+public:
+    /**
+     * Constructor.
+     */
+    TexPool();
+    
+    /**
+     * Deconstructor. Will call release().
+     */
+    ~TexPool();
+    
+    /**
+     * Return a texture of size <w>x<h> (for mipmapping if <genMipmap> is true) for an
+     * output that is written in step <firstStep> and read until step <lastStep>.
+     * The texture is bound to the active texture unit. Requests must be made in the
+     * order of their <firstStep>.
+     */
+    GLuint acquire(int w, int h, bool genMipmap, int firstStep, int lastStep);
+    
+    /**
+     * Delete all textures of the pool.
+     */
+    void release();
+    
+    /**
+     * Return the number of textures in the pool.
+     */
+    int getNumTextures() const { return (int)entries.size(); }
+    
+    /**
+     * Return the number of outputs that were assigned a pooled texture.
+     */
+    int getNumRequests() const { return numRequests; }
+    
+    /**
+     * Return the size of all textures in the pool in bytes.
+     */
+    size_t getMemSize() const;
+    
+    /**
+     * Return the size in bytes that the requested outputs would need with an own
+     * texture each.
+     */
+    size_t getRequestedMemSize() const { return requestedMemSize; }
+
+private:
+    /**
+     * Pool entry.
+     */
+    typedef struct {
+        GLuint texId;   // texture id
+        int w;          // texture width
+        int h;          // texture height
+        bool mipmap;    // texture is used for mipmapping
+        int busyUntil;  // last step in which the current output in this texture is read
+    } TexPoolEntry;
+    
+    /**
+     * Return the size of a texture of size <w>x<h> (with mipmap if <mipmap> is true) in bytes.
+     */
+    static size_t getTexMemSize(int w, int h, bool mipmap);
+    
+    
+    vector<TexPoolEntry> entries;   // pooled textures
+    
+    int numRequests;                // number of acquire() calls
+    size_t requestedMemSize;        // summed up texture size of all acquire() calls
+};
+
+}
+
+#endif
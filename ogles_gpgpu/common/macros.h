@@ -13,6 +13,10 @@
 #define OG_TO_STR_(x) #x
 #define OG_TO_STR(x) OG_TO_STR_(x)
 
+// fragment shader precision statement for shaders that calculate exact texture
+// coordinates, which is not possible with mediump precision (might only be a half float)
+#define OG_FSHADER_PRECISION_HIGH "#ifdef GL_FRAGMENT_PRECISION_HIGH\nprecision highp float;\n#else\nprecision mediump float;\n#endif\n"
+
 #ifdef DEBUG
 #define OG_LOGINF(class, args...) fprintf(stdout, "ogles_gpgpu::%s - %s - ", class, __FUNCTION__); fprintf(stdout, args); fprintf(stdout, "\n")
 #else
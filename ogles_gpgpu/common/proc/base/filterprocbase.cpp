@@ -9,6 +9,10 @@
 
 #include "filterprocbase.h"
 
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
 using namespace ogles_gpgpu;
 using namespace std;
 
@@ -43,30 +47,194 @@ void FilterProcBase::useTexture(GLuint id, GLuint useTexUnit, GLenum target) {
 	}
 }
 
+void FilterProcBase::cleanup() {
+    if (quadVAO) {
+        QuadBuffers *quadBuffers = glState->getQuadBuffers();
+        if (quadBuffers) quadBuffers->deleteVertexArray(quadVAO);
+        
+        quadVAO = 0;
+    }
+    
+    quadVBO = 0;    // owned by the quad buffers
+    
+    ProcBase::cleanup();
+}
+
+void FilterProcBase::setFusedStages(const vector<FilterProcBase *> &stages) {
+    assert(shader && getIsPointOp() && !stages.empty());
+    
+    fusedStages = stages;
+    
+    // generate the fragment shader source. each point operation gets its own name prefix
+    ostringstream src;
+    src << "precision mediump float;\n"
+        << "varying vec2 vTexCoord;\n"
+        << "uniform sampler2D uInputTex;\n";
+    
+    // round a stage's result like its 8 bit output texture would do, so that the fused
+    // shader produces the same output as the single processors. this needs more than
+    // mediump precision, which might only be a half float
+    src << "#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+        << "vec4 og_round8(highp vec4 px) { highp vec4 r = floor(clamp(px, 0.0, 1.0) * 255.0 + 0.5) / 255.0; return r; }\n"
+        << "#else\n"
+        << "vec4 og_round8(vec4 px) { return floor(clamp(px, 0.0, 1.0) * 255.0 + 0.5) / 255.0; }\n"
+        << "#endif\n";
+    
+    for (size_t i = 0; i <= fusedStages.size(); i++) {
+        const FilterProcBase *stage = i < fusedStages.size() ? fusedStages[i] : this;
+        assert(stage->getIsPointOp());
+        
+        string stageSrc(stage->getPointOpSrc());
+        Tools::strReplaceAll(stageSrc, "pt_", getFusedStagePrefix(i));
+        src << stageSrc << "\n";
+    }
+    
+    src << "void main() {\n"
+        << "    vec4 px = texture2D(uInputTex, vTexCoord);\n";
+    
+    for (size_t i = 0; i < fusedStages.size(); i++) {
+        src << "    px = og_round8(" << getFusedStagePrefix(i) << "apply(px));\n";
+    }
+    
+    src << "    gl_FragColor = " << getFusedStagePrefix(fusedStages.size()) << "apply(px);\n"
+        << "}\n";
+    
+    fusedShaderSrc = src.str();
+    
+    // recreate the shader with the generated source
+    releaseShader();
+    
+    filterShaderSetup(fusedShaderSrc.c_str(), texTarget);
+    
+    // the fused shader renders with the orientation of the first stage
+    initTexCoordBuf(fusedStages[0]->getOutputRenderOrientation());
+    
+    OG_LOGINF(getProcName(), "fused %d point operations into one shader", (int)fusedStages.size() + 1);
+}
+
+ROI FilterProcBase::getInputROI(int inW, int inH) const {
+    if (renderROI.w <= 0) return ProcBase::getInputROI(inW, inH);
+    
+    // texture coordinates of the pixels of the rendered texels. shaders with packed
+    // output find the pixels of a texel by its position, also if the rows are padded
+    int tx, ty, tw, th;
+    getROITexels(renderROI, tx, ty, tw, th);
+    
+    int px = getOutTexelPx();
+    double s0 = (double)(tx * px) / (double)outFrameW;
+    double s1 = (double)min(outFrameW, (tx + tw) * px) / (double)outFrameW;
+    double t0 = (double)ty / (double)outFrameH;
+    double t1 = (double)(ty + th) / (double)outFrameH;
+    
+    // the texture coordinates that the quad samples there in the input texture
+    bool mirrored = quadOrientation == RenderOrientationStdMirrored || quadOrientation == RenderOrientationFlippedMirrored;
+    bool flipped = quadOrientation == RenderOrientationFlipped || quadOrientation == RenderOrientationFlippedMirrored;
+    bool diagonal = quadOrientation == RenderOrientationDiagonal;
+    
+    if (mirrored) {
+        double s = s0;
+        s0 = 1.0 - s1;
+        s1 = 1.0 - s;
+    }
+    
+    if (flipped) {
+        double t = t0;
+        t0 = 1.0 - t1;
+        t1 = 1.0 - t;
+    }
+    
+    if (diagonal) {
+        swap(s0, t0);
+        swap(s1, t1);
+    }
+    
+    int x0 = (int)floor(s0 * inW);
+    int x1 = (int)ceil(s1 * inW);
+    int y0 = (int)floor(t0 * inH);
+    int y1 = (int)ceil(t1 * inH);
+    
+    // grow the region by the filter radius, and by the pixels that are interpolated
+    // (or averaged in a mipmap level) if the input is scaled
+    int rx, ry;
+    getFilterRadius(rx, ry);
+    
+    int outW = diagonal ? outFrameH : outFrameW;
+    int outH = diagonal ? outFrameW : outFrameH;
+    
+    // a pass that swaps rows and columns might step by output pixels along the input
+    // rows, so that the radius is scaled by the larger ratio of the frame sides
+    if (diagonal) {
+        int minOutSide = min(outFrameW, outFrameH);
+        rx = ry = (max(rx, ry) * max(inW, inH) + minOutSide - 1) / minOutSide;
+    }
+    
+    if (inW != outW) rx += (inW + outW - 1) / outW + 1;
+    if (inH != outH) ry += (inH + outH - 1) / outH + 1;
+    
+    ROI roi;
+    roi.x = max(0, x0 - rx);
+    roi.y = max(0, y0 - ry);
+    roi.w = min(inW, x1 + rx) - roi.x;
+    roi.h = min(inH, y1 + ry) - roi.y;
+    
+    return roi;
+}
+
 #pragma mark protected methods
 
 void FilterProcBase::filterInit(const char *fShaderSrc, RenderOrientation o) {
+	// set geometry (before the shader setup, which might already create the shared
+	// vertex buffer if the render orientation was set before)
+	memcpy(vertexBuf, ProcBase::quadVertices, OGLES_GPGPU_QUAD_VERTEX_BUFSIZE * sizeof(GLfloat));
+    
 	// create shader object
 	filterShaderSetup(fShaderSrc, texTarget);
     
-	// set geometry
-	memcpy(vertexBuf, ProcBase::quadVertices, OGLES_GPGPU_QUAD_VERTEX_BUFSIZE * sizeof(GLfloat));
-    
 	// set texture coordinates
     initTexCoordBuf(o);
 }
 
 void FilterProcBase::filterShaderSetup(const char *fShaderSrc, GLenum target) {
+    // YUV input is converted to RGBA while it is read
+    string yuvShaderSrc;
+    bool yuvInput = Tools::isYUVFormat(inputDataFmt);
+    
+    if (yuvInput) {
+        yuvShaderSrc = getYUVInputShaderSrc(fShaderSrc, inputDataFmt);
+    }
+    
     // create shader object
-    ProcBase::createShader(FilterProcBase::vshaderDefault, fShaderSrc, target);
+    ProcBase::createShader(FilterProcBase::vshaderDefault, yuvInput ? yuvShaderSrc.c_str() : fShaderSrc, target);
     
     // get shader params
     shParamAPos = shader->getParam(ATTR, "aPos");
 	shParamATexCoord = shader->getParam(ATTR, "aTexCoord");
     shParamUInputTex = shader->getParam(UNIF, "uInputTex");
     
+    shParamUInputChromaTex[0] = shParamUInputChromaTex[1] = -1;
+    
+    if (yuvInput && inputDataFmt != INPUT_FORMAT_Y8) {
+        shParamUInputChromaTex[0] = shader->getParam(UNIF, "uInputChromaTex0");
+        
+        if (inputDataFmt == INPUT_FORMAT_I420) {
+            shParamUInputChromaTex[1] = shader->getParam(UNIF, "uInputChromaTex1");
+        }
+    }
+    
+    // get the uniforms of the fused point operations, including the own ones
+    if (!fusedStages.empty()) {
+        for (size_t i = 0; i < fusedStages.size(); i++) {
+            fusedStages[i]->getPointOpShaderParams(shader, getFusedStagePrefix(i));
+        }
+        
+        getPointOpShaderParams(shader, getFusedStagePrefix(fusedStages.size()));
+    }
+    
     // remember used shader source
     fragShaderSrcForCompilation = fShaderSrc;
+    
+    // the vertex array object depends on the attribute locations
+    setupQuadBuffers();
 }
 
 void FilterProcBase::initTexCoordBuf(RenderOrientation overrideRenderOrientation) {
@@ -77,6 +245,8 @@ void FilterProcBase::initTexCoordBuf(RenderOrientation overrideRenderOrientation
     
     switch (o) {
         default:
+            o = RenderOrientationStd;
+            // fall through
         case RenderOrientationStd:
             coordsPtr = ProcBase::quadTexCoordsStd;
             break;
@@ -95,44 +265,191 @@ void FilterProcBase::initTexCoordBuf(RenderOrientation overrideRenderOrientation
     }
     
 	memcpy(texCoordBuf, coordsPtr, OGLES_GPGPU_QUAD_TEX_BUFSIZE * sizeof(GLfloat));
+    
+    quadOrientation = o;
+    
+    // the shared vertex buffer depends on the orientation
+    setupQuadBuffers();
+}
+
+void FilterProcBase::setupQuadBuffers() {
+    QuadBuffers *quadBuffers = glState->getQuadBuffers();
+    
+    if (!quadBuffers || !shader || quadOrientation == RenderOrientationNone) return;
+    
+    quadVBO = quadBuffers->getVBO(quadOrientation, vertexBuf, texCoordBuf);
+    
+    if (!quadBuffers->getVertexArraySupport()) return;
+    
+    // record the vertex attribute setup in a new vertex array object (the attribute
+    // locations might have changed with a new shader)
+    if (quadVAO) quadBuffers->deleteVertexArray(quadVAO);
+    quadVAO = quadBuffers->genVertexArray();
+    
+    quadBuffers->bindVertexArray(quadVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    
+	glVertexAttribPointer(shParamAPos,
+						  OGLES_GPGPU_QUAD_COORDS_PER_VERTEX,
+						  GL_FLOAT,
+						  GL_FALSE,
+						  0,
+						  QuadBuffers::getVertexOffset());
+    glVertexAttribPointer(shParamATexCoord,
+    					  OGLES_GPGPU_QUAD_TEXCOORDS_PER_VERTEX,
+    					  GL_FLOAT,
+    					  GL_FALSE,
+    					  0,
+    					  QuadBuffers::getTexCoordOffset());
+	glEnableVertexAttribArray(shParamAPos);
+    glEnableVertexAttribArray(shParamATexCoord);
+    
+    quadBuffers->bindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    
+    // the calls above bypassed the shadow copy of the OpenGL state
+    glState->invalidate();
+    
+    Tools::checkGLErr(getProcName(), "setup vertex array object");
+}
+
+string FilterProcBase::getYUVInputShaderSrc(const char *fShaderSrc, GLenum fmt) {
+    string src(fShaderSrc);
+    const string inputDecl("uniform sampler2D uInputTex;");
+    size_t declPos = src.find(inputDecl);
+    
+    if (declPos == string::npos) {
+        OG_LOGERR("FilterProcBase", "no input sampler uInputTex found, YUV input is not converted");
+        return src;
+    }
+    
+    // read the input through og_yuvTex(), which is declared after the input sampler
+    Tools::strReplaceAll(src, "texture2D(uInputTex, ", "og_yuvTex(uInputTex, ");
+    
+    ostringstream conv;
+    conv << "\n";
+    
+    if (fmt != INPUT_FORMAT_Y8) {
+        conv << "uniform sampler2D uInputChromaTex0;\n";
+    }
+    
+    if (fmt == INPUT_FORMAT_I420) {
+        conv << "uniform sampler2D uInputChromaTex1;\n";
+    }
+    
+    conv << "vec4 og_yuvTex(sampler2D yTex, vec2 coord) {\n"
+         << "    float y = texture2D(yTex, coord).r;\n";
+    
+    if (fmt == INPUT_FORMAT_Y8) {   // the luminance is the gray value
+        conv << "    return vec4(y, y, y, 1.0);\n";
+    } else {
+        if (fmt == INPUT_FORMAT_NV12) {
+            conv << "    vec2 uv = texture2D(uInputChromaTex0, coord).ra;\n";
+        } else if (fmt == INPUT_FORMAT_NV21) {
+            conv << "    vec2 uv = texture2D(uInputChromaTex0, coord).ar;\n";
+        } else {
+            conv << "    vec2 uv = vec2(texture2D(uInputChromaTex0, coord).r, texture2D(uInputChromaTex1, coord).r);\n";
+        }
+        
+        // full range BT.601 with chroma values centered at 128
+        conv << "    uv -= 0.5019608;\n";
+        conv << "    return vec4(y + 1.402 * uv.y, y - 0.344136 * uv.x - 0.714136 * uv.y, y + 1.772 * uv.x, 1.0);\n";
+    }
+    
+    conv << "}\n";
+    
+    src.insert(declPos + inputDecl.size(), conv.str());
+    
+    return src;
+}
+
+string FilterProcBase::getFusedStagePrefix(size_t stageIdx) {
+    ostringstream prefix;
+    prefix << "s" << stageIdx << "_";
+    
+    return prefix.str();
 }
 
 void FilterProcBase::filterRenderPrepare() {
-	shader->use();
+	glState->useProgram(shader->getProgramId());
+    
+	// render to FBO (bind it before clearing, so that the FBO is cleared and not
+	// the default framebuffer, which might not even exist in a surfaceless context)
+	if (fbo) glState->bindFramebuffer(fbo->getId());
     
-	// set the viewport
-	glViewport(0, 0, outFrameW, outFrameH);
+	// set the viewport (in texels of the output texture)
+	glState->viewport(0, 0, getOutTexW(), outFrameH);
+    
+	// only render (and clear) the texels of the render region
+	if (renderROI.w > 0) {
+        int tx, ty, tw, th;
+        getROITexels(renderROI, tx, ty, tw, th);
+        glState->scissor(tx, ty, tw, th);
+    } else {
+        glState->disableScissor();
+    }
     
 	glClear(GL_COLOR_BUFFER_BIT);
     
 	// set input texture
-    glActiveTexture(GL_TEXTURE0 + texUnit);
-	glBindTexture(texTarget, texId);	// bind input texture
+    glState->activeTexture(texUnit);
+	glState->bindTexture(texTarget, texId);	// bind input texture
     
 	// set common uniforms
     glUniform1i(shParamUInputTex, texUnit);
+    
+    // set the uniforms of the fused point operations (the own uniforms are set in render())
+    for (vector<FilterProcBase *>::iterator it = fusedStages.begin();
+         it != fusedStages.end();
+         ++it)
+    {
+        (*it)->setPointOpUniforms();
+    }
+    
+    // set the chroma planes of YUV input
+    if (shParamUInputChromaTex[0] >= 0) {
+        for (int i = 0; i < 2 && shParamUInputChromaTex[i] >= 0; i++) {
+            glState->activeTexture(OGLES_GPGPU_CHROMA_TEX_UNIT + i);
+            glState->bindTexture(GL_TEXTURE_2D, inputChromaTexIds[i]);
+            glUniform1i(shParamUInputChromaTex[i], OGLES_GPGPU_CHROMA_TEX_UNIT + i);
+        }
+        
+        glState->activeTexture(texUnit);
+    }
 }
 
 void FilterProcBase::filterRenderSetCoords() {
-	// render to FBO
-	if (fbo) fbo->bind();
+    // the vertex array object contains the complete geometry setup
+    if (quadVAO) {
+        glState->bindVertexArray(quadVAO);
+        return;
+    }
     
-	// set geometry
-	glEnableVertexAttribArray(shParamAPos);
+    // set geometry from the shared vertex buffer or from the client-side buffers
+    const GLvoid *vertexPtr = vertexBuf;
+    const GLvoid *texCoordPtr = texCoordBuf;
+    
+    if (quadVBO) {
+        glState->bindArrayBuffer(quadVBO);
+        vertexPtr = QuadBuffers::getVertexOffset();
+        texCoordPtr = QuadBuffers::getTexCoordOffset();
+    }
+    
+	glState->enableVertexAttribArray(shParamAPos);
 	glVertexAttribPointer(shParamAPos,
 						  OGLES_GPGPU_QUAD_COORDS_PER_VERTEX,
 						  GL_FLOAT,
 						  GL_FALSE,
 						  0,
-						  vertexBuf);
+						  vertexPtr);
     
     glVertexAttribPointer(shParamATexCoord,
     					  OGLES_GPGPU_QUAD_TEXCOORDS_PER_VERTEX,
     					  GL_FLOAT,
     					  GL_FALSE,
     					  0,
-    					  texCoordBuf);
-    glEnableVertexAttribArray(shParamATexCoord);
+    					  texCoordPtr);
+    glState->enableVertexAttribArray(shParamATexCoord);
 }
 
 void FilterProcBase::filterRenderDraw() {
@@ -142,8 +459,16 @@ void FilterProcBase::filterRenderDraw() {
 
 void FilterProcBase::filterRenderCleanup() {
 	// cleanup
-	glDisableVertexAttribArray(shParamAPos);
-	glDisableVertexAttribArray(shParamATexCoord);
+    if (quadVAO) {
+        glState->unbindVertexArray();
+    } else {
+        glState->disableVertexAttribArray(shParamAPos);
+        glState->disableVertexAttribArray(shParamATexCoord);
+        
+        if (quadVBO) glState->unbindArrayBuffer();
+    }
+    
+	if (fbo) glState->unbindFramebuffer();
     
-	if (fbo) fbo->unbind();
+    if (renderROI.w > 0) glState->releaseScissor();
 }
\ No newline at end of file
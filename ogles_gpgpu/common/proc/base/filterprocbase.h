@@ -17,6 +17,15 @@
 
 #include "procbase.h"
 
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// texture unit of the first chroma plane of YUV input (the second plane uses the
+// following unit). the units before are used by the inputs of MultiInputProcBase
+#define OGLES_GPGPU_CHROMA_TEX_UNIT 6
+
 namespace ogles_gpgpu {
 
 /**
@@ -26,8 +35,16 @@ namespace ogles_gpgpu {
 class FilterProcBase : public ProcBase {
 public:
     FilterProcBase() : ProcBase(),
-    				   fragShaderSrcForCompilation(NULL)
-    				   {}
+    				   fragShaderSrcForCompilation(NULL),
+                       quadOrientation(RenderOrientationNone),
+                       quadVBO(0),
+                       quadVAO(0)
+    				   { shParamUInputChromaTex[0] = shParamUInputChromaTex[1] = -1; }
+    
+    /**
+     * Cleanup processor's resources, including the vertex array object.
+     */
+    virtual void cleanup();
     
     /**
      * Set output orientation to <o>.
@@ -39,7 +56,56 @@ public:
      */
     virtual void useTexture(GLuint id, GLuint useTexUnit = 1, GLenum target = GL_TEXTURE_2D);
     
+    /**
+     * Returns true if this processor is a point operation, i.e. it implements
+     * getPointOpSrc().
+     */
+    virtual bool getIsPointOp() const { return getPointOpSrc() != NULL; }
+    
+    /**
+     * Fuse the point operations of processors <stages> (in render order) into the
+     * shader of this point operation processor. The render() call of this processor
+     * then applies the point operations of <stages> to its input, followed by its own
+     * point operation, so that the processors in <stages> do not need to be rendered
+     * anymore. Their parameters are still set via their own objects. The render
+     * orientation of the first stage is used. Must be called after init().
+     */
+    void setFusedStages(const vector<FilterProcBase *> &stages);
+    
+    /**
+     * Return the processors whose point operations are fused into the shader of this
+     * processor.
+     */
+    const vector<FilterProcBase *> &getFusedStages() const { return fusedStages; }
+    
+    /**
+     * Return the region of an input frame of size <inW>x<inH> that the fullscreen quad
+     * samples for the texels of the render region, grown by the filter radius.
+     */
+    virtual ROI getInputROI(int inW, int inH) const;
+    
 protected:
+    /**
+     * Return the GLSL source of the point operation of this processor or NULL if it
+     * is no point operation. The source must define the function
+     * "vec4 pt_apply(vec4 px)" that returns the output color for the input color <px>,
+     * and the uniforms that it uses. All its global names must start with "pt_", as
+     * this prefix is replaced to fuse several point operations into one shader.
+     */
+    virtual const char *getPointOpSrc() const { return NULL; }
+    
+    /**
+     * Get the locations of the point operation's uniforms in shader <sh>, in which the
+     * "pt_" prefix of their names was replaced by <prefix>.
+     */
+    virtual void getPointOpShaderParams(Shader *sh, const string &prefix) { }
+    
+    /**
+     * Set the point operation's uniforms in the currently used shader.
+     */
+    virtual void setPointOpUniforms() { }
+    
+
     /**
      * Common initialization method for filters with fragment shader source <fShaderSrc>
      * and render output orientation <o>.
@@ -48,16 +114,38 @@ protected:
     
     /**
      * Common filter shader creation method with fragment shader source <fShaderSrc> and
-     * texture target <target>.
+     * texture target <target>. For YUV input (see setExternalInputDataFormat()), the
+     * shader is extended to convert the input while reading it.
      */
     void filterShaderSetup(const char *fShaderSrc, GLenum target);
     
+    /**
+     * Return fragment shader source <fShaderSrc> extended for input in YUV format <fmt>:
+     * all reads of "uInputTex" are replaced by a function that reads the Y plane from
+     * "uInputTex" and the chroma planes from "uInputChromaTex0" (and "uInputChromaTex1"
+     * for I420) and returns the RGBA color.
+     */
+    static string getYUVInputShaderSrc(const char *fShaderSrc, GLenum fmt);
+    
     /**
      * Initialize texture coordinate buffer according to member variable
      * <renderOrientation> or override member variable by <overrideRenderOrientation>.
      */
     void initTexCoordBuf(RenderOrientation overrideRenderOrientation = RenderOrientationNone);
     
+    /**
+     * Get the shared vertex buffer of the quad for the current render orientation and
+     * record the vertex attribute setup in a vertex array object, if the quad buffers
+     * of the OpenGL state support it. Does nothing without quad buffers (then the
+     * client-side buffers <vertexBuf> and <texCoordBuf> are used).
+     */
+    void setupQuadBuffers();
+    
+    /**
+     * Return the name prefix of the point operation number <stageIdx> in a fused shader.
+     */
+    static string getFusedStagePrefix(size_t stageIdx);
+    
     void filterRenderPrepare();
     void filterRenderSetCoords();
     void filterRenderDraw();
@@ -68,11 +156,19 @@ protected:
     
     const char *fragShaderSrcForCompilation;	// used fragment shader source for shader compilation
     
+    vector<FilterProcBase *> fusedStages;   // point operations that are fused into this processor's shader. weak refs
+    string fusedShaderSrc;                  // generated fragment shader source of the fused point operations
+    
 	GLint shParamAPos;          // shader attribute vertex positions
 	GLint shParamATexCoord;     // shader attribute texture coordinates
+    GLint shParamUInputChromaTex[2];    // shader uniform chroma plane samplers for YUV input (-1 if not used)
     
 	GLfloat vertexBuf[OGLES_GPGPU_QUAD_VERTEX_BUFSIZE]; // vertex data buffer for a quad
 	GLfloat texCoordBuf[OGLES_GPGPU_QUAD_TEX_BUFSIZE];  // texture coordinate data buffer for a quad
+    
+    RenderOrientation quadOrientation;  // render orientation of <texCoordBuf>
+    GLuint quadVBO;     // shared vertex buffer of the quad (see QuadBuffers). 0 if not used
+    GLuint quadVAO;     // vertex array object with the vertex attribute setup. 0 if not used
 };
 
 }
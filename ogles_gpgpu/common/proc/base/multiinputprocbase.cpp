@@ -0,0 +1,90 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "multiinputprocbase.h"
+
+#include <sstream>
+
+using namespace ogles_gpgpu;
+using namespace std;
+
+#pragma mark constructor
+
+MultiInputProcBase::MultiInputProcBase(int numInputs) : FilterProcBase() {
+    assert(numInputs >= 2 && numInputs <= OGLES_GPGPU_MAX_PROC_INPUTS);
+    
+    this->numInputs = numInputs;
+    
+    for (int i = 0; i < OGLES_GPGPU_MAX_PROC_INPUTS; i++) {
+        addTexIds[i] = 0;
+        shParamUAddInputTex[i] = -1;
+    }
+}
+
+#pragma mark public methods
+
+void MultiInputProcBase::useTexture(GLuint id, GLuint useTexUnit, GLenum target) {
+    FilterProcBase::useTexture(id, useTexUnit, target);
+    
+    // the shader might have been recreated for the new texture target
+    if (shader) getAddInputShaderParams();
+}
+
+void MultiInputProcBase::useInputTexture(int inputIdx, GLuint id, GLenum target) {
+    assert(inputIdx >= 0 && inputIdx < numInputs);
+    
+    if (inputIdx == 0) {
+        useTexture(id, texUnit, target);
+        return;
+    }
+    
+    if (target != GL_TEXTURE_2D) {
+        OG_LOGERR(getProcName(), "additional input %d must have texture target GL_TEXTURE_2D", inputIdx);
+    }
+    
+    addTexIds[inputIdx] = id;
+}
+
+void MultiInputProcBase::printInfo() {
+    FilterProcBase::printInfo();
+    
+    for (int i = 1; i < numInputs; i++) {
+        OG_LOGINF(getProcName(), "info: additional input %d: tex %d (unit %d)", i, addTexIds[i], texUnit + i);
+    }
+}
+
+#pragma mark protected methods
+
+void MultiInputProcBase::multiInputInit(const char *fShaderSrc, RenderOrientation o) {
+    filterInit(fShaderSrc, o);
+    
+    getAddInputShaderParams();
+}
+
+void MultiInputProcBase::multiInputRenderPrepare() {
+    filterRenderPrepare();
+    
+    // bind the additional input textures to the following texture units
+    for (int i = 1; i < numInputs; i++) {
+        glState->activeTexture(texUnit + i);
+        glState->bindTexture(GL_TEXTURE_2D, addTexIds[i]);
+        glUniform1i(shParamUAddInputTex[i], texUnit + i);
+    }
+    
+    glState->activeTexture(texUnit);
+}
+
+void MultiInputProcBase::getAddInputShaderParams() {
+    for (int i = 1; i < numInputs; i++) {
+        ostringstream name;
+        name << "uInputTex" << (i + 1);
+        
+        shParamUAddInputTex[i] = shader->getParam(UNIF, name.str().c_str());
+    }
+}
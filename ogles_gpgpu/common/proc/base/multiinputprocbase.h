@@ -0,0 +1,90 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Base class for filter processors with several input textures.
+ */
+#ifndef OGLES_GPGPU_COMMON_PROC_MULTIINPUTPROCBASE
+#define OGLES_GPGPU_COMMON_PROC_MULTIINPUTPROCBASE
+
+#include "../../common_includes.h"
+
+#include "filterprocbase.h"
+
+#define OGLES_GPGPU_MAX_PROC_INPUTS 4
+
+namespace ogles_gpgpu {
+
+/**
+ * Base class for filter processors that combine several input textures, e.g.
+ * the outputs of two branches of the pipeline (see Core::addProcToPipeline()).
+ * Input 0 is handled like the input of a FilterProcBase and determines the
+ * input frame size. The additional inputs are sampled with the same texture
+ * coordinates, so they may have a different size. They are bound to the texture
+ * units following the unit of input 0 and are accessible in the fragment shader
+ * as "uInputTex2", "uInputTex3", etc. These samplers must be declared as
+ * "uniform lowp sampler2D", because they are always GL_TEXTURE_2D textures.
+ */
+class MultiInputProcBase : public FilterProcBase {
+public:
+    /**
+     * Constructor for a processor with <numInputs> input textures
+     * (2 to OGLES_GPGPU_MAX_PROC_INPUTS).
+     */
+    MultiInputProcBase(int numInputs);
+    
+    /**
+     * Return the number of input textures that this processor needs.
+     */
+    virtual int getNumInputs() const { return numInputs; }
+    
+    /**
+     * Use texture id <id> as input texture 0 at texture <useTexUnit> with texture target <target>.
+     */
+    virtual void useTexture(GLuint id, GLuint useTexUnit = 1, GLenum target = GL_TEXTURE_2D);
+    
+    /**
+     * Use texture id <id> with texture target <target> as input number <inputIdx>.
+     * Additional inputs (<inputIdx> > 0) must have the target GL_TEXTURE_2D.
+     */
+    virtual void useInputTexture(int inputIdx, GLuint id, GLenum target = GL_TEXTURE_2D);
+    
+    /**
+     * Print some information about the processor's setup.
+     */
+    virtual void printInfo();
+
+protected:
+    /**
+     * Common initialization method for multi input filters with fragment shader
+     * source <fShaderSrc> and render output orientation <o>.
+     */
+    void multiInputInit(const char *fShaderSrc, RenderOrientation o = RenderOrientationNone);
+    
+    /**
+     * Prepare rendering like filterRenderPrepare() and additionally bind the
+     * additional input textures.
+     */
+    void multiInputRenderPrepare();
+    
+    /**
+     * Get the shader uniforms of the additional input samplers.
+     */
+    void getAddInputShaderParams();
+    
+    
+    int numInputs;      // number of input textures
+    
+    GLuint addTexIds[OGLES_GPGPU_MAX_PROC_INPUTS];              // texture ids of the additional inputs (index 0 is unused)
+    GLint shParamUAddInputTex[OGLES_GPGPU_MAX_PROC_INPUTS];     // shader uniforms of the additional input samplers (index 0 is unused)
+};
+
+}
+
+#endif
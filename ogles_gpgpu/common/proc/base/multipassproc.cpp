@@ -9,6 +9,10 @@
 
 #include "multipassproc.h"
 
+#include "../../profiler.h"
+
+#include <sstream>
+
 using namespace ogles_gpgpu;
 
 #pragma mark constructor/deconstructor
@@ -105,9 +109,9 @@ void MultiPassProc::setExternalInputDataFormat(GLenum fmt) {
     firstProc->setExternalInputDataFormat(fmt);
 }
 
-void MultiPassProc::setExternalInputData(const unsigned char *data) {
+void MultiPassProc::setExternalInputData(const unsigned char *data, int rowStride) {
     assert(firstProc);
-    firstProc->setExternalInputData(data);
+    firstProc->setExternalInputData(data, rowStride);
 }
 
 void MultiPassProc::createFBOTex(bool genMipmap) {
@@ -119,12 +123,148 @@ void MultiPassProc::createFBOTex(bool genMipmap) {
     }
 }
 
+void MultiPassProc::setFBOTexPool(TexPool *pool, int firstStep, int lastStep, bool keepOutput) {
+    int step = firstStep;
+    
+    for (list<ProcInterface *>::iterator it = procPasses.begin();
+         it != procPasses.end();
+         ++it)
+    {
+        int passSteps = (*it)->getNumPasses();
+        
+        if (*it == lastProc) {  // output of this processor
+            (*it)->setFBOTexPool(pool, step, lastStep, keepOutput);
+        } else {                // intermediate output is read by the next pass
+            (*it)->setFBOTexPool(pool, step, step + passSteps, false);
+        }
+        
+        step += passSteps;
+    }
+}
+
+int MultiPassProc::getNumPasses() const {
+    int num = 0;
+    
+    for (list<ProcInterface *>::const_iterator it = procPasses.begin();
+         it != procPasses.end();
+         ++it)
+    {
+        num += (*it)->getNumPasses();
+    }
+    
+    return num;
+}
+
+void MultiPassProc::setGLContextPtr(void *glContext) {
+    for (list<ProcInterface *>::iterator it = procPasses.begin();
+         it != procPasses.end();
+         ++it)
+    {
+        (*it)->setGLContextPtr(glContext);
+    }
+}
+
+void MultiPassProc::setShaderRegistry(ShaderRegistry *registry) {
+    for (list<ProcInterface *>::iterator it = procPasses.begin();
+         it != procPasses.end();
+         ++it)
+    {
+        (*it)->setShaderRegistry(registry);
+    }
+}
+
+void MultiPassProc::setGLState(GLState *state) {
+    for (list<ProcInterface *>::iterator it = procPasses.begin();
+         it != procPasses.end();
+         ++it)
+    {
+        (*it)->setGLState(state);
+    }
+}
+
+PackedGraySupport MultiPassProc::getPackedGraySupport() const {
+    // packed grayscale images can only be passed through if all passes keep them
+    for (list<ProcInterface *>::const_iterator it = procPasses.begin();
+         it != procPasses.end();
+         ++it)
+    {
+        if ((*it)->getPackedGraySupport() != PACKED_GRAY_KEEP) return PACKED_GRAY_NONE;
+    }
+    
+    return PACKED_GRAY_KEEP;
+}
+
+void MultiPassProc::setPackedGray(bool packed) {
+    for (list<ProcInterface *>::iterator it = procPasses.begin();
+         it != procPasses.end();
+         ++it)
+    {
+        (*it)->setPackedGray(packed);
+    }
+}
+
+bool MultiPassProc::getPackedGray() const {
+    assert(lastProc);
+    return lastProc->getPackedGray();
+}
+
+void MultiPassProc::setNumFrameSlots(int num) {
+    for (list<ProcInterface *>::iterator it = procPasses.begin();
+         it != procPasses.end();
+         ++it)
+    {
+        (*it)->setNumFrameSlots(num);
+    }
+}
+
+void MultiPassProc::selectFrameSlot(int slot) {
+    ProcInterface *prevProc = NULL;
+    
+    for (list<ProcInterface *>::iterator it = procPasses.begin();
+         it != procPasses.end();
+         ++it)
+    {
+        (*it)->selectFrameSlot(slot);
+        
+        if (prevProc) {     // previous pass output of this slot is this pass' input
+            (*it)->useTexture(prevProc->getOutputTexId(), prevProc->getTextureUnit());
+        }
+        
+        prevProc = *it;
+    }
+}
+
+void MultiPassProc::setProfiler(Profiler *profiler, int stage) {
+    this->profiler = profiler;
+    passStages.clear();
+    
+    if (!profiler) return;
+    
+    int passNum = 1;
+    for (list<ProcInterface *>::iterator it = procPasses.begin();
+         it != procPasses.end();
+         ++it)
+    {
+        ostringstream name;
+        name << (*it)->getProcName() << " (pass " << passNum++ << ")";
+        
+        passStages.push_back(profiler->addStage(name.str(), stage));
+    }
+}
+
 void MultiPassProc::render() {
+    int passIdx = 0;
     for (list<ProcInterface *>::iterator it = procPasses.begin();
          it != procPasses.end();
          ++it)
     {
+        if (profiler) profiler->beginStage(passStages[passIdx]);
+        
         (*it)->render();
+        
+        if (profiler) profiler->endStage(passStages[passIdx]);
+        
+        passIdx++;
     }
 }
 
@@ -158,6 +298,17 @@ void MultiPassProc::useTexture(GLuint id, GLuint useTexUnit, GLenum target) {
     }
 }
 
+void MultiPassProc::useInputTexture(int inputIdx, GLuint id, GLenum target) {
+    assert(inputIdx == 0);
+    
+    useTexture(id, getTextureUnit(), target);
+}
+
+void MultiPassProc::useInputChromaTextures(GLuint chromaTexId0, GLuint chromaTexId1) {
+    assert(firstProc);
+    firstProc->useInputChromaTextures(chromaTexId0, chromaTexId1);
+}
+
 GLuint MultiPassProc::getTextureUnit() const {
     assert(firstProc);
     return firstProc->getTextureUnit();
@@ -199,6 +350,38 @@ void MultiPassProc::getResultData(unsigned char *data) const {
     return lastProc->getResultData(data);
 }
 
+void MultiPassProc::startResultReadback(unsigned long tag) {
+    assert(lastProc);
+    lastProc->startResultReadback(tag);
+}
+
+void MultiPassProc::setReadbackROI(const ROI &roi) {
+    assert(lastProc);
+    lastProc->setReadbackROI(roi);
+}
+
+void MultiPassProc::setRenderROI(const ROI &roi) {
+    ROI passROI = roi;
+    
+    // each pass renders the region that the next pass reads from it
+    for (list<ProcInterface *>::reverse_iterator it = procPasses.rbegin();
+         it != procPasses.rend();
+         ++it)
+    {
+        (*it)->setRenderROI(passROI);
+        
+        list<ProcInterface *>::reverse_iterator prev = it;
+        if (++prev == procPasses.rend()) break;
+        
+        passROI = (*it)->getInputROI((*prev)->getOutFrameW(), (*prev)->getOutFrameH());
+    }
+}
+
+ROI MultiPassProc::getInputROI(int inW, int inH) const {
+    assert(firstProc);
+    return firstProc->getInputROI(inW, inH);
+}
+
 MemTransfer *MultiPassProc::getMemTransferObj() const {
     assert(lastProc);
     return lastProc->getMemTransferObj();
@@ -209,14 +392,98 @@ GLuint MultiPassProc::getInputTexId() const {
     return firstProc->getInputTexId();
 }
 
+GLuint MultiPassProc::getInputChromaTexId(int plane) const {
+    assert(firstProc);
+    return firstProc->getInputChromaTexId(plane);
+}
+
 GLuint MultiPassProc::getOutputTexId() const {
     assert(lastProc);
     return lastProc->getOutputTexId();
 }
 
+bool MultiPassProc::getCPUSupport() const {
+    for (list<ProcInterface *>::const_iterator it = procPasses.begin();
+         it != procPasses.end();
+         ++it)
+    {
+        if (!(*it)->getCPUSupport()) return false;
+    }
+    
+    return true;
+}
+
+void MultiPassProc::getFilterRadius(int &rx, int &ry) const {
+    rx = ry = 0;
+    
+    // each pass reads the output of the previous pass
+    for (list<ProcInterface *>::const_iterator it = procPasses.begin();
+         it != procPasses.end();
+         ++it)
+    {
+        int passRx, passRy;
+        (*it)->getFilterRadius(passRx, passRy);
+        rx += passRx;
+        ry += passRy;
+    }
+}
+
+void MultiPassProc::getCPUPasses(vector<ProcInterface *> &passes) {
+    for (list<ProcInterface *>::iterator it = procPasses.begin();
+         it != procPasses.end();
+         ++it)
+    {
+        (*it)->getCPUPasses(passes);
+    }
+}
+
+void MultiPassProc::prepareCPU(int inW, int inH) {
+    ProcInterface *prevProc = NULL;
+    
+    for (list<ProcInterface *>::iterator it = procPasses.begin();
+         it != procPasses.end();
+         ++it)
+    {
+        // subsequent passes get the previous pass' output frame size
+        if (!prevProc) {
+            (*it)->prepareCPU(inW, inH);
+        } else {
+            (*it)->prepareCPU(prevProc->getOutFrameW(), prevProc->getOutFrameH());
+        }
+        
+        prevProc = *it;
+    }
+    
+    cpuPassOutputs.resize(procPasses.size() - 1);
+}
+
+void MultiPassProc::processCPU(const vector<const CPUImage *> &inputs, CPUImage &output) {
+    vector<const CPUImage *> passInputs(inputs);
+    
+    int passIdx = 0;
+    for (list<ProcInterface *>::iterator it = procPasses.begin();
+         it != procPasses.end();
+         ++it)
+    {
+        if (profiler) profiler->beginStage(passStages[passIdx]);
+        
+        // the last pass writes the output, the other passes write the next pass' input
+        CPUImage &passOutput = *it == lastProc ? output : cpuPassOutputs[passIdx];
+        (*it)->processCPU(passInputs, passOutput);
+        passInputs.assign(1, &passOutput);
+        
+        if (profiler) profiler->endStage(passStages[passIdx]);
+        
+        passIdx++;
+    }
+}
+
 #pragma mark protected methods
 
 void MultiPassProc::multiPassInit() {
     firstProc = procPasses.front();
     lastProc = procPasses.back();
+    
+    profiler = NULL;
+    passStages.clear();
 }
\ No newline at end of file
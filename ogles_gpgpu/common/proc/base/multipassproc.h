@@ -15,8 +15,10 @@
 
 #include "../../common_includes.h"
 #include "procinterface.h"
+#include "../../cpu/cpuimage.h"
 
 #include <list>
+#include <vector>
 
 using namespace std;
 
@@ -54,9 +56,10 @@ public:
     
     /**
      * Insert external data into this processor. It will be used as input texture.
+     * <rowStride> is the number of bytes between rows in <data> (0 means tightly packed rows).
      * Note: init() must have been called with prepareForExternalInput = true for that.
      */
-    virtual void setExternalInputData(const unsigned char *data);
+    virtual void setExternalInputData(const unsigned char *data, int rowStride = 0);
     
     /**
      * Create a texture that is attached to the FBO and will contain the processing result.
@@ -64,6 +67,45 @@ public:
      */
     virtual void createFBOTex(bool genMipmap);
     
+    /**
+     * Take the output textures of the passes from texture pool <pool>. Each pass is
+     * rendered in its own step from <firstStep> on and its output is read by the next
+     * pass. The output of the last pass is read until step <lastStep> or gets an own
+     * texture if <keepOutput> is true.
+     */
+    virtual void setFBOTexPool(TexPool *pool, int firstStep, int lastStep, bool keepOutput);
+    
+    /**
+     * Set the pointer to the OpenGL context <glContext> for all passes. Must be set before init().
+     */
+    virtual void setGLContextPtr(void *glContext);
+    
+    /**
+     * Set the shader registry <registry> for all passes. Must be set before init().
+     */
+    virtual void setShaderRegistry(ShaderRegistry *registry);
+    
+    /**
+     * Set the shadow OpenGL state <state> for all passes.
+     */
+    virtual void setGLState(GLState *state);
+    
+    /**
+     * Set the number of frame slots to <num> for all passes. Must be set before init().
+     */
+    virtual void setNumFrameSlots(int num);
+    
+    /**
+     * Select frame slot <slot> for all passes and connect the passes' textures of
+     * this slot.
+     */
+    virtual void selectFrameSlot(int slot);
+    
+    /**
+     * Set the profiler <profiler> and register a sub-stage of stage <stage> for each pass.
+     */
+    virtual void setProfiler(Profiler *profiler, int stage);
+    
     /**
      * Render a result, i.e. run the shader on the input texture.
      * Abstract method.
@@ -80,6 +122,23 @@ public:
      */
     virtual void useTexture(GLuint id, GLuint useTexUnit = 1, GLenum target = GL_TEXTURE_2D);
     
+    /**
+     * Return the number of input textures that this processor needs.
+     */
+    virtual int getNumInputs() const { return 1; }
+    
+    /**
+     * Use texture id <id> with texture target <target> as input number <inputIdx>
+     * of the first pass. Multipass processors only have input 0.
+     */
+    virtual void useInputTexture(int inputIdx, GLuint id, GLenum target = GL_TEXTURE_2D);
+    
+    /**
+     * Use the chroma plane textures <chromaTexId0> and <chromaTexId1> for YUV input
+     * of the first pass.
+     */
+    virtual void useInputChromaTextures(GLuint chromaTexId0, GLuint chromaTexId1);
+    
     /**
      * Return used texture unit.
      */
@@ -127,6 +186,28 @@ public:
      */
     virtual void getResultData(unsigned char *data) const;
     
+    /**
+     * Start an asynchronous readback of the result data from the FBO, tagged with
+     * <tag>. A later getResultData() call returns the data.
+     */
+    virtual void startResultReadback(unsigned long tag);
+    
+    /**
+     * Restrict the result data of the last pass to region <roi> of the output frame.
+     */
+    virtual void setReadbackROI(const ROI &roi);
+    
+    /**
+     * Restrict rendering of the last pass to region <roi> of the output frame. The
+     * previous passes render the regions that the following passes read.
+     */
+    virtual void setRenderROI(const ROI &roi);
+    
+    /**
+     * Return the region of an input frame of size <inW>x<inH> that the first pass reads.
+     */
+    virtual ROI getInputROI(int inW, int inH) const;
+    
     /**
      * Return pointer to MemTransfer object of this processor.
      */
@@ -137,15 +218,77 @@ public:
      */
     virtual GLuint getInputTexId() const;
     
+    /**
+     * Return the texture id of chroma plane <plane> of YUV external input of the first pass.
+     */
+    virtual GLuint getInputChromaTexId(int plane) const;
+    
     /**
      * Return the output texture id (= texture that is attached to the FBO).
      */
     virtual GLuint getOutputTexId() const;
 
     /**
-     * Get number of passes for this multipass processor.
+     * Get number of render passes for this multipass processor.
+     */
+    virtual int getNumPasses() const;
+    
+    /**
+     * Multipass processors are no point operations, so they can not be fused.
+     */
+    virtual bool getIsPointOp() const { return false; }
+    
+    /**
+     * Returns PACKED_GRAY_KEEP if all passes can read and write packed grayscale images.
+     */
+    virtual PackedGraySupport getPackedGraySupport() const;
+    
+    /**
+     * Write packed grayscale output in all passes: <packed>. Must be set before init().
+     */
+    virtual void setPackedGray(bool packed);
+    
+    /**
+     * Returns true if the output of the last pass is packed grayscale.
+     */
+    virtual bool getPackedGray() const;
+    
+    /**
+     * Multipass processors need all channels of their input.
      */
-    size_t getNumPasses() const { return procPasses.size(); }
+    virtual bool getReadsLumaOnly() const { return false; }
+    
+    /**
+     * Returns true if all passes can be executed by the CPU backend.
+     */
+    virtual bool getCPUSupport() const;
+    
+    /**
+     * Not implemented for multipass processors (see getCPUPasses())!
+     */
+    virtual RenderOrientation getCPURenderOrientation() const { return RenderOrientationNone; }
+    
+    /**
+     * Get the filter radius of all passes together.
+     */
+    virtual void getFilterRadius(int &rx, int &ry) const;
+    
+    /**
+     * Append the passes to <passes>.
+     */
+    virtual void getCPUPasses(vector<ProcInterface *> &passes);
+    
+    /**
+     * Prepare all passes for execution by the CPU backend with input frames of size
+     * <inW>x<inH>.
+     */
+    virtual void prepareCPU(int inW, int inH);
+    
+    /**
+     * Process the input image <inputs> in all passes on the CPU and write the result of
+     * the last pass to <output>.
+     */
+    virtual void processCPU(const vector<const CPUImage *> &inputs, CPUImage &output);
     
     /**
      * Return te list of processor instances of each pass of this multipass processor.
@@ -163,6 +306,11 @@ protected:
     
     ProcInterface *firstProc;
     ProcInterface *lastProc;
+    
+    Profiler *profiler;         // weak ref. may be NULL
+    vector<int> passStages;     // profiler stage id for each pass
+    
+    vector<CPUImage> cpuPassOutputs;    // outputs of all passes but the last one on the CPU
 };
     
 }
@@ -9,6 +9,9 @@
 
 #include "procbase.h"
 
+#include "../../cpu/cpukernels.h"
+
+#include <algorithm>
 #include <string>
 
 using namespace ogles_gpgpu;
@@ -57,11 +60,23 @@ ProcBase::ProcBase() {
 	shader = NULL;
     fbo = NULL;
     willDownscale = false;
+    glContextPtr = NULL;
+    shaderRegistry = NULL;
+    glState = &untrackedGLState;
+    numFrameSlots = 1;
+    externalInput = false;
+    inputDataFmt = GL_RGBA;
+    inputChromaTexIds[0] = inputChromaTexIds[1] = 0;
     
     procParamOutW = procParamOutH = 0;
     procParamOutScale = 1.0f;
     
     renderOrientation = RenderOrientationStd;
+    
+    packedGray = false;
+    
+    renderROI.x = renderROI.y = renderROI.w = renderROI.h = 0;
+    readbackROI = renderROI;
 }
 
 ProcBase::~ProcBase() {
@@ -76,10 +91,7 @@ void ProcBase::cleanup() {
         outFrameW = outFrameH = 0;
 	}
     
-    if (shader) {
-        delete shader;
-        shader = NULL;
-    }
+    releaseShader();
 }
 
 void ProcBase::printInfo() {
@@ -92,9 +104,61 @@ void ProcBase::printInfo() {
               willDownscale);
 }
 
+void ProcBase::useInputTexture(int inputIdx, GLuint id, GLenum target) {
+    assert(inputIdx == 0);
+
+    useTexture(id, texUnit, target);
+}
+
+void ProcBase::setPackedGray(bool packed) {
+    assert(!fbo && (!packed || getPackedGraySupport() != PACKED_GRAY_NONE));
+    
+    packedGray = packed;
+}
+
 void ProcBase::getResultData(unsigned char *data) const {
     assert(fbo != NULL);
-    fbo->readBuffer(data);
+    
+    // read the texels that hold the readback region
+    int tx, ty, tw, th;
+    getROITexels(readbackROI, tx, ty, tw, th);
+    fbo->getMemTransfer()->setOutputReadRect(tx, ty, tw, th);
+    
+    // rows of packed output are padded to whole texels if they do not fill the last
+    // texel, and the region might start inside a texel. otherwise the texture data
+    // can be copied as it is
+    int rowLen = getResultRowLen(readbackROI.w > 0 ? readbackROI.w : outFrameW);
+    int rowOffset = readbackROI.w > 0 ? getResultRowLen(readbackROI.x) - tx * 4 : 0;
+    int texRowLen = tw * 4;
+    
+    if (rowLen == texRowLen) {
+        assert(rowOffset == 0);
+        fbo->readBuffer(data);
+        return;
+    }
+    
+    packedResultBuf.resize(texRowLen * th);
+    fbo->readBuffer(&packedResultBuf[0]);
+    
+    for (int y = 0; y < th; y++) {
+        memcpy(data + y * rowLen, &packedResultBuf[y * texRowLen + rowOffset], rowLen);
+    }
+}
+
+void ProcBase::startResultReadback(unsigned long tag) {
+    assert(fbo != NULL);
+    
+    int tx, ty, tw, th;
+    getROITexels(readbackROI, tx, ty, tw, th);
+    fbo->getMemTransfer()->setOutputReadRect(tx, ty, tw, th);
+    
+    fbo->startReadback(tag);
+}
+
+ROI ProcBase::getInputROI(int inW, int inH) const {
+    ROI roi = { 0, 0, inW, inH };
+    
+    return roi;
 }
 
 MemTransfer *ProcBase::getMemTransferObj() const {
@@ -103,6 +167,10 @@ MemTransfer *ProcBase::getMemTransferObj() const {
     return fbo->getMemTransfer();
 }
 
+GLuint ProcBase::getInputChromaTexId(int plane) const {
+    return (externalInput && fbo) ? fbo->getMemTransfer()->getInputChromaTexId(plane) : 0;
+}
+
 GLuint ProcBase::getOutputTexId() const {
     assert(fbo != NULL);
     
@@ -112,11 +180,20 @@ GLuint ProcBase::getOutputTexId() const {
 void ProcBase::createFBOTex(bool genMipmap) {
     assert(fbo != NULL);
     
-    fbo->createAttachedTex(outFrameW, outFrameH, genMipmap);
+    fbo->createAttachedTex(getOutTexW(), outFrameH, genMipmap);
     
     // update frame size, because it might be set to a POT size because of mipmapping
-    outFrameW = fbo->getTexWidth();
-    outFrameH = fbo->getTexHeight();
+    // (packed grayscale output is never mipmapped and keeps its size in pixels)
+    if (!packedGray) {
+        outFrameW = fbo->getTexWidth();
+        outFrameH = fbo->getTexHeight();
+    }
+}
+
+void ProcBase::setFBOTexPool(TexPool *pool, int firstStep, int lastStep, bool keepOutput) {
+    assert(fbo != NULL);
+    
+    fbo->setTexPool(keepOutput ? NULL : pool, firstStep, lastStep);
 }
 
 int ProcBase::reinit(int inW, int inH, bool prepareForExternalInput) {
@@ -126,8 +203,10 @@ int ProcBase::reinit(int inW, int inH, bool prepareForExternalInput) {
     
     fbo->destroyAttachedTex();  // needs to be recreated later!
     
+    externalInput = prepareForExternalInput;
+    
     if (prepareForExternalInput) {    // recreate input
-        useTexture(fbo->getMemTransfer()->prepareInput(inFrameW, inFrameH, inputDataFmt));
+        prepareExternalInput();
     }
     
     OG_LOGINF(getProcName(), "reinit with input size %dx%d, output size %dx%d, downscale %d",
@@ -144,9 +223,10 @@ void ProcBase::baseInit(int inW, int inH, unsigned int order, bool prepareForExt
     setInOutFrameSizes(inW, inH, outW, outH, scaleFactor);
     
     // prepare for external input data
+    externalInput = prepareForExternalInput;
+    
     if (prepareForExternalInput) {
-        assert(fbo != NULL);
-        useTexture(fbo->getMemTransfer()->prepareInput(inW, inH, inputDataFmt));
+        prepareExternalInput();
         OG_LOGINF(getProcName(), "prepared for external input");
     }
     
@@ -154,10 +234,61 @@ void ProcBase::baseInit(int inW, int inH, unsigned int order, bool prepareForExt
               inFrameW, inFrameH, outFrameW, outFrameH, willDownscale);
 }
 
-void ProcBase::setExternalInputData(const unsigned char *data) {
+void ProcBase::selectFrameSlot(int slot) {
+    if (!fbo) return;   // nothing to select
+    
+    fbo->selectSlot(slot);
+    
+    if (externalInput) {    // use the input textures of this slot
+        texId = fbo->getMemTransfer()->getInputTexId();
+        inputChromaTexIds[0] = fbo->getMemTransfer()->getInputChromaTexId(0);
+        inputChromaTexIds[1] = fbo->getMemTransfer()->getInputChromaTexId(1);
+    }
+}
+
+void ProcBase::setExternalInputData(const unsigned char *data, int rowStride) {
+    fbo->getMemTransfer()->setInputRowStride(rowStride);
     fbo->getMemTransfer()->toGPU(data);
 }
 
+void ProcBase::prepareCPU(int inW, int inH) {
+    setInOutFrameSizes(inW, inH, procParamOutW, procParamOutH, procParamOutScale);
+    
+    OG_LOGINF(getProcName(), "prepared for the CPU with input size %dx%d, output size %dx%d",
+              inFrameW, inFrameH, outFrameW, outFrameH);
+}
+
+void ProcBase::processCPU(const vector<const CPUImage *> &inputs, CPUImage &output) {
+    assert((int)inputs.size() == getNumInputs());
+    
+    // an output that holds a row band of the output frame is kept (see CPUTileExecutor)
+    if (output.getWidth() != outFrameW || output.getHeight() != outFrameH) {
+        output.resize(outFrameW, outFrameH);
+    }
+    
+    // the fullscreen quad samples each input with the output size and orientation
+    vector<const CPUImage *> renderInputs(inputs);
+    
+    for (size_t i = 0; i < inputs.size(); i++) {
+        if (inputs[i]->getWidth() != outFrameW || inputs[i]->getHeight() != outFrameH
+            || getCPURenderOrientation() != RenderOrientationStd)
+        {
+            assert(output.getNumRows() == outFrameH);
+            
+            cpuResampledInputs.resize(inputs.size());
+            cpuResampledInputs[i].resize(outFrameW, outFrameH);
+            CPUKernels::resample(*inputs[i], cpuResampledInputs[i], getCPURenderOrientation());
+            renderInputs[i] = &cpuResampledInputs[i];
+        }
+    }
+    
+    renderCPU(renderInputs, output);
+}
+
+void ProcBase::renderCPU(const vector<const CPUImage *> &inputs, CPUImage &output) {
+    OG_LOGERR(getProcName(), "processing on the CPU is not supported");
+}
+
 void ProcBase::setInOutFrameSizes(int inW, int inH, int outW, int outH, float scaleFactor) {
     inFrameW = inW;
     inFrameH = inH;
@@ -176,18 +307,61 @@ void ProcBase::setInOutFrameSizes(int inW, int inH, int outW, int outH, float sc
     outFrameH = outH;
     
     willDownscale = (outFrameW < inFrameW || outFrameH < inFrameH);
+    
+    // the regions refer to the previous frame size
+    renderROI.w = readbackROI.w = 0;
+}
+
+void ProcBase::getROITexels(const ROI &roi, int &tx, int &ty, int &tw, int &th) const {
+    int texW = getOutTexW();
+    
+    if (roi.w <= 0 || roi.h <= 0) {
+        tx = ty = 0;
+        tw = texW;
+        th = outFrameH;
+        return;
+    }
+    
+    int px = getOutTexelPx();
+    
+    tx = roi.x / px;
+    ty = roi.y;
+    tw = min(texW, (roi.x + roi.w + px - 1) / px) - tx;
+    th = roi.h;
+}
+
+bool ProcBase::getKeepsPixelRows() const {
+    // vertical flipping keeps the pixel order in the rows
+    return procParamOutW <= 0 && procParamOutH <= 0 && procParamOutScale == 1.0f
+        && (renderOrientation == RenderOrientationStd || renderOrientation == RenderOrientationFlipped);
+}
+
+void ProcBase::prepareExternalInput() {
+    assert(fbo != NULL);
+    
+    // prepare an input texture for each frame slot
+    int prevSlot = fbo->getSelectedSlot();
+    
+    for (int slot = 0; slot < fbo->getNumSlots(); slot++) {
+        fbo->selectSlot(slot);
+        fbo->getMemTransfer()->prepareInput(inFrameW, inFrameH, inputDataFmt);
+    }
+    
+    fbo->selectSlot(prevSlot);
+    
+    useTexture(fbo->getMemTransfer()->getInputTexId());
 }
 
 void ProcBase::createFBO() {
     assert(fbo == NULL);
     
-    fbo = new FBO();
+    fbo = new FBO(numFrameSlots, glContextPtr);
     fbo->setGLTexUnit(1);
 }
 
 void ProcBase::createShader(const char *vShSrc, const char *fShSrc, GLenum target) {
 	if (shader) {	// already compiled,
-		if (texTarget != target) delete shader;	 // change in texture target -> recreate!
+		if (texTarget != target) releaseShader();	 // change in texture target -> recreate!
 		else return;	// no change -> do nothing
 	}
 	
@@ -210,10 +384,30 @@ void ProcBase::createShader(const char *vShSrc, const char *fShSrc, GLenum targe
 	}
 #endif
     
-    shader = new Shader();
-    bool compiled = shader->buildFromSrc(vShSrc, fSrcStr.c_str());
+    if (shaderRegistry) {   // get a shared program
+        shader = shaderRegistry->acquire(vShSrc, fSrcStr.c_str(), target);
+    } else {
+        shader = new Shader();
+        
+        if (!shader->buildFromSrc(vShSrc, fSrcStr.c_str())) {
+            delete shader;
+            shader = NULL;
+        }
+    }
     
-    assert(compiled);
+    assert(shader);
     
     OG_LOGINF(getProcName(), "shader compiled successfully");
+}
+
+void ProcBase::releaseShader() {
+    if (!shader) return;
+    
+    if (shaderRegistry) {
+        shaderRegistry->release(shader);
+    } else {
+        delete shader;
+    }
+    
+    shader = NULL;
 }
\ No newline at end of file
@@ -18,7 +18,14 @@
 
 #include "../../gl/fbo.h"
 #include "../../gl/shader.h"
+#include "../../gl/shaderregistry.h"
+#include "../../gl/glstate.h"
 #include "../../gl/memtransfer.h"
+#include "../../cpu/cpuimage.h"
+
+#include <vector>
+
+using namespace std;
 
 #define OGLES_GPGPU_QUAD_VERTICES 				4
 #define OGLES_GPGPU_QUAD_COORDS_PER_VERTEX      3
@@ -62,9 +69,10 @@ public:
     
     /**
      * Insert external data into this processor. It will be used as input texture.
+     * <rowStride> is the number of bytes between rows in <data> (0 means tightly packed rows).
      * Note: init() must have been called with prepareForExternalInput = true for that.
      */
-    virtual void setExternalInputData(const unsigned char *data);
+    virtual void setExternalInputData(const unsigned char *data, int rowStride = 0);
     
     /**
      * Create a texture that is attached to the FBO and will contain the processing result.
@@ -72,11 +80,89 @@ public:
      */
     virtual void createFBOTex(bool genMipmap);
     
+    /**
+     * Take the output texture from texture pool <pool> in the following createFBOTex()
+     * call, unless <keepOutput> is true. The output is written in step <firstStep> and
+     * read until step <lastStep>.
+     */
+    virtual void setFBOTexPool(TexPool *pool, int firstStep, int lastStep, bool keepOutput);
+    
+    /**
+     * Return the number of render passes of this processor.
+     */
+    virtual int getNumPasses() const { return 1; }
+    
+    /**
+     * Returns true if this processor is a point operation that can be fused with
+     * other point operations. Not the case by default.
+     */
+    virtual bool getIsPointOp() const { return false; }
+    
+    /**
+     * Return the packed grayscale support of this processor. Not supported by default.
+     */
+    virtual PackedGraySupport getPackedGraySupport() const { return PACKED_GRAY_NONE; }
+    
+    /**
+     * Write packed grayscale output: <packed>. Must be set before init().
+     */
+    virtual void setPackedGray(bool packed);
+    
+    /**
+     * Returns true if the output is packed grayscale.
+     */
+    virtual bool getPackedGray() const { return packedGray; }
+    
+    /**
+     * Set the pointer to the OpenGL context <glContext>. Must be set before init().
+     */
+    virtual void setGLContextPtr(void *glContext) { assert(!fbo); glContextPtr = glContext; }
+    
+    /**
+     * Set the shader registry <registry> from which the shader is acquired. Must be set
+     * before init().
+     */
+    virtual void setShaderRegistry(ShaderRegistry *registry) { assert(!shader); shaderRegistry = registry; }
+    
+    /**
+     * Set the shadow OpenGL state <state> that is used in render(). NULL sets the
+     * processor's own untracked state.
+     */
+    virtual void setGLState(GLState *state) { glState = state ? state : &untrackedGLState; }
+    
+    /**
+     * Set the number of frame slots to <num>. Must be set before init().
+     */
+    virtual void setNumFrameSlots(int num) { assert(num > 0 && !fbo); numFrameSlots = num; }
+    
+    /**
+     * Select frame slot <slot> for the following render() call and output getter
+     * methods.
+     */
+    virtual void selectFrameSlot(int slot);
+    
+    /**
+     * Set the profiler. Not needed for single pass processors, because their
+     * render() call is measured by the caller.
+     */
+    virtual void setProfiler(Profiler *profiler, int stage) { }
+    
     /**
      * Print some information about the processor's setup.
      */
     virtual void printInfo();
     
+    /**
+     * Return the number of input textures that this processor needs.
+     */
+    virtual int getNumInputs() const { return 1; }
+
+    /**
+     * Use texture id <id> with texture target <target> as input number <inputIdx>.
+     * Single input processors only have input 0.
+     */
+    virtual void useInputTexture(int inputIdx, GLuint id, GLenum target = GL_TEXTURE_2D);
+
     /**
      * Return used texture unit.
      */
@@ -118,10 +204,33 @@ public:
     virtual bool getWillDownscale() const { return willDownscale; }
     
     /**
-     * Return the result data from the FBO.
+     * Return the result data from the FBO. Packed grayscale output is returned as one
+     * byte per pixel.
      */
     virtual void getResultData(unsigned char *data) const;
     
+    /**
+     * Start an asynchronous readback of the result data from the FBO, tagged with
+     * <tag>. A later getResultData() call returns the data.
+     */
+    virtual void startResultReadback(unsigned long tag);
+    
+    /**
+     * Restrict getResultData() and startResultReadback() to region <roi> of the
+     * output frame.
+     */
+    virtual void setReadbackROI(const ROI &roi) { readbackROI = Tools::clipROI(roi, outFrameW, outFrameH); }
+    
+    /**
+     * Restrict rendering to region <roi> of the output frame.
+     */
+    virtual void setRenderROI(const ROI &roi) { renderROI = Tools::clipROI(roi, outFrameW, outFrameH); }
+    
+    /**
+     * Return the whole input frame of size <inW>x<inH> by default.
+     */
+    virtual ROI getInputROI(int inW, int inH) const;
+    
     /**
      * Return pointer to MemTransfer object of this processor.
      */
@@ -132,11 +241,61 @@ public:
      */
     virtual GLuint getInputTexId() const { return texId; }
     
+    /**
+     * Return the texture id of chroma plane <plane> of YUV external input (0 if there
+     * is no such plane).
+     */
+    virtual GLuint getInputChromaTexId(int plane) const;
+    
+    /**
+     * Use the chroma plane textures <chromaTexId0> and <chromaTexId1> for YUV input.
+     */
+    virtual void useInputChromaTextures(GLuint chromaTexId0, GLuint chromaTexId1) { inputChromaTexIds[0] = chromaTexId0; inputChromaTexIds[1] = chromaTexId1; }
+    
+    /**
+     * Most processors need all channels of their input.
+     */
+    virtual bool getReadsLumaOnly() const { return false; }
+    
     /**
      * Return the output texture id (= texture that is attached to the FBO).
      */
     virtual GLuint getOutputTexId() const;
     
+    /**
+     * Not supported by default.
+     */
+    virtual bool getCPUSupport() const { return false; }
+    
+    /**
+     * The output render orientation by default.
+     */
+    virtual RenderOrientation getCPURenderOrientation() const { return renderOrientation; }
+    
+    /**
+     * Point operation by default.
+     */
+    virtual void getFilterRadius(int &rx, int &ry) const { rx = ry = 0; }
+    
+    /**
+     * A single pass processor executes its only pass itself.
+     */
+    virtual void getCPUPasses(vector<ProcInterface *> &passes) { passes.push_back(this); }
+    
+    /**
+     * Prepare the processor for execution by the CPU backend with input frames of
+     * size <inW>x<inH>.
+     */
+    virtual void prepareCPU(int inW, int inH);
+    
+    /**
+     * Process the input images <inputs> on the CPU and write the result to <output>.
+     * Inputs whose size differs from the output size are scaled (and all inputs are
+     * reoriented for a render orientation other than RenderOrientationStd) like the
+     * fullscreen quad samples them, then renderCPU() is called.
+     */
+    virtual void processCPU(const vector<const CPUImage *> &inputs, CPUImage &output);
+    
 protected:
     /**
      * Common initializations with input size <inW>x<inH>, pipeline processing <order>, output size <outW>x<outH> and
@@ -151,6 +310,12 @@ protected:
      */
     virtual void setInOutFrameSizes(int inW, int inH, int outW, int outH, float scaleFactor);
     
+    /**
+     * Prepare the input textures for external input data of size <inFrameW>x<inFrameH>
+     * for all frame slots and use the input texture of the selected slot.
+     */
+    virtual void prepareExternalInput();
+    
     /**
      * Create an FBO for this processor. This will contain the result after rendering in its attached texture.
      */
@@ -163,6 +328,48 @@ protected:
      */
     virtual void createShader(const char *vShSrc, const char *fShSrc, GLenum target);
     
+    /**
+     * Give back the shader to the shader registry or delete it if no registry is used.
+     */
+    void releaseShader();
+    
+    /**
+     * Return the width of the output texture in texels. Packed grayscale output
+     * needs one texel for 4 pixels.
+     */
+    virtual int getOutTexW() const { return packedGray ? (outFrameW + 3) / 4 : outFrameW; }
+    
+    /**
+     * Return the number of pixels in a row that one texel of the output texture
+     * holds. Packed grayscale output holds 4 pixels per texel.
+     */
+    virtual int getOutTexelPx() const { return packedGray ? 4 : 1; }
+    
+    /**
+     * Return the number of bytes of <w> pixels of a row of the result data (see
+     * getResultData()).
+     */
+    virtual int getResultRowLen(int w) const { return packedGray ? w : w * 4; }
+    
+    /**
+     * Get the texels of the output texture at <tx>, <ty> with size <tw>x<th> that
+     * hold the pixels of region <roi> (the whole texture for roi.w <= 0).
+     */
+    void getROITexels(const ROI &roi, int &tx, int &ty, int &tw, int &th) const;
+    
+    /**
+     * Process the input images <inputs>, which have the output frame size, on the CPU
+     * and write the result to <output>, which has the output frame size. This is what
+     * the fragment shader does in render(). Not supported by default.
+     */
+    virtual void renderCPU(const vector<const CPUImage *> &inputs, CPUImage &output);
+    
+    /**
+     * Returns true if the output has the size of the input and the same horizontal
+     * pixel order, as needed for PACKED_GRAY_KEEP support.
+     */
+    bool getKeepsPixelRows() const;
+    
     
 	static const GLfloat quadTexCoordsStd[];                // default quad texture coordinates
     static const GLfloat quadTexCoordsStdMirrored[];        // default quad texture coordinates (mirrored)
@@ -172,10 +379,19 @@ protected:
 	static const GLfloat quadVertices[];                    // default quad vertices
     
     FBO *fbo;       // strong ref.!
-	Shader *shader;	// strong ref.!
+	Shader *shader;	// strong ref. or shared ref. from <shaderRegistry>!
     
     unsigned int orderNum;  // position of this processor in the pipeline
     
+    void *glContextPtr;     // pointer to OpenGL context (platform specific type), weak ref. may be NULL
+    ShaderRegistry *shaderRegistry; // registry of shared shader programs, weak ref. may be NULL
+    
+    GLState *glState;           // shadow OpenGL state for rendering, weak ref.
+    GLState untrackedGLState;   // own state without tracking that is used by default
+    
+    int numFrameSlots;      // number of frame slots (frame ring depth)
+    bool externalInput;     // prepared for external input?
+    
 	GLuint texId;       // input texture id
     GLuint texUnit;     // input texture unit (glActiveTexture())
     GLenum texTarget;   // input texture target
@@ -191,12 +407,21 @@ protected:
     bool willDownscale; // is true if output size < input size.
     
     GLenum inputDataFmt;    // input pixel data format
+    GLuint inputChromaTexIds[2];    // chroma plane textures for YUV input (0 if not used)
 
 	int inFrameW;   // input frame width
 	int inFrameH;   // input frame height
     
 	int outFrameW;  // output frame width
 	int outFrameH;  // output frame height
+    
+    bool packedGray;    // output (and input for PACKED_GRAY_KEEP) is packed grayscale?
+    mutable vector<unsigned char> packedResultBuf;  // padded rows of packed output or texels of the readback region for getResultData()
+    
+    ROI renderROI;      // rendered region of the output frame (w = 0 for the whole frame)
+    ROI readbackROI;    // region of the output frame that getResultData() returns (w = 0 for the whole frame)
+    
+    vector<CPUImage> cpuResampledInputs;    // scaled or reoriented inputs for renderCPU()
 };
 
 }
@@ -17,7 +17,27 @@
 
 #include "../../gl/memtransfer.h"
 
+#include <vector>
+
+using namespace std;
+
 namespace ogles_gpgpu {
+
+class Profiler;
+class TexPool;
+class CPUImage;
+class ShaderRegistry;
+class GLState;
+
+/**
+ * Packed grayscale support of a processor. A packed grayscale image stores 4
+ * horizontally adjacent gray pixels in the RGBA channels of one texel.
+ */
+typedef enum {
+    PACKED_GRAY_NONE = 0,   // no packed grayscale support
+    PACKED_GRAY_PACK,       // writes packed grayscale output from unpacked input (e.g. grayscale conversion)
+    PACKED_GRAY_KEEP        // reads and writes packed grayscale images of the same size
+} PackedGraySupport;
     
 /**
  * GPGPU processor interface
@@ -47,15 +67,19 @@ public:
     virtual void cleanup() = 0;
     
     /**
-     * Set pixel data format for input data to <fmt>. Must be set before init() / reinit().
+     * Set pixel data format for input data to <fmt>. Input in one of the YUV formats
+     * (see InputYUVFormat) is converted to RGBA in the shader that reads input 0. Core
+     * also sets the format for processors that read the pipeline input without being
+     * the first processor. Must be set before init() / reinit().
      */
     virtual void setExternalInputDataFormat(GLenum fmt) = 0;
     
     /**
      * Insert external data into this processor. It will be used as input texture.
+     * <rowStride> is the number of bytes between rows in <data> (0 means tightly packed rows).
      * Note: init() must have been called with prepareForExternalInput = true for that.
      */
-    virtual void setExternalInputData(const unsigned char *data) = 0;
+    virtual void setExternalInputData(const unsigned char *data, int rowStride = 0) = 0;
     
     /**
      * Create a texture that is attached to the FBO and will contain the processing result.
@@ -63,6 +87,95 @@ public:
      */
     virtual void createFBOTex(bool genMipmap) = 0;
     
+    /**
+     * Take the output textures from texture pool <pool> (weak ref.) in the following
+     * createFBOTex() call. The render passes of the processor are rendered in the
+     * steps from <firstStep> on and the output of the last pass is read until step
+     * <lastStep> (see TexPool). If <keepOutput> is true, the last pass gets an own output
+     * texture per frame slot, so that its output can be read back. Set <pool> to NULL
+     * to create own textures for all passes.
+     */
+    virtual void setFBOTexPool(TexPool *pool, int firstStep, int lastStep, bool keepOutput) = 0;
+    
+    /**
+     * Return the number of render passes of this processor (1 for most processors).
+     */
+    virtual int getNumPasses() const = 0;
+    
+    /**
+     * Returns true if this processor is a single pass point operation (each output
+     * pixel only depends on the input pixel at the same position) that can be fused
+     * with other point operations into one shader (see Core::setUseShaderFusion()).
+     * Only processors that are derived from FilterProcBase may return true.
+     */
+    virtual bool getIsPointOp() const = 0;
+    
+    /**
+     * Return the packed grayscale support of this processor with its current settings
+     * (see Core::setUsePackedGray()).
+     */
+    virtual PackedGraySupport getPackedGraySupport() const = 0;
+    
+    /**
+     * Write packed grayscale output: <packed>. Processors with PACKED_GRAY_KEEP
+     * support then also expect packed grayscale input. The output frame size stays the
+     * size in pixels. Must be set before init().
+     */
+    virtual void setPackedGray(bool packed) = 0;
+    
+    /**
+     * Returns true if the output is packed grayscale. getResultData() then returns
+     * one byte per pixel.
+     */
+    virtual bool getPackedGray() const = 0;
+    
+    /**
+     * Returns true if this processor only needs the luminance of input 0 (e.g. a
+     * grayscale conversion), so that only the Y plane of YUV input must be uploaded.
+     */
+    virtual bool getReadsLumaOnly() const = 0;
+    
+    /**
+     * Set the pointer to the OpenGL context <glContext> (platform specific type) in
+     * which the processor will be used. It is passed to the processor's MemTransfer
+     * objects (needed by some platform optimizations). Must be set before init().
+     */
+    virtual void setGLContextPtr(void *glContext) = 0;
+    
+    /**
+     * Set the shader registry <registry> from which the processor gets its shader
+     * programs (may be NULL, then each processor builds its own programs). Must be set
+     * before init().
+     */
+    virtual void setShaderRegistry(ShaderRegistry *registry) = 0;
+    
+    /**
+     * Set the shadow OpenGL state <state> through which the processor changes the
+     * OpenGL state in render() (may be NULL, then all calls are issued).
+     */
+    virtual void setGLState(GLState *state) = 0;
+    
+    /**
+     * Set the number of frame slots to <num> (see Core::setFrameRingDepth()).
+     * Each frame slot has its own output texture and FBO and, if prepared for
+     * external input, its own input texture. Must be set before init().
+     */
+    virtual void setNumFrameSlots(int num) = 0;
+    
+    /**
+     * Select frame slot <slot> for the following render() call and output getter
+     * methods. If prepared for external input, the input texture of this slot will
+     * be used as input texture.
+     */
+    virtual void selectFrameSlot(int slot) = 0;
+    
+    /**
+     * Set the profiler <profiler> (weak ref) and the id of the profiler stage <stage>
+     * that measures this processor's render() call. Processors that consist of
+     * several render calls can register sub-stages and measure them separately.
+     */
+    virtual void setProfiler(Profiler *profiler, int stage) = 0;
+    
     /**
      * Render a result, i.e. run the shader on the input texture.
      * Abstract method.
@@ -84,6 +197,24 @@ public:
      */
     virtual void useTexture(GLuint id, GLuint useTexUnit = 1, GLenum target = GL_TEXTURE_2D) = 0;
 
+    /**
+     * Return the number of input textures that this processor needs (1 for most processors).
+     */
+    virtual int getNumInputs() const = 0;
+
+    /**
+     * Use texture id <id> with texture target <target> as input number <inputIdx>
+     * (0 to getNumInputs() - 1). Input 0 is the input that is set with useTexture().
+     */
+    virtual void useInputTexture(int inputIdx, GLuint id, GLenum target = GL_TEXTURE_2D) = 0;
+    
+    /**
+     * Use the chroma plane textures <chromaTexId0> and <chromaTexId1> (see
+     * MemTransfer::getInputChromaTexId()) together with input texture 0 if the input
+     * data format is a YUV format (see setExternalInputDataFormat()).
+     */
+    virtual void useInputChromaTextures(GLuint chromaTexId0, GLuint chromaTexId1) = 0;
+
     /**
      * Return used texture unit.
      */
@@ -125,10 +256,39 @@ public:
     virtual bool getWillDownscale() const = 0;
     
     /**
-     * Return the result data from the FBO.
+     * Return the result data from the FBO. <data> must hold getOutFrameW() * getOutFrameH()
+     * bytes per channel (4 channels, or 1 channel for packed grayscale output).
      */
     virtual void getResultData(unsigned char *data) const = 0;
     
+    /**
+     * Start an asynchronous readback of the result data from the FBO, tagged with
+     * <tag>. A later getResultData() call returns the data.
+     */
+    virtual void startResultReadback(unsigned long tag) = 0;
+    
+    /**
+     * Restrict getResultData() and startResultReadback() to region <roi> of the output
+     * frame (see ROI). getResultData() then writes the rows of this region one after
+     * another (roi.w * 4 bytes per row, or roi.w bytes for packed grayscale output).
+     * A region with roi.w <= 0 reads the whole frame (default).
+     */
+    virtual void setReadbackROI(const ROI &roi) = 0;
+    
+    /**
+     * Restrict rendering to region <roi> of the output frame (see ROI). Only the
+     * texels that hold pixels of this region are rendered, the rest of the output
+     * texture is undefined. A region with roi.w <= 0 renders the whole frame (default).
+     */
+    virtual void setRenderROI(const ROI &roi) = 0;
+    
+    /**
+     * Return the region of an input frame of size <inW>x<inH> that render() reads to
+     * render the region that was set with setRenderROI(). It includes the filter radius
+     * (see getFilterRadius()) and the pixels that are interpolated if the input is scaled.
+     */
+    virtual ROI getInputROI(int inW, int inH) const = 0;
+    
     /**
      * Return pointer to MemTransfer object of this processor.
      */
@@ -139,10 +299,55 @@ public:
      */
     virtual GLuint getInputTexId() const = 0;
     
+    /**
+     * Return the texture id of chroma plane <plane> of YUV external input (0 if there
+     * is no such plane, see MemTransfer::getInputChromaTexId()).
+     */
+    virtual GLuint getInputChromaTexId(int plane) const = 0;
+    
     /**
      * Return the output texture id (= texture that is attached to the FBO).
      */
     virtual GLuint getOutputTexId() const = 0;
+    
+    /**
+     * Returns true if this processor can be executed by the CPU backend (see
+     * Core::setBackend()).
+     */
+    virtual bool getCPUSupport() const = 0;
+    
+    /**
+     * Get the render orientation of the CPU backend, which is the output render
+     * orientation unless the processor renders differently on the CPU.
+     */
+    virtual RenderOrientation getCPURenderOrientation() const = 0;
+    
+    /**
+     * Get the number of pixels <rx> and <ry> around an output pixel in x and y
+     * direction that the processor reads from its input (e.g. 3 in y direction for
+     * the vertical pass of the Gauss filter). Point operations read no surrounding
+     * pixels.
+     */
+    virtual void getFilterRadius(int &rx, int &ry) const = 0;
+    
+    /**
+     * Append the processors that execute the passes of this processor on the CPU in
+     * pass order to <passes> (this processor itself for single pass processors).
+     */
+    virtual void getCPUPasses(vector<ProcInterface *> &passes) = 0;
+    
+    /**
+     * Prepare the processor for execution by the CPU backend with input frames of
+     * size <inW>x<inH>. This only sets the output frame size, no OpenGL objects are
+     * created.
+     */
+    virtual void prepareCPU(int inW, int inH) = 0;
+    
+    /**
+     * Process the input images <inputs> (one per input, see getNumInputs()) on the CPU
+     * and write the result to <output>. Used by the CPU backend instead of render().
+     */
+    virtual void processCPU(const vector<const CPUImage *> &inputs, CPUImage &output) = 0;
 };
 }
 
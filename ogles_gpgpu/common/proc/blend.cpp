@@ -0,0 +1,75 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0 
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015 
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "blend.h"
+
+#include "../cpu/cpukernels.h"
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+// Linear blending fragment shader
+const char *BlendProc::fshaderBlendSrc = OG_TO_STR(
+precision mediump float;
+varying vec2 vTexCoord;
+uniform float uWeight;
+uniform sampler2D uInputTex;
+uniform lowp sampler2D uInputTex2;
+void main() {
+    vec4 a = texture2D(uInputTex, vTexCoord);
+    vec4 b = texture2D(uInputTex2, vTexCoord);
+    gl_FragColor = vec4(mix(a.rgb, b.rgb, uWeight), 1.0);
+}
+);
+
+BlendProc::BlendProc() : MultiInputProcBase(2) {
+    // set defaults
+    weight = 0.5f;
+}
+
+int BlendProc::init(int inW, int inH, unsigned int order, bool prepareForExternalInput) {
+    OG_LOGINF(getProcName(), "initialize");
+    
+    // create fbo for output
+    createFBO();
+    
+    // parent init - set defaults
+    baseInit(inW, inH, order, prepareForExternalInput, procParamOutW, procParamOutH, procParamOutScale);
+    
+    // MultiInputProcBase init - create shaders, get shader params, set buffers for OpenGL
+    multiInputInit(fshaderBlendSrc);
+    
+    // get additional shader params
+    shParamUWeight = shader->getParam(UNIF, "uWeight");
+    
+    return 1;
+}
+
+void BlendProc::render() {
+    OG_LOGINF(getProcName(), "input tex %d and %d, target %d, framebuffer of size %dx%d", texId, addTexIds[1], texTarget, outFrameW, outFrameH);
+    
+    multiInputRenderPrepare();
+	
+	glUniform1f(shParamUWeight, weight);
+    
+    Tools::checkGLErr("BlendProc", "render prepare");
+    
+    filterRenderSetCoords();
+    Tools::checkGLErr("BlendProc", "render set coords");
+    
+    filterRenderDraw();
+    Tools::checkGLErr("BlendProc", "render draw");
+    
+    filterRenderCleanup();
+    Tools::checkGLErr("BlendProc", "render cleanup");
+}
+
+void BlendProc::renderCPU(const vector<const CPUImage *> &inputs, CPUImage &output) {
+    CPUKernels::blend(*inputs[0], *inputs[1], output, weight);
+}
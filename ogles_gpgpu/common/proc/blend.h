@@ -0,0 +1,81 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0 
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015 
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * GPGPU blending processor.
+ */
+#ifndef OGLES_GPGPU_COMMON_PROC_BLEND
+#define OGLES_GPGPU_COMMON_PROC_BLEND
+
+#include "../common_includes.h"
+
+#include "base/multiinputprocbase.h"
+
+namespace ogles_gpgpu {
+    
+/**
+ * GPGPU processor that blends two input images linearly: (1 - w) * a + w * b
+ * with weight w, e.g. to combine the outputs of two pipeline branches.
+ * Input 0 (a) is the input that is set with useTexture(), input 1 (b) is the
+ * additional input (see MultiInputProcBase).
+ */
+class BlendProc : public MultiInputProcBase {
+public:
+    /**
+     * Constructor.
+     */
+    BlendProc();
+    
+    /**
+     * Return the processors name.
+     */
+    virtual const char *getProcName() { return "BlendProc"; }
+    
+    /**
+     * Set the weight [0..1] <w> of input 1 (default 0.5).
+     */
+    void setWeight(float w) { weight = w; }
+    
+    /**
+     * Get the weight [0..1] of input 1.
+     */
+    float getWeight() const { return weight; }
+    
+    /**
+     * Init the processor for input frames of size <inW>x<inH> which is at
+     * position <order> in the processing pipeline.
+     */
+    virtual int init(int inW, int inH, unsigned int order, bool prepareForExternalInput = false);
+    
+    /**
+     * Render the output.
+     */
+    virtual void render();
+    
+    /**
+     * Supported by the CPU backend.
+     */
+    virtual bool getCPUSupport() const { return true; }
+    
+protected:
+    /**
+     * Blending on the CPU.
+     */
+    virtual void renderCPU(const vector<const CPUImage *> &inputs, CPUImage &output);
+    
+private:
+    float weight;           // weight of input 1 [0.0 .. 1.0]
+    
+	GLint shParamUWeight;   // shader uniform weight
+    
+    static const char *fshaderBlendSrc;     // fragment shader source for blending
+};
+}
+
+#endif
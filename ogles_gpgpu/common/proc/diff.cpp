@@ -0,0 +1,75 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0 
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015 
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "diff.h"
+
+#include "../cpu/cpukernels.h"
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+// Absolute difference fragment shader
+const char *DiffProc::fshaderDiffSrc = OG_TO_STR(
+precision mediump float;
+varying vec2 vTexCoord;
+uniform float uGain;
+uniform sampler2D uInputTex;
+uniform lowp sampler2D uInputTex2;
+void main() {
+    vec3 a = texture2D(uInputTex, vTexCoord).rgb;
+    vec3 b = texture2D(uInputTex2, vTexCoord).rgb;
+    gl_FragColor = vec4(clamp(abs(a - b) * uGain, 0.0, 1.0), 1.0);
+}
+);
+
+DiffProc::DiffProc() : MultiInputProcBase(2) {
+    // set defaults
+    gain = 1.0f;
+}
+
+int DiffProc::init(int inW, int inH, unsigned int order, bool prepareForExternalInput) {
+    OG_LOGINF(getProcName(), "initialize");
+    
+    // create fbo for output
+    createFBO();
+    
+    // parent init - set defaults
+    baseInit(inW, inH, order, prepareForExternalInput, procParamOutW, procParamOutH, procParamOutScale);
+    
+    // MultiInputProcBase init - create shaders, get shader params, set buffers for OpenGL
+    multiInputInit(fshaderDiffSrc);
+    
+    // get additional shader params
+    shParamUGain = shader->getParam(UNIF, "uGain");
+    
+    return 1;
+}
+
+void DiffProc::render() {
+    OG_LOGINF(getProcName(), "input tex %d and %d, target %d, framebuffer of size %dx%d", texId, addTexIds[1], texTarget, outFrameW, outFrameH);
+    
+    multiInputRenderPrepare();
+	
+	glUniform1f(shParamUGain, gain);
+    
+    Tools::checkGLErr("DiffProc", "render prepare");
+    
+    filterRenderSetCoords();
+    Tools::checkGLErr("DiffProc", "render set coords");
+    
+    filterRenderDraw();
+    Tools::checkGLErr("DiffProc", "render draw");
+    
+    filterRenderCleanup();
+    Tools::checkGLErr("DiffProc", "render cleanup");
+}
+
+void DiffProc::renderCPU(const vector<const CPUImage *> &inputs, CPUImage &output) {
+    CPUKernels::diff(*inputs[0], *inputs[1], output, gain);
+}
@@ -0,0 +1,82 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0 
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015 
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * GPGPU difference processor.
+ */
+#ifndef OGLES_GPGPU_COMMON_PROC_DIFF
+#define OGLES_GPGPU_COMMON_PROC_DIFF
+
+#include "../common_includes.h"
+
+#include "base/multiinputprocbase.h"
+
+namespace ogles_gpgpu {
+    
+/**
+ * GPGPU processor that calculates the absolute difference |a - b| of two input
+ * images per channel, e.g. of the outputs of two pipeline branches. The difference
+ * is multiplied with a gain factor.
+ * Input 0 (a) is the input that is set with useTexture(), input 1 (b) is the
+ * additional input (see MultiInputProcBase).
+ */
+class DiffProc : public MultiInputProcBase {
+public:
+    /**
+     * Constructor.
+     */
+    DiffProc();
+    
+    /**
+     * Return the processors name.
+     */
+    virtual const char *getProcName() { return "DiffProc"; }
+    
+    /**
+     * Set the gain factor <g> with which the difference is multiplied (default 1.0).
+     */
+    void setGain(float g) { gain = g; }
+    
+    /**
+     * Get the gain factor.
+     */
+    float getGain() const { return gain; }
+    
+    /**
+     * Init the processor for input frames of size <inW>x<inH> which is at
+     * position <order> in the processing pipeline.
+     */
+    virtual int init(int inW, int inH, unsigned int order, bool prepareForExternalInput = false);
+    
+    /**
+     * Render the output.
+     */
+    virtual void render();
+    
+    /**
+     * Supported by the CPU backend.
+     */
+    virtual bool getCPUSupport() const { return true; }
+    
+protected:
+    /**
+     * Absolute difference on the CPU.
+     */
+    virtual void renderCPU(const vector<const CPUImage *> &inputs, CPUImage &output);
+    
+private:
+    float gain;             // gain factor for the difference
+    
+	GLint shParamUGain;     // shader uniform gain factor
+    
+    static const char *fshaderDiffSrc;  // fragment shader source for the absolute difference
+};
+}
+
+#endif
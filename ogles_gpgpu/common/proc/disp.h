@@ -51,6 +51,11 @@ public:
      */
     virtual void getResultData(unsigned char *data) const { assert(false); }
     
+    /**
+     * Not implemented - no output is returned because Disp renders on screen.
+     */
+    virtual void startResultReadback(unsigned long tag) { assert(false); }
+    
     /**
      * Not implemented - no MemTransferObj for output is set because Disp renders on screen.
      */
@@ -9,6 +9,8 @@
 
 #include "grayscale.h"
 
+#include "../cpu/cpukernels.h"
+
 using namespace std;
 using namespace ogles_gpgpu;
 
@@ -31,6 +33,32 @@ void main() {
 }
 );
 
+// Packed grayscale output: converts the 4 horizontally adjacent input pixels of an
+// output texel. uPackCoords maps the texel's texture coordinate to the pixels' ones
+// (x: scale, y: offset, z: distance between two pixels)
+const char *GrayscaleProc::fshaderGrayscalePackedSrc = OG_FSHADER_PRECISION_HIGH OG_TO_STR(
+varying vec2 vTexCoord;
+uniform sampler2D uInputTex;
+uniform vec3 uInputConvVec;
+uniform vec3 uPackCoords;
+void main() {
+    float s = floor(gl_FragCoord.x) * uPackCoords.x + uPackCoords.y;
+    float d = uPackCoords.z;
+    gl_FragColor = vec4(dot(texture2D(uInputTex, vec2(s, vTexCoord.y)).rgb, uInputConvVec),
+                        dot(texture2D(uInputTex, vec2(s + d, vTexCoord.y)).rgb, uInputConvVec),
+                        dot(texture2D(uInputTex, vec2(s + 2.0 * d, vTexCoord.y)).rgb, uInputConvVec),
+                        dot(texture2D(uInputTex, vec2(s + 3.0 * d, vTexCoord.y)).rgb, uInputConvVec));
+}
+);
+
+const char *GrayscaleProc::pointOpGrayscaleSrc = OG_TO_STR(
+uniform vec3 pt_uInputConvVec;
+vec4 pt_apply(vec4 px) {
+    float gray = dot(px.rgb, pt_uInputConvVec);
+    return vec4(gray, gray, gray, 1.0);
+}
+);
+
 GrayscaleProc::GrayscaleProc() {
     // set defaults
     inputConvType = GRAYSCALE_INPUT_CONVERSION_NONE;
@@ -47,11 +75,15 @@ int GrayscaleProc::init(int inW, int inH, unsigned int order, bool prepareForExt
     baseInit(inW, inH, order, prepareForExternalInput, procParamOutW, procParamOutH, procParamOutScale);
     
     // FilterProcBase init - create shaders, get shader params, set buffers for OpenGL
-    filterInit(fshaderGrayscaleSrc);
+    filterInit(packedGray ? fshaderGrayscalePackedSrc : fshaderGrayscaleSrc);
     
     // get additional shader params
     shParamUInputConvVec = shader->getParam(UNIF, "uInputConvVec");
     
+    if (packedGray) {
+        shParamUPackCoords = shader->getParam(UNIF, "uPackCoords");
+    }
+    
     return 1;
 }
 
@@ -59,7 +91,18 @@ void GrayscaleProc::render() {
     OG_LOGINF(getProcName(), "input tex %d, target %d, framebuffer of size %dx%d", texId, texTarget, outFrameW, outFrameH);
     
     filterRenderPrepare();
-    glUniform3fv(shParamUInputConvVec, 1, grayscaleConvVec);        // set additional uniforms
+    setPointOpUniforms();       // set additional uniforms
+    
+    if (packedGray) {
+        // sample the 4 pixel centers of the texel in the output column. the last texel
+        // of a row is padded with the border pixel if the width is no multiple of 4.
+        // mirrored output has the pixels in reverse order
+        bool mirrored = renderOrientation == RenderOrientationStdMirrored || renderOrientation == RenderOrientationFlippedMirrored;
+        float pxD = (mirrored ? -1.0f : 1.0f) / (float)outFrameW;
+        
+        glUniform3f(shParamUPackCoords, 4.0f * pxD, mirrored ? 1.0f + 0.5f * pxD : 0.5f * pxD, pxD);
+    }
+    
     Tools::checkGLErr(getProcName(), "render prepare");
     
     filterRenderSetCoords();
@@ -94,4 +137,16 @@ void GrayscaleProc::setGrayscaleConvType(GrayscaleInputConversionType type) {
     memcpy(grayscaleConvVec, v, sizeof(GLfloat) * 3);
     
     inputConvType = type;
-}
\ No newline at end of file
+}
+
+void GrayscaleProc::getPointOpShaderParams(Shader *sh, const string &prefix) {
+    shParamUInputConvVec = sh->getParam(UNIF, (prefix + "uInputConvVec").c_str());
+}
+
+void GrayscaleProc::setPointOpUniforms() {
+    glUniform3fv(shParamUInputConvVec, 1, grayscaleConvVec);
+}
+
+void GrayscaleProc::renderCPU(const vector<const CPUImage *> &inputs, CPUImage &output) {
+    CPUKernels::grayscale(*inputs[0], output, grayscaleConvVec);
+}
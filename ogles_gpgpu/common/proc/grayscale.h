@@ -76,12 +76,53 @@ public:
      */
     GrayscaleInputConversionType getGrayscaleConvType() const { return inputConvType; }
     
+    /**
+     * The grayscale conversion can pack its output. Not possible with diagonal render
+     * orientation, which swaps rows and columns.
+     */
+    virtual PackedGraySupport getPackedGraySupport() const { return renderOrientation != RenderOrientationDiagonal ? PACKED_GRAY_PACK : PACKED_GRAY_NONE; }
+    
+    /**
+     * The RGB conversion vector is the BT.601 luminance, which is the Y value of YUV input.
+     */
+    virtual bool getReadsLumaOnly() const { return inputConvType == GRAYSCALE_INPUT_CONVERSION_RGB; }
+    
+    /**
+     * Supported by the CPU backend.
+     */
+    virtual bool getCPUSupport() const { return true; }
+    
+protected:
+    /**
+     * Return the GLSL source of the point operation for shader fusion. The packed
+     * conversion reads 4 input pixels and is no point operation.
+     */
+    virtual const char *getPointOpSrc() const { return packedGray ? NULL : pointOpGrayscaleSrc; }
+    
+    /**
+     * Get the locations of the point operation's uniforms in shader <sh> with name prefix <prefix>.
+     */
+    virtual void getPointOpShaderParams(Shader *sh, const string &prefix);
+    
+    /**
+     * Set the point operation's uniforms in the currently used shader.
+     */
+    virtual void setPointOpUniforms();
+    
+    /**
+     * Grayscale conversion on the CPU.
+     */
+    virtual void renderCPU(const vector<const CPUImage *> &inputs, CPUImage &output);
+    
 private:
     static const char *fshaderGrayscaleSrc;         // fragment shader source
+    static const char *fshaderGrayscalePackedSrc;   // fragment shader source for packed grayscale output
+    static const char *pointOpGrayscaleSrc;         // point operation source for shader fusion
     static const GLfloat grayscaleConvVecRGB[3];    // weighted channel grayscale conversion for RGB input (default)
     static const GLfloat grayscaleConvVecBGR[3];    // weighted channel grayscale conversion for BGR input
     
     GLint shParamUInputConvVec; // shader uniform weighted channel grayscale conversion vector
+    GLint shParamUPackCoords;   // shader uniform texture coordinate transformation for packed grayscale output
     
     GLfloat grayscaleConvVec[3];                // currently set weighted channel grayscale conversion vector
     GrayscaleInputConversionType inputConvType; // grayscale conversion type
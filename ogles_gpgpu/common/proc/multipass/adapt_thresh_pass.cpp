@@ -9,6 +9,8 @@
 
 #include "adapt_thresh_pass.h"
 
+#include "../../cpu/cpukernels.h"
+
 using namespace ogles_gpgpu;
 
 // Adaptive thresholding - Pass 1 fragment shader
@@ -61,6 +63,62 @@ void main() {
 }
 );
 
+// Adaptive thresholding of packed grayscale images (4 pixels per texel) - Pass 1
+// Perform a horizontal 5x1 average gray pixel value calculation. Each output texel
+// holds 2 pixels: the first or the last 2 pixels of an input texel
+const char *AdaptThreshProcPass::fshaderAdaptThreshPackedPass1Src = OG_FSHADER_PRECISION_HIGH OG_TO_STR(
+varying vec2 vTexCoord;
+uniform vec2 uPxD;
+uniform sampler2D uInputTex;
+void main() {
+    // odd output texels hold the last 2 pixels. sample at the input texel's center
+    float second = mod(floor(gl_FragCoord.x), 2.0);
+    vec2 texCoord = vec2(vTexCoord.x + (0.25 - 0.5 * second) * uPxD.x, vTexCoord.y);
+    // get center texel and the neighbour texels. the image border is continued with the border pixel
+    vec4 pxC = texture2D(uInputTex, texCoord);
+    vec4 pxL = mix(vec4(pxC.r), texture2D(uInputTex, texCoord - vec2(uPxD.x, 0.0)), step(uPxD.x, texCoord.x));
+    vec4 pxR = mix(vec4(pxC.a), texture2D(uInputTex, texCoord + vec2(uPxD.x, 0.0)), step(texCoord.x + uPxD.x, 1.0));
+    // the 6 pixels around the 2 pixels of this texel (which are a.z and a.w)
+    vec4 a = mix(vec4(pxL.ba, pxC.rg), pxC, second);
+    vec2 b = mix(pxC.ba, pxR.rg, second);
+    // Result stores average pixel value and original gray value of both pixels
+    float sum = a.y + a.z + a.w + b.x;
+    gl_FragColor = vec4((a.x + sum) / 5.0, a.z, (sum + b.y) / 5.0, a.w);
+}
+);
+
+// Adaptive thresholding of packed grayscale images - Pass 2
+// Perform a vertical 5x1 average gray pixel value calculation and the final
+// binarization of the 4 pixels of an output texel
+const char *AdaptThreshProcPass::fshaderAdaptThreshPackedPass2Src = OG_FSHADER_PRECISION_HIGH OG_TO_STR(
+varying vec2 vTexCoord;
+uniform vec2 uPxD;
+uniform sampler2D uInputTex;
+void main() {
+    // input texels with the first and the last 2 pixels. they store: avg., orig. gray value (for each pixel)
+    vec2 texCoordA = vec2(vTexCoord.x - 0.25 * uPxD.x, vTexCoord.y);
+    vec2 texCoordB = vec2(vTexCoord.x + 0.25 * uPxD.x, vTexCoord.y);
+    vec4 centerA = texture2D(uInputTex, texCoordA);
+    vec4 centerB = texture2D(uInputTex, texCoordB);
+    const float bigC = 9.5 / 255.0;
+    // get the sums
+    vec4 sumA = texture2D(uInputTex, texCoordA + vec2(0.0, uPxD.y * -2.0)) +
+    texture2D(uInputTex, texCoordA + vec2(0.0, uPxD.y * -1.0)) +
+    centerA +
+    texture2D(uInputTex, texCoordA + vec2(0.0, uPxD.y *  1.0)) +
+    texture2D(uInputTex, texCoordA + vec2(0.0, uPxD.y *  2.0));
+    vec4 sumB = texture2D(uInputTex, texCoordB + vec2(0.0, uPxD.y * -2.0)) +
+    texture2D(uInputTex, texCoordB + vec2(0.0, uPxD.y * -1.0)) +
+    centerB +
+    texture2D(uInputTex, texCoordB + vec2(0.0, uPxD.y *  1.0)) +
+    texture2D(uInputTex, texCoordB + vec2(0.0, uPxD.y *  2.0));
+    // get the averages
+    vec4 avg = vec4(sumA.r, sumA.b, sumB.r, sumB.b) / 5.0;
+    // create inverted binary values
+    gl_FragColor = 1.0 - step(avg - bigC, vec4(centerA.g, centerA.a, centerB.g, centerB.a));
+}
+);
+
 int AdaptThreshProcPass::init(int inW, int inH, unsigned int order, bool prepareForExternalInput) {
     OG_LOGINF(getProcName(), "render pass %d", renderPass);
     
@@ -70,15 +128,18 @@ int AdaptThreshProcPass::init(int inW, int inH, unsigned int order, bool prepare
     // parent init - set defaults
     baseInit(inW, inH, order, prepareForExternalInput, procParamOutW, procParamOutH, procParamOutScale);
     
-    // calculate pixel delta values
-    pxDx = 1.0f / (float)outFrameW;
+    // calculate pixel delta values (packed grayscale pixels are stepped through by
+    // texels of 4 pixels horizontally)
+    pxDx = 1.0f / (float)(packedGray ? (outFrameW + 3) / 4 : outFrameW);
     pxDy = 1.0f / (float)outFrameH;
     
-    // get necessary fragment shader source
-    const char *shSrc = renderPass == 1 ? fshaderAdaptThreshPass1Src : fshaderAdaptThreshPass2Src;
-    
-    // FilterProcBase init - create shaders, get shader params, set buffers for OpenGL
-    filterInit(shSrc, RenderOrientationDiagonal);
+    // FilterProcBase init - create shaders, get shader params, set buffers for OpenGL.
+    // the passes over packed grayscale images do not swap rows and columns
+    if (packedGray) {
+        filterInit(renderPass == 1 ? fshaderAdaptThreshPackedPass1Src : fshaderAdaptThreshPackedPass2Src);
+    } else {
+        filterInit(renderPass == 1 ? fshaderAdaptThreshPass1Src : fshaderAdaptThreshPass2Src, RenderOrientationDiagonal);
+    }
     
     // get additional shader params
     shParamUPxD = shader->getParam(UNIF, "uPxD");
@@ -89,6 +150,11 @@ int AdaptThreshProcPass::init(int inW, int inH, unsigned int order, bool prepare
 void AdaptThreshProcPass::createFBOTex(bool genMipmap) {
     assert(fbo);
     
+    if (packedGray) {   // rows and columns are not swapped
+        FilterProcBase::createFBOTex(genMipmap);
+        return;
+    }
+    
     if (renderPass == 1) {
         fbo->createAttachedTex(outFrameH, outFrameW, genMipmap);   // swapped
     } else {
@@ -117,4 +183,13 @@ void AdaptThreshProcPass::render() {
     
     filterRenderCleanup();
     Tools::checkGLErr(getProcName(), "render cleanup");
-}
\ No newline at end of file
+}
+
+void AdaptThreshProcPass::renderCPU(const vector<const CPUImage *> &inputs, CPUImage &output) {
+    // the CPU passes do not swap rows and columns, so pass 1 averages horizontally
+    if (renderPass == 1) {
+        CPUKernels::adaptThreshAvg(*inputs[0], output);
+    } else {
+        CPUKernels::adaptThresh(*inputs[0], output);
+    }
+}
@@ -59,6 +59,45 @@ public:
      */
     virtual void render();
     
+    /**
+     * Both passes can binarize packed grayscale images. Then the first pass writes
+     * 2 pixels per texel (average and original gray value of each) and the second
+     * pass the packed binary image.
+     */
+    virtual PackedGraySupport getPackedGraySupport() const { return getKeepsPixelRows() ? PACKED_GRAY_KEEP : PACKED_GRAY_NONE; }
+    
+    /**
+     * Supported by the CPU backend.
+     */
+    virtual bool getCPUSupport() const { return true; }
+    
+    /**
+     * The CPU passes do not swap rows and columns.
+     */
+    virtual RenderOrientation getCPURenderOrientation() const { return RenderOrientationStd; }
+    
+    /**
+     * Pass 1 reads 2 pixels to each side, pass 2 2 pixels above and below.
+     */
+    virtual void getFilterRadius(int &rx, int &ry) const { rx = renderPass == 1 ? 2 : 0; ry = renderPass == 2 ? 2 : 0; }
+    
+protected:
+    /**
+     * Return the width of the output texture in texels. The packed output of the first
+     * pass has 2 pixels per texel.
+     */
+    virtual int getOutTexW() const { return packedGray && renderPass == 1 ? 2 * ((outFrameW + 3) / 4) : FilterProcBase::getOutTexW(); }
+    
+    /**
+     * Return the number of pixels in a row that one output texel holds.
+     */
+    virtual int getOutTexelPx() const { return packedGray && renderPass == 1 ? 2 : FilterProcBase::getOutTexelPx(); }
+    
+    /**
+     * Pass 1 or 2 of adaptive thresholding on the CPU.
+     */
+    virtual void renderCPU(const vector<const CPUImage *> &inputs, CPUImage &output);
+    
 private:
     int renderPass; // render pass number. must be 1 or 2
     
@@ -69,6 +108,8 @@ private:
     
     static const char *fshaderAdaptThreshPass1Src;  // fragment shader source for adaptive thresholding pass 1
     static const char *fshaderAdaptThreshPass2Src;  // fragment shader source for adaptive thresholding pass 2
+    static const char *fshaderAdaptThreshPackedPass1Src;    // fragment shader source for adaptive thresholding pass 1 of packed grayscale images
+    static const char *fshaderAdaptThreshPackedPass2Src;    // fragment shader source for adaptive thresholding pass 2 of packed grayscale images
 };
 }
 
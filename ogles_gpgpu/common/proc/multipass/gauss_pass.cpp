@@ -9,11 +9,13 @@
 
 #include "gauss_pass.h"
 
-using namespace ogles_gpgpu;
+#include "../../cpu/cpukernels.h"
 
-const char *GaussProcPass::fshaderGaussSrc = OG_TO_STR(
-precision mediump float;
+using namespace ogles_gpgpu;
 
+// 7x1 Gauss kernel. The tap coordinates need highp where available, because mediump
+// can be a half float that samples between the pixels of wide frames
+const char *GaussProcPass::fshaderGaussSrc = OG_FSHADER_PRECISION_HIGH OG_TO_STR(
 uniform sampler2D uInputTex;
 uniform float uPxD;
 varying vec2 vTexCoord;
@@ -33,6 +35,44 @@ void main() {
 }
 );
 
+// Horizontal 7x1 Gauss kernel on packed grayscale images (4 pixels per texel).
+// Uses the neighbour texels on both sides. The image border is continued with the
+// border pixel
+const char *GaussProcPass::fshaderGaussPackedPass1Src = OG_FSHADER_PRECISION_HIGH OG_TO_STR(
+uniform sampler2D uInputTex;
+uniform float uPxD;
+varying vec2 vTexCoord;
+void main() {
+    vec4 pxC = texture2D(uInputTex, vTexCoord);
+    vec4 pxL = mix(vec4(pxC.r), texture2D(uInputTex, vTexCoord - vec2(uPxD, 0.0)), step(uPxD, vTexCoord.x));
+    vec4 pxR = mix(vec4(pxC.a), texture2D(uInputTex, vTexCoord + vec2(uPxD, 0.0)), step(vTexCoord.x + uPxD, 1.0));
+    gl_FragColor = 0.006 * (vec4(pxL.gba, pxC.r) + vec4(pxC.a, pxR.rgb))
+                 + 0.061 * (vec4(pxL.ba, pxC.rg) + vec4(pxC.ba, pxR.rg))
+                 + 0.242 * (vec4(pxL.a, pxC.rgb) + vec4(pxC.gba, pxR.r))
+                 + 0.382 * pxC;
+}
+);
+
+// Vertical 1x7 Gauss kernel on packed grayscale images (each channel separately)
+const char *GaussProcPass::fshaderGaussPackedPass2Src = OG_FSHADER_PRECISION_HIGH OG_TO_STR(
+uniform sampler2D uInputTex;
+uniform float uPxD;
+varying vec2 vTexCoord;
+void main() {
+    vec4 pxC  = texture2D(uInputTex, vTexCoord);
+    vec4 pxT1 = texture2D(uInputTex, vTexCoord - vec2(0.0, uPxD));
+    vec4 pxT2 = texture2D(uInputTex, vTexCoord - vec2(0.0, 2.0 * uPxD));
+    vec4 pxT3 = texture2D(uInputTex, vTexCoord - vec2(0.0, 3.0 * uPxD));
+    vec4 pxB1 = texture2D(uInputTex, vTexCoord + vec2(0.0, uPxD));
+    vec4 pxB2 = texture2D(uInputTex, vTexCoord + vec2(0.0, 2.0 * uPxD));
+    vec4 pxB3 = texture2D(uInputTex, vTexCoord + vec2(0.0, 3.0 * uPxD));
+    gl_FragColor = 0.006 * (pxT3 + pxB3)
+                 + 0.061 * (pxT2 + pxB2)
+                 + 0.242 * (pxT1 + pxB1)
+                 + 0.382 * pxC;
+}
+);
+
 int GaussProcPass::init(int inW, int inH, unsigned int order, bool prepareForExternalInput) {
     OG_LOGINF(getProcName(), "render pass %d", renderPass);
     
@@ -42,12 +82,17 @@ int GaussProcPass::init(int inW, int inH, unsigned int order, bool prepareForExt
     // parent init - set defaults
     baseInit(inW, inH, order, prepareForExternalInput, procParamOutW, procParamOutH, procParamOutScale);
     
-    // calculate pixel delta values
-    pxDx = 1.0f / (float)outFrameW;
+    // calculate pixel delta values (packed grayscale pixels are stepped through by texels horizontally)
+    pxDx = 1.0f / (float)getOutTexW();
     pxDy = 1.0f / (float)outFrameH;
     
-    // FilterProcBase init - create shaders, get shader params, set buffers for OpenGL
-    filterInit(fshaderGaussSrc, RenderOrientationDiagonal);
+    // FilterProcBase init - create shaders, get shader params, set buffers for OpenGL.
+    // the passes over packed grayscale images do not swap rows and columns
+    if (packedGray) {
+        filterInit(renderPass == 1 ? fshaderGaussPackedPass1Src : fshaderGaussPackedPass2Src);
+    } else {
+        filterInit(fshaderGaussSrc, RenderOrientationDiagonal);
+    }
     
     // get additional shader params
     shParamUPxD = shader->getParam(UNIF, "uPxD");
@@ -58,6 +103,11 @@ int GaussProcPass::init(int inW, int inH, unsigned int order, bool prepareForExt
 void GaussProcPass::createFBOTex(bool genMipmap) {
     assert(fbo);
     
+    if (packedGray) {   // rows and columns are not swapped
+        FilterProcBase::createFBOTex(genMipmap);
+        return;
+    }
+    
     if (renderPass == 1) {
         fbo->createAttachedTex(outFrameH, outFrameW, genMipmap);   // swapped
     } else {
@@ -74,7 +124,7 @@ void GaussProcPass::render() {
     
     filterRenderPrepare();
 	
-	glUniform1f(shParamUPxD, renderPass == 1 ? pxDy : pxDx);	// texture pixel delta values
+	glUniform1f(shParamUPxD, renderPass == 1 ? pxDx : pxDy);	// texture pixel delta values
     
     Tools::checkGLErr(getProcName(), "render prepare");
     
@@ -86,4 +136,9 @@ void GaussProcPass::render() {
     
     filterRenderCleanup();
     Tools::checkGLErr(getProcName(), "render cleanup");
-}
\ No newline at end of file
+}
+
+void GaussProcPass::renderCPU(const vector<const CPUImage *> &inputs, CPUImage &output) {
+    // the CPU passes do not swap rows and columns, like the passes over packed grayscale images
+    CPUKernels::gauss(*inputs[0], output, renderPass == 2);
+}
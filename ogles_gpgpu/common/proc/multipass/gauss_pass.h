@@ -57,6 +57,33 @@ public:
      * Overrides ProcBase's method.
      */
     virtual void createFBOTex(bool genMipmap);
+    
+    /**
+     * Both passes can smooth packed grayscale images. Then the first pass smoothes
+     * horizontally and the second one vertically without swapping rows and columns.
+     */
+    virtual PackedGraySupport getPackedGraySupport() const { return getKeepsPixelRows() ? PACKED_GRAY_KEEP : PACKED_GRAY_NONE; }
+    
+    /**
+     * Supported by the CPU backend.
+     */
+    virtual bool getCPUSupport() const { return true; }
+    
+    /**
+     * The CPU passes do not swap rows and columns.
+     */
+    virtual RenderOrientation getCPURenderOrientation() const { return RenderOrientationStd; }
+    
+    /**
+     * Pass 1 reads 3 pixels to each side, pass 2 3 pixels above and below.
+     */
+    virtual void getFilterRadius(int &rx, int &ry) const { rx = renderPass == 1 ? 3 : 0; ry = renderPass == 2 ? 3 : 0; }
+    
+protected:
+    /**
+     * Horizontal (pass 1) or vertical (pass 2) smoothing on the CPU.
+     */
+    virtual void renderCPU(const vector<const CPUImage *> &inputs, CPUImage &output);
 
 private:
     int renderPass; // render pass number. must be 1 or 2
@@ -67,6 +94,8 @@ private:
 	float pxDy;	// pixel delta value for texture access
     
     static const char *fshaderGaussSrc;  // fragment shader source for gaussian smoothing for both passes
+    static const char *fshaderGaussPackedPass1Src;  // fragment shader source for horizontal gaussian smoothing of packed grayscale images
+    static const char *fshaderGaussPackedPass2Src;  // fragment shader source for vertical gaussian smoothing of packed grayscale images
 };
 
 }
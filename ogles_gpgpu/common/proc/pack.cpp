@@ -0,0 +1,144 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "pack.h"
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+// red channel of 4 horizontally adjacent pixels per texel
+const char *PackProc::fshaderPackGray8Src = OG_FSHADER_PRECISION_HIGH OG_TO_STR(
+varying vec2 vTexCoord;
+uniform sampler2D uInputTex;
+uniform float uPxD;
+void main() {
+    float s = (floor(gl_FragCoord.x) * 4.0 + 0.5) * uPxD;
+    gl_FragColor = vec4(texture2D(uInputTex, vec2(s, vTexCoord.y)).r,
+                        texture2D(uInputTex, vec2(s + uPxD, vTexCoord.y)).r,
+                        texture2D(uInputTex, vec2(s + 2.0 * uPxD, vTexCoord.y)).r,
+                        texture2D(uInputTex, vec2(s + 3.0 * uPxD, vTexCoord.y)).r);
+}
+);
+
+// 32 horizontally adjacent pixels per texel as bits (8 pixels per channel, first pixel
+// in the lowest bit). pixels behind the right image border are 0
+const char *PackProc::fshaderPackMask1Src = OG_FSHADER_PRECISION_HIGH OG_TO_STR(
+varying vec2 vTexCoord;
+uniform sampler2D uInputTex;
+uniform float uPxD;
+uniform float uWidth;
+float packByte(float p) {
+    float v = 0.0;
+    float bit = 1.0;
+    for (int i = 0; i < 8; i++) {
+        float px = texture2D(uInputTex, vec2((p + 0.5) * uPxD, vTexCoord.y)).r;
+        v += bit * step(0.5, px) * step(p + 0.5, uWidth);
+        bit *= 2.0;
+        p += 1.0;
+    }
+    return v / 255.0;
+}
+void main() {
+    float p = floor(gl_FragCoord.x) * 32.0;
+    gl_FragColor = vec4(packByte(p), packByte(p + 8.0), packByte(p + 16.0), packByte(p + 24.0));
+}
+);
+
+// the same for packed grayscale input: 8 pixels of a channel are 2 input texels
+const char *PackProc::fshaderPackMask1PackedSrc = OG_FSHADER_PRECISION_HIGH OG_TO_STR(
+varying vec2 vTexCoord;
+uniform sampler2D uInputTex;
+uniform float uPxD;
+uniform float uWidth;
+float packByte(float t) {
+    vec4 px0 = texture2D(uInputTex, vec2((t + 0.5) * uPxD, vTexCoord.y));
+    vec4 px1 = texture2D(uInputTex, vec2((t + 1.5) * uPxD, vTexCoord.y));
+    vec4 idx = vec4(t * 4.0 + 0.5) + vec4(0.0, 1.0, 2.0, 3.0);
+    return (dot(step(0.5, px0) * step(idx, vec4(uWidth)), vec4(1.0, 2.0, 4.0, 8.0))
+          + dot(step(0.5, px1) * step(idx + 4.0, vec4(uWidth)), vec4(16.0, 32.0, 64.0, 128.0))) / 255.0;
+}
+void main() {
+    float t = floor(gl_FragCoord.x) * 8.0;
+    gl_FragColor = vec4(packByte(t), packByte(t + 2.0), packByte(t + 4.0), packByte(t + 6.0));
+}
+);
+
+PackProc::PackProc() {
+    outputFormat = OUTPUT_FORMAT_GRAY8;
+    packedInput = false;
+}
+
+int PackProc::init(int inW, int inH, unsigned int order, bool prepareForExternalInput) {
+    OG_LOGINF(getProcName(), "initialize with output format %d, packed input %d", outputFormat, packedInput);
+    
+    // create fbo for output
+    createFBO();
+    
+    // parent init - the output has the input size in pixels
+    baseInit(inW, inH, order, prepareForExternalInput);
+    
+    // FilterProcBase init - create shaders, get shader params, set buffers for OpenGL.
+    // packed grayscale input already is in the format of OUTPUT_FORMAT_GRAY8
+    assert(!(packedInput && outputFormat == OUTPUT_FORMAT_GRAY8));
+    
+    if (outputFormat == OUTPUT_FORMAT_MASK1) {
+        filterInit(packedInput ? fshaderPackMask1PackedSrc : fshaderPackMask1Src);
+        shParamUWidth = shader->getParam(UNIF, "uWidth");
+    } else {
+        filterInit(fshaderPackGray8Src);
+    }
+    
+    // get additional shader params
+    shParamUPxD = shader->getParam(UNIF, "uPxD");
+    
+    return 1;
+}
+
+void PackProc::createFBOTex(bool genMipmap) {
+    assert(fbo != NULL);
+    
+    fbo->createAttachedTex(getOutTexW(), outFrameH, false);
+}
+
+void PackProc::render() {
+    OG_LOGINF(getProcName(), "input tex %d, target %d, framebuffer of size %dx%d", texId, texTarget, getOutTexW(), outFrameH);
+    
+    filterRenderPrepare();
+    
+    // texture coordinate distance between the input pixels (or texels of packed input)
+    int inTexW = packedInput ? (inFrameW + 3) / 4 : inFrameW;
+    glUniform1f(shParamUPxD, 1.0f / (float)inTexW);
+    
+    if (outputFormat == OUTPUT_FORMAT_MASK1) {
+        glUniform1f(shParamUWidth, (float)inFrameW);
+    }
+    
+    Tools::checkGLErr(getProcName(), "render prepare");
+    
+    filterRenderSetCoords();
+    Tools::checkGLErr(getProcName(), "render set coords");
+    
+    filterRenderDraw();
+    Tools::checkGLErr(getProcName(), "render draw");
+    
+    filterRenderCleanup();
+    Tools::checkGLErr(getProcName(), "render cleanup");
+}
+
+int PackProc::getOutTexW() const {
+    return outputFormat == OUTPUT_FORMAT_MASK1 ? (outFrameW + 31) / 32 : (outFrameW + 3) / 4;
+}
+
+int PackProc::getOutTexelPx() const {
+    return outputFormat == OUTPUT_FORMAT_MASK1 ? 32 : 4;
+}
+
+int PackProc::getResultRowLen(int w) const {
+    return outputFormat == OUTPUT_FORMAT_MASK1 ? (w + 7) / 8 : w;
+}
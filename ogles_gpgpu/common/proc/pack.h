@@ -0,0 +1,103 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * GPGPU output packing processor.
+ */
+#ifndef OGLES_GPGPU_COMMON_PROC_PACK
+#define OGLES_GPGPU_COMMON_PROC_PACK
+
+#include "../common_includes.h"
+
+#include "base/filterprocbase.h"
+
+namespace ogles_gpgpu {
+
+/**
+ * GPGPU processor that packs its input image into fewer bytes for the readback
+ * (see Core::setOutputFormat()): OUTPUT_FORMAT_GRAY8 writes the red channel of 4
+ * pixels into one RGBA texel, OUTPUT_FORMAT_MASK1 writes 32 pixels as bits into one
+ * RGBA texel. The output size is the input size in pixels, getResultData() returns
+ * the packed rows without padding.
+ */
+class PackProc : public FilterProcBase {
+public:
+    /**
+     * Constructor.
+     */
+    PackProc();
+    
+    /**
+     * Return the processors name.
+     */
+    virtual const char *getProcName() { return "PackProc"; }
+    
+    /**
+     * Set the output format to <fmt> (OUTPUT_FORMAT_GRAY8 or OUTPUT_FORMAT_MASK1).
+     * Must be set before init().
+     */
+    void setOutputFormat(OutputFormat fmt) { assert(!fbo && fmt != OUTPUT_FORMAT_RGBA); outputFormat = fmt; }
+    
+    /**
+     * Get the output format.
+     */
+    OutputFormat getOutputFormat() const { return outputFormat; }
+    
+    /**
+     * Read packed grayscale input (4 pixels per texel, see ProcInterface::getPackedGraySupport()):
+     * <packed>. Must be set before init().
+     */
+    void setPackedInput(bool packed) { assert(!fbo); packedInput = packed; }
+    
+    /**
+     * Init the processor for input frames of size <inW>x<inH> which is at
+     * position <order> in the processing pipeline.
+     */
+    virtual int init(int inW, int inH, unsigned int order, bool prepareForExternalInput = false);
+    
+    /**
+     * Create the output texture with the packed size. Mipmaps are not supported.
+     */
+    virtual void createFBOTex(bool genMipmap);
+    
+    /**
+     * Render the output.
+     */
+    virtual void render();
+
+protected:
+    /**
+     * Return the width of the output texture in texels.
+     */
+    virtual int getOutTexW() const;
+    
+    /**
+     * Return the number of pixels in a row that one output texel holds.
+     */
+    virtual int getOutTexelPx() const;
+    
+    /**
+     * Return the number of bytes of <w> pixels of a packed row of the result data.
+     */
+    virtual int getResultRowLen(int w) const;
+
+private:
+    OutputFormat outputFormat;  // packed output format
+    bool packedInput;           // input is packed grayscale?
+    
+    GLint shParamUPxD;      // shader uniform texture coordinate distance between input pixels (or texels)
+    GLint shParamUWidth;    // shader uniform input width in pixels
+    
+    static const char *fshaderPackGray8Src;         // fragment shader source for OUTPUT_FORMAT_GRAY8
+    static const char *fshaderPackMask1Src;         // fragment shader source for OUTPUT_FORMAT_MASK1
+    static const char *fshaderPackMask1PackedSrc;   // fragment shader source for OUTPUT_FORMAT_MASK1 with packed grayscale input
+};
+}
+
+#endif
@@ -9,6 +9,8 @@
 
 #include "thresh.h"
 
+#include "../cpu/cpukernels.h"
+
 using namespace std;
 using namespace ogles_gpgpu;
 
@@ -26,6 +28,32 @@ void main() {
 }
 );
 
+// Simple thresholding of packed grayscale images (4 pixels per texel)
+const char *ThreshProc::fshaderSimpleThreshPackedSrc = OG_TO_STR(
+precision mediump float;
+varying vec2 vTexCoord;
+uniform float uThresh;
+uniform sampler2D uInputTex;
+void main() {
+    gl_FragColor = step(vec4(uThresh), texture2D(uInputTex, vTexCoord));
+}
+);
+
+const char *ThreshProc::pointOpThreshSrc = OG_TO_STR(
+uniform float pt_uThresh;
+vec4 pt_apply(vec4 px) {
+    float bin = step(pt_uThresh, px.r);
+    return vec4(bin, bin, bin, 1.0);
+}
+);
+
+const char *ThreshProc::pointOpThreshPackedSrc = OG_TO_STR(
+uniform float pt_uThresh;
+vec4 pt_apply(vec4 px) {
+    return step(vec4(pt_uThresh), px);
+}
+);
+
 ThreshProc::ThreshProc() {
     // set defaults
     threshVal = 0.5f;
@@ -41,7 +69,7 @@ int ThreshProc::init(int inW, int inH, unsigned int order, bool prepareForExtern
     baseInit(inW, inH, order, prepareForExternalInput, procParamOutW, procParamOutH, procParamOutScale);
     
     // FilterProcBase init - create shaders, get shader params, set buffers for OpenGL
-    filterInit(fshaderSimpleThreshSrc);
+    filterInit(packedGray ? fshaderSimpleThreshPackedSrc : fshaderSimpleThreshSrc);
     
     // get additional shader params
     shParamUThresh = shader->getParam(UNIF, "uThresh");
@@ -54,7 +82,7 @@ void ThreshProc::render() {
     
     filterRenderPrepare();
 	
-	glUniform1f(shParamUThresh, threshVal);	// thresholding value for simple thresholding
+	setPointOpUniforms();	// thresholding value for simple thresholding
     
     Tools::checkGLErr("ThreshProc", "render prepare");
     
@@ -66,4 +94,16 @@ void ThreshProc::render() {
     
     filterRenderCleanup();
     Tools::checkGLErr("ThreshProc", "render cleanup");
-}
\ No newline at end of file
+}
+
+void ThreshProc::getPointOpShaderParams(Shader *sh, const string &prefix) {
+    shParamUThresh = sh->getParam(UNIF, (prefix + "uThresh").c_str());
+}
+
+void ThreshProc::setPointOpUniforms() {
+    glUniform1f(shParamUThresh, threshVal);
+}
+
+void ThreshProc::renderCPU(const vector<const CPUImage *> &inputs, CPUImage &output) {
+    CPUKernels::thresh(*inputs[0], output, threshVal);
+}
@@ -61,12 +61,46 @@ public:
      */
     virtual void render();
     
+    /**
+     * Thresholding works on each channel of packed grayscale images.
+     */
+    virtual PackedGraySupport getPackedGraySupport() const { return getKeepsPixelRows() ? PACKED_GRAY_KEEP : PACKED_GRAY_NONE; }
+    
+    /**
+     * Supported by the CPU backend.
+     */
+    virtual bool getCPUSupport() const { return true; }
+    
+protected:
+    /**
+     * Return the GLSL source of the point operation for shader fusion.
+     */
+    virtual const char *getPointOpSrc() const { return packedGray ? pointOpThreshPackedSrc : pointOpThreshSrc; }
+    
+    /**
+     * Get the locations of the point operation's uniforms in shader <sh> with name prefix <prefix>.
+     */
+    virtual void getPointOpShaderParams(Shader *sh, const string &prefix);
+    
+    /**
+     * Set the point operation's uniforms in the currently used shader.
+     */
+    virtual void setPointOpUniforms();
+    
+    /**
+     * Thresholding on the CPU.
+     */
+    virtual void renderCPU(const vector<const CPUImage *> &inputs, CPUImage &output);
+    
 private:
     float threshVal;            // thresholding value [0.0 .. 1.0]
     
 	GLint shParamUThresh;	// fixed threshold value
     
     static const char *fshaderSimpleThreshSrc;      // fragment shader source for simple thresholding
+    static const char *fshaderSimpleThreshPackedSrc;    // fragment shader source for simple thresholding of packed grayscale images
+    static const char *pointOpThreshSrc;            // point operation source for shader fusion
+    static const char *pointOpThreshPackedSrc;      // point operation source for shader fusion with packed grayscale images
 };
 }
 
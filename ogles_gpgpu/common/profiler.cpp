@@ -0,0 +1,381 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "profiler.h"
+
+#if defined(GL_EXT_disjoint_timer_query) && (defined(__ANDROID__) || defined(__linux__))
+#define OGLES_GPGPU_PROFILER_USE_TIMER_QUERY
+#include <EGL/egl.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+#ifdef OGLES_GPGPU_PROFILER_USE_TIMER_QUERY
+// function pointers to EXT_disjoint_timer_query functions
+static PFNGLGENQUERIESEXTPROC glExtGenQueries = NULL;
+static PFNGLDELETEQUERIESEXTPROC glExtDeleteQueries = NULL;
+static PFNGLQUERYCOUNTEREXTPROC glExtQueryCounter = NULL;
+static PFNGLGETQUERYIVEXTPROC glExtGetQueryiv = NULL;
+static PFNGLGETQUERYOBJECTUIVEXTPROC glExtGetQueryObjectuiv = NULL;
+static PFNGLGETQUERYOBJECTUI64VEXTPROC glExtGetQueryObjectui64v = NULL;
+static PFNGLGETINTEGER64VEXTPROC glExtGetInteger64v = NULL;
+
+// the function pointers are the same for all contexts, so they are loaded only once
+static once_flag timerQueryFuncsLoaded;
+
+static void loadTimerQueryFuncs() {
+    glExtGenQueries = (PFNGLGENQUERIESEXTPROC)eglGetProcAddress("glGenQueriesEXT");
+    glExtDeleteQueries = (PFNGLDELETEQUERIESEXTPROC)eglGetProcAddress("glDeleteQueriesEXT");
+    glExtQueryCounter = (PFNGLQUERYCOUNTEREXTPROC)eglGetProcAddress("glQueryCounterEXT");
+    glExtGetQueryiv = (PFNGLGETQUERYIVEXTPROC)eglGetProcAddress("glGetQueryivEXT");
+    glExtGetQueryObjectuiv = (PFNGLGETQUERYOBJECTUIVEXTPROC)eglGetProcAddress("glGetQueryObjectuivEXT");
+    glExtGetQueryObjectui64v = (PFNGLGETQUERYOBJECTUI64VEXTPROC)eglGetProcAddress("glGetQueryObjectui64vEXT");
+    glExtGetInteger64v = (PFNGLGETINTEGER64VEXTPROC)eglGetProcAddress("glGetInteger64vEXT");
+}
+#endif
+
+#pragma mark constructor/deconstructor
+
+Profiler::Profiler() {
+    // set defaults
+    gpuTimerSupport = false;
+    enabled = false;
+    windowSize = OGLES_GPGPU_PROFILER_DEFAULT_WINDOW_SIZE;
+    trace = NULL;
+    curFrame = 0;
+}
+
+Profiler::~Profiler() {
+    clear();
+}
+
+#pragma mark public methods
+
+bool Profiler::initGPUTimerSupport(bool glExtDisjointTimerQuery) {
+    gpuTimerSupport = false;
+
+#ifdef OGLES_GPGPU_PROFILER_USE_TIMER_QUERY
+    if (glExtDisjointTimerQuery) {
+        call_once(timerQueryFuncsLoaded, loadTimerQueryFuncs);
+        
+        if (glExtGenQueries && glExtDeleteQueries && glExtQueryCounter && glExtGetQueryiv
+         && glExtGetQueryObjectuiv && glExtGetQueryObjectui64v && glExtGetInteger64v)
+        {
+            // timestamp queries are optional in this extension. they are
+            // supported if the timestamp counter has more than 0 bits
+            GLint counterBits = 0;
+            glExtGetQueryiv(GL_TIMESTAMP_EXT, GL_QUERY_COUNTER_BITS_EXT, &counterBits);
+            gpuTimerSupport = counterBits > 0;
+            
+            Tools::checkGLErr("Profiler", "query timestamp counter bits");
+        }
+    }
+#endif
+    
+    OG_LOGINF("Profiler", "GPU timer support: %d", gpuTimerSupport);
+    
+    return gpuTimerSupport;
+}
+
+void Profiler::setWindowSize(int size) {
+    assert(size > 0);
+    
+    windowSize = size;
+    resetSamples();
+}
+
+void Profiler::setTraceRecorder(TraceRecorder *trace) {
+    this->trace = trace;
+    
+    if (trace) {
+        setTraceGPUClockReference();
+    }
+}
+
+int Profiler::addStage(const string &name, int parent) {
+    assert(parent < (int)stages.size());
+    
+    Stage s;
+    s.name = name;
+    s.parent = parent;
+    s.depth = parent >= 0 ? stages[parent].depth + 1 : 0;
+    s.frame = 0;
+    s.oldestPending = 0;
+    s.numPending = 0;
+    memset(s.queries, 0, sizeof(s.queries));
+    memset(s.queryFrames, 0, sizeof(s.queryFrames));
+    
+    resetWindow(s.cpuSamples);
+    resetWindow(s.gpuSamples);
+    
+    stages.push_back(s);
+    
+    return (int)stages.size() - 1;
+}
+
+void Profiler::clear() {
+    for (vector<Stage>::iterator it = stages.begin();
+         it != stages.end();
+         ++it)
+    {
+        releaseQueries(*it);
+    }
+    
+    stages.clear();
+}
+
+void Profiler::resetSamples() {
+    for (vector<Stage>::iterator it = stages.begin();
+         it != stages.end();
+         ++it)
+    {
+        resetWindow(it->cpuSamples);
+        resetWindow(it->gpuSamples);
+    }
+}
+
+void Profiler::collectGPUResults() {
+#ifdef OGLES_GPGPU_PROFILER_USE_TIMER_QUERY
+    if (!gpuTimerSupport) return;
+    
+    vector<GPUResult> results;
+    
+    for (int i = 0; i < (int)stages.size(); i++) {
+        fetchGPUResults(i, results);
+    }
+    
+    // results that were measured during a disjoint operation are invalid.
+    // reading the disjoint state also resets it
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    
+    if (disjoint) {
+        OG_LOGINF("Profiler", "GPU disjoint operation occurred, discarding %d GPU time samples", (int)results.size());
+        
+        // the GPU clock might have been reset
+        if (trace) {
+            setTraceGPUClockReference();
+        }
+        
+        return;
+    }
+    
+    for (vector<GPUResult>::iterator it = results.begin();
+         it != results.end();
+         ++it)
+    {
+        Stage &s = stages[it->stage];
+        
+        if (enabled) {
+            addSample(s.gpuSamples, (double)(it->endNs - it->beginNs) / 1000000.0);
+        }
+        
+        if (trace) {
+            trace->addGPUEvent(s.name, it->beginNs, it->endNs, it->frame);
+        }
+    }
+#endif
+}
+
+vector<ProfilerStageStats> Profiler::getStats() {
+    collectGPUResults();
+    
+    vector<ProfilerStageStats> stats;
+    
+    for (vector<Stage>::const_iterator it = stages.begin();
+         it != stages.end();
+         ++it)
+    {
+        ProfilerStageStats st;
+        st.name = it->name;
+        st.depth = it->depth;
+        st.cpu = calcStats(it->cpuSamples);
+        st.gpu = calcStats(it->gpuSamples);
+        
+        stats.push_back(st);
+    }
+    
+    return stats;
+}
+
+void Profiler::printStats() {
+    vector<ProfilerStageStats> stats = getStats();
+    
+    OG_LOGINF("Profiler", "stage times in ms (min / mean / p95), %d samples per stage max.", windowSize);
+    
+    for (vector<ProfilerStageStats>::const_iterator it = stats.begin();
+         it != stats.end();
+         ++it)
+    {
+        OG_LOGINF("Profiler", "%*s%s: CPU %.3f / %.3f / %.3f (%u), GPU %.3f / %.3f / %.3f (%u)",
+                  it->depth * 2, "", it->name.c_str(),
+                  it->cpu.min, it->cpu.mean, it->cpu.p95, it->cpu.numSamples,
+                  it->gpu.min, it->gpu.mean, it->gpu.p95, it->gpu.numSamples);
+    }
+}
+
+#pragma mark private methods
+
+void Profiler::beginStageMeasurement(int stage) {
+    assert(stage < (int)stages.size());
+    
+    Stage &s = stages[stage];
+
+#ifdef OGLES_GPGPU_PROFILER_USE_TIMER_QUERY
+    if (gpuTimerSupport) {
+        if (s.queries[0][0] == 0) {     // create queries on first use
+            glExtGenQueries(OGLES_GPGPU_PROFILER_MAX_PENDING_QUERIES * 2, &s.queries[0][0]);
+        }
+        
+        if (s.numPending == OGLES_GPGPU_PROFILER_MAX_PENDING_QUERIES) {
+            collectGPUResults();
+            
+            if (s.numPending == OGLES_GPGPU_PROFILER_MAX_PENDING_QUERIES) {    // still no result available
+                s.oldestPending = (s.oldestPending + 1) % OGLES_GPGPU_PROFILER_MAX_PENDING_QUERIES;
+                s.numPending--;
+            }
+        }
+        
+        int idx = (s.oldestPending + s.numPending) % OGLES_GPGPU_PROFILER_MAX_PENDING_QUERIES;
+        glExtQueryCounter(s.queries[idx][0], GL_TIMESTAMP_EXT);
+        s.queryFrames[idx] = curFrame;
+    }
+#endif
+    
+    s.frame = curFrame;
+    s.cpuStart = Clock::now();
+}
+
+void Profiler::endStageMeasurement(int stage) {
+    assert(stage < (int)stages.size());
+    
+    Stage &s = stages[stage];
+    
+    Clock::time_point cpuEnd = Clock::now();
+    
+    if (enabled) {
+        addSample(s.cpuSamples, chrono::duration<double, milli>(cpuEnd - s.cpuStart).count());
+    }
+    
+    if (trace) {
+        trace->addCPUEvent(s.name, s.cpuStart, cpuEnd, s.frame);
+    }
+
+#ifdef OGLES_GPGPU_PROFILER_USE_TIMER_QUERY
+    if (gpuTimerSupport) {
+        int idx = (s.oldestPending + s.numPending) % OGLES_GPGPU_PROFILER_MAX_PENDING_QUERIES;
+        glExtQueryCounter(s.queries[idx][1], GL_TIMESTAMP_EXT);
+        s.numPending++;
+    }
+#endif
+}
+
+void Profiler::fetchGPUResults(int stage, vector<GPUResult> &results) {
+#ifdef OGLES_GPGPU_PROFILER_USE_TIMER_QUERY
+    Stage &s = stages[stage];
+    
+    while (s.numPending > 0) {
+        GLuint *q = s.queries[s.oldestPending];
+        
+        // queries complete in order, so the begin timestamp is available
+        // when the end timestamp is available
+        GLuint available = 0;
+        glExtGetQueryObjectuiv(q[1], GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+        
+        if (!available) break;
+        
+        GLuint64 tBegin = 0, tEnd = 0;
+        glExtGetQueryObjectui64v(q[0], GL_QUERY_RESULT_EXT, &tBegin);
+        glExtGetQueryObjectui64v(q[1], GL_QUERY_RESULT_EXT, &tEnd);
+        
+        if (tEnd >= tBegin) {
+            GPUResult res;
+            res.stage = stage;
+            res.beginNs = tBegin;
+            res.endNs = tEnd;
+            res.frame = s.queryFrames[s.oldestPending];
+            
+            results.push_back(res);
+        }
+        
+        s.oldestPending = (s.oldestPending + 1) % OGLES_GPGPU_PROFILER_MAX_PENDING_QUERIES;
+        s.numPending--;
+    }
+#endif
+}
+
+void Profiler::setTraceGPUClockReference() {
+#ifdef OGLES_GPGPU_PROFILER_USE_TIMER_QUERY
+    if (!gpuTimerSupport) return;
+    
+    // the current GPU time is returned without waiting for pending commands
+    GLint64 gpuTime = 0;
+    glExtGetInteger64v(GL_TIMESTAMP_EXT, &gpuTime);
+    
+    trace->setGPUClockReference((unsigned long long)gpuTime, Clock::now());
+#endif
+}
+
+void Profiler::releaseQueries(Stage &s) {
+#ifdef OGLES_GPGPU_PROFILER_USE_TIMER_QUERY
+    if (s.queries[0][0] > 0) {
+        glExtDeleteQueries(OGLES_GPGPU_PROFILER_MAX_PENDING_QUERIES * 2, &s.queries[0][0]);
+    }
+#endif
+    
+    memset(s.queries, 0, sizeof(s.queries));
+    s.oldestPending = 0;
+    s.numPending = 0;
+}
+
+void Profiler::resetWindow(SampleWindow &w) {
+    w.samples.assign(windowSize, 0.0);
+    w.next = 0;
+    w.num = 0;
+}
+
+void Profiler::addSample(SampleWindow &w, double ms) {
+    w.samples[w.next] = ms;
+    w.next = (w.next + 1) % (int)w.samples.size();
+    w.num = min(w.num + 1, (int)w.samples.size());
+}
+
+ProfilerTimeStats Profiler::calcStats(const SampleWindow &w) {
+    ProfilerTimeStats st;
+    st.numSamples = w.num;
+    st.min = st.mean = st.p95 = 0.0;
+    
+    if (w.num == 0) return st;
+    
+    // the valid samples are the first <num> samples as long as the window was not filled
+    vector<double> sorted(w.samples.begin(), w.samples.begin() + w.num);
+    sort(sorted.begin(), sorted.end());
+    
+    double sum = 0.0;
+    for (vector<double>::const_iterator it = sorted.begin();
+         it != sorted.end();
+         ++it)
+    {
+        sum += *it;
+    }
+    
+    // nearest-rank percentile
+    int p95Idx = (int)ceil(0.95 * w.num) - 1;
+    
+    st.min = sorted.front();
+    st.mean = sum / w.num;
+    st.p95 = sorted[max(p95Idx, 0)];
+    
+    return st;
+}
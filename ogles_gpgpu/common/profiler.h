@@ -0,0 +1,285 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Profiler for CPU and GPU times of pipeline stages.
+ */
+
+#ifndef OGLES_GPGPU_COMMON_PROFILER
+#define OGLES_GPGPU_COMMON_PROFILER
+
+#include "common_includes.h"
+#include "trace_recorder.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define OGLES_GPGPU_PROFILER_DEFAULT_WINDOW_SIZE    120
+#define OGLES_GPGPU_PROFILER_MAX_PENDING_QUERIES    8
+
+namespace ogles_gpgpu {
+
+/**
+ * Aggregated time measurements of a stage (in milliseconds) over the rolling window.
+ * All values are 0 if no samples were measured (<numSamples> is 0).
+ */
+typedef struct {
+    unsigned int numSamples;    // number of samples in the window
+    double min;
+    double mean;
+    double p95;                 // 95th percentile
+} ProfilerTimeStats;
+
+/**
+ * Measurements of a profiled stage.
+ */
+typedef struct {
+    string name;            // stage name
+    int depth;              // nesting depth (0 for Core methods, 1 for processors, 2 for passes)
+    ProfilerTimeStats cpu;  // CPU (wall clock) time for submitting the stage's commands
+    ProfilerTimeStats gpu;  // GPU execution time of the stage's commands
+} ProfilerStageStats;
+
+/**
+ * Profiler for the stages of a processing pipeline. A stage is a Core method or
+ * the render() call of a processor or of a single pass of a multipass processor.
+ * Stages are registered with addStage() and are measured between beginStage()
+ * and endStage().
+ * The CPU time is the wall clock time (std::chrono::steady_clock) between both
+ * calls, i.e. the time for submitting the commands. The GPU time is the time the
+ * GPU spent on these commands. It is measured with timestamp queries of the
+ * EXT_disjoint_timer_query extension, when available (see initGPUTimerSupport()).
+ * Query results are collected a few frames later without stalling the pipeline.
+ * Results of queries that overlapped a disjoint operation (e.g. a GPU frequency
+ * change) are discarded.
+ * Each stage keeps the last <windowSize> samples, from which the min, mean and
+ * 95th percentile (p95) are calculated in getStats().
+ * Additionally, a TraceRecorder can be attached, which records each measurement
+ * as CPU and GPU event on a timeline (see setTraceRecorder()).
+ * Profiling is disabled by default. Disabled profiling and tracing costs one branch
+ * per stage.
+ */
+class Profiler {
+public:
+    /**
+     * Constructor. Set defaults.
+     */
+    Profiler();
+    
+    /**
+     * Deconstructor. Deletes all queries.
+     */
+    ~Profiler();
+    
+    /**
+     * Check if GPU timer queries (EXT_disjoint_timer_query with timestamp support)
+     * are available in the current OpenGL context, which is then used for profiling.
+     * <glExtDisjointTimerQuery> signals the availability of the extension. Returns
+     * true if GPU times can be measured.
+     */
+    bool initGPUTimerSupport(bool glExtDisjointTimerQuery);
+    
+    /**
+     * Returns true if GPU times can be measured.
+     */
+    bool getGPUTimerSupport() const { return gpuTimerSupport; }
+    
+    /**
+     * Enable profiling: <enabled>.
+     */
+    void setEnabled(bool enabled) { this->enabled = enabled; }
+    
+    /**
+     * Get "enabled" status.
+     */
+    bool getEnabled() const { return enabled; }
+    
+    /**
+     * Attach trace recorder <trace> (weak ref) or detach it by passing NULL. The
+     * measurements of all stages are then recorded in the trace recorder, even if
+     * profiling is disabled. Needs a current OpenGL context to set the GPU clock
+     * reference of the trace recorder.
+     */
+    void setTraceRecorder(TraceRecorder *trace);
+    
+    /**
+     * Get the attached trace recorder (may be NULL).
+     */
+    TraceRecorder *getTraceRecorder() const { return trace; }
+    
+    /**
+     * Returns true if stages are measured, i.e. profiling is enabled or a trace recorder
+     * is attached.
+     */
+    bool getActive() const { return enabled || trace; }
+    
+    /**
+     * Set the number of the frame that the following measurements belong to: <frame>.
+     */
+    void setFrame(unsigned long frame) { curFrame = frame; }
+    
+    /**
+     * Set the number of samples per stage to aggregate to <size>. Clears all samples.
+     */
+    void setWindowSize(int size);
+    
+    /**
+     * Get the number of samples per stage to aggregate.
+     */
+    int getWindowSize() const { return windowSize; }
+    
+    /**
+     * Register a stage with name <name> as sub-stage of stage <parent> (-1 for none).
+     * Returns the stage id.
+     */
+    int addStage(const string &name, int parent = -1);
+    
+    /**
+     * Get the number of registered stages.
+     */
+    int getNumStages() const { return (int)stages.size(); }
+    
+    /**
+     * Remove all stages and delete their queries.
+     */
+    void clear();
+    
+    /**
+     * Discard all samples of all stages.
+     */
+    void resetSamples();
+    
+    /**
+     * Start measuring stage <stage>.
+     */
+    void beginStage(int stage) {
+        if ((enabled || trace) && stage >= 0) beginStageMeasurement(stage);
+    }
+    
+    /**
+     * Stop measuring stage <stage>.
+     */
+    void endStage(int stage) {
+        if ((enabled || trace) && stage >= 0) endStageMeasurement(stage);
+    }
+    
+    /**
+     * Collect the results of all GPU queries that are available without waiting.
+     */
+    void collectGPUResults();
+    
+    /**
+     * Collect the available GPU results and return the aggregated measurements of
+     * all stages in the order in which they were registered.
+     */
+    vector<ProfilerStageStats> getStats();
+    
+    /**
+     * Print the aggregated measurements of all stages to the info log.
+     */
+    void printStats();
+
+private:
+    typedef chrono::steady_clock Clock;
+    
+    /**
+     * Result of a GPU timestamp query pair.
+     */
+    struct GPUResult {
+        int stage;
+        unsigned long long beginNs;
+        unsigned long long endNs;
+        unsigned long frame;
+    };
+    
+    /**
+     * Ring buffer of samples.
+     */
+    struct SampleWindow {
+        vector<double> samples;
+        int next;   // index for the next sample
+        int num;    // number of valid samples
+    };
+    
+    /**
+     * Profiled stage.
+     */
+    struct Stage {
+        string name;
+        int parent;
+        int depth;
+        
+        Clock::time_point cpuStart;     // start of the current CPU measurement
+        unsigned long frame;            // frame of the current measurement
+        SampleWindow cpuSamples;
+        SampleWindow gpuSamples;
+        
+        GLuint queries[OGLES_GPGPU_PROFILER_MAX_PENDING_QUERIES][2];    // pairs of begin/end timestamp queries
+        unsigned long queryFrames[OGLES_GPGPU_PROFILER_MAX_PENDING_QUERIES];    // frame of each query pair
+        int oldestPending;  // index of the oldest pending query pair
+        int numPending;     // number of pending query pairs
+    };
+    
+    /**
+     * Start measuring stage <stage>.
+     */
+    void beginStageMeasurement(int stage);
+    
+    /**
+     * Stop measuring stage <stage>.
+     */
+    void endStageMeasurement(int stage);
+    
+    /**
+     * Append the available query results of stage <stage> to <results>.
+     */
+    void fetchGPUResults(int stage, vector<GPUResult> &results);
+    
+    /**
+     * Set the GPU clock reference of the attached trace recorder to the current time.
+     */
+    void setTraceGPUClockReference();
+    
+    /**
+     * Delete the queries of stage <s>.
+     */
+    void releaseQueries(Stage &s);
+    
+    /**
+     * Reset sample window <w> to hold <windowSize> samples.
+     */
+    void resetWindow(SampleWindow &w);
+    
+    /**
+     * Add sample <ms> to window <w>.
+     */
+    static void addSample(SampleWindow &w, double ms);
+    
+    /**
+     * Calculate the statistics of window <w>.
+     */
+    static ProfilerTimeStats calcStats(const SampleWindow &w);
+    
+    
+    bool gpuTimerSupport;   // GPU timestamp queries available?
+    bool enabled;           // profiling enabled?
+    int windowSize;         // number of samples per stage
+    
+    TraceRecorder *trace;   // attached trace recorder. weak ref. may be NULL
+    unsigned long curFrame; // frame of the following measurements
+    
+    vector<Stage> stages;   // registered stages
+};
+
+}
+
+#endif
@@ -11,6 +11,7 @@
 
 #include "common_includes.h"
 
+#include <algorithm>
 #include <cmath>
 
 #ifndef log2f
@@ -20,16 +21,40 @@
 using namespace ogles_gpgpu;
 using namespace std;
 
+#ifdef DEBUG
+thread_local ValidationLevel Tools::validationLevel = VALIDATION_LEVEL_PER_CALL;
+#else
+thread_local ValidationLevel Tools::validationLevel = VALIDATION_LEVEL_PER_FRAME;
+#endif
+
 #ifdef OGLES_GPGPU_BENCHMARK
-clock_t Tools::startTick = 0;
-vector<double> Tools::timeMeasurements;
+thread_local chrono::steady_clock::time_point Tools::startTime;
+thread_local vector<double> Tools::timeMeasurements;
 #endif
 
-void Tools::checkGLErr(const char *cls, const char *msg) {
-	GLenum err = glGetError();
-	if (err != GL_NO_ERROR) {
-        OG_LOGERR(cls, "%s - GL error '%d' occured", msg, err);
+bool Tools::checkGLErrNow(const char *cls, const char *msg) {
+    bool hadErr = false;
+    
+    // several error flags might be set
+	GLenum err;
+	while ((err = glGetError()) != GL_NO_ERROR) {
+        OG_LOGERR(cls, "%s - GL error '%d' (%s) occured", msg, err, getGLErrName(err));
+        hadErr = true;
 	}
+    
+    return hadErr;
+}
+
+const char *Tools::getGLErrName(unsigned int err) {
+    switch (err) {
+        case GL_NO_ERROR:                       return "GL_NO_ERROR";
+        case GL_INVALID_ENUM:                   return "GL_INVALID_ENUM";
+        case GL_INVALID_VALUE:                  return "GL_INVALID_VALUE";
+        case GL_INVALID_OPERATION:              return "GL_INVALID_OPERATION";
+        case GL_INVALID_FRAMEBUFFER_OPERATION:  return "GL_INVALID_FRAMEBUFFER_OPERATION";
+        case GL_OUT_OF_MEMORY:                  return "GL_OUT_OF_MEMORY";
+        default:                                return "unknown error";
+    }
 }
 
 bool Tools::isPOT(float v) {
@@ -65,22 +90,63 @@ void Tools::strReplaceAll(string& str, const string& from, const string& to) {
     }
 }
 
+bool Tools::isGLES3Context() {
+    // version string format is "OpenGL ES <major>.<minor> <vendor specific>"
+    const char *glVersionStr = (const char *)glGetString(GL_VERSION);
+    int glMajVers = 0;
+    
+    return glVersionStr && sscanf(glVersionStr, "OpenGL ES %d", &glMajVers) == 1 && glMajVers >= 3;
+}
+
+bool Tools::isYUVFormat(unsigned int fmt) {
+    return fmt >= INPUT_FORMAT_Y8 && fmt <= INPUT_FORMAT_I420;
+}
+
+unsigned long long Tools::hashStr(unsigned long long hash, const char *str) {
+    do {
+        hash ^= (unsigned char)*str;
+        hash *= 1099511628211ULL;  // FNV-1a prime
+    } while (*str++);
+    
+    return hash;
+}
+
+ROI Tools::clipROI(const ROI &roi, int w, int h) {
+    ROI res = { 0, 0, 0, 0 };
+    
+    if (roi.w <= 0 || roi.h <= 0) return res;
+    
+    int x0 = max(0, roi.x);
+    int y0 = max(0, roi.y);
+    int x1 = min(w, roi.x + roi.w);
+    int y1 = min(h, roi.y + roi.h);
+    
+    if (x0 == 0 && y0 == 0 && x1 == w && y1 == h) return res;
+    
+    res.x = x0;
+    res.y = y0;
+    res.w = max(0, x1 - x0);
+    res.h = max(0, y1 - y0);
+    
+    return res;
+}
+
 #ifdef OGLES_GPGPU_BENCHMARK
 void Tools::resetTimeMeasurement() {
-    startTick = 0;
+    startTime = chrono::steady_clock::time_point();
     timeMeasurements.clear();
 }
 
 void Tools::startTimeMeasurement() {
-    startTick = clock();
+    startTime = chrono::steady_clock::now();
 }
 
 void Tools::stopTimeMeasurement() {
-    double ms = getTicksDiffInMs(startTick, clock());
+    double ms = getTimeDiffInMs(startTime, chrono::steady_clock::now());
     timeMeasurements.push_back(ms);
 }
 
-double Tools::getTicksDiffInMs(clock_t t1, clock_t t2) {
-    return (((double)(t2 - t1) / CLOCKS_PER_SEC) * 1000.0);
+double Tools::getTimeDiffInMs(chrono::steady_clock::time_point t1, chrono::steady_clock::time_point t2) {
+    return chrono::duration<double, milli>(t2 - t1).count();
 }
 #endif
\ No newline at end of file
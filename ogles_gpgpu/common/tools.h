@@ -16,23 +16,62 @@
 #include <vector>
 #include <string>
 #include <sstream>
-#include <ctime>
+#include <chrono>
 #include <cstdio>
 
+#include "types.h"
+
+#define OGLES_GPGPU_FNV1A_OFFSET_BASIS  14695981039346656037ULL  // start value of Tools::hashStr()
+
 using namespace std;
 
 namespace ogles_gpgpu {
 
+/**
+ * OpenGL error checking levels.
+ */
+typedef enum {
+    VALIDATION_LEVEL_OFF = 0,       // no OpenGL error checks
+    VALIDATION_LEVEL_PER_FRAME,     // one check at the end of Core::init(), Core::prepare() and each Core::process() call (default)
+    VALIDATION_LEVEL_PER_CALL       // check after each render step and OpenGL operation (default in DEBUG builds)
+} ValidationLevel;
+
 /**
  * Common tools collection.
  */
 class Tools {
 public:
     /**
-     * Check for an OpenGL error in the previous call(s). Produce error
-     * message in class <cls> with prefix <msg>.
+     * Check for an OpenGL error in the previous call(s) if the validation level of
+     * the current thread is VALIDATION_LEVEL_PER_CALL. Produce error message in class
+     * <cls> with prefix <msg>.
+     */
+    static void checkGLErr(const char *cls, const char *msg) {
+        if (validationLevel == VALIDATION_LEVEL_PER_CALL) checkGLErrNow(cls, msg);
+    }
+    
+    /**
+     * Check for OpenGL errors in the previous call(s) regardless of the validation
+     * level. Produce an error message in class <cls> with prefix <msg> for each error.
+     * Returns true if an error occurred.
      */
-    static void checkGLErr(const char *cls, const char *msg);
+    static bool checkGLErrNow(const char *cls, const char *msg);
+    
+    /**
+     * Set the validation level for checkGLErr() calls in the current thread to <level>.
+     * Core sets the level of its OpenGL context (see Core::setValidationLevel()).
+     */
+    static void setValidationLevel(ValidationLevel level) { validationLevel = level; }
+    
+    /**
+     * Get the validation level of the current thread.
+     */
+    static ValidationLevel getValidationLevel() { return validationLevel; }
+    
+    /**
+     * Return the name of OpenGL error code <err>.
+     */
+    static const char *getGLErrName(unsigned int err);
     
     /**
      * Check if <v> is a power-of-two (POT) value.
@@ -54,21 +93,49 @@ public:
      * Code from http://stackoverflow.com/a/3418285.
      */
     static void strReplaceAll(string& str, const string& from, const string& to);
+    
+    /**
+     * Returns true if the current OpenGL context is an OpenGL ES 3.0 (or later) context.
+     */
+    static bool isGLES3Context();
+    
+    /**
+     * Returns true if input pixel format <fmt> is one of the YUV formats (see InputYUVFormat).
+     */
+    static bool isYUVFormat(unsigned int fmt);
+    
+    /**
+     * Update the 64 bit FNV-1a hash <hash> with the bytes of <str> including the
+     * terminating 0 and return the new hash. Start with OGLES_GPGPU_FNV1A_OFFSET_BASIS.
+     */
+    static unsigned long long hashStr(unsigned long long hash, const char *str);
+    
+    /**
+     * Clip region of interest <roi> to a frame of size <w>x<h>. Returns a region with
+     * w = 0 (the whole frame) if <roi> already stands for the whole frame or covers it.
+     */
+    static ROI clipROI(const ROI &roi, int w, int h);
 
 #ifdef OGLES_GPGPU_BENCHMARK
+    /**
+     * Simple wall clock (steady clock) time measurements. For detailed measurements
+     * per processor and GPU times, see Profiler. The measurements are kept per thread,
+     * so that Core objects in different threads do not interfere.
+     */
     static void resetTimeMeasurement();
     static void startTimeMeasurement();
     static void stopTimeMeasurement();
     
-    static double getTicksDiffInMs(clock_t t1, clock_t t2);
+    static double getTimeDiffInMs(chrono::steady_clock::time_point t1, chrono::steady_clock::time_point t2);
     static vector<double> getTimeMeasurements() { return timeMeasurements; }
 #endif
     
 private:
+    static thread_local ValidationLevel validationLevel;    // validation level of the current thread
     
 #ifdef OGLES_GPGPU_BENCHMARK
-    static clock_t startTick;
-    static vector<double> timeMeasurements;
+    static thread_local chrono::steady_clock::time_point startTime;
+    static thread_local vector<double> timeMeasurements;
 #endif
 };
     
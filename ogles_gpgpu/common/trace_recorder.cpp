@@ -0,0 +1,153 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "trace_recorder.h"
+
+#include "common_includes.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+#pragma mark constructor
+
+TraceRecorder::TraceRecorder() {
+    // set defaults
+    nextIdx = 0;
+    numEvents = 0;
+    numDropped = 0;
+    hasGPUClockReference = false;
+    gpuRefNs = 0;
+    gpuRefUs = 0.0;
+    startTime = Clock::now();
+}
+
+#pragma mark public methods
+
+void TraceRecorder::start(size_t capacity) {
+    assert(capacity > 0);
+    
+    events.resize(capacity);
+    clear();
+    
+    startTime = Clock::now();
+    hasGPUClockReference = false;
+}
+
+void TraceRecorder::clear() {
+    nextIdx = 0;
+    numEvents = 0;
+    numDropped = 0;
+}
+
+void TraceRecorder::setGPUClockReference(unsigned long long gpuTimeNs, Clock::time_point cpuTime) {
+    gpuRefNs = gpuTimeNs;
+    gpuRefUs = chrono::duration<double, micro>(cpuTime - startTime).count();
+    hasGPUClockReference = true;
+}
+
+void TraceRecorder::addCPUEvent(const string &name, Clock::time_point begin, Clock::time_point end, unsigned long frame) {
+    if (events.empty()) return;     // not started
+    
+    Event &ev = nextEvent();
+    ev.name = name;     // reuses the memory of the overwritten event's name
+    ev.track = TRACE_TRACK_CPU;
+    ev.beginUs = chrono::duration<double, micro>(begin - startTime).count();
+    ev.durUs = chrono::duration<double, micro>(end - begin).count();
+    ev.frame = frame;
+}
+
+void TraceRecorder::addGPUEvent(const string &name, unsigned long long beginNs, unsigned long long endNs, unsigned long frame) {
+    if (events.empty() || !hasGPUClockReference) return;
+    
+    Event &ev = nextEvent();
+    ev.name = name;
+    ev.track = TRACE_TRACK_GPU;
+    ev.beginUs = gpuRefUs + ((double)beginNs - (double)gpuRefNs) / 1000.0;
+    ev.durUs = (double)(endNs - beginNs) / 1000.0;
+    ev.frame = frame;
+}
+
+void TraceRecorder::writeJSON(ostream &os) const {
+    os << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":" << numDropped << "},";
+    os << "\"traceEvents\":[" << endl;
+    
+    // name the tracks
+    os << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"ogles_gpgpu\"}}," << endl;
+    os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << getTrackTid(TRACE_TRACK_CPU) << ",\"args\":{\"name\":\"CPU\"}}," << endl;
+    os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << getTrackTid(TRACE_TRACK_GPU) << ",\"args\":{\"name\":\"GPU\"}}";
+    
+    os << fixed << setprecision(3);
+    
+    // write the events from oldest to newest as complete events ("X")
+    size_t oldestIdx = (nextIdx + events.size() - numEvents) % max(events.size(), (size_t)1);
+    for (size_t i = 0; i < numEvents; i++) {
+        const Event &ev = events[(oldestIdx + i) % events.size()];
+        
+        os << "," << endl << "{\"name\":";
+        writeJSONString(os, ev.name);
+        os << ",\"cat\":\"" << (ev.track == TRACE_TRACK_GPU ? "gpu" : "cpu") << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << getTrackTid(ev.track)
+           << ",\"ts\":" << ev.beginUs << ",\"dur\":" << ev.durUs
+           << ",\"args\":{\"frame\":" << ev.frame << "}}";
+    }
+    
+    os << endl << "]}" << endl;
+}
+
+bool TraceRecorder::writeJSONFile(const char *path) const {
+    ofstream f(path);
+    
+    if (!f) {
+        OG_LOGERR("TraceRecorder", "could not open file %s", path);
+        return false;
+    }
+    
+    writeJSON(f);
+    
+    return f.good();
+}
+
+#pragma mark private methods
+
+TraceRecorder::Event &TraceRecorder::nextEvent() {
+    Event &ev = events[nextIdx];
+    nextIdx = (nextIdx + 1) % events.size();
+    
+    if (numEvents < events.size()) {
+        numEvents++;
+    } else {
+        numDropped++;
+    }
+    
+    return ev;
+}
+
+void TraceRecorder::writeJSONString(ostream &os, const string &s) {
+    os << '"';
+    
+    for (string::const_iterator it = s.begin(); it != s.end(); ++it) {
+        unsigned char c = (unsigned char)*it;
+        
+        if (c == '"' || c == '\\') {
+            os << '\\' << (char)c;
+        } else if (c < 0x20) {  // control characters
+            char esc[8];
+            snprintf(esc, sizeof(esc), "\\u%04x", c);
+            os << esc;
+        } else {
+            os << (char)c;
+        }
+    }
+    
+    os << '"';
+}
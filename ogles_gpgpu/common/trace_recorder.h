@@ -0,0 +1,148 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Recorder for a timeline of pipeline events in the Chrome trace event format.
+ */
+
+#ifndef OGLES_GPGPU_COMMON_TRACE_RECORDER
+#define OGLES_GPGPU_COMMON_TRACE_RECORDER
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define OGLES_GPGPU_TRACE_DEFAULT_CAPACITY  16384
+
+namespace ogles_gpgpu {
+
+/**
+ * Tracks (rows) of the trace timeline.
+ */
+typedef enum {
+    TRACE_TRACK_CPU = 0,    // CPU time of the calls that submit the commands
+    TRACE_TRACK_GPU         // GPU execution of the commands
+} TraceTrack;
+
+/**
+ * Records timed events in a ring buffer with a fixed capacity and writes them as
+ * JSON in the Chrome trace event format, which can be loaded in chrome://tracing
+ * or in the Perfetto UI (https://ui.perfetto.dev).
+ * If the ring buffer is full, the oldest events are overwritten, so that memory
+ * usage is bounded and the trace contains the most recent events.
+ * CPU events are timed with std::chrono::steady_clock. GPU events are timed with
+ * GPU timestamps (in ns), which are mapped to the CPU timeline with a reference
+ * pair of simultaneous GPU and CPU times (see setGPUClockReference()).
+ * Events are added by the Profiler, which is attached to the trace recorder with
+ * Core::startTracing().
+ */
+class TraceRecorder {
+public:
+    typedef chrono::steady_clock Clock;
+    
+    /**
+     * Constructor. Set defaults.
+     */
+    TraceRecorder();
+    
+    /**
+     * Discard all events and start a new trace with a ring buffer of <capacity> events.
+     * Time 0 of the trace is the current time.
+     */
+    void start(size_t capacity = OGLES_GPGPU_TRACE_DEFAULT_CAPACITY);
+    
+    /**
+     * Discard all events.
+     */
+    void clear();
+    
+    /**
+     * Set GPU time <gpuTimeNs> (in ns) which corresponds to the CPU time <cpuTime>.
+     * Needed to map GPU timestamps to the CPU timeline.
+     */
+    void setGPUClockReference(unsigned long long gpuTimeNs, Clock::time_point cpuTime);
+    
+    /**
+     * Add a CPU event with name <name> from <begin> to <end>, belonging to frame <frame>.
+     */
+    void addCPUEvent(const string &name, Clock::time_point begin, Clock::time_point end, unsigned long frame);
+    
+    /**
+     * Add a GPU event with name <name> from GPU timestamp <beginNs> to <endNs> (in ns),
+     * belonging to frame <frame>. Ignored if no GPU clock reference was set.
+     */
+    void addGPUEvent(const string &name, unsigned long long beginNs, unsigned long long endNs, unsigned long frame);
+    
+    /**
+     * Get the number of events in the ring buffer.
+     */
+    size_t getNumEvents() const { return numEvents; }
+    
+    /**
+     * Get the number of events that were overwritten because the ring buffer was full.
+     */
+    unsigned long getNumDroppedEvents() const { return numDropped; }
+    
+    /**
+     * Write the recorded events as Chrome trace JSON to <os>.
+     */
+    void writeJSON(ostream &os) const;
+    
+    /**
+     * Write the recorded events as Chrome trace JSON to file <path>.
+     * Returns true on success.
+     */
+    bool writeJSONFile(const char *path) const;
+
+private:
+    /**
+     * Timed event.
+     */
+    struct Event {
+        string name;
+        TraceTrack track;
+        double beginUs;     // begin time in microseconds since trace start
+        double durUs;       // duration in microseconds
+        unsigned long frame;
+    };
+    
+    /**
+     * Return the next event slot in the ring buffer.
+     */
+    Event &nextEvent();
+    
+    /**
+     * Return the trace thread id for track <track> (thread ids start at 1).
+     */
+    static int getTrackTid(TraceTrack track) { return (int)track + 1; }
+    
+    /**
+     * Write string <s> as escaped JSON string to <os>.
+     */
+    static void writeJSONString(ostream &os, const string &s);
+    
+    
+    vector<Event> events;       // ring buffer of events
+    size_t nextIdx;             // index of the next event slot
+    size_t numEvents;           // number of valid events
+    unsigned long numDropped;   // number of overwritten events
+    
+    Clock::time_point startTime;    // time 0 of the trace
+    
+    bool hasGPUClockReference;      // was a GPU clock reference set?
+    unsigned long long gpuRefNs;    // GPU time of the reference
+    double gpuRefUs;                // CPU trace time of the reference
+};
+
+}
+
+#endif
@@ -25,6 +25,50 @@ typedef enum {
     RenderOrientationDiagonal
 } RenderOrientation;
 
+/**
+ * Region of interest: a rectangle at position <x>, <y> with size <w>x<h> in pixels
+ * of a frame. Row 0 is the first row of the frame data. A rectangle with <w> <= 0
+ * or <h> <= 0 stands for the whole frame (see Core::setROI()).
+ */
+typedef struct {
+    int x;
+    int y;
+    int w;
+    int h;
+} ROI;
+
+/**
+ * Output data formats (see Core::setOutputFormat()).
+ */
+typedef enum {
+    OUTPUT_FORMAT_RGBA = 0,     // 4 bytes per pixel (default)
+    OUTPUT_FORMAT_GRAY8,        // 1 byte per pixel: the red channel (the gray value of grayscale outputs)
+    OUTPUT_FORMAT_MASK1         // 1 bit per pixel: red channel >= 0.5 (e.g. thresholding outputs). 8 pixels per byte, first pixel in the lowest bit, rows padded to whole bytes
+} OutputFormat;
+
+/**
+ * Processing backends that execute the pipeline (see Core::setBackend()).
+ */
+typedef enum {
+    PROCESSING_BACKEND_GPU = 0, // render the processors' shaders with OpenGL (default)
+    PROCESSING_BACKEND_CPU,     // run reference implementations of the shaders on the CPU (see CPUKernels)
+    PROCESSING_BACKEND_AUTO     // select the faster one of both in Core::prepare() (see BackendTuner)
+} ProcessingBackend;
+
+/**
+ * YUV input data formats for Core::prepare() in addition to the OpenGL pixel formats
+ * (e.g. GL_RGBA). The values do not collide with OpenGL enums. All formats start with
+ * the Y plane (1 byte per pixel). The chroma planes have half the width and height
+ * (rounded up) and follow the Y plane. YUV values are converted to RGB with the full
+ * range BT.601 (JPEG) equations in the shaders of the processors that read the input.
+ */
+typedef enum {
+    INPUT_FORMAT_Y8 = 0x10001,  // Y plane only: gray input or the luma of any of the following formats
+    INPUT_FORMAT_NV12,          // Y plane, followed by a plane of interleaved U/V samples
+    INPUT_FORMAT_NV21,          // Y plane, followed by a plane of interleaved V/U samples (Android camera default)
+    INPUT_FORMAT_I420           // Y plane, followed by the U plane and the V plane
+} InputYUVFormat;
+
 }
 
 #endif
\ No newline at end of file
@@ -23,9 +23,12 @@
 // include processors
 
 #include "common/proc/adapt_thresh.h"
+#include "common/proc/blend.h"
+#include "common/proc/diff.h"
 #include "common/proc/disp.h"
 #include "common/proc/gauss.h"
 #include "common/proc/grayscale.h"
+#include "common/proc/pack.h"
 #include "common/proc/thresh.h"
 
 #endif
@@ -58,7 +58,21 @@ bool EGL::setup(int rSize, int gSize, int bSize, int aSize, int depthSize) {
 		return false;
 	}
     
+#ifdef OGLES_GPGPU_OPENGL_ES3
+	// try to create an OpenGL ES 3.0 context first (backwards compatible to OpenGL ES 2.0)
+	const EGLint ctxAttrES3[] = {
+        EGL_CONTEXT_CLIENT_VERSION, 3,
+        EGL_NONE
+	};
+    
+	ctx = eglCreateContext(disp, conf, EGL_NO_CONTEXT, ctxAttrES3);
+	if (ctx == EGL_NO_CONTEXT) {
+		OG_LOGINF("EGL", "OpenGL ES 3.0 context not available, falling back to OpenGL ES 2.0");
+		ctx = eglCreateContext(disp, conf, EGL_NO_CONTEXT, ctxAttr);
+	}
+#else
 	ctx = eglCreateContext(disp, conf, EGL_NO_CONTEXT, ctxAttr);
+#endif
 	if (ctx == EGL_NO_CONTEXT) {
 		OG_LOGERR("EGL", "eglCreateContext failed: %d", eglGetError());
 		return false;
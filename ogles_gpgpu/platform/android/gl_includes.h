@@ -8,8 +8,14 @@
 //
 
 /**
- * OpenGL ES 2.0 includes for Android.
+ * OpenGL ES 2.0 / 3.0 includes for Android.
  */
  
+// define OGLES_GPGPU_OPENGL_ES3 to compile with OpenGL ES 3.0 features (fences, pixel buffer
+// objects, etc.). they are only used when an OpenGL ES 3.0 context is detected at runtime.
+#ifdef OGLES_GPGPU_OPENGL_ES3
+#include <GLES3/gl3.h>
+#else
 #include <GLES2/gl2.h>
+#endif
 #include <GLES2/gl2ext.h>
\ No newline at end of file
@@ -15,6 +15,10 @@
 #define OG_TO_STR_(x) #x
 #define OG_TO_STR(x) OG_TO_STR_(x)
 
+// fragment shader precision statement for shaders that calculate exact texture
+// coordinates, which is not possible with mediump precision (might only be a half float)
+#define OG_FSHADER_PRECISION_HIGH "#ifdef GL_FRAGMENT_PRECISION_HIGH\nprecision highp float;\n#else\nprecision mediump float;\n#endif\n"
+
 #ifdef DEBUG
 
 #define OG_LOGINF(class, args...)  __android_log_write(ANDROID_LOG_INFO, "ogles_gpgpu", class); __android_log_write(ANDROID_LOG_INFO, "ogles_gpgpu", __FUNCTION__); __android_log_print(ANDROID_LOG_INFO, "ogles_gpgpu", args)
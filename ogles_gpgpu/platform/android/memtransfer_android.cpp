@@ -120,6 +120,11 @@ MemTransferAndroid::~MemTransferAndroid() {
 #pragma mark public methods
 
 void MemTransferAndroid::releaseInput() {
+    if (Tools::isYUVFormat(inputPixelFormat)) {     // plane textures of MemTransfer
+        MemTransfer::releaseInput();
+        return;
+    }
+    
     // release input image
     if (inputImage) {
     	OG_LOGINF("MemTransferAndroid", "releasing input image");
@@ -169,6 +174,10 @@ void MemTransferAndroid::init() {
 GLuint MemTransferAndroid::prepareInput(int inTexW, int inTexH, GLenum inputPxFormat, void *inputDataPtr) {
     assert(initialized && inTexW > 0 && inTexH > 0);
     
+    if (Tools::isYUVFormat(inputPxFormat)) {    // plane textures are updated with glTexSubImage2D()
+        return MemTransfer::prepareInput(inTexW, inTexH, inputPxFormat);
+    }
+    
     if (inputDataPtr == NULL && inputW == inTexW && inputH == inTexH && inputPixelFormat == inputPxFormat) {
         return inputTexId; // no change
     }
@@ -300,6 +309,11 @@ GLuint MemTransferAndroid::prepareOutput(int outTexW, int outTexH) {
 }
 
 void MemTransferAndroid::toGPU(const unsigned char *buf) {
+    if (Tools::isYUVFormat(inputPixelFormat)) {     // plane textures are updated with glTexSubImage2D()
+        MemTransfer::toGPU(buf);
+        return;
+    }
+    
     assert(preparedInput && inputPixelBuffer && inputTexId > 0 && buf);
     
     // bind the input texture
@@ -314,7 +328,13 @@ void MemTransferAndroid::toGPU(const unsigned char *buf) {
 	unsigned char *graphicsPtr = (unsigned char *)lockBufferAndGetPtr(BUF_TYPE_INPUT);
     
 	// copy whole image from "buf" to "graphicsPtr"
-    memcpy(graphicsPtr, buf, inputW * inputH * 4);
+    if (getInputRowsArePacked()) {
+        memcpy(graphicsPtr, buf, inputW * inputH * 4);
+    } else {    // copy row by row from padded input
+        for (int y = 0; y < inputH; y++) {
+            memcpy(graphicsPtr + y * inputW * 4, buf + y * inputRowStride, inputW * 4);
+        }
+    }
     
 	// unlock the graphics buffer again
 	unlockBuffer(BUF_TYPE_INPUT);
@@ -335,8 +355,8 @@ void MemTransferAndroid::fromGPU(unsigned char *buf) {
 	// lock the graphics buffer at graphicsPtr
 	const unsigned char *graphicsPtr = (const unsigned char *)lockBufferAndGetPtr(BUF_TYPE_OUTPUT);
     
-	// copy whole image from "graphicsPtr" to "buf"
-    memcpy(buf, graphicsPtr, outputW * outputH * 4);
+	// copy the read rectangle (by default the whole image) from "graphicsPtr" to "buf"
+    copyOutputReadRect(graphicsPtr, buf);
     
 	// unlock the graphics buffer again
 	unlockBuffer(BUF_TYPE_OUTPUT);
@@ -8,8 +8,14 @@
 //
 
 /**
- * OpenGL ES 2.0 includes for iOS.
+ * OpenGL ES 2.0 / 3.0 includes for iOS.
  */
 
+// define OGLES_GPGPU_OPENGL_ES3 to compile with OpenGL ES 3.0 features (fences, pixel buffer
+// objects, etc.). they are only used when an OpenGL ES 3.0 context is detected at runtime.
+#ifdef OGLES_GPGPU_OPENGL_ES3
+#include <OpenGLES/ES3/gl.h>
+#else
 #include <OpenGLES/ES2/gl.h>
+#endif
 #include <OpenGLES/ES2/glext.h>
\ No newline at end of file
@@ -11,7 +11,7 @@
 
 #import <CoreVideo/CoreVideo.h>
 
-#include "../../common/core.h"
+#include "../../common/common_includes.h"
 
 /**
  * Most code as from http://allmybrain.com/2011/12/08/rendering-to-a-texture-with-ios-5-texture-cache-api/
@@ -46,6 +46,11 @@ MemTransferIOS::~MemTransferIOS() {
 #pragma mark public methods
 
 void MemTransferIOS::releaseInput() {
+    if (Tools::isYUVFormat(inputPixelFormat)) {     // plane textures of MemTransfer
+        MemTransfer::releaseInput();
+        return;
+    }
+    
     if (inputPixelBuffer) {
         CVPixelBufferRelease(inputPixelBuffer);
         inputPixelBuffer = NULL;
@@ -96,7 +101,6 @@ void MemTransferIOS::init() {
                          empty);
     
     // create texture cache
-    void *glCtxPtr = Core::getInstance()->getGLContextPtr();
     OG_LOGINF("MemTransferIOS", "OpenGL ES context at %p", glCtxPtr);
     assert(glCtxPtr);
     CVReturn res = CVOpenGLESTextureCacheCreate(kCFAllocatorDefault,
@@ -116,6 +120,10 @@ void MemTransferIOS::init() {
 GLuint MemTransferIOS::prepareInput(int inTexW, int inTexH, GLenum inputPxFormat, void *inputDataPtr) {
     assert(initialized && inTexW > 0 && inTexH > 0);
     
+    if (Tools::isYUVFormat(inputPxFormat)) {    // plane textures are updated with glTexSubImage2D()
+        return MemTransfer::prepareInput(inTexW, inTexH, inputPxFormat);
+    }
+    
     if (inputDataPtr == NULL && inputW == inTexW && inputH == inTexH && inputPixelFormat == inputPxFormat) {
         return inputTexId; // no change
     }
@@ -271,11 +279,22 @@ GLuint MemTransferIOS::prepareOutput(int outTexW, int outTexH) {
 }
 
 void MemTransferIOS::toGPU(const unsigned char *buf) {
+    if (Tools::isYUVFormat(inputPixelFormat)) {     // plane textures are updated with glTexSubImage2D()
+        MemTransfer::toGPU(buf);
+        return;
+    }
+    
     assert(preparedInput && inputPixelBuffer && inputTexId > 0 && buf);
     
     // copy data to pixel buffer
     void *pixelBufferAddr = lockBufferAndGetPtr(BUF_TYPE_INPUT);
-    memcpy(pixelBufferAddr, buf, inputPixelBufferSize);
+    if (getInputRowsArePacked()) {
+        memcpy(pixelBufferAddr, buf, inputPixelBufferSize);
+    } else {    // copy row by row from padded input
+        for (int y = 0; y < inputH; y++) {
+            memcpy((unsigned char *)pixelBufferAddr + y * inputW * 4, buf + y * inputRowStride, inputW * 4);
+        }
+    }
     unlockBuffer(BUF_TYPE_INPUT);
 
     // bind the texture
@@ -289,7 +308,7 @@ void MemTransferIOS::fromGPU(unsigned char *buf) {
 	glBindTexture(GL_TEXTURE_2D, outputTexId);
     
     const void *pixelBufferAddr = lockBufferAndGetPtr(BUF_TYPE_OUTPUT);
-    memcpy(buf, pixelBufferAddr, outputPixelBufferSize);
+    copyOutputReadRect((const unsigned char *)pixelBufferAddr, buf);
     unlockBuffer(BUF_TYPE_OUTPUT);
 }
 
@@ -35,17 +35,18 @@ public:
     static bool initPlatformOptimizations();
 
     /**
-     * Constructor. Set defaults.
+     * Constructor for OpenGL context <glContext> (EAGLContext). Set defaults.
      */
-    MemTransferIOS() :  MemTransfer(),
-                        bufferAttr(NULL),
-                        inputPixelBuffer(NULL),
-                        outputPixelBuffer(NULL),
-                        inputTexture(NULL),
-                        outputTexture(NULL),
-                        textureCache(NULL),
-                        inputPixelBufferSize(0),
-                        outputPixelBufferSize(0) { }
+    MemTransferIOS(void *glContext) :   MemTransfer(),
+                                        glCtxPtr(glContext),
+                                        bufferAttr(NULL),
+                                        inputPixelBuffer(NULL),
+                                        outputPixelBuffer(NULL),
+                                        inputTexture(NULL),
+                                        outputTexture(NULL),
+                                        textureCache(NULL),
+                                        inputPixelBufferSize(0),
+                                        outputPixelBufferSize(0) { }
     
     /**
      * Deconstructor. Release in- and outputs.
@@ -106,6 +107,8 @@ private:
     void getPixelBufferAndLockFlags(BufType bufType, CVPixelBufferRef *buf, CVOptionFlags *lockOpt);
     
     
+    void *glCtxPtr;                     // OpenGL context (EAGLContext), weak ref.
+    
     CFMutableDictionaryRef bufferAttr;  // buffer attributes
     
     CVPixelBufferRef inputPixelBuffer;  // input pixel buffer
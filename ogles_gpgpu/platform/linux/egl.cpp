@@ -0,0 +1,230 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "egl.h"
+
+#include <EGL/eglext.h>
+
+#include "../../common/common_includes.h"
+
+#include <string>
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+EGLConfig EGL::conf = NULL;
+EGLSurface EGL::surface = EGL_NO_SURFACE;
+EGLContext EGL::ctx = EGL_NO_CONTEXT;
+EGLDisplay EGL::disp = EGL_NO_DISPLAY;
+bool EGL::surfacelessSupported = false;
+
+bool EGL::setup(int rSize, int gSize, int bSize, int aSize, int depthSize) {
+	// EGL config attributes
+	const EGLint confAttr[] = {
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,	// use OpenGL ES 2.0, very important!
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,			// we might create a pixelbuffer surface
+        EGL_RED_SIZE, 	rSize,
+        EGL_GREEN_SIZE, gSize,
+        EGL_BLUE_SIZE, 	bSize,
+        EGL_ALPHA_SIZE, aSize,
+        EGL_DEPTH_SIZE, depthSize,
+        EGL_NONE
+	};
+
+	EGLint eglMajVers, eglMinVers;
+	EGLint numConfigs;
+
+	disp = getDisplay();
+	if (disp == EGL_NO_DISPLAY) {
+		OG_LOGERR("EGL", "eglGetDisplay failed: %d", eglGetError());
+		return false;
+	}
+
+	if (!eglInitialize(disp, &eglMajVers, &eglMinVers)) {
+		OG_LOGERR("EGL", "eglInitialize failed: %d", eglGetError());
+		return false;
+	}
+
+	OG_LOGINF("EGL", "EGL init with version %d.%d", eglMajVers, eglMinVers);
+
+    // check for surfaceless context support
+    const char *dispExt = eglQueryString(disp, EGL_EXTENSIONS);
+    surfacelessSupported = dispExt && string(dispExt).find("EGL_KHR_surfaceless_context") != string::npos;
+
+    OG_LOGINF("EGL", "surfaceless context support: %d", surfacelessSupported);
+
+	if (!eglBindAPI(EGL_OPENGL_ES_API)) {
+		OG_LOGERR("EGL", "eglBindAPI failed: %d", eglGetError());
+		return false;
+	}
+
+	if (!eglChooseConfig(disp, confAttr, &conf, 1, &numConfigs) || numConfigs < 1) {	// choose the first config
+		OG_LOGERR("EGL", "eglChooseConfig failed: %d", eglGetError());
+		return false;
+	}
+
+	ctx = createGLESContext(EGL_NO_CONTEXT);
+	if (ctx == EGL_NO_CONTEXT) {
+		OG_LOGERR("EGL", "eglCreateContext failed: %d", eglGetError());
+		return false;
+	}
+
+    return true;
+}
+
+bool EGL::createPBufferSurface(int w, int h) {
+    assert(disp != EGL_NO_DISPLAY && conf != NULL && ctx != EGL_NO_CONTEXT);
+    assert(w > 0 && h > 0);
+
+    destroySurface();
+
+	// surface attributes
+	// the surface size is set to the input frame size
+	const EGLint surfaceAttr[] = {
+        EGL_WIDTH, w,
+        EGL_HEIGHT, h,
+        EGL_NONE
+	};
+
+	surface = eglCreatePbufferSurface(disp, conf, surfaceAttr);	// create a pixelbuffer surface
+	if (surface == EGL_NO_SURFACE) {
+		OG_LOGERR("EGL", "eglCreatePbufferSurface failed: %d", eglGetError());
+		return false;
+	}
+
+    return true;
+}
+
+bool EGL::activate() {
+    assert(disp != EGL_NO_DISPLAY && conf != NULL && ctx != EGL_NO_CONTEXT);
+    assert(surface != EGL_NO_SURFACE || surfacelessSupported);
+
+	if (!eglMakeCurrent(disp, surface, surface, ctx)) {
+		OG_LOGERR("EGL", "eglMakeCurrent failed: %d", eglGetError());
+		return false;
+	}
+
+    return true;
+}
+
+bool EGL::deactivate() {
+    if (disp == EGL_NO_DISPLAY) return true;    // nothing to do
+
+	if (!eglMakeCurrent(disp, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT)) {
+		OG_LOGERR("EGL", "eglMakeCurrent failed: %d", eglGetError());
+		return false;
+	}
+
+    return true;
+}
+
+void EGL::shutdown() {
+    deactivate();
+
+    destroySurface();
+    eglDestroyContext(disp, ctx);
+    eglTerminate(disp);
+
+    disp = EGL_NO_DISPLAY;
+    ctx = EGL_NO_CONTEXT;
+    conf = NULL;
+}
+
+EGLContext EGL::createContext(bool shareObjects) {
+    assert(disp != EGL_NO_DISPLAY && conf != NULL && ctx != EGL_NO_CONTEXT);
+
+    if (!surfacelessSupported) {
+        OG_LOGERR("EGL", "additional contexts need surfaceless context support");
+        return EGL_NO_CONTEXT;
+    }
+
+    EGLContext c = createGLESContext(shareObjects ? ctx : EGL_NO_CONTEXT);
+    if (c == EGL_NO_CONTEXT) {
+        OG_LOGERR("EGL", "eglCreateContext failed: %d", eglGetError());
+    }
+
+    return c;
+}
+
+bool EGL::activateContext(EGLContext c) {
+    assert(disp != EGL_NO_DISPLAY);
+
+    if (!eglMakeCurrent(disp, EGL_NO_SURFACE, EGL_NO_SURFACE, c)) {
+        OG_LOGERR("EGL", "eglMakeCurrent failed: %d", eglGetError());
+        return false;
+    }
+
+    return true;
+}
+
+void EGL::destroyContext(EGLContext c) {
+    if (disp == EGL_NO_DISPLAY || c == EGL_NO_CONTEXT) return;
+
+    eglDestroyContext(disp, c);
+}
+
+EGLDisplay EGL::getDisplay() {
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+    // check client extensions for the surfaceless platform
+    const char *clientExt = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+    if (clientExt && string(clientExt).find("EGL_MESA_platform_surfaceless") != string::npos) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+        if (getPlatformDisplay) {
+            EGLDisplay d = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+
+            if (d != EGL_NO_DISPLAY) {
+                OG_LOGINF("EGL", "using surfaceless platform display");
+                return d;
+            }
+        }
+    }
+#endif
+
+    // fallback: default display (needs X11 or Wayland)
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+EGLContext EGL::createGLESContext(EGLContext shareCtx) {
+	// EGL context attributes
+	const EGLint ctxAttr[] = {
+        EGL_CONTEXT_CLIENT_VERSION, 2,				// use OpenGL ES 2.0, very important!
+        EGL_NONE
+	};
+
+	EGLContext c;
+
+#ifdef OGLES_GPGPU_OPENGL_ES3
+	// try to create an OpenGL ES 3.0 context first (backwards compatible to OpenGL ES 2.0)
+	const EGLint ctxAttrES3[] = {
+        EGL_CONTEXT_CLIENT_VERSION, 3,
+        EGL_NONE
+	};
+    
+	c = eglCreateContext(disp, conf, shareCtx, ctxAttrES3);
+	if (c == EGL_NO_CONTEXT) {
+		OG_LOGINF("EGL", "OpenGL ES 3.0 context not available, falling back to OpenGL ES 2.0");
+		c = eglCreateContext(disp, conf, shareCtx, ctxAttr);
+	}
+#else
+	c = eglCreateContext(disp, conf, shareCtx, ctxAttr);
+#endif
+
+	return c;
+}
+
+void EGL::destroySurface() {
+    if (surface == EGL_NO_SURFACE) return;
+
+    eglDestroySurface(disp, surface);
+
+    surface = EGL_NO_SURFACE;
+}
@@ -0,0 +1,115 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0 
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015 
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Linux EGL context manager
+ */
+
+#ifndef OGLES_GPGPU_LINUX_EGL
+#define OGLES_GPGPU_LINUX_EGL
+
+#include <EGL/egl.h>
+
+namespace ogles_gpgpu {
+    
+/**
+ * Linux EGL context manager class with static functions for setting up and
+ * tearing down a headless EGL context. Works with Mesa's software rasterizer
+ * (llvmpipe / softpipe) as well as with GPU drivers.
+ * If the EGL implementation supports surfaceless contexts (EGL_KHR_surfaceless_context),
+ * no pixelbuffer surface is needed at all, because ogles_gpgpu renders into
+ * FBOs anyway. Otherwise, createPBufferSurface() must be called before activate().
+ */
+class EGL {
+public:
+    /**
+     * Create a EGL context by choosing an appropriate config for the specified bit-sizes.
+     * Prefers Mesa's surfaceless platform (EGL_MESA_platform_surfaceless), so that
+     * no X11 or Wayland display is necessary.
+     * Returns true on success, otherwise false.
+     */
+    static bool setup(int rSize = 8, int gSize = 8, int bSize = 8, int aSize = 8, int depthSize = 16);
+    
+    /**
+     * Create a pixelbuffer surface of size <w>x<h>. If the surface already exists, it will be
+     * destroyed and recreated (no matter if its size changed or not).
+     * Returns true on success, otherwise false.
+     */
+    static bool createPBufferSurface(int w, int h);
+    
+    /**
+     * Activate current EGL setup. setup() must be called first. createPBufferSurface()
+     * must also be called first, if surfaceless contexts are not supported.
+     */
+    static bool activate();
+    
+    /**
+     * Deactivate current EGL setup.
+     */
+    static bool deactivate();
+    
+    /**
+     * Destroy the EGL context, display and surface instances. Also calls deactivate().
+     */
+    static void shutdown();
+    
+    /**
+     * Returns true if the EGL implementation supports contexts without surfaces.
+     * Only valid after setup().
+     */
+    static bool getSupportsSurfaceless() { return surfacelessSupported; }
+    
+    /**
+     * Create an additional EGL context with the config of the main context, for example
+     * to run a separate ogles_gpgpu::Core object in another thread. If <shareObjects> is
+     * true, the new context shares its textures, buffers and shaders with the main context.
+     * setup() must be called first and surfaceless contexts must be supported.
+     * Returns the new context or EGL_NO_CONTEXT on failure.
+     */
+    static EGLContext createContext(bool shareObjects = false);
+    
+    /**
+     * Make the additional context <c> current in the calling thread (without a surface).
+     * Pass EGL_NO_CONTEXT to release the current context of the calling thread.
+     */
+    static bool activateContext(EGLContext c);
+    
+    /**
+     * Destroy the additional context <c>. It must not be current in any thread.
+     */
+    static void destroyContext(EGLContext c);
+    
+private:
+    /**
+     * Get an EGL display. Try the surfaceless platform first, then the default display.
+     */
+    static EGLDisplay getDisplay();
+    
+    /**
+     * Create an OpenGL ES context with the chosen config, sharing its objects with <shareCtx>.
+     * Tries OpenGL ES 3.0 first, if enabled.
+     */
+    static EGLContext createGLESContext(EGLContext shareCtx);
+    
+    /**
+     * Destroy the current EGL surface, if it was created.
+     */
+    static void destroySurface();
+    
+    
+    static EGLConfig conf;
+    static EGLSurface surface;
+    static EGLContext ctx;
+    static EGLDisplay disp;
+    
+    static bool surfacelessSupported;   // EGL_KHR_surfaceless_context available?
+};
+}
+
+#endif
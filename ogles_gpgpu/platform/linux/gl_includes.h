@@ -0,0 +1,21 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0 
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015 
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * OpenGL ES 2.0 / 3.0 includes for Linux (Mesa or vendor EGL/GLES drivers).
+ */
+ 
+// define OGLES_GPGPU_OPENGL_ES3 to compile with OpenGL ES 3.0 features (fences, pixel buffer
+// objects, etc.). they are only used when an OpenGL ES 3.0 context is detected at runtime.
+#ifdef OGLES_GPGPU_OPENGL_ES3
+#include <GLES3/gl3.h>
+#else
+#include <GLES2/gl2.h>
+#endif
+#include <GLES2/gl2ext.h>
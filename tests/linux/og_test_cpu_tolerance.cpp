@@ -0,0 +1,250 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// Author: Markus Konrad <post@mkonrad.net>, Winter 2014/2015
+// http://www.mkonrad.net
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Headless Linux test: runs pipelines of all processor types with the GPU and the
+ * CPU backend on random noise (the worst case for filters) at square and non-square
+ * frame sizes, with scaled and reoriented outputs and YUV input, and checks that the
+ * outputs agree within the tolerances that the README documents for the CPU backend.
+ *
+ * Returns 1 if an output differs by more, or 77 (skipped) if no OpenGL context
+ * with highp float precision in fragment shaders is available.
+ */
+
+#include "ogles_gpgpu/ogles_gpgpu.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+#define EXIT_SKIPPED    77
+
+#define BORDER_SIZE     3   // border pixels of the frame with an own tolerance (Gauss filter radius)
+
+#define YUV_CHROMA_RANGE    16  // max. distance of the chroma values of YUV input from neutral gray
+
+/**
+ * Test pipelines.
+ */
+typedef enum {
+    PIPE_GRAY = 0,          // grayscale conversion
+    PIPE_GAUSS,             // Gauss filter
+    PIPE_GRAY_GAUSS,        // grayscale conversion, Gauss filter
+    PIPE_GRAY_THRESH,       // grayscale conversion, thresholding
+    PIPE_GRAY_ADAPT_THRESH, // grayscale conversion, adaptive thresholding
+    PIPE_BLEND_DIFF         // grayscale conversion and Gauss filter, blended and subtracted
+} TestPipeline;
+
+/**
+ * Test pipeline and the max. difference between GPU and CPU output per channel.
+ */
+struct TolCase {
+    const char *name;
+    TestPipeline pipeline;
+    float scale;                    // output scale of the last processor
+    RenderOrientation orientation;  // output orientation of the last processor
+    GLenum inputFormat;
+    int maxDiff;
+    int borderMaxDiff;              // max. difference in the border pixels
+    float maxOutlierFrac;           // fraction of the pixels that may differ by more (thresholding results)
+};
+
+static const TolCase cases[] = {
+    { "gray",           PIPE_GRAY,              1.0f,   RenderOrientationStd,       GL_RGBA,            1,  1,  0.0f },
+    { "gray 0.5",       PIPE_GRAY,              0.5f,   RenderOrientationStd,       GL_RGBA,            2,  2,  0.0f },
+    { "gray flipped",   PIPE_GRAY,              1.0f,   RenderOrientationFlipped,   GL_RGBA,            2,  2,  0.0f },
+    { "gray diagonal",  PIPE_GRAY,              1.0f,   RenderOrientationDiagonal,  GL_RGBA,            2,  2,  0.0f },
+    { "gauss",          PIPE_GAUSS,             1.0f,   RenderOrientationStd,       GL_RGBA,            2,  2,  0.0f },
+    { "gray+gauss",     PIPE_GRAY_GAUSS,        1.0f,   RenderOrientationStd,       GL_RGBA,            2,  2,  0.0f },
+    { "gauss 0.5",      PIPE_GAUSS,             0.5f,   RenderOrientationStd,       GL_RGBA,            2,  24, 0.0f },
+    { "thresh",         PIPE_GRAY_THRESH,       1.0f,   RenderOrientationStd,       GL_RGBA,            0,  0,  0.01f },
+    { "adaptthresh",    PIPE_GRAY_ADAPT_THRESH, 1.0f,   RenderOrientationStd,       GL_RGBA,            0,  0,  0.01f },
+    { "blend+diff",     PIPE_BLEND_DIFF,        1.0f,   RenderOrientationStd,       GL_RGBA,            2,  2,  0.0f },
+    { "gray nv12",      PIPE_GRAY,              1.0f,   RenderOrientationStd,       INPUT_FORMAT_NV12,  0,  0,  0.0f },
+    { "gray i420",      PIPE_GRAY,              1.0f,   RenderOrientationStd,       INPUT_FORMAT_I420,  0,  0,  0.0f },
+    { "gauss nv12",     PIPE_GAUSS,             1.0f,   RenderOrientationStd,       INPUT_FORMAT_NV12,  8,  8,  0.0f },
+};
+
+static const int sizes[][2] = { { 320, 240 }, { 240, 320 }, { 123, 77 }, { 641, 479 } };
+
+/**
+ * Run pipeline <tc> with backend <backend> on frame <input> of size <w>x<h> and
+ * return the RGBA output in <output> and its width in <outW>.
+ */
+static void runPipeline(ProcessingBackend backend, const TolCase &tc,
+                        const vector<unsigned char> &input, int w, int h, vector<unsigned char> &output, int &outW)
+{
+    Core core;
+    GrayscaleProc grayscaleProc;
+    GaussProc gaussProc;
+    ThreshProc threshProc;
+    AdaptThreshProc adaptThreshProc;
+    BlendProc blendProc;
+    DiffProc diffProc;
+    ProcInterface *lastProc = NULL;
+    
+    core.setBackend(backend);
+    
+    switch (tc.pipeline) {
+        case PIPE_GRAY:
+            core.addProcToPipeline(&grayscaleProc);
+            lastProc = &grayscaleProc;
+            break;
+        case PIPE_GAUSS:
+            core.addProcToPipeline(&gaussProc);
+            lastProc = &gaussProc;
+            break;
+        case PIPE_GRAY_GAUSS:
+            core.addProcToPipeline(&grayscaleProc);
+            core.addProcToPipeline(&gaussProc);
+            lastProc = &gaussProc;
+            break;
+        case PIPE_GRAY_THRESH:
+            threshProc.setThreshVal(0.5f);
+            core.addProcToPipeline(&grayscaleProc);
+            core.addProcToPipeline(&threshProc);
+            lastProc = &threshProc;
+            break;
+        case PIPE_GRAY_ADAPT_THRESH:
+            core.addProcToPipeline(&grayscaleProc);
+            core.addProcToPipeline(&adaptThreshProc);
+            lastProc = &adaptThreshProc;
+            break;
+        case PIPE_BLEND_DIFF:
+            core.addProcToPipeline(&grayscaleProc);
+            core.addProcToPipeline(&gaussProc, &grayscaleProc);
+            core.addProcToPipeline(&blendProc, &grayscaleProc, &gaussProc);
+            core.addProcToPipeline(&diffProc, &blendProc, &gaussProc);
+            lastProc = &diffProc;
+            break;
+    }
+    
+    lastProc->setOutputSize(tc.scale);
+    if (tc.orientation != RenderOrientationStd) {   // only single pass processors
+        lastProc->setOutputRenderOrientation(tc.orientation);
+    }
+    
+    core.init();
+    core.prepare(w, h, tc.inputFormat);
+    
+    core.setInputData(&input[0]);
+    core.process();
+    
+    outW = core.getOutputFrameW();
+    output.resize(core.getOutputDataSize());
+    core.getOutputData(&output[0]);
+}
+
+/**
+ * Compare the RGBA frames <a> and <b> of width <w>. Return the max. difference per
+ * channel, separately for the inner pixels (<maxDiff>) and the border pixels
+ * (<borderMaxDiff>), and the number of pixels that differ by more than allowed by
+ * <tc> (<numOutliers>).
+ */
+static void compareOutputs(const vector<unsigned char> &a, const vector<unsigned char> &b, int w, const TolCase &tc,
+                           int &maxDiff, int &borderMaxDiff, int &numOutliers)
+{
+    maxDiff = borderMaxDiff = numOutliers = 0;
+    
+    if (a.size() != b.size()) {
+        maxDiff = borderMaxDiff = 255;
+        numOutliers = (int)max(a.size(), b.size()) / 4;
+        return;
+    }
+    
+    int h = (int)a.size() / (w * 4);
+    
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            bool border = x < BORDER_SIZE || y < BORDER_SIZE || x >= w - BORDER_SIZE || y >= h - BORDER_SIZE;
+            int pxDiff = 0;
+            
+            for (int c = 0; c < 4; c++) {
+                int i = (y * w + x) * 4 + c;
+                pxDiff = max(pxDiff, abs((int)a[i] - (int)b[i]));
+            }
+            
+            if (border) {
+                borderMaxDiff = max(borderMaxDiff, pxDiff);
+                if (pxDiff > tc.borderMaxDiff) numOutliers++;
+            } else {
+                maxDiff = max(maxDiff, pxDiff);
+                if (pxDiff > tc.maxDiff) numOutliers++;
+            }
+        }
+    }
+}
+
+int main() {
+    // set up EGL context
+    if (!EGL::setup()
+        || (!EGL::getSupportsSurfaceless() && !EGL::createPBufferSurface(64, 64))
+        || !EGL::activate())
+    {
+        fprintf(stderr, "no EGL context, skipped\n");
+        return EXIT_SKIPPED;
+    }
+    
+    // with mediump, the filter taps of wide frames are sampled at imprecise coordinates
+    GLint range[2], precision = 0;
+    glGetShaderPrecisionFormat(GL_FRAGMENT_SHADER, GL_HIGH_FLOAT, range, &precision);
+    
+    if (precision == 0) {
+        fprintf(stderr, "no highp float precision in fragment shaders, skipped\n");
+        EGL::shutdown();
+        return EXIT_SKIPPED;
+    }
+    
+    int numFailed = 0;
+    
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int w = sizes[s][0];
+        int h = sizes[s][1];
+        
+        vector<unsigned char> rgbaInput(w * h * 4);
+        srand((unsigned int)s);
+        for (size_t i = 0; i < rgbaInput.size(); i++) {
+            rgbaInput[i] = (unsigned char)(rand() & 0xFF);
+        }
+        
+        // YUV input: noise in the Y plane, chroma values within YUV_CHROMA_RANGE of neutral
+        vector<unsigned char> yuvInput(w * h + 2 * ((w + 1) / 2) * ((h + 1) / 2));
+        for (size_t i = 0; i < yuvInput.size(); i++) {
+            yuvInput[i] = (unsigned char)(i < (size_t)(w * h) ? (rand() & 0xFF) : 128 - YUV_CHROMA_RANGE + rand() % (2 * YUV_CHROMA_RANGE + 1));
+        }
+        
+        for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+            const TolCase &tc = cases[c];
+            const vector<unsigned char> &input = tc.inputFormat == GL_RGBA ? rgbaInput : yuvInput;
+            vector<unsigned char> gpuOutput, cpuOutput;
+            int outW;
+            runPipeline(PROCESSING_BACKEND_GPU, tc, input, w, h, gpuOutput, outW);
+            runPipeline(PROCESSING_BACKEND_CPU, tc, input, w, h, cpuOutput, outW);
+            
+            int maxDiff, borderMaxDiff, numOutliers;
+            compareOutputs(gpuOutput, cpuOutput, outW, tc, maxDiff, borderMaxDiff, numOutliers);
+            
+            int maxOutliers = (int)(tc.maxOutlierFrac * gpuOutput.size() / 4);
+            bool ok = numOutliers <= maxOutliers;
+            printf("%-14s %4dx%-4d max. difference %d (allowed %d), border %d (allowed %d), outliers %d (allowed %d): %s\n",
+                   tc.name, w, h, maxDiff, tc.maxDiff, borderMaxDiff, tc.borderMaxDiff, numOutliers, maxOutliers,
+                   ok ? "ok" : "FAILED");
+            
+            if (!ok) numFailed++;
+        }
+    }
+    
+    EGL::shutdown();
+    
+    return numFailed > 0 ? 1 : 0;
+}